@@ -0,0 +1,120 @@
+/* ApiBenchmark.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+package im.tox.jtoxcore.bench;
+
+import im.tox.jtoxcore.JTox;
+import im.tox.jtoxcore.ToxException;
+import im.tox.jtoxcore.ToxOptions;
+import im.tox.jtoxcore.callbacks.CallbackHandler;
+import im.tox.jtoxcore.callbacks.OnMessageCallback;
+
+import java.util.concurrent.TimeUnit;
+
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OperationsPerInvocation;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+import org.openjdk.jmh.annotations.Warmup;
+
+/**
+ * Benchmarks for the instance API, run against the mock toxcore from
+ * bench/mock. The mock has to be started with {@link #MOCK_SCRIPT} in the
+ * JTOX_MOCK environment variable, which the jtoxcore-bench target does.
+ *
+ * @author sonOfRa
+ *
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.NANOSECONDS)
+@Warmup(iterations = 5, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+public class ApiBenchmark {
+
+	/**
+	 * Messages the mock delivers per doTox: 100000 per second at 1 ms per
+	 * tick.
+	 */
+	public static final int MESSAGES_PER_TICK = 100;
+
+	public static final String MOCK_SCRIPT = "friends=64,message=100000,message_size=128,tick_ms=1";
+
+	private JTox<BenchFriend> jtox;
+	private BenchFriend friend;
+	private long received;
+
+	@Setup
+	public void setUp() throws ToxException {
+		if (!MOCK_SCRIPT.equals(System.getenv("JTOX_MOCK"))) {
+			throw new IllegalStateException("Run with JTOX_MOCK=" + MOCK_SCRIPT + " against the mock library");
+		}
+
+		BenchFriendList friendList = new BenchFriendList();
+		CallbackHandler<BenchFriend> handler = new CallbackHandler<BenchFriend>(friendList);
+		handler.registerOnMessageCallback(new OnMessageCallback<BenchFriend>() {
+
+			@Override
+			public void execute(BenchFriend friend, String message) {
+				ApiBenchmark.this.received += message.length();
+			}
+		});
+		this.jtox = new JTox<BenchFriend>(friendList, handler, new ToxOptions(false, true, false));
+		// The mock brings its friends online in the first doTox
+		this.jtox.doTox();
+		this.jtox.refreshList();
+		this.friend = friendList.getByFriendNumber(0);
+	}
+
+	@TearDown
+	public void tearDown() throws ToxException {
+		this.jtox.killTox();
+	}
+
+	@Benchmark
+	public int sendMessage() throws ToxException {
+		return this.jtox.sendMessage(this.friend, "The quick brown fox jumps over the lazy dog");
+	}
+
+	@Benchmark
+	public void refreshList() throws ToxException {
+		this.jtox.refreshList();
+	}
+
+	/**
+	 * One doTox, in which the mock delivers {@link #MESSAGES_PER_TICK}
+	 * messages through the callback handler. The score is per message.
+	 */
+	@Benchmark
+	@OperationsPerInvocation(MESSAGES_PER_TICK)
+	public long callbackDispatch() throws ToxException {
+		this.jtox.doTox();
+		return this.received;
+	}
+}
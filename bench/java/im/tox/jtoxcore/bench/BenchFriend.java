@@ -0,0 +1,111 @@
+/* BenchFriend.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+package im.tox.jtoxcore.bench;
+
+import im.tox.jtoxcore.ToxFriend;
+import im.tox.jtoxcore.ToxUserStatus;
+
+/**
+ * Minimal friend for the benchmarks, holding whatever the binding sets.
+ *
+ * @author sonOfRa
+ *
+ */
+public class BenchFriend implements ToxFriend {
+
+	private final int friendnumber;
+	private String id;
+	private String name;
+	private String statusMessage;
+	private ToxUserStatus status = ToxUserStatus.TOX_USERSTATUS_NONE;
+	private boolean online;
+	private boolean typing;
+
+	public BenchFriend(int friendnumber) {
+		this.friendnumber = friendnumber;
+	}
+
+	@Override
+	public String getId() {
+		return this.id;
+	}
+
+	@Override
+	public String getName() {
+		return this.name;
+	}
+
+	@Override
+	public String getStatusMessage() {
+		return this.statusMessage;
+	}
+
+	@Override
+	public ToxUserStatus getStatus() {
+		return this.status;
+	}
+
+	@Override
+	public boolean isOnline() {
+		return this.online;
+	}
+
+	@Override
+	public int getFriendnumber() {
+		return this.friendnumber;
+	}
+
+	@Override
+	public boolean isTyping() {
+		return this.typing;
+	}
+
+	@Override
+	public void setId(String id) {
+		this.id = id;
+	}
+
+	@Override
+	public void setName(String name) {
+		this.name = name;
+	}
+
+	@Override
+	public void setStatusMessage(String statusMessage) {
+		this.statusMessage = statusMessage;
+	}
+
+	@Override
+	public void setStatus(ToxUserStatus status) {
+		this.status = status;
+	}
+
+	@Override
+	public void setOnline(boolean online) {
+		this.online = online;
+	}
+
+	@Override
+	public void setTyping(boolean typing) {
+		this.typing = typing;
+	}
+}
@@ -0,0 +1,157 @@
+/* BenchFriendList.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+package im.tox.jtoxcore.bench;
+
+import im.tox.jtoxcore.FriendExistsException;
+import im.tox.jtoxcore.FriendList;
+import im.tox.jtoxcore.ToxUserStatus;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Map;
+import java.util.TreeMap;
+
+/**
+ * Friend list for the benchmarks, a map from friend number to friend.
+ *
+ * @author sonOfRa
+ *
+ */
+public class BenchFriendList implements FriendList<BenchFriend> {
+
+	private final Map<Integer, BenchFriend> friends = new TreeMap<Integer, BenchFriend>();
+
+	@Override
+	public BenchFriend getByFriendNumber(int friendnumber) {
+		return this.friends.get(friendnumber);
+	}
+
+	@Override
+	public BenchFriend getById(String id) {
+		for (BenchFriend friend : this.friends.values()) {
+			if (id.equals(friend.getId())) {
+				return friend;
+			}
+		}
+
+		return null;
+	}
+
+	@Override
+	public List<BenchFriend> getByName(String name, boolean ignorecase) {
+		List<BenchFriend> result = new ArrayList<BenchFriend>();
+
+		for (BenchFriend friend : this.friends.values()) {
+			String friendName = friend.getName();
+
+			if (friendName != null && (ignorecase ? friendName.equalsIgnoreCase(name) : friendName.equals(name))) {
+				result.add(friend);
+			}
+		}
+
+		return result;
+	}
+
+	@Override
+	public List<BenchFriend> searchFriend(String partial) {
+		List<BenchFriend> result = new ArrayList<BenchFriend>();
+		String lower = partial.toLowerCase();
+
+		for (BenchFriend friend : this.friends.values()) {
+			if (friend.getName() != null && friend.getName().toLowerCase().contains(lower)) {
+				result.add(friend);
+			}
+		}
+
+		return result;
+	}
+
+	@Override
+	public List<BenchFriend> getByStatus(ToxUserStatus status) {
+		List<BenchFriend> result = new ArrayList<BenchFriend>();
+
+		for (BenchFriend friend : this.friends.values()) {
+			if (friend.isOnline() && friend.getStatus() == status) {
+				result.add(friend);
+			}
+		}
+
+		return result;
+	}
+
+	@Override
+	public List<BenchFriend> getOnlineFriends() {
+		List<BenchFriend> result = new ArrayList<BenchFriend>();
+
+		for (BenchFriend friend : this.friends.values()) {
+			if (friend.isOnline()) {
+				result.add(friend);
+			}
+		}
+
+		return result;
+	}
+
+	@Override
+	public List<BenchFriend> getOfflineFriends() {
+		List<BenchFriend> result = new ArrayList<BenchFriend>();
+
+		for (BenchFriend friend : this.friends.values()) {
+			if (!friend.isOnline()) {
+				result.add(friend);
+			}
+		}
+
+		return result;
+	}
+
+	@Override
+	public List<BenchFriend> all() {
+		return new ArrayList<BenchFriend>(this.friends.values());
+	}
+
+	@Override
+	public BenchFriend addFriend(int friendnumber) throws FriendExistsException {
+		if (this.friends.containsKey(friendnumber)) {
+			throw new FriendExistsException(friendnumber);
+		}
+
+		return addFriendIfNotExists(friendnumber);
+	}
+
+	@Override
+	public BenchFriend addFriendIfNotExists(int friendnumber) {
+		BenchFriend friend = this.friends.get(friendnumber);
+
+		if (friend == null) {
+			friend = new BenchFriend(friendnumber);
+			this.friends.put(friendnumber, friend);
+		}
+
+		return friend;
+	}
+
+	@Override
+	public void removeFriend(int friendnumber) {
+		this.friends.remove(friendnumber);
+	}
+}
@@ -0,0 +1,74 @@
+/* ConversionBenchmark.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+package im.tox.jtoxcore.bench;
+
+import im.tox.jtoxcore.JTox;
+
+import java.util.concurrent.TimeUnit;
+
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.Warmup;
+
+/**
+ * Benchmarks for the static conversion helpers of {@link JTox}. They do not
+ * touch native code.
+ *
+ * @author sonOfRa
+ *
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.NANOSECONDS)
+@Warmup(iterations = 5, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+public class ConversionBenchmark {
+
+	private static final String ADDRESS = "56A1ADE4B65B86BCD51CC73E2CD4E542179F47959FE3E0E21B4B0ACDADE51855D34D34D37CB5";
+
+	/**
+	 * Plain ASCII, and the same length of text with two and three byte
+	 * characters
+	 */
+	@Param({ "The quick brown fox jumps over the lazy dog",
+			"Zwölf Boxkämpfer jagen Viktor quer über den großen Sylter Deich",
+			"いろはにほへと　ちりぬるを　わかよたれそ　つねならむ" })
+	public String text;
+
+	@Benchmark
+	public byte[] hexToByteArray() {
+		return JTox.hexToByteArray(ADDRESS);
+	}
+
+	@Benchmark
+	public byte[] getStringBytes() {
+		return JTox.getStringBytes(this.text);
+	}
+}
@@ -0,0 +1,723 @@
+/* LoadGenerator.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+package im.tox.jtoxcore.bench;
+
+import im.tox.jtoxcore.FriendExistsException;
+import im.tox.jtoxcore.JTox;
+import im.tox.jtoxcore.ToxAvCallbackID;
+import im.tox.jtoxcore.ToxCallType;
+import im.tox.jtoxcore.ToxCodecSettings;
+import im.tox.jtoxcore.ToxException;
+import im.tox.jtoxcore.ToxFileControl;
+import im.tox.jtoxcore.ToxOptions;
+import im.tox.jtoxcore.callbacks.CallbackHandler;
+import im.tox.jtoxcore.callbacks.OnAudioDataCallback;
+import im.tox.jtoxcore.callbacks.OnAvCallbackCallback;
+import im.tox.jtoxcore.callbacks.OnConnectionStatusCallback;
+import im.tox.jtoxcore.callbacks.OnFileControlCallback;
+import im.tox.jtoxcore.callbacks.OnFileSendRequestCallback;
+import im.tox.jtoxcore.callbacks.OnMessageBufferCallback;
+import im.tox.jtoxcore.callbacks.OnReadReceiptCallback;
+
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.OutputStream;
+import java.net.UnknownHostException;
+import java.nio.ByteBuffer;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import java.util.Locale;
+import java.util.Random;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.CopyOnWriteArrayList;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicLong;
+
+/**
+ * Load generator for capacity planning. Starts several instances in one
+ * process, has them bootstrap off each other over 127.0.0.1 and befriend each
+ * other, then drives message, file and call workloads between them and
+ * reports throughput and latency. No public node is contacted, so it runs on
+ * an offline machine.
+ * <p/>
+ * Usage:
+ *
+ * <pre>
+ * java -Djava.library.path=... im.tox.jtoxcore.bench.LoadGenerator [options]
+ *   --instances n   instances to start (default 4)
+ *   --duration s    length of the measurement in seconds (default 10)
+ *   --rate n        messages per second sent by each instance (default 100)
+ *   --size n        message size in bytes (default 128)
+ *   --file n        every instance sends a file of n bytes to the next one (default 0, none)
+ *   --calls n       the first n instances call the next one and send audio (default 0)
+ *   --port n        first port core binds to (default 33445)
+ *   --json          print the report as JSON
+ * </pre>
+ *
+ * Instances are bootstrapped with the assumption that they bind to
+ * consecutive ports starting at --port, with some slack for ports already in
+ * use.
+ *
+ * @author sonOfRa
+ *
+ */
+public class LoadGenerator {
+
+	private static final String LOOPBACK = "127.0.0.1";
+	private static final int PORT_SLACK = 8;
+	private static final long CONNECT_TIMEOUT = 120000;
+	private static final long DRAIN_TIME = 2000;
+	private static final int AUDIO_FRAME_MS = 20;
+	private static final int AUDIO_SAMPLES = 960;
+	private static final int AUDIO_DEST_MAX = 2048;
+
+	private int instances = 4;
+	private int duration = 10;
+	private int rate = 100;
+	private int size = 128;
+	private long fileSize = 0;
+	private int calls = 0;
+	private int port = 33445;
+	private boolean json = false;
+
+	private final List<Node> nodes = new ArrayList<Node>();
+	private volatile boolean running = true;
+	private volatile boolean measuring = false;
+
+	private final AtomicLong messagesSent = new AtomicLong();
+	private final AtomicLong messagesReceived = new AtomicLong();
+	private final AtomicLong sendFailures = new AtomicLong();
+	private final LongSamples receiptRtt = new LongSamples();
+	private final LongSamples callSetup = new LongSamples();
+	private final AtomicLong filesFinished = new AtomicLong();
+	private final AtomicLong fileBytes = new AtomicLong();
+	private final AtomicLong filesLastFinish = new AtomicLong();
+	private final AtomicLong audioFramesSent = new AtomicLong();
+	private final AtomicLong audioFramesReceived = new AtomicLong();
+	private long fileStart;
+
+	public static void main(String[] args) throws Exception {
+		LoadGenerator generator = new LoadGenerator();
+
+		if (!generator.parse(args)) {
+			System.err.println("Usage: LoadGenerator [--instances n] [--duration s] [--rate n] [--size n] [--file n] "
+					+ "[--calls n] [--port n] [--json]");
+			System.exit(2);
+		}
+
+		System.exit(generator.run() ? 0 : 1);
+	}
+
+	private boolean parse(String[] args) {
+		for (int i = 0; i < args.length; i++) {
+			String arg = args[i];
+
+			if (arg.equals("--json")) {
+				this.json = true;
+				continue;
+			}
+
+			if (i + 1 == args.length) {
+				return false;
+			}
+
+			long value;
+
+			try {
+				value = Long.parseLong(args[++i]);
+			} catch (NumberFormatException e) {
+				return false;
+			}
+
+			if (value < 0) {
+				return false;
+			}
+
+			if (arg.equals("--instances")) {
+				this.instances = (int) value;
+			} else if (arg.equals("--duration")) {
+				this.duration = (int) value;
+			} else if (arg.equals("--rate")) {
+				this.rate = (int) value;
+			} else if (arg.equals("--size")) {
+				this.size = (int) Math.min(value, JTox.TOX_MAX_MESSAGE_LENGTH);
+			} else if (arg.equals("--file")) {
+				this.fileSize = value;
+			} else if (arg.equals("--calls")) {
+				this.calls = (int) value;
+			} else if (arg.equals("--port")) {
+				this.port = (int) value;
+			} else {
+				return false;
+			}
+		}
+
+		return this.instances >= 2 && this.size > 0;
+	}
+
+	private boolean run() throws Exception {
+		for (int i = 0; i < this.instances; i++) {
+			this.nodes.add(new Node(i));
+		}
+
+		connect();
+
+		for (Node node : this.nodes) {
+			node.start();
+		}
+
+		if (!awaitOnline()) {
+			System.err.println("Instances did not connect to each other within " + CONNECT_TIMEOUT / 1000 + " s");
+			shutdown();
+			return false;
+		}
+
+		this.measuring = true;
+		long start = System.nanoTime();
+
+		for (Node node : this.nodes) {
+			node.startWorkload();
+		}
+
+		startFiles();
+		startCalls();
+		Thread.sleep(TimeUnit.SECONDS.toMillis(this.duration));
+		this.measuring = false;
+		long elapsed = System.nanoTime() - start;
+
+		// Give receipts for the last messages a chance to arrive
+		Thread.sleep(DRAIN_TIME);
+		shutdown();
+		report(elapsed);
+		return true;
+	}
+
+	/**
+	 * Befriend every instance with every other one, and bootstrap all of
+	 * them off each other
+	 */
+	private void connect() throws ToxException, UnknownHostException {
+		byte[][] clientIds = new byte[this.instances][];
+
+		for (Node node : this.nodes) {
+			clientIds[node.index] = Arrays.copyOf(node.jtox.getAddressBytes(), JTox.TOX_CLIENT_ID_SIZE);
+		}
+
+		for (Node node : this.nodes) {
+			for (Node other : this.nodes) {
+				if (other == node) {
+					continue;
+				}
+
+				try {
+					BenchFriend friend = node.jtox.confirmRequest(clientIds[other.index]);
+					node.friendNumbers[other.index] = friend.getFriendnumber();
+				} catch (FriendExistsException e) {
+					throw new IllegalStateException("Two instances have the same key", e);
+				}
+
+				for (int p = this.port; p < this.port + this.instances + PORT_SLACK; p++) {
+					node.jtox.bootstrap(LOOPBACK, p, clientIds[other.index]);
+				}
+			}
+		}
+	}
+
+	private boolean awaitOnline() throws InterruptedException {
+		long deadline = System.currentTimeMillis() + CONNECT_TIMEOUT;
+
+		while (System.currentTimeMillis() < deadline) {
+			boolean all = true;
+
+			for (Node node : this.nodes) {
+				all &= node.online.size() == this.instances - 1;
+			}
+
+			if (all) {
+				return true;
+			}
+
+			Thread.sleep(100);
+		}
+
+		return false;
+	}
+
+	private void startFiles() throws IOException, ToxException {
+		if (this.fileSize == 0) {
+			return;
+		}
+
+		File source = File.createTempFile("jtox-load", ".bin");
+		source.deleteOnExit();
+		OutputStream out = new FileOutputStream(source);
+
+		try {
+			byte[] block = new byte[65536];
+			new Random(0).nextBytes(block);
+
+			for (long written = 0; written < this.fileSize; written += block.length) {
+				out.write(block, 0, (int) Math.min(block.length, this.fileSize - written));
+			}
+		} finally {
+			out.close();
+		}
+
+		this.fileStart = System.nanoTime();
+
+		for (Node node : this.nodes) {
+			Node next = this.nodes.get((node.index + 1) % this.instances);
+			node.jtox.sendFile(node.friendNumbers[next.index], source);
+		}
+	}
+
+	private void startCalls() throws ToxException {
+		ToxCodecSettings settings = audioSettings();
+
+		for (int i = 0; i < Math.min(this.calls, this.instances); i++) {
+			Node node = this.nodes.get(i);
+			Node next = this.nodes.get((i + 1) % this.instances);
+			node.callStarted = System.nanoTime();
+			node.jtox.avCall(node.friendNumbers[next.index], settings, 10);
+		}
+	}
+
+	private static ToxCodecSettings audioSettings() {
+		return new ToxCodecSettings(ToxCallType.TYPE_AUDIO, 500, 1280, 720, 64000, AUDIO_FRAME_MS, 48000, 1);
+	}
+
+	private void shutdown() throws InterruptedException {
+		this.running = false;
+
+		for (Node node : this.nodes) {
+			node.join();
+		}
+
+		for (Node node : this.nodes) {
+			try {
+				node.jtox.killTox();
+			} catch (ToxException e) {
+				// Already gone
+			}
+		}
+	}
+
+	private void report(long elapsed) {
+		double seconds = elapsed / 1e9;
+		long lost = 0;
+
+		for (Node node : this.nodes) {
+			lost += node.pendingReceipts.size();
+		}
+
+		long[] rtt = this.receiptRtt.sorted();
+		long[] setup = this.callSetup.sorted();
+		double fileSeconds = this.filesFinished.get() == 0 ? 0 : (this.filesLastFinish.get() - this.fileStart) / 1e9;
+		double fileRate = fileSeconds == 0 ? 0 : this.fileBytes.get() / fileSeconds / 1e6;
+
+		if (this.json) {
+			StringBuilder sb = new StringBuilder();
+			sb.append("{\"instances\":").append(this.instances);
+			sb.append(",\"duration_s\":").append(format(seconds));
+			sb.append(",\"messages\":{\"sent\":").append(this.messagesSent.get());
+			sb.append(",\"received\":").append(this.messagesReceived.get());
+			sb.append(",\"send_failures\":").append(this.sendFailures.get());
+			sb.append(",\"per_second\":").append(format(this.messagesReceived.get() / seconds));
+			sb.append(",\"receipts_missing\":").append(lost);
+			sb.append(",\"receipt_rtt_ms\":").append(percentilesJson(rtt)).append('}');
+			sb.append(",\"files\":{\"finished\":").append(this.filesFinished.get());
+			sb.append(",\"bytes\":").append(this.fileBytes.get());
+			sb.append(",\"mb_per_s\":").append(format(fileRate)).append('}');
+			sb.append(",\"calls\":{\"established\":").append(setup.length);
+			sb.append(",\"setup_ms\":").append(percentilesJson(setup));
+			sb.append(",\"audio_frames_sent\":").append(this.audioFramesSent.get());
+			sb.append(",\"audio_frames_received\":").append(this.audioFramesReceived.get()).append("}}");
+			System.out.println(sb);
+			return;
+		}
+
+		System.out.println("instances            " + this.instances);
+		System.out.println("duration             " + format(seconds) + " s");
+		System.out.println("messages sent        " + this.messagesSent.get() + " (" + this.sendFailures.get()
+				+ " send failures)");
+		System.out.println("messages received    " + this.messagesReceived.get() + " ("
+				+ format(this.messagesReceived.get() / seconds) + "/s)");
+		System.out.println("receipts missing     " + lost);
+		System.out.println("receipt rtt ms       " + percentilesText(rtt));
+
+		if (this.fileSize > 0) {
+			System.out.println("files finished       " + this.filesFinished.get() + " of " + this.instances + ", "
+					+ format(fileRate) + " MB/s");
+		}
+
+		if (this.calls > 0) {
+			System.out.println("calls established    " + setup.length + " of " + Math.min(this.calls, this.instances));
+			System.out.println("call setup ms        " + percentilesText(setup));
+			System.out.println("audio frames         " + this.audioFramesSent.get() + " sent, "
+					+ this.audioFramesReceived.get() + " received");
+		}
+	}
+
+	private static String format(double value) {
+		return String.format(Locale.ROOT, "%.2f", value);
+	}
+
+	private static double percentile(long[] sorted, double q) {
+		int index = (int) Math.ceil(q * sorted.length) - 1;
+		return sorted[Math.max(0, Math.min(sorted.length - 1, index))] / 1e6;
+	}
+
+	private static String percentilesText(long[] sorted) {
+		if (sorted.length == 0) {
+			return "-";
+		}
+
+		return "p50 " + format(percentile(sorted, 0.5)) + "  p90 " + format(percentile(sorted, 0.9)) + "  p99 "
+				+ format(percentile(sorted, 0.99)) + "  max " + format(sorted[sorted.length - 1] / 1e6);
+	}
+
+	private static String percentilesJson(long[] sorted) {
+		if (sorted.length == 0) {
+			return "null";
+		}
+
+		return "{\"p50\":" + format(percentile(sorted, 0.5)) + ",\"p90\":" + format(percentile(sorted, 0.9))
+				+ ",\"p99\":" + format(percentile(sorted, 0.99)) + ",\"max\":" + format(sorted[sorted.length - 1] / 1e6)
+				+ "}";
+	}
+
+	/**
+	 * Growable array of durations in nanoseconds
+	 */
+	private static final class LongSamples {
+
+		private long[] values = new long[1024];
+		private int count;
+
+		synchronized void add(long value) {
+			if (this.count == this.values.length) {
+				this.values = Arrays.copyOf(this.values, this.count * 2);
+			}
+
+			this.values[this.count++] = value;
+		}
+
+		synchronized long[] sorted() {
+			long[] result = Arrays.copyOf(this.values, this.count);
+			Arrays.sort(result);
+			return result;
+		}
+	}
+
+	/**
+	 * One instance, with the threads driving it
+	 */
+	private final class Node {
+
+		final int index;
+		final JTox<BenchFriend> jtox;
+		/** Friend number of each other instance, by instance index */
+		final int[] friendNumbers;
+		final ConcurrentHashMap<Integer, Boolean> online = new ConcurrentHashMap<Integer, Boolean>();
+		/** Send time by friend number and receipt */
+		final ConcurrentHashMap<Long, Long> pendingReceipts = new ConcurrentHashMap<Long, Long>();
+		/** Receipts that arrived before sendMessage returned */
+		final ConcurrentHashMap<Long, Long> earlyReceipts = new ConcurrentHashMap<Long, Long>();
+		/**
+		 * Held while matching a receipt against both maps, so a receipt
+		 * can't slip between the sender's check and its insert
+		 */
+		private final Object receiptLock = new Object();
+		final List<Integer> activeCalls = new CopyOnWriteArrayList<Integer>();
+		volatile long callStarted;
+		private final List<Thread> threads = new ArrayList<Thread>();
+
+		Node(int index) throws ToxException {
+			this.index = index;
+			this.friendNumbers = new int[LoadGenerator.this.instances];
+			Arrays.fill(this.friendNumbers, -1);
+			BenchFriendList friendList = new BenchFriendList();
+			CallbackHandler<BenchFriend> handler = new CallbackHandler<BenchFriend>(friendList);
+			register(handler);
+			this.jtox = new JTox<BenchFriend>(friendList, handler, new ToxOptions(false, true, false));
+		}
+
+		private long key(int friendnumber, int receipt) {
+			return ((long) friendnumber << 32) | (receipt & 0xFFFFFFFFL);
+		}
+
+		private void register(CallbackHandler<BenchFriend> handler) {
+			handler.registerOnConnectionStatusCallback(new OnConnectionStatusCallback<BenchFriend>() {
+
+				@Override
+				public void execute(BenchFriend friend, boolean isOnline) {
+					if (isOnline) {
+						Node.this.online.put(friend.getFriendnumber(), Boolean.TRUE);
+					} else {
+						Node.this.online.remove(friend.getFriendnumber());
+					}
+				}
+			});
+			handler.registerOnMessageBufferCallback(new OnMessageBufferCallback() {
+
+				@Override
+				public void execute(int friendnumber, ByteBuffer data, int offset, int length) {
+					if (LoadGenerator.this.measuring) {
+						LoadGenerator.this.messagesReceived.incrementAndGet();
+					}
+				}
+			});
+			handler.registerOnReadReceiptCallback(new OnReadReceiptCallback<BenchFriend>() {
+
+				@Override
+				public void execute(BenchFriend friend, int receipt) {
+					long now = System.nanoTime();
+					long key = key(friend.getFriendnumber(), receipt);
+					Long sent;
+
+					synchronized (Node.this.receiptLock) {
+						sent = Node.this.pendingReceipts.remove(key);
+
+						if (sent == null) {
+							Node.this.earlyReceipts.put(key, now);
+						}
+					}
+
+					if (sent != null) {
+						LoadGenerator.this.receiptRtt.add(now - sent);
+					}
+				}
+			});
+			handler.registerOnFileSendRequestCallback(new OnFileSendRequestCallback<BenchFriend>() {
+
+				@Override
+				public void execute(BenchFriend friend, int filenumber, long filesize, byte[] filename) {
+					try {
+						File destination = File.createTempFile("jtox-load-recv", ".bin");
+						destination.deleteOnExit();
+						Node.this.jtox.receiveFile(friend.getFriendnumber(), filenumber, filesize, destination);
+					} catch (IOException e) {
+						System.err.println("Could not create a file to receive into: " + e);
+					} catch (ToxException e) {
+						System.err.println("Could not accept file: " + e);
+					}
+				}
+			});
+			handler.registerOnFileControlCallback(new OnFileControlCallback<BenchFriend>() {
+
+				@Override
+				public void execute(BenchFriend friend, boolean sending, int fileNumber, ToxFileControl controlType,
+						byte[] data) {
+					if (!sending && controlType == ToxFileControl.TOX_FILECONTROL_FINISHED) {
+						LoadGenerator.this.filesFinished.incrementAndGet();
+						LoadGenerator.this.fileBytes.addAndGet(LoadGenerator.this.fileSize);
+						LoadGenerator.this.filesLastFinish.set(System.nanoTime());
+					}
+				}
+			});
+			handler.registerOnAvCallbackCallback(new OnAvCallbackCallback<BenchFriend>() {
+
+				@Override
+				public void execute(int callId, ToxAvCallbackID callbackId) {
+					try {
+						switch (callbackId) {
+							case ON_INVITE:
+								Node.this.jtox.avAnswer(callId, audioSettings());
+								break;
+
+							case ON_STARTING:
+								LoadGenerator.this.callSetup.add(System.nanoTime() - Node.this.callStarted);
+								startMedia(callId);
+								break;
+
+							case ON_START:
+								startMedia(callId);
+								break;
+
+							case ON_END:
+							case ON_ENDING:
+							case ON_PEER_TIMEOUT:
+								Node.this.activeCalls.remove(Integer.valueOf(callId));
+								break;
+
+							default:
+								break;
+						}
+					} catch (ToxException e) {
+						System.err.println("Call " + callId + " failed: " + e);
+					}
+				}
+			});
+			handler.registerOnAudioDataCallback(new OnAudioDataCallback<BenchFriend>() {
+
+				@Override
+				public void execute(int callId, byte[] data) {
+					LoadGenerator.this.audioFramesReceived.incrementAndGet();
+				}
+			});
+		}
+
+		private void startMedia(int callId) throws ToxException {
+			this.jtox.avPrepareTransmission(callId, 3, 40, false);
+			this.activeCalls.add(callId);
+		}
+
+		void start() {
+			spawn("tox-" + this.index, new Runnable() {
+
+				@Override
+				public void run() {
+					doToxLoop();
+				}
+			});
+		}
+
+		void startWorkload() {
+			spawn("messages-" + this.index, new Runnable() {
+
+				@Override
+				public void run() {
+					sendLoop();
+				}
+			});
+
+			if (LoadGenerator.this.calls > 0) {
+				spawn("audio-" + this.index, new Runnable() {
+
+					@Override
+					public void run() {
+						audioLoop();
+					}
+				});
+			}
+		}
+
+		private synchronized void spawn(String name, Runnable task) {
+			Thread thread = new Thread(task, name);
+			thread.setDaemon(true);
+			this.threads.add(thread);
+			thread.start();
+		}
+
+		synchronized void join() throws InterruptedException {
+			for (Thread thread : this.threads) {
+				thread.join();
+			}
+		}
+
+		private void doToxLoop() {
+			try {
+				while (LoadGenerator.this.running) {
+					this.jtox.doTox();
+					Thread.sleep(Math.max(1, this.jtox.doToxInterval()));
+				}
+			} catch (ToxException e) {
+				System.err.println("doTox failed on instance " + this.index + ": " + e);
+			} catch (InterruptedException e) {
+				Thread.currentThread().interrupt();
+			}
+		}
+
+		private void sendLoop() {
+			char[] text = new char[LoadGenerator.this.size];
+			Arrays.fill(text, 'x');
+			String message = new String(text);
+			List<BenchFriend> friends = new ArrayList<BenchFriend>();
+
+			for (int number : this.friendNumbers) {
+				if (number != -1) {
+					friends.add(this.jtox.getFriendList().getByFriendNumber(number));
+				}
+			}
+
+			long start = System.nanoTime();
+			long sent = 0;
+
+			try {
+				while (LoadGenerator.this.measuring) {
+					long due = (System.nanoTime() - start) * LoadGenerator.this.rate / 1000000000L;
+
+					for (; sent < due && LoadGenerator.this.measuring; sent++) {
+						BenchFriend friend = friends.get((int) (sent % friends.size()));
+						long now = System.nanoTime();
+
+						try {
+							int receipt = this.jtox.sendMessage(friend, message);
+							long key = key(friend.getFriendnumber(), receipt);
+							Long early;
+
+							synchronized (this.receiptLock) {
+								early = this.earlyReceipts.remove(key);
+
+								if (early == null) {
+									this.pendingReceipts.put(key, now);
+								}
+							}
+
+							if (early != null) {
+								LoadGenerator.this.receiptRtt.add(early - now);
+							}
+
+							LoadGenerator.this.messagesSent.incrementAndGet();
+						} catch (ToxException e) {
+							LoadGenerator.this.sendFailures.incrementAndGet();
+						}
+					}
+
+					Thread.sleep(1);
+				}
+			} catch (InterruptedException e) {
+				Thread.currentThread().interrupt();
+			}
+		}
+
+		private void audioLoop() {
+			int[] pcm = new int[AUDIO_SAMPLES / 2];
+
+			for (int i = 0; i < pcm.length; i++) {
+				pcm[i] = (int) (Math.sin(i / 8.0) * 8000) & 0xFFFF;
+			}
+
+			try {
+				while (LoadGenerator.this.measuring) {
+					for (int callId : this.activeCalls) {
+						try {
+							byte[] frame = this.jtox.avPrepareAudioFrame(callId, AUDIO_DEST_MAX, pcm, AUDIO_SAMPLES);
+
+							if (frame != null && frame.length > 0 && this.jtox.avSendAudio(callId, frame) == 0) {
+								LoadGenerator.this.audioFramesSent.incrementAndGet();
+							}
+						} catch (ToxException e) {
+							this.activeCalls.remove(Integer.valueOf(callId));
+						}
+					}
+
+					Thread.sleep(AUDIO_FRAME_MS);
+				}
+			} catch (InterruptedException e) {
+				Thread.currentThread().interrupt();
+			}
+		}
+	}
+}
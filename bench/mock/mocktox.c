@@ -0,0 +1,1569 @@
+/* mocktox.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <tox/tox.h>
+#include <tox/toxav.h>
+#include <vpx/vpx_image.h>
+
+/*
+ * Stand-in for libtoxcore and libtoxav that implements the entry points jni/JTox.c uses, for
+ * measuring the binding without a network. Nothing leaves the process: every instance has a set
+ * of scripted friends that are online from the first tox_do on and produce events at configurable
+ * rates. All events are delivered from tox_do on the calling thread, like core does.
+ *
+ * The script is read from the JTOX_MOCK environment variable when an instance is created, as a
+ * comma separated list of key=value pairs. Rates are events per second, summed over all friends:
+ *
+ *   friends=4          friends every instance starts with
+ *   message=0          incoming messages, message_size bytes each (default 128)
+ *   action=0           incoming actions, also message_size bytes
+ *   status=0           name, status message and user status changes, in turn
+ *   file=0             chunks of an incoming file, file_chunk bytes each (default 1371)
+ *   audio=0            audio frames per active call, audio_samples samples each (default 960)
+ *   video=0            video frames per active call, video_width x video_height (default 640x480)
+ *   calls=0            incoming calls offered once the instance is connected
+ *   receipts=1         acknowledge every sent message with a read receipt on the next tox_do
+ *   tick_ms=0          if set, every tox_do advances a virtual clock by this many milliseconds
+ *                      instead of following the real one, which makes runs reproducible
+ *   seed=1             seed for keys and payloads
+ *   verbose=0          print a summary of what was generated to stderr in tox_kill
+ *
+ * This file follows the toxcore and toxav API the binding is written against.
+ */
+#define MOCK_MAX_FRIENDS 4096
+#define MOCK_MAX_CALLS 64
+#define MOCK_MAX_RECEIPTS 65536
+#define MOCK_MAX_FILES 256
+/* Caps the events a single tox_do emits per stream, e.g. after the process was suspended */
+#define MOCK_MAX_BURST 100000
+#define MOCK_SAVE_MAGIC "JTXM"
+
+typedef struct {
+	unsigned friends;
+	double message_rate;
+	unsigned message_size;
+	double action_rate;
+	double status_rate;
+	double file_rate;
+	unsigned file_chunk;
+	double audio_rate;
+	unsigned audio_samples;
+	double video_rate;
+	unsigned video_width;
+	unsigned video_height;
+	unsigned calls;
+	int receipts;
+	unsigned tick_ms;
+	uint32_t seed;
+	int verbose;
+} mock_config_t;
+
+typedef struct {
+	int exists;
+	uint8_t client_id[TOX_CLIENT_ID_SIZE];
+	uint8_t name[TOX_MAX_NAME_LENGTH];
+	uint16_t name_length;
+	uint8_t status_message[TOX_MAX_STATUSMESSAGE_LENGTH];
+	uint16_t status_message_length;
+	uint8_t user_status;
+	uint8_t online;
+	uint8_t typing;
+	/* Next file number for transfers we send to this friend */
+	uint8_t next_file;
+} mock_friend_t;
+
+typedef struct {
+	int32_t friendnumber;
+	uint32_t receipt;
+} mock_receipt_t;
+
+typedef struct {
+	int32_t friendnumber;
+	uint8_t filenumber;
+} mock_file_t;
+
+typedef struct {
+	uint64_t messages;
+	uint64_t actions;
+	uint64_t status_changes;
+	uint64_t file_chunks;
+	uint64_t audio_frames;
+	uint64_t video_frames;
+	uint64_t receipts;
+	uint64_t sent_messages;
+	uint64_t sent_bytes;
+	uint64_t sent_file_bytes;
+	uint64_t sent_audio_bytes;
+	uint64_t sent_video_bytes;
+} mock_counters_t;
+
+struct Tox {
+	mock_config_t config;
+	uint32_t rng;
+	uint64_t now_us;
+	uint64_t last_us;
+	int started;
+	int connected;
+	int calls_offered;
+
+	double owed_messages;
+	double owed_actions;
+	double owed_status;
+	double owed_file;
+	double owed_audio;
+	double owed_video;
+	uint32_t next_friend;
+
+	uint8_t address[TOX_FRIEND_ADDRESS_SIZE];
+	uint32_t nospam;
+	uint8_t name[TOX_MAX_NAME_LENGTH];
+	uint16_t name_length;
+	uint8_t status_message[TOX_MAX_STATUSMESSAGE_LENGTH];
+	uint16_t status_message_length;
+	uint8_t user_status;
+
+	mock_friend_t *friends;
+	uint32_t friend_count;
+	uint8_t *payload;
+
+	mock_receipt_t *receipts;
+	uint32_t receipt_count;
+	uint32_t next_receipt;
+
+	int incoming_file_offered;
+	mock_file_t accepted[MOCK_MAX_FILES];
+	uint32_t accepted_count;
+
+	mock_counters_t counters;
+	struct _ToxAv *av;
+
+	void (*friend_request)(Tox *, uint8_t *, uint8_t *, uint16_t, void *);
+	void *friend_request_data;
+	void (*friend_message)(Tox *, int, uint8_t *, uint16_t, void *);
+	void *friend_message_data;
+	void (*friend_action)(Tox *, int32_t, uint8_t *, uint16_t, void *);
+	void *friend_action_data;
+	void (*name_change)(Tox *, int32_t, uint8_t *, uint16_t, void *);
+	void *name_change_data;
+	void (*status_message_change)(Tox *, int32_t, uint8_t *, uint16_t, void *);
+	void *status_message_data;
+	void (*user_status_change)(Tox *, int32_t, uint8_t, void *);
+	void *user_status_data;
+	void (*typing_change)(Tox *, int32_t, uint8_t, void *);
+	void *typing_change_data;
+	void (*read_receipt)(Tox *, int32_t, uint32_t, void *);
+	void *read_receipt_data;
+	void (*connection_status)(Tox *, int32_t, uint8_t, void *);
+	void *connection_status_data;
+	void (*file_send_request)(Tox *, int32_t, uint8_t, uint64_t, uint8_t *, uint16_t, void *);
+	void *file_send_request_data;
+	void (*file_control)(Tox *, int32_t, uint8_t, uint8_t, uint8_t, uint8_t *, uint16_t, void *);
+	void *file_control_data;
+	void (*file_data)(Tox *, int32_t, uint8_t, uint8_t *, uint16_t, void *);
+	void *file_data_data;
+};
+
+typedef struct {
+	ToxAvCallState state;
+	int incoming;
+	/* Set by toxav_call, the peer picks up on the next tox_do */
+	int ringing;
+	ToxAvCSettings settings;
+} mock_call_t;
+
+struct _ToxAv {
+	Tox *tox;
+	int32_t max_calls;
+	mock_call_t calls[MOCK_MAX_CALLS];
+	ToxAVCallback callstate[av_OnMediaChange + 1];
+	void *callstate_data[av_OnMediaChange + 1];
+	void (*audio)(ToxAv *, int32_t, int16_t *, int, void *);
+	void *audio_data;
+	void (*video)(ToxAv *, int32_t, vpx_image_t *, void *);
+	void *video_data;
+	int16_t *pcm;
+	vpx_image_t *image;
+};
+
+const ToxAvCSettings av_DefaultSettings = {
+	TypeAudio,
+	500,
+	1280,
+	720,
+	64000,
+	20,
+	48000,
+	1
+};
+
+static uint32_t mock_random(Tox *tox)
+{
+	/* xorshift32 */
+	uint32_t x = tox->rng;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	tox->rng = x;
+	return x;
+}
+
+static void mock_fill(Tox *tox, uint8_t *data, size_t length)
+{
+	size_t i;
+
+	for (i = 0; i < length; i++) {
+		data[i] = (uint8_t) mock_random(tox);
+	}
+}
+
+static uint64_t mock_clock_us(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static void mock_parse_config(mock_config_t *config)
+{
+	const char *script = getenv("JTOX_MOCK");
+	char *copy;
+	char *item;
+	char *save;
+
+	memset(config, 0, sizeof(mock_config_t));
+	config->friends = 4;
+	config->message_size = 128;
+	config->file_chunk = 1371;
+	config->audio_samples = 960;
+	config->video_width = 640;
+	config->video_height = 480;
+	config->receipts = 1;
+	config->seed = 1;
+
+	if (script == NULL) {
+		return;
+	}
+
+	copy = strdup(script);
+
+	for (item = strtok_r(copy, ",", &save); item != NULL; item = strtok_r(NULL, ",", &save)) {
+		char *value = strchr(item, '=');
+
+		if (value == NULL) {
+			fprintf(stderr, "mocktox: ignoring '%s'\n", item);
+			continue;
+		}
+
+		*value++ = '\0';
+
+		if (strcmp(item, "friends") == 0) {
+			config->friends = (unsigned) strtoul(value, NULL, 10);
+		} else if (strcmp(item, "message") == 0) {
+			config->message_rate = strtod(value, NULL);
+		} else if (strcmp(item, "message_size") == 0) {
+			config->message_size = (unsigned) strtoul(value, NULL, 10);
+		} else if (strcmp(item, "action") == 0) {
+			config->action_rate = strtod(value, NULL);
+		} else if (strcmp(item, "status") == 0) {
+			config->status_rate = strtod(value, NULL);
+		} else if (strcmp(item, "file") == 0) {
+			config->file_rate = strtod(value, NULL);
+		} else if (strcmp(item, "file_chunk") == 0) {
+			config->file_chunk = (unsigned) strtoul(value, NULL, 10);
+		} else if (strcmp(item, "audio") == 0) {
+			config->audio_rate = strtod(value, NULL);
+		} else if (strcmp(item, "audio_samples") == 0) {
+			config->audio_samples = (unsigned) strtoul(value, NULL, 10);
+		} else if (strcmp(item, "video") == 0) {
+			config->video_rate = strtod(value, NULL);
+		} else if (strcmp(item, "video_width") == 0) {
+			config->video_width = (unsigned) strtoul(value, NULL, 10);
+		} else if (strcmp(item, "video_height") == 0) {
+			config->video_height = (unsigned) strtoul(value, NULL, 10);
+		} else if (strcmp(item, "calls") == 0) {
+			config->calls = (unsigned) strtoul(value, NULL, 10);
+		} else if (strcmp(item, "receipts") == 0) {
+			config->receipts = atoi(value);
+		} else if (strcmp(item, "tick_ms") == 0) {
+			config->tick_ms = (unsigned) strtoul(value, NULL, 10);
+		} else if (strcmp(item, "seed") == 0) {
+			config->seed = (uint32_t) strtoul(value, NULL, 10);
+		} else if (strcmp(item, "verbose") == 0) {
+			config->verbose = atoi(value);
+		} else {
+			fprintf(stderr, "mocktox: unknown key '%s'\n", item);
+		}
+	}
+
+	free(copy);
+
+	if (config->friends > MOCK_MAX_FRIENDS) {
+		config->friends = MOCK_MAX_FRIENDS;
+	}
+
+	if (config->message_size == 0 || config->message_size > TOX_MAX_MESSAGE_LENGTH) {
+		config->message_size = TOX_MAX_MESSAGE_LENGTH;
+	}
+
+	if (config->file_chunk == 0 || config->file_chunk > UINT16_MAX) {
+		config->file_chunk = 1371;
+	}
+
+	if (config->calls > MOCK_MAX_CALLS) {
+		config->calls = MOCK_MAX_CALLS;
+	}
+
+	if (config->seed == 0) {
+		config->seed = 1;
+	}
+}
+
+static int mock_friend_valid(Tox *tox, int32_t friendnumber)
+{
+	return friendnumber >= 0 && (uint32_t) friendnumber < tox->friend_count && tox->friends[friendnumber].exists;
+}
+
+static int32_t mock_add_friend(Tox *tox, const uint8_t *client_id)
+{
+	uint32_t i;
+
+	for (i = 0; i < tox->friend_count; i++) {
+		if (tox->friends[i].exists && memcmp(tox->friends[i].client_id, client_id, TOX_CLIENT_ID_SIZE) == 0) {
+			return -1;
+		}
+	}
+
+	for (i = 0; i < tox->friend_count && tox->friends[i].exists; i++) {
+	}
+
+	if (i == MOCK_MAX_FRIENDS) {
+		return -1;
+	}
+
+	if (i == tox->friend_count) {
+		tox->friend_count++;
+	}
+
+	memset(&tox->friends[i], 0, sizeof(mock_friend_t));
+	tox->friends[i].exists = 1;
+	memcpy(tox->friends[i].client_id, client_id, TOX_CLIENT_ID_SIZE);
+	tox->friends[i].name_length = (uint16_t) sprintf((char *) tox->friends[i].name, "mock friend %u", i);
+	/* Friends added after the start come online with the next tox_do */
+	return (int32_t) i;
+}
+
+/* Round robin over the online friends, -1 if there are none */
+static int32_t mock_next_online(Tox *tox)
+{
+	uint32_t tried;
+
+	for (tried = 0; tried < tox->friend_count; tried++) {
+		uint32_t i = tox->next_friend++ % tox->friend_count;
+
+		if (tox->friends[i].exists && tox->friends[i].online) {
+			return (int32_t) i;
+		}
+	}
+
+	return -1;
+}
+
+/* Number of events of a stream that are due this tick */
+static uint32_t mock_due(double *owed, double rate, double seconds)
+{
+	double due;
+
+	*owed += rate * seconds;
+	due = *owed;
+
+	if (due < 1) {
+		return 0;
+	}
+
+	if (due > MOCK_MAX_BURST) {
+		*owed = 0;
+		return MOCK_MAX_BURST;
+	}
+
+	*owed -= (uint32_t) due;
+	return (uint32_t) due;
+}
+
+Tox *tox_new(Tox_Options *options)
+{
+	Tox *tox = calloc(1, sizeof(Tox));
+	uint8_t client_id[TOX_CLIENT_ID_SIZE];
+	uint16_t checksum = 0;
+	uint32_t i;
+
+	(void) options;
+
+	if (tox == NULL) {
+		return NULL;
+	}
+
+	mock_parse_config(&tox->config);
+	tox->rng = tox->config.seed;
+	tox->friends = calloc(MOCK_MAX_FRIENDS, sizeof(mock_friend_t));
+	tox->payload = malloc(TOX_MAX_MESSAGE_LENGTH);
+	tox->receipts = malloc(MOCK_MAX_RECEIPTS * sizeof(mock_receipt_t));
+
+	if (tox->friends == NULL || tox->payload == NULL || tox->receipts == NULL) {
+		tox_kill(tox);
+		return NULL;
+	}
+
+	/* Printable payload, so it also passes through the String callbacks */
+	for (i = 0; i < TOX_MAX_MESSAGE_LENGTH; i++) {
+		tox->payload[i] = (uint8_t) ('a' + mock_random(tox) % 26);
+	}
+
+	mock_fill(tox, tox->address, TOX_CLIENT_ID_SIZE);
+	tox->nospam = mock_random(tox);
+	memcpy(tox->address + TOX_CLIENT_ID_SIZE, &tox->nospam, sizeof(uint32_t));
+
+	for (i = 0; i < TOX_CLIENT_ID_SIZE + sizeof(uint32_t); i++) {
+		checksum ^= (uint16_t) (tox->address[i] << ((i % 2) * 8));
+	}
+
+	memcpy(tox->address + TOX_CLIENT_ID_SIZE + sizeof(uint32_t), &checksum, sizeof(uint16_t));
+	tox->name_length = (uint16_t) sprintf((char *) tox->name, "mock");
+
+	for (i = 0; i < tox->config.friends; i++) {
+		mock_fill(tox, client_id, TOX_CLIENT_ID_SIZE);
+		mock_add_friend(tox, client_id);
+	}
+
+	return tox;
+}
+
+void tox_kill(Tox *tox)
+{
+	if (tox == NULL) {
+		return;
+	}
+
+	if (tox->config.verbose) {
+		mock_counters_t *c = &tox->counters;
+		fprintf(stderr, "{\"mocktox\":{\"messages\":%llu,\"actions\":%llu,\"status_changes\":%llu,"
+				"\"file_chunks\":%llu,\"audio_frames\":%llu,\"video_frames\":%llu,\"receipts\":%llu,"
+				"\"sent_messages\":%llu,\"sent_bytes\":%llu,\"sent_file_bytes\":%llu,\"sent_audio_bytes\":%llu,"
+				"\"sent_video_bytes\":%llu}}\n",
+				(unsigned long long) c->messages, (unsigned long long) c->actions,
+				(unsigned long long) c->status_changes, (unsigned long long) c->file_chunks,
+				(unsigned long long) c->audio_frames, (unsigned long long) c->video_frames,
+				(unsigned long long) c->receipts, (unsigned long long) c->sent_messages,
+				(unsigned long long) c->sent_bytes, (unsigned long long) c->sent_file_bytes,
+				(unsigned long long) c->sent_audio_bytes, (unsigned long long) c->sent_video_bytes);
+	}
+
+	free(tox->friends);
+	free(tox->payload);
+	free(tox->receipts);
+	free(tox);
+}
+
+static void mock_do_friends(Tox *tox)
+{
+	uint32_t i;
+
+	for (i = 0; i < tox->friend_count; i++) {
+		if (tox->friends[i].exists && !tox->friends[i].online) {
+			tox->friends[i].online = 1;
+
+			if (tox->connection_status != NULL) {
+				tox->connection_status(tox, (int32_t) i, 1, tox->connection_status_data);
+			}
+		}
+	}
+}
+
+static void mock_do_receipts(Tox *tox)
+{
+	uint32_t i;
+	uint32_t count = tox->receipt_count;
+
+	/* Receipts queued from within the callbacks are delivered on the next tick */
+	tox->receipt_count = 0;
+
+	for (i = 0; i < count; i++) {
+		tox->counters.receipts++;
+
+		if (tox->read_receipt != NULL) {
+			tox->read_receipt(tox, tox->receipts[i].friendnumber, tox->receipts[i].receipt, tox->read_receipt_data);
+		}
+	}
+}
+
+static void mock_do_files(Tox *tox)
+{
+	uint32_t i;
+	uint32_t count = tox->accepted_count;
+
+	/* Every transfer we offered is accepted by the friend right away */
+	tox->accepted_count = 0;
+
+	for (i = 0; i < count; i++) {
+		if (tox->file_control != NULL) {
+			tox->file_control(tox, tox->accepted[i].friendnumber, 1, tox->accepted[i].filenumber,
+							  TOX_FILECONTROL_ACCEPT, NULL, 0, tox->file_control_data);
+		}
+	}
+}
+
+static void mock_do_streams(Tox *tox, double seconds)
+{
+	mock_config_t *config = &tox->config;
+	uint32_t n;
+	uint32_t i;
+	int32_t friendnumber;
+
+	n = mock_due(&tox->owed_messages, config->message_rate, seconds);
+
+	for (i = 0; i < n && (friendnumber = mock_next_online(tox)) != -1; i++) {
+		tox->counters.messages++;
+
+		if (tox->friend_message != NULL) {
+			tox->friend_message(tox, friendnumber, tox->payload, (uint16_t) config->message_size,
+								tox->friend_message_data);
+		}
+	}
+
+	n = mock_due(&tox->owed_actions, config->action_rate, seconds);
+
+	for (i = 0; i < n && (friendnumber = mock_next_online(tox)) != -1; i++) {
+		tox->counters.actions++;
+
+		if (tox->friend_action != NULL) {
+			tox->friend_action(tox, friendnumber, tox->payload, (uint16_t) config->message_size, tox->friend_action_data);
+		}
+	}
+
+	n = mock_due(&tox->owed_status, config->status_rate, seconds);
+
+	for (i = 0; i < n && (friendnumber = mock_next_online(tox)) != -1; i++) {
+		mock_friend_t *f = &tox->friends[friendnumber];
+		uint64_t change = tox->counters.status_changes++;
+
+		switch (change % 3) {
+			case 0:
+				f->name_length = (uint16_t) sprintf((char *) f->name, "mock friend %d (%llu)", friendnumber,
+													(unsigned long long) change);
+
+				if (tox->name_change != NULL) {
+					tox->name_change(tox, friendnumber, f->name, f->name_length, tox->name_change_data);
+				}
+
+				break;
+
+			case 1:
+				f->status_message_length = (uint16_t) sprintf((char *) f->status_message, "status %llu",
+										   (unsigned long long) change);
+
+				if (tox->status_message_change != NULL) {
+					tox->status_message_change(tox, friendnumber, f->status_message, f->status_message_length,
+											   tox->status_message_data);
+				}
+
+				break;
+
+			default:
+				f->user_status = (uint8_t) ((f->user_status + 1) % TOX_USERSTATUS_INVALID);
+
+				if (tox->user_status_change != NULL) {
+					tox->user_status_change(tox, friendnumber, f->user_status, tox->user_status_data);
+				}
+
+				break;
+		}
+	}
+
+	n = mock_due(&tox->owed_file, config->file_rate, seconds);
+
+	if (n > 0 && tox->friend_count > 0 && tox->friends[0].online) {
+		if (!tox->incoming_file_offered) {
+			static uint8_t filename[] = "mock.bin";
+
+			tox->incoming_file_offered = 1;
+
+			if (tox->file_send_request != NULL) {
+				tox->file_send_request(tox, 0, 0, UINT64_MAX, filename, sizeof(filename) - 1,
+									   tox->file_send_request_data);
+			}
+		}
+
+		for (i = 0; i < n; i++) {
+			tox->counters.file_chunks++;
+
+			if (tox->file_data != NULL) {
+				uint8_t *chunk = malloc(config->file_chunk);
+
+				if (chunk == NULL) {
+					break;
+				}
+
+				memset(chunk, (int) (tox->counters.file_chunks & 0xFF), config->file_chunk);
+				tox->file_data(tox, 0, 0, chunk, (uint16_t) config->file_chunk, tox->file_data_data);
+				free(chunk);
+			}
+		}
+	}
+}
+
+static void mock_do_av(ToxAv *av, double seconds);
+
+void tox_do(Tox *tox)
+{
+	double seconds;
+	uint64_t now = tox->config.tick_ms ? tox->now_us + tox->config.tick_ms * 1000ULL : mock_clock_us();
+
+	if (!tox->started) {
+		tox->started = 1;
+		tox->last_us = now;
+	}
+
+	tox->now_us = now;
+	seconds = (double) (now - tox->last_us) / 1000000;
+	tox->last_us = now;
+	tox->connected = 1;
+
+	mock_do_friends(tox);
+	mock_do_receipts(tox);
+	mock_do_files(tox);
+	mock_do_streams(tox, seconds);
+
+	if (tox->av != NULL) {
+		mock_do_av(tox->av, seconds);
+	}
+}
+
+uint32_t tox_do_interval(Tox *tox)
+{
+	return tox->config.tick_ms ? tox->config.tick_ms : 50;
+}
+
+int tox_isconnected(Tox *tox)
+{
+	return tox->connected;
+}
+
+int tox_bootstrap_from_address(Tox *tox, const char *address, uint16_t port, uint8_t *public_key)
+{
+	(void) tox;
+	(void) port;
+	(void) public_key;
+	return address != NULL;
+}
+
+void tox_get_address(Tox *tox, uint8_t *address)
+{
+	memcpy(address, tox->address, TOX_FRIEND_ADDRESS_SIZE);
+}
+
+uint32_t tox_get_nospam(Tox *tox)
+{
+	return tox->nospam;
+}
+
+void tox_set_nospam(Tox *tox, uint32_t nospam)
+{
+	tox->nospam = nospam;
+	memcpy(tox->address + TOX_CLIENT_ID_SIZE, &nospam, sizeof(uint32_t));
+}
+
+int32_t tox_add_friend(Tox *tox, uint8_t *address, uint8_t *data, uint16_t length)
+{
+	(void) data;
+
+	if (length == 0) {
+		return -1;
+	}
+
+	return mock_add_friend(tox, address);
+}
+
+int32_t tox_add_friend_norequest(Tox *tox, uint8_t *client_id)
+{
+	return mock_add_friend(tox, client_id);
+}
+
+int tox_get_client_id(Tox *tox, int32_t friendnumber, uint8_t *client_id)
+{
+	if (!mock_friend_valid(tox, friendnumber)) {
+		return -1;
+	}
+
+	memcpy(client_id, tox->friends[friendnumber].client_id, TOX_CLIENT_ID_SIZE);
+	return 0;
+}
+
+int tox_del_friend(Tox *tox, int32_t friendnumber)
+{
+	if (!mock_friend_valid(tox, friendnumber)) {
+		return -1;
+	}
+
+	tox->friends[friendnumber].exists = 0;
+
+	while (tox->friend_count > 0 && !tox->friends[tox->friend_count - 1].exists) {
+		tox->friend_count--;
+	}
+
+	return 0;
+}
+
+int tox_get_friend_connection_status(Tox *tox, int32_t friendnumber)
+{
+	return mock_friend_valid(tox, friendnumber) ? tox->friends[friendnumber].online : -1;
+}
+
+int tox_friend_exists(Tox *tox, int32_t friendnumber)
+{
+	return mock_friend_valid(tox, friendnumber);
+}
+
+static uint32_t mock_send(Tox *tox, int32_t friendnumber, uint32_t length)
+{
+	uint32_t receipt;
+
+	if (!mock_friend_valid(tox, friendnumber) || !tox->friends[friendnumber].online || length == 0
+			|| length > TOX_MAX_MESSAGE_LENGTH) {
+		return 0;
+	}
+
+	receipt = ++tox->next_receipt;
+
+	if (receipt == 0) {
+		receipt = ++tox->next_receipt;
+	}
+
+	tox->counters.sent_messages++;
+	tox->counters.sent_bytes += length;
+
+	if (tox->config.receipts && tox->receipt_count < MOCK_MAX_RECEIPTS) {
+		tox->receipts[tox->receipt_count].friendnumber = friendnumber;
+		tox->receipts[tox->receipt_count].receipt = receipt;
+		tox->receipt_count++;
+	}
+
+	return receipt;
+}
+
+uint32_t tox_send_message(Tox *tox, int32_t friendnumber, uint8_t *message, uint32_t length)
+{
+	(void) message;
+	return mock_send(tox, friendnumber, length);
+}
+
+uint32_t tox_send_action(Tox *tox, int32_t friendnumber, uint8_t *action, uint32_t length)
+{
+	(void) action;
+	return mock_send(tox, friendnumber, length);
+}
+
+int tox_set_name(Tox *tox, uint8_t *name, uint16_t length)
+{
+	if (length > TOX_MAX_NAME_LENGTH) {
+		return -1;
+	}
+
+	memcpy(tox->name, name, length);
+	tox->name_length = length;
+	return 0;
+}
+
+uint16_t tox_get_self_name(Tox *tox, uint8_t *name)
+{
+	memcpy(name, tox->name, tox->name_length);
+	return tox->name_length;
+}
+
+int tox_get_name(Tox *tox, int32_t friendnumber, uint8_t *name)
+{
+	if (!mock_friend_valid(tox, friendnumber)) {
+		return -1;
+	}
+
+	memcpy(name, tox->friends[friendnumber].name, tox->friends[friendnumber].name_length);
+	return tox->friends[friendnumber].name_length;
+}
+
+int tox_set_status_message(Tox *tox, uint8_t *status, uint16_t length)
+{
+	if (length > TOX_MAX_STATUSMESSAGE_LENGTH) {
+		return -1;
+	}
+
+	memcpy(tox->status_message, status, length);
+	tox->status_message_length = length;
+	return 0;
+}
+
+int tox_set_user_status(Tox *tox, uint8_t userstatus)
+{
+	if (userstatus >= TOX_USERSTATUS_INVALID) {
+		return -1;
+	}
+
+	tox->user_status = userstatus;
+	return 0;
+}
+
+int tox_get_status_message_size(Tox *tox, int32_t friendnumber)
+{
+	return mock_friend_valid(tox, friendnumber) ? tox->friends[friendnumber].status_message_length : -1;
+}
+
+int tox_get_status_message(Tox *tox, int32_t friendnumber, uint8_t *buf, uint32_t maxlen)
+{
+	uint32_t length;
+
+	if (!mock_friend_valid(tox, friendnumber)) {
+		return -1;
+	}
+
+	length = tox->friends[friendnumber].status_message_length;
+	length = length < maxlen ? length : maxlen;
+	memcpy(buf, tox->friends[friendnumber].status_message, length);
+	return (int) length;
+}
+
+int tox_get_self_status_message(Tox *tox, uint8_t *buf, uint32_t maxlen)
+{
+	uint32_t length = tox->status_message_length < maxlen ? tox->status_message_length : maxlen;
+
+	memcpy(buf, tox->status_message, length);
+	return (int) length;
+}
+
+uint8_t tox_get_user_status(Tox *tox, int32_t friendnumber)
+{
+	return mock_friend_valid(tox, friendnumber) ? tox->friends[friendnumber].user_status : TOX_USERSTATUS_INVALID;
+}
+
+uint8_t tox_get_self_user_status(Tox *tox)
+{
+	return tox->user_status;
+}
+
+int tox_set_user_is_typing(Tox *tox, int32_t friendnumber, uint8_t is_typing)
+{
+	(void) is_typing;
+	return mock_friend_valid(tox, friendnumber) ? 0 : -1;
+}
+
+uint8_t tox_get_is_typing(Tox *tox, int32_t friendnumber)
+{
+	return mock_friend_valid(tox, friendnumber) ? tox->friends[friendnumber].typing : 0;
+}
+
+uint32_t tox_count_friendlist(Tox *tox)
+{
+	uint32_t i;
+	uint32_t count = 0;
+
+	for (i = 0; i < tox->friend_count; i++) {
+		count += tox->friends[i].exists;
+	}
+
+	return count;
+}
+
+uint32_t tox_get_friendlist(Tox *tox, int32_t *out_list, uint32_t list_size)
+{
+	uint32_t i;
+	uint32_t count = 0;
+
+	for (i = 0; i < tox->friend_count && count < list_size; i++) {
+		if (tox->friends[i].exists) {
+			out_list[count++] = (int32_t) i;
+		}
+	}
+
+	return count;
+}
+
+int tox_group_number_peers(Tox *tox, int groupnumber)
+{
+	(void) tox;
+	(void) groupnumber;
+	return -1;
+}
+
+int tox_group_get_names(Tox *tox, int groupnumber, uint8_t names[][TOX_MAX_NAME_LENGTH], uint16_t lengths[],
+						uint16_t length)
+{
+	(void) tox;
+	(void) groupnumber;
+	(void) names;
+	(void) lengths;
+	(void) length;
+	return -1;
+}
+
+/* Group chats are not simulated; every call fails or reports nothing */
+int tox_add_groupchat(Tox *tox)
+{
+	(void) tox;
+	return -1;
+}
+
+int tox_del_groupchat(Tox *tox, int groupnumber)
+{
+	(void) tox;
+	(void) groupnumber;
+	return -1;
+}
+
+int tox_group_peername(Tox *tox, int groupnumber, int peernumber, uint8_t *name)
+{
+	(void) tox;
+	(void) groupnumber;
+	(void) peernumber;
+	(void) name;
+	return -1;
+}
+
+int tox_invite_friend(Tox *tox, int32_t friendnumber, int groupnumber)
+{
+	(void) tox;
+	(void) friendnumber;
+	(void) groupnumber;
+	return -1;
+}
+
+int tox_join_groupchat(Tox *tox, int32_t friendnumber, uint8_t *friend_group_public_key)
+{
+	(void) tox;
+	(void) friendnumber;
+	(void) friend_group_public_key;
+	return -1;
+}
+
+int tox_group_message_send(Tox *tox, int groupnumber, uint8_t *message, uint32_t length)
+{
+	(void) tox;
+	(void) groupnumber;
+	(void) message;
+	(void) length;
+	return -1;
+}
+
+int tox_group_action_send(Tox *tox, int groupnumber, uint8_t *action, uint32_t length)
+{
+	(void) tox;
+	(void) groupnumber;
+	(void) action;
+	(void) length;
+	return -1;
+}
+
+uint32_t tox_count_chatlist(Tox *tox)
+{
+	(void) tox;
+	return 0;
+}
+
+uint32_t tox_get_chatlist(Tox *tox, int *out_list, uint32_t list_size)
+{
+	(void) tox;
+	(void) out_list;
+	(void) list_size;
+	return 0;
+}
+
+void tox_callback_group_invite(Tox *tox, void (*function)(Tox *tox, int32_t, uint8_t *, void *), void *userdata)
+{
+	(void) tox;
+	(void) function;
+	(void) userdata;
+}
+
+void tox_callback_group_message(Tox *tox, void (*function)(Tox *tox, int, int, uint8_t *, uint16_t, void *),
+								void *userdata)
+{
+	(void) tox;
+	(void) function;
+	(void) userdata;
+}
+
+void tox_callback_group_action(Tox *tox, void (*function)(Tox *tox, int, int, uint8_t *, uint16_t, void *),
+							   void *userdata)
+{
+	(void) tox;
+	(void) function;
+	(void) userdata;
+}
+
+void tox_callback_group_namelist_change(Tox *tox, void (*function)(Tox *tox, int, int, uint8_t, void *),
+										void *userdata)
+{
+	(void) tox;
+	(void) function;
+	(void) userdata;
+}
+
+int tox_new_file_sender(Tox *tox, int32_t friendnumber, uint64_t filesize, uint8_t *filename,
+						uint16_t filename_length)
+{
+	mock_friend_t *f;
+
+	(void) filesize;
+	(void) filename;
+	(void) filename_length;
+
+	if (!mock_friend_valid(tox, friendnumber) || tox->accepted_count == MOCK_MAX_FILES) {
+		return -1;
+	}
+
+	f = &tox->friends[friendnumber];
+	tox->accepted[tox->accepted_count].friendnumber = friendnumber;
+	tox->accepted[tox->accepted_count].filenumber = f->next_file;
+	tox->accepted_count++;
+	return f->next_file++;
+}
+
+int tox_file_send_control(Tox *tox, int32_t friendnumber, uint8_t send_receive, uint8_t filenumber,
+						  uint8_t message_id, uint8_t *data, uint16_t length)
+{
+	(void) send_receive;
+	(void) filenumber;
+	(void) message_id;
+	(void) data;
+	(void) length;
+	return mock_friend_valid(tox, friendnumber) ? 0 : -1;
+}
+
+int tox_file_send_data(Tox *tox, int32_t friendnumber, uint8_t filenumber, uint8_t *data, uint16_t length)
+{
+	(void) filenumber;
+	(void) data;
+
+	if (!mock_friend_valid(tox, friendnumber)) {
+		return -1;
+	}
+
+	tox->counters.sent_file_bytes += length;
+	return 0;
+}
+
+int tox_file_data_size(Tox *tox, int32_t friendnumber)
+{
+	return mock_friend_valid(tox, friendnumber) ? (int) tox->config.file_chunk : -1;
+}
+
+uint64_t tox_file_data_remaining(Tox *tox, int32_t friendnumber, uint8_t filenumber, uint8_t send_receive)
+{
+	(void) tox;
+	(void) friendnumber;
+	(void) filenumber;
+	(void) send_receive;
+	return 0;
+}
+
+/*
+ * Saved state: magic, nospam, name length and name, status message length and message, user status,
+ * friend count and client ids. Little endian is assumed, saves are not meant to leave the machine.
+ */
+uint32_t tox_size(Tox *tox)
+{
+	return 4 + 4 + 2 + tox->name_length + 2 + tox->status_message_length + 1 + 4
+		   + tox_count_friendlist(tox) * TOX_CLIENT_ID_SIZE;
+}
+
+void tox_save(Tox *tox, uint8_t *data)
+{
+	uint32_t count = tox_count_friendlist(tox);
+	uint32_t i;
+
+	memcpy(data, MOCK_SAVE_MAGIC, 4);
+	data += 4;
+	memcpy(data, &tox->nospam, 4);
+	data += 4;
+	memcpy(data, &tox->name_length, 2);
+	memcpy(data + 2, tox->name, tox->name_length);
+	data += 2 + tox->name_length;
+	memcpy(data, &tox->status_message_length, 2);
+	memcpy(data + 2, tox->status_message, tox->status_message_length);
+	data += 2 + tox->status_message_length;
+	*data++ = tox->user_status;
+	memcpy(data, &count, 4);
+	data += 4;
+
+	for (i = 0; i < tox->friend_count; i++) {
+		if (tox->friends[i].exists) {
+			memcpy(data, tox->friends[i].client_id, TOX_CLIENT_ID_SIZE);
+			data += TOX_CLIENT_ID_SIZE;
+		}
+	}
+}
+
+int tox_load(Tox *tox, uint8_t *data, uint32_t length)
+{
+	uint8_t *end = data + length;
+	uint16_t name_length;
+	uint16_t status_length;
+	uint32_t nospam;
+	uint32_t count;
+	uint32_t i;
+
+	if (length < 4 + 4 + 2 || memcmp(data, MOCK_SAVE_MAGIC, 4) != 0) {
+		return -1;
+	}
+
+	memcpy(&nospam, data + 4, 4);
+	memcpy(&name_length, data + 8, 2);
+	data += 10;
+
+	if (name_length > TOX_MAX_NAME_LENGTH || end - data < name_length + 2) {
+		return -1;
+	}
+
+	memcpy(tox->name, data, name_length);
+	tox->name_length = name_length;
+	data += name_length;
+	memcpy(&status_length, data, 2);
+	data += 2;
+
+	if (status_length > TOX_MAX_STATUSMESSAGE_LENGTH || end - data < status_length + 1 + 4) {
+		return -1;
+	}
+
+	memcpy(tox->status_message, data, status_length);
+	tox->status_message_length = status_length;
+	data += status_length;
+	tox->user_status = *data++;
+	memcpy(&count, data, 4);
+	data += 4;
+
+	if ((uint64_t) (end - data) < (uint64_t) count * TOX_CLIENT_ID_SIZE) {
+		return -1;
+	}
+
+	tox_set_nospam(tox, nospam);
+
+	for (i = 0; i < count; i++) {
+		mock_add_friend(tox, data + i * TOX_CLIENT_ID_SIZE);
+	}
+
+	return 0;
+}
+
+void tox_callback_friend_request(Tox *tox, void (*function)(Tox *tox, uint8_t *, uint8_t *, uint16_t, void *),
+								 void *userdata)
+{
+	tox->friend_request = function;
+	tox->friend_request_data = userdata;
+}
+
+void tox_callback_friend_message(Tox *tox, void (*function)(Tox *tox, int, uint8_t *, uint16_t, void *),
+								 void *userdata)
+{
+	tox->friend_message = function;
+	tox->friend_message_data = userdata;
+}
+
+void tox_callback_friend_action(Tox *tox, void (*function)(Tox *tox, int32_t, uint8_t *, uint16_t, void *),
+								void *userdata)
+{
+	tox->friend_action = function;
+	tox->friend_action_data = userdata;
+}
+
+void tox_callback_name_change(Tox *tox, void (*function)(Tox *tox, int32_t, uint8_t *, uint16_t, void *),
+							  void *userdata)
+{
+	tox->name_change = function;
+	tox->name_change_data = userdata;
+}
+
+void tox_callback_status_message(Tox *tox, void (*function)(Tox *tox, int32_t, uint8_t *, uint16_t, void *),
+								 void *userdata)
+{
+	tox->status_message_change = function;
+	tox->status_message_data = userdata;
+}
+
+void tox_callback_user_status(Tox *tox, void (*function)(Tox *tox, int32_t, uint8_t, void *), void *userdata)
+{
+	tox->user_status_change = function;
+	tox->user_status_data = userdata;
+}
+
+void tox_callback_typing_change(Tox *tox, void (*function)(Tox *tox, int32_t, uint8_t, void *), void *userdata)
+{
+	tox->typing_change = function;
+	tox->typing_change_data = userdata;
+}
+
+void tox_callback_read_receipt(Tox *tox, void (*function)(Tox *tox, int32_t, uint32_t, void *), void *userdata)
+{
+	tox->read_receipt = function;
+	tox->read_receipt_data = userdata;
+}
+
+void tox_callback_connection_status(Tox *tox, void (*function)(Tox *tox, int32_t, uint8_t, void *), void *userdata)
+{
+	tox->connection_status = function;
+	tox->connection_status_data = userdata;
+}
+
+void tox_callback_file_send_request(Tox *tox, void (*function)(Tox *m, int32_t, uint8_t, uint64_t, uint8_t *,
+									uint16_t, void *), void *userdata)
+{
+	tox->file_send_request = function;
+	tox->file_send_request_data = userdata;
+}
+
+void tox_callback_file_control(Tox *tox, void (*function)(Tox *m, int32_t, uint8_t, uint8_t, uint8_t, uint8_t *,
+							   uint16_t, void *), void *userdata)
+{
+	tox->file_control = function;
+	tox->file_control_data = userdata;
+}
+
+void tox_callback_file_data(Tox *tox, void (*function)(Tox *m, int32_t, uint8_t, uint8_t *, uint16_t length, void *),
+							void *userdata)
+{
+	tox->file_data = function;
+	tox->file_data_data = userdata;
+}
+
+/*
+ * A/V. Calls only exist as state: frames are generated for every active call, and whatever the
+ * binding sends is counted and dropped.
+ */
+static void mock_callstate(ToxAv *av, int32_t call_index, ToxAvCallbackID id)
+{
+	if (av->callstate[id] != NULL) {
+		av->callstate[id](av, call_index, av->callstate_data[id]);
+	}
+}
+
+static int mock_call_valid(ToxAv *av, int32_t call_index)
+{
+	return call_index >= 0 && call_index < av->max_calls;
+}
+
+static void mock_do_av(ToxAv *av, double seconds)
+{
+	Tox *tox = av->tox;
+	uint32_t frames;
+	uint32_t n;
+	int32_t i;
+
+	/* Incoming calls are offered once, after the first friends came online */
+	if (!tox->calls_offered) {
+		tox->calls_offered = 1;
+
+		for (i = 0; i < (int32_t) tox->config.calls && i < av->max_calls; i++) {
+			av->calls[i].state = av_CallInviting;
+			av->calls[i].incoming = 1;
+			mock_callstate(av, i, av_OnInvite);
+		}
+	}
+
+	for (i = 0; i < av->max_calls; i++) {
+		if (av->calls[i].ringing) {
+			av->calls[i].ringing = 0;
+			av->calls[i].state = av_CallActive;
+			mock_callstate(av, i, av_OnStarting);
+		}
+	}
+
+	frames = mock_due(&tox->owed_audio, tox->config.audio_rate, seconds);
+
+	for (n = 0; n < frames; n++) {
+		for (i = 0; i < av->max_calls; i++) {
+			if (av->calls[i].state == av_CallActive && av->audio != NULL) {
+				tox->counters.audio_frames++;
+				av->audio(av, i, av->pcm, (int) tox->config.audio_samples, av->audio_data);
+			}
+		}
+	}
+
+	frames = mock_due(&tox->owed_video, tox->config.video_rate, seconds);
+
+	for (n = 0; n < frames; n++) {
+		for (i = 0; i < av->max_calls; i++) {
+			if (av->calls[i].state == av_CallActive && av->video != NULL && av->image != NULL) {
+				/* Change the picture a little every frame, like a camera would */
+				av->image->planes[VPX_PLANE_Y][tox->counters.video_frames % (av->image->stride[VPX_PLANE_Y] * av->image->d_h)]++;
+				tox->counters.video_frames++;
+				av->video(av, i, av->image, av->video_data);
+			}
+		}
+	}
+}
+
+ToxAv *toxav_new(Tox *messenger, int32_t max_calls)
+{
+	ToxAv *av = calloc(1, sizeof(ToxAv));
+	unsigned width = messenger->config.video_width;
+	unsigned height = messenger->config.video_height;
+	unsigned plane;
+	size_t i;
+
+	if (av == NULL) {
+		return NULL;
+	}
+
+	av->tox = messenger;
+	av->max_calls = max_calls < MOCK_MAX_CALLS ? max_calls : MOCK_MAX_CALLS;
+	av->pcm = calloc(messenger->config.audio_samples ? messenger->config.audio_samples : 1, sizeof(int16_t));
+
+	for (i = 0; i < messenger->config.audio_samples; i++) {
+		/* Sawtooth, audible enough to tell it is not silence */
+		av->pcm[i] = (int16_t) ((i * 512) & 0x7FFF);
+	}
+
+	if (width > 0 && height > 0) {
+		av->image = vpx_img_alloc(NULL, VPX_IMG_FMT_I420, width, height, 1);
+	}
+
+	if (av->image != NULL) {
+		for (plane = 0; plane < 3; plane++) {
+			unsigned rows = plane == VPX_PLANE_Y ? height : (height + 1) / 2;
+			memset(av->image->planes[plane], plane == VPX_PLANE_Y ? 0x80 : 0x40, av->image->stride[plane] * rows);
+		}
+	}
+
+	messenger->av = av;
+	return av;
+}
+
+void toxav_kill(ToxAv *av)
+{
+	if (av == NULL) {
+		return;
+	}
+
+	av->tox->av = NULL;
+
+	if (av->image != NULL) {
+		vpx_img_free(av->image);
+	}
+
+	free(av->pcm);
+	free(av);
+}
+
+void toxav_register_callstate_callback(ToxAv *av, ToxAVCallback cb, ToxAvCallbackID id, void *userdata)
+{
+	av->callstate[id] = cb;
+	av->callstate_data[id] = userdata;
+}
+
+void toxav_register_audio_recv_callback(ToxAv *av, void (*cb)(ToxAv *, int32_t, int16_t *, int, void *),
+										void *userdata)
+{
+	av->audio = cb;
+	av->audio_data = userdata;
+}
+
+void toxav_register_video_recv_callback(ToxAv *av, void (*cb)(ToxAv *, int32_t, vpx_image_t *, void *),
+										void *userdata)
+{
+	av->video = cb;
+	av->video_data = userdata;
+}
+
+int toxav_call(ToxAv *av, int32_t *call_index, int user, const ToxAvCSettings *csettings, int ringing_seconds)
+{
+	int32_t i;
+
+	(void) ringing_seconds;
+
+	if (!mock_friend_valid(av->tox, user)) {
+		return -1;
+	}
+
+	for (i = 0; i < av->max_calls; i++) {
+		if (av->calls[i].state == av_CallNonExistant || av->calls[i].state == av_CallHanged_up) {
+			av->calls[i].state = av_CallStarting;
+			av->calls[i].incoming = 0;
+			av->calls[i].ringing = 1;
+			av->calls[i].settings = *csettings;
+			*call_index = i;
+			mock_callstate(av, i, av_OnRinging);
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+static int mock_end_call(ToxAv *av, int32_t call_index)
+{
+	if (!mock_call_valid(av, call_index) || av->calls[call_index].state == av_CallNonExistant) {
+		return -1;
+	}
+
+	av->calls[call_index].state = av_CallHanged_up;
+	av->calls[call_index].ringing = 0;
+	return 0;
+}
+
+int toxav_hangup(ToxAv *av, int32_t call_index)
+{
+	return mock_end_call(av, call_index);
+}
+
+int toxav_answer(ToxAv *av, int32_t call_index, const ToxAvCSettings *csettings)
+{
+	if (!mock_call_valid(av, call_index) || av->calls[call_index].state != av_CallInviting) {
+		return -1;
+	}
+
+	av->calls[call_index].state = av_CallActive;
+	av->calls[call_index].settings = *csettings;
+	mock_callstate(av, call_index, av_OnStart);
+	return 0;
+}
+
+int toxav_reject(ToxAv *av, int32_t call_index, const char *reason)
+{
+	(void) reason;
+	return mock_end_call(av, call_index);
+}
+
+int toxav_cancel(ToxAv *av, int32_t call_index, int peer_id, const char *reason)
+{
+	(void) peer_id;
+	(void) reason;
+	return mock_end_call(av, call_index);
+}
+
+int toxav_change_settings(ToxAv *av, int32_t call_index, const ToxAvCSettings *csettings)
+{
+	if (!mock_call_valid(av, call_index)) {
+		return -1;
+	}
+
+	av->calls[call_index].settings = *csettings;
+	return 0;
+}
+
+int toxav_stop_call(ToxAv *av, int32_t call_index)
+{
+	return mock_end_call(av, call_index);
+}
+
+int toxav_prepare_transmission(ToxAv *av, int32_t call_index, uint32_t jbuf_size, uint32_t VAD_treshold,
+							   int support_video)
+{
+	(void) jbuf_size;
+	(void) VAD_treshold;
+	(void) support_video;
+	return mock_call_valid(av, call_index) ? 0 : -1;
+}
+
+int toxav_kill_transmission(ToxAv *av, int32_t call_index)
+{
+	return mock_call_valid(av, call_index) ? 0 : -1;
+}
+
+/* "Encoding" copies a tenth of the picture, which is in the range of what vp8 produces */
+int toxav_prepare_video_frame(ToxAv *av, int32_t call_index, uint8_t *dest, int dest_max, vpx_image_t *input)
+{
+	int size;
+
+	if (!mock_call_valid(av, call_index) || dest_max <= 0) {
+		return -1;
+	}
+
+	size = (int) (input->d_w * input->d_h / 10);
+	size = size < dest_max ? size : dest_max;
+	memcpy(dest, input->planes[VPX_PLANE_Y], (size_t) size);
+	return size;
+}
+
+int toxav_send_video(ToxAv *av, int32_t call_index, const uint8_t *frame, int frame_size)
+{
+	(void) frame;
+
+	if (!mock_call_valid(av, call_index)) {
+		return -1;
+	}
+
+	av->tox->counters.sent_video_bytes += (uint64_t) frame_size;
+	return 0;
+}
+
+/* Opus at 64 kbit/s turns 20 ms of 48 kHz mono into about 160 bytes */
+int toxav_prepare_audio_frame(ToxAv *av, int32_t call_index, uint8_t *dest, int dest_max, const int16_t *frame,
+							  int frame_size)
+{
+	int size = frame_size / 6;
+
+	if (!mock_call_valid(av, call_index) || dest_max <= 0) {
+		return -1;
+	}
+
+	size = size < dest_max ? size : dest_max;
+	memcpy(dest, frame, (size_t) size);
+	return size;
+}
+
+int toxav_send_audio(ToxAv *av, int32_t call_index, const uint8_t *frame, int size)
+{
+	(void) frame;
+
+	if (!mock_call_valid(av, call_index)) {
+		return -1;
+	}
+
+	av->tox->counters.sent_audio_bytes += (uint64_t) size;
+	return 0;
+}
+
+int toxav_get_peer_csettings(ToxAv *av, int32_t call_index, int peer, ToxAvCSettings *dest)
+{
+	(void) peer;
+
+	if (!mock_call_valid(av, call_index) || av->calls[call_index].state == av_CallNonExistant) {
+		return -1;
+	}
+
+	*dest = av->calls[call_index].settings;
+	return 0;
+}
+
+int toxav_get_peer_id(ToxAv *av, int32_t call_index, int peer)
+{
+	(void) peer;
+	return mock_call_valid(av, call_index) ? 0 : -1;
+}
+
+ToxAvCallState toxav_get_call_state(ToxAv *av, int32_t call_index)
+{
+	return mock_call_valid(av, call_index) ? av->calls[call_index].state : av_CallNonExistant;
+}
+
+int toxav_capability_supported(ToxAv *av, int32_t call_index, ToxAvCapabilities capability)
+{
+	(void) capability;
+	return mock_call_valid(av, call_index);
+}
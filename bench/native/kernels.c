@@ -0,0 +1,277 @@
+/* kernels.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tox/tox.h>
+#include <tox/toxav.h>
+#include <jni.h>
+
+#include "utils.h"
+#include "yuv.h"
+
+/*
+ * Microbenchmarks for the conversion kernels of the binding, linked against the library itself.
+ * Every kernel is calibrated to run for about SAMPLE_NS per sample, and the result of SAMPLES
+ * samples is written as JSON to stdout, or to the file given with -o.
+ *
+ * codec_settings_to_native needs a JVM and the jToxcore jar, it is only measured when the jar is
+ * given with -j.
+ */
+#define SAMPLES 7
+#define SAMPLE_NS 200000000ULL
+#define WARMUP_NS 100000000ULL
+
+/* Defined in JTox.c */
+void addr_to_hex(uint8_t *, char *);
+
+typedef void (*kernel_t)(void *);
+
+typedef struct {
+	vpx_image_t *img;
+	uint8_t *yv12;
+} video_args_t;
+
+typedef struct {
+	JNIEnv *env;
+	jobject settings;
+} settings_args_t;
+
+static int first_result = 1;
+
+static void kernel_vpx_to_yv12(void *arg)
+{
+	video_args_t *args = arg;
+	yuv_vpx_to_yv12(args->img, args->yv12);
+}
+
+static void kernel_yv12_to_vpx(void *arg)
+{
+	video_args_t *args = arg;
+	yuv_yv12_to_vpx(args->yv12, args->img);
+}
+
+static void kernel_addr_to_hex(void *arg)
+{
+	static char hex[TOX_FRIEND_ADDRESS_SIZE * 2 + 1];
+	addr_to_hex(arg, hex);
+}
+
+static void kernel_codec_settings_to_native(void *arg)
+{
+	settings_args_t *args = arg;
+	JNIEnv *env = args->env;
+
+	/* The conversion does not release its local references */
+	(*env)->PushLocalFrame(env, 16);
+	codec_settings_to_native(env, args->settings);
+	(*env)->PopLocalFrame(env, NULL);
+}
+
+static uint64_t run(kernel_t kernel, void *arg, uint64_t iterations)
+{
+	uint64_t start = monotonic_time_ns();
+	uint64_t i;
+
+	for (i = 0; i < iterations; i++) {
+		kernel(arg);
+	}
+
+	return monotonic_time_ns() - start;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+	double x = *(const double *) a;
+	double y = *(const double *) b;
+	return (x > y) - (x < y);
+}
+
+static void measure(FILE *out, const char *name, kernel_t kernel, void *arg, uint64_t bytes_per_op)
+{
+	double samples[SAMPLES];
+	uint64_t iterations = 1;
+	uint64_t elapsed;
+	int i;
+
+	/* Double the iterations until a batch takes long enough, which also warms up caches */
+	while ((elapsed = run(kernel, arg, iterations)) < WARMUP_NS / 8) {
+		iterations *= 2;
+	}
+
+	iterations = iterations * SAMPLE_NS / (elapsed ? elapsed : 1) + 1;
+
+	for (i = 0; i < SAMPLES; i++) {
+		samples[i] = (double) run(kernel, arg, iterations) / iterations;
+	}
+
+	fprintf(out, "%s\n    {\"name\": \"%s\", \"unit\": \"ns/op\", \"iterations\": %llu, \"samples\": [",
+			first_result ? "" : ",", name, (unsigned long long) iterations);
+	first_result = 0;
+
+	for (i = 0; i < SAMPLES; i++) {
+		fprintf(out, "%s%.2f", i ? ", " : "", samples[i]);
+	}
+
+	qsort(samples, SAMPLES, sizeof(double), compare_double);
+	fprintf(out, "], \"min\": %.2f, \"median\": %.2f", samples[0], samples[SAMPLES / 2]);
+
+	if (bytes_per_op) {
+		fprintf(out, ", \"mb_per_s\": %.1f", bytes_per_op * 1000.0 / samples[SAMPLES / 2]);
+	}
+
+	fprintf(out, "}");
+	fflush(out);
+}
+
+static void measure_video(FILE *out, unsigned int width, unsigned int height)
+{
+	video_args_t args;
+	char name[64];
+	size_t size = yuv_yv12_size(width, height);
+	size_t i;
+
+	args.img = vpx_img_alloc(NULL, VPX_IMG_FMT_I420, width, height, 1);
+	args.yv12 = malloc(size);
+
+	if (args.img == NULL || args.yv12 == NULL) {
+		fprintf(stderr, "Could not allocate a %ux%u frame\n", width, height);
+		exit(1);
+	}
+
+	for (i = 0; i < size; i++) {
+		args.yv12[i] = (uint8_t) (i * 31);
+	}
+
+	yuv_yv12_to_vpx(args.yv12, args.img);
+
+	snprintf(name, sizeof(name), "yv12_from_vpx_%ux%u", width, height);
+	measure(out, name, kernel_vpx_to_yv12, &args, size);
+	snprintf(name, sizeof(name), "yv12_to_vpx_%ux%u", width, height);
+	measure(out, name, kernel_yv12_to_vpx, &args, size);
+
+	vpx_img_free(args.img);
+	free(args.yv12);
+}
+
+static int measure_codec_settings(FILE *out, const char *jar)
+{
+	JavaVM *jvm;
+	JavaVMInitArgs vm_args;
+	JavaVMOption option;
+	settings_args_t args;
+	jclass type_class;
+	jclass settings_class;
+	jobject type;
+	char *classpath = malloc(strlen(jar) + sizeof("-Djava.class.path="));
+
+	if (classpath == NULL) {
+		return -1;
+	}
+
+	sprintf(classpath, "-Djava.class.path=%s", jar);
+	option.optionString = classpath;
+	vm_args.version = JNI_VERSION_1_6;
+	vm_args.nOptions = 1;
+	vm_args.options = &option;
+	vm_args.ignoreUnrecognized = JNI_FALSE;
+
+	if (JNI_CreateJavaVM(&jvm, (void **) &args.env, &vm_args) != JNI_OK) {
+		fprintf(stderr, "Could not create a JVM\n");
+		free(classpath);
+		return -1;
+	}
+
+	free(classpath);
+	type_class = (*args.env)->FindClass(args.env, "im/tox/jtoxcore/ToxCallType");
+	settings_class = (*args.env)->FindClass(args.env, "im/tox/jtoxcore/ToxCodecSettings");
+
+	if (type_class == NULL || settings_class == NULL) {
+		fprintf(stderr, "%s does not contain the jToxcore classes\n", jar);
+		(*jvm)->DestroyJavaVM(jvm);
+		return -1;
+	}
+
+	type = (*args.env)->GetStaticObjectField(args.env, type_class,
+			(*args.env)->GetStaticFieldID(args.env, type_class, "TYPE_VIDEO", "Lim/tox/jtoxcore/ToxCallType;"));
+	args.settings = (*args.env)->NewObject(args.env, settings_class,
+										   (*args.env)->GetMethodID(args.env, settings_class, "<init>",
+												   "(Lim/tox/jtoxcore/ToxCallType;IIIIIII)V"),
+										   type, 500, 1280, 720, 64000, 20, 48000, 1);
+
+	if (args.settings == NULL) {
+		fprintf(stderr, "Could not create a ToxCodecSettings\n");
+		(*args.env)->ExceptionDescribe(args.env);
+		(*jvm)->DestroyJavaVM(jvm);
+		return -1;
+	}
+
+	measure(out, "codec_settings_to_native", kernel_codec_settings_to_native, &args, 0);
+	(*jvm)->DestroyJavaVM(jvm);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	FILE *out = stdout;
+	const char *jar = NULL;
+	uint8_t address[TOX_FRIEND_ADDRESS_SIZE];
+	int result = 0;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			out = fopen(argv[++i], "w");
+
+			if (out == NULL) {
+				perror(argv[i]);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			jar = argv[++i];
+		} else {
+			fprintf(stderr, "Usage: %s [-o results.json] [-j jToxcore.jar]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	for (i = 0; i < (int) TOX_FRIEND_ADDRESS_SIZE; i++) {
+		address[i] = (uint8_t) (i * 97);
+	}
+
+	fprintf(out, "{\n  \"harness\": \"jtoxcore-kernels\",\n  \"benchmarks\": [");
+	measure_video(out, 320, 240);
+	measure_video(out, 640, 480);
+	measure_video(out, 1280, 720);
+	measure(out, "addr_to_hex", kernel_addr_to_hex, address, 0);
+
+	if (jar != NULL) {
+		result = measure_codec_settings(out, jar);
+	}
+
+	fprintf(out, "\n  ]\n}\n");
+
+	if (out != stdout) {
+		fclose(out);
+	}
+
+	return result ? 1 : 0;
+}
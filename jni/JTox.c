@@ -31,11 +31,25 @@
 #include <tox/toxav.h>
 
 #include "JTox.h"
-#include "callbacks.h"
 #include "types.h"
+#include "callbacks.h"
 #include "utils.h"
+#include "utf8.h"
+#include "bitrate.h"
+#include "filesched.h"
+#include "journal.h"
+#include "mediastats.h"
+#include "presence.h"
+#include "reqfilter.h"
+#include "roster.h"
+#include "state.h"
+#include "timeline.h"
+#include "stats.h"
+#include "trace.h"
+#include "yuv.h"
 
 #define ADDR_SIZE_HEX (TOX_FRIEND_ADDRESS_SIZE * 2 + 1)
+#define CLIENT_ID_SIZE_HEX (TOX_CLIENT_ID_SIZE * 2 + 1)
 #define UNUSED(x) (void)(x)
 
 #ifdef ANDROID
@@ -44,7 +58,6 @@
 #define ATTACH_THREAD(ptr,env) (*ptr->jvm)->AttachCurrentThread(ptr->jvm, (void **) &env, 0)
 #endif
 
-#define ALIGN(x, y) y*((x + (y-1))/y)
 /**
  * Begin Utilities section
  */
@@ -55,13 +68,17 @@ Tox_Options tox_options_to_native(JNIEnv *env, jobject tox_options);
  */
 void addr_to_hex(uint8_t *addr, char *buf)
 {
-	uint32_t i;
+	bytes_to_hex(addr, TOX_FRIEND_ADDRESS_SIZE, buf);
+}
 
-	for (i = 0; i < TOX_FRIEND_ADDRESS_SIZE; i++) {
-		char xx[3];
-		snprintf(xx, sizeof(xx), "%02X", addr[i] & 0xff);
-		strcat(buf, xx);
-	}
+/**
+ * Create a new java byte array holding a copy of the given native buffer
+ */
+static jbyteArray bytes_to_java(JNIEnv *env, const uint8_t *data, jsize length)
+{
+	jbyteArray result = (*env)->NewByteArray(env, length);
+	(*env)->SetByteArrayRegion(env, result, 0, length, (const jbyte *) data);
+	return result;
 }
 
 /**
@@ -76,6 +93,7 @@ void addr_to_hex(uint8_t *addr, char *buf)
 
 jint JNI_OnLoad(JavaVM* jvm, void* aReserved)
 {
+    uint64_t onload_start = monotonic_time_us();
     cache = malloc(sizeof(cachedId));
     JNIEnv *env;
 
@@ -92,11 +110,11 @@ jint JNI_OnLoad(JavaVM* jvm, void* aReserved)
                                       "(IIILim/tox/jtoxcore/ToxFileControl;[B)V");
     cache->onFileDataMethodId = (*env)->GetMethodID(env, handlerclass, "onFileData", "(II[B)V");
     cache->onFileSendRequestMethodId = (*env)->GetMethodID(env, handlerclass, "onFileSendRequest", "(IIJ[B)V");
-    cache->onFriendRequestMethodId = (*env)->GetMethodID(env, handlerclass, "onFriendRequest", "(Ljava/lang/String;[B)V");
-    cache->onMessageMethodId = (*env)->GetMethodID(env, handlerclass, "onMessage", "(I[B)V");
-    cache->onActionMethodId = (*env)->GetMethodID(env, handlerclass, "onAction", "(I[B)V");
-    cache->onNameChangeMethodId = (*env)->GetMethodID(env, handlerclass, "onNameChange", "(I[B)V");
-    cache->onStatusMessageMethodId = (*env)->GetMethodID(env, handlerclass, "onStatusMessage", "(I[B)V");
+    cache->onFriendRequestMethodId = (*env)->GetMethodID(env, handlerclass, "onFriendRequest", "([B[B)V");
+    cache->onMessageMethodId = (*env)->GetMethodID(env, handlerclass, "onMessage", "(II)V");
+    cache->onActionMethodId = (*env)->GetMethodID(env, handlerclass, "onAction", "(II)V");
+    cache->onNameChangeMethodId = (*env)->GetMethodID(env, handlerclass, "onNameChange", "(II)V");
+    cache->onStatusMessageMethodId = (*env)->GetMethodID(env, handlerclass, "onStatusMessage", "(II)V");
     cache->onUserStatusMethodId = (*env)->GetMethodID(env, handlerclass, "onUserStatus",
                                                       "(ILim/tox/jtoxcore/ToxUserStatus;)V");
     cache->onReadReceiptMethodId = (*env)->GetMethodID(env, handlerclass, "onReadReceipt", "(II)V");
@@ -106,13 +124,57 @@ jint JNI_OnLoad(JavaVM* jvm, void* aReserved)
                                                      "onAudioData", "(I[B)V");
     cache->onVideoDataMethodId = (*env)->GetMethodID(env, handlerclass,
                                                      "onVideoData", "(I[BII)V");
+    cache->onGroupInviteMethodId = (*env)->GetMethodID(env, handlerclass, "onGroupInvite", "(I[B)V");
+    cache->onGroupMessageMethodId = (*env)->GetMethodID(env, handlerclass, "onGroupMessage", "(III)V");
+    cache->onGroupActionMethodId = (*env)->GetMethodID(env, handlerclass, "onGroupAction", "(III)V");
+    cache->onGroupNamelistChangeMethodId = (*env)->GetMethodID(env, handlerclass, "onGroupNamelistChange", "(III)V");
     cache->onAvCallbackMethodId = (*env)->GetMethodID(env, handlerclass, "onAvCallback", "(ILim/tox/jtoxcore/ToxAvCallbackID;)V");
+    cache->eventBufferFieldId = (*env)->GetFieldID(env, handlerclass, "eventBuffer", "Ljava/nio/ByteBuffer;");
+    cache->presenceBufferFieldId = (*env)->GetFieldID(env, (*env)->FindClass(env, "im/tox/jtoxcore/JTox"),
+                                                      "presenceBuffer", "Ljava/nio/ByteBuffer;");
+    codec_settings_cache(env);
 
+    timeline_onload(onload_start, monotonic_time_us());
     return JNI_VERSION_1_6;
 }
 
+/**
+ * Point the JTox presenceBuffer field at the roster's memory. Has to be called again whenever
+ * the roster moves, which only happens in callbacks, while the JTox lock is held.
+ */
+static int publish_roster(JNIEnv *env, tox_jni_globals_t *globals)
+{
+	jobject buffer = (*env)->NewDirectByteBuffer(env, roster_buffer(globals->roster),
+					 (jlong) roster_size(globals->roster));
+
+	if (buffer == NULL) {
+		return -1;
+	}
+
+	(*env)->SetObjectField(env, globals->jtox, globals->cache->presenceBufferFieldId, buffer);
+	(*env)->DeleteLocalRef(env, buffer);
+	return 0;
+}
+
+/**
+ * Free everything tox_new built around the messenger. Any of the modules may still be NULL.
+ */
+static void globals_free(JNIEnv *env, tox_jni_globals_t *globals)
+{
+	filesched_free(globals->file_scheduler);
+	journal_free(globals->journal);
+	reqfilter_free(globals->request_filter);
+	presence_free(globals->presence);
+	roster_free(globals->roster);
+	timeline_free(globals->timeline);
+	(*env)->DeleteGlobalRef(env, globals->handler);
+	(*env)->DeleteGlobalRef(env, globals->jtox);
+	free(globals);
+}
+
 JNIEXPORT jlong JNICALL Java_im_tox_jtoxcore_JTox_tox_1new(JNIEnv *env, jobject jobj, jobject tox_options)
 {
+	STATS_ENTRY(TOX_NEW);
 	tox_jni_globals_t *globals = malloc(sizeof(tox_jni_globals_t));
 	JavaVM *jvm;
     Tox_Options tox_options_native;
@@ -121,13 +183,54 @@ JNIEXPORT jlong JNICALL Java_im_tox_jtoxcore_JTox_tox_1new(JNIEnv *env, jobject
 	jobject handler = (*env)->GetObjectField(env, jobj, id);
 	jobject handlerRef = (*env)->NewGlobalRef(env, handler);
 	jobject jtoxRef = (*env)->NewGlobalRef(env, jobj);
+	jobject eventBuffer;
+	uint64_t start;
 	(*env)->GetJavaVM(env, &jvm);
-    tox_options_native = tox_options_to_native(env, tox_options);
-	globals->tox = tox_new(&tox_options_native);
+
+	if (globals == NULL) {
+		(*env)->DeleteGlobalRef(env, handlerRef);
+		(*env)->DeleteGlobalRef(env, jtoxRef);
+		return 0;
+	}
+
 	globals->jvm = jvm;
 	globals->handler = handlerRef;
 	globals->jtox = jtoxRef;
     globals->cache = cache;
+	/* Every incoming request goes through the filter, so there is no instance without one */
+	globals->request_filter = reqfilter_new(monotonic_time_ns() ^ (uint64_t) (intptr_t) globals);
+	globals->timeline = timeline_new();
+	globals->file_scheduler = filesched_new();
+	globals->journal = journal_new();
+	globals->presence = presence_new();
+	globals->roster = roster_new();
+
+	if (globals->request_filter == NULL || globals->timeline == NULL || globals->file_scheduler == NULL
+			|| globals->journal == NULL || globals->presence == NULL || globals->roster == NULL) {
+		globals_free(env, globals);
+		return 0;
+	}
+
+    tox_options_native = tox_options_to_native(env, tox_options);
+	start = monotonic_time_us();
+	globals->tox = tox_new(&tox_options_native);
+	timeline_mark(globals->timeline, TIMELINE_TOX_NEW, TIMELINE_NO_FRIEND, start, monotonic_time_us());
+
+	if (globals->tox == NULL) {
+		globals_free(env, globals);
+		return 0;
+	}
+
+	if (publish_roster(env, globals) != 0) {
+		tox_kill(globals->tox);
+		globals_free(env, globals);
+		return 0;
+	}
+
+	eventBuffer = (*env)->GetObjectField(env, handler, cache->eventBufferFieldId);
+	globals->event_buffer = (*env)->GetDirectBufferAddress(env, eventBuffer);
+	globals->event_buffer_capacity = (*env)->GetDirectBufferCapacity(env, eventBuffer);
+	globals->dirty = 1;
 
 	tox_callback_friend_action(globals->tox, callback_action, globals);
 
@@ -153,36 +256,146 @@ JNIEXPORT jlong JNICALL Java_im_tox_jtoxcore_JTox_tox_1new(JNIEnv *env, jobject
 
 	tox_callback_file_data(globals->tox, callback_filedata, globals);
 
+	tox_callback_group_invite(globals->tox, callback_group_invite, globals);
+
+	tox_callback_group_message(globals->tox, callback_group_message, globals);
+
+	tox_callback_group_action(globals->tox, callback_group_action, globals);
+
+	tox_callback_group_namelist_change(globals->tox, callback_group_namelist_change, globals);
+
 	return ((jlong) ((intptr_t) globals));
 }
 
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1bootstrap_1from_1address(JNIEnv *env, jobject obj,
-		jlong messenger, jstring ip, jint port, jbyteArray address)
+		jlong messenger, jbyteArray ip, jint port, jbyteArray address)
 {
-	const char *_ip = (*env)->GetStringUTFChars(env, ip, 0);
-	jbyte *_address = (*env)->GetByteArrayElements(env, address, 0);
-
+	STATS_ENTRY(TOX_BOOTSTRAP_FROM_ADDRESS);
+	char *_ip = utf8_copy_cstring(env, ip);
+	jbyte *_address;
 	uint16_t _port = (uint16_t) port;
+	jint result;
+	uint64_t start = monotonic_time_us();
 
-	jint result = tox_bootstrap_from_address(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, _ip, _port,
+	if (_ip == NULL) {
+		return 0;
+	}
+
+	_address = (*env)->GetByteArrayElements(env, address, 0);
+	result = tox_bootstrap_from_address(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, _ip, _port,
 				  (uint8_t *) _address);
 
-	(*env)->ReleaseStringUTFChars(env, ip, _ip);
+	if (result != 0) {
+		timeline_mark(((tox_jni_globals_t *) ((intptr_t) messenger))->timeline, TIMELINE_BOOTSTRAP,
+					  TIMELINE_NO_FRIEND, start, monotonic_time_us());
+	}
+
+	free(_ip);
 	(*env)->ReleaseByteArrayElements(env, address, _address, JNI_ABORT);
 
 	UNUSED(obj);
 	return result;
 }
 
+JNIEXPORT jintArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1bootstrap_1nodes(JNIEnv *env, jobject obj,
+		jlong messenger, jobjectArray ips, jintArray ports, jobjectArray pubkeys)
+{
+	STATS_ENTRY(TOX_BOOTSTRAP_NODES);
+	tox_jni_globals_t *globals = (tox_jni_globals_t *) ((intptr_t) messenger);
+	Tox *tox = globals->tox;
+	jsize count = (*env)->GetArrayLength(env, ports);
+	jintArray result = (*env)->NewIntArray(env, count);
+	jint *_ports = (*env)->GetIntArrayElements(env, ports, 0);
+	jint *_result = (*env)->GetIntArrayElements(env, result, 0);
+	uint64_t start = monotonic_time_us();
+	int accepted = 0;
+	jsize i;
+
+	for (i = 0; i < count; i++) {
+		jbyteArray ip = (jbyteArray) (*env)->GetObjectArrayElement(env, ips, i);
+		jbyteArray pubkey = (jbyteArray) (*env)->GetObjectArrayElement(env, pubkeys, i);
+		char *_ip = ip == NULL ? NULL : utf8_copy_cstring(env, ip);
+
+		_result[i] = 0;
+
+		if (_ip != NULL && pubkey != NULL) {
+			jbyte *_pubkey = (*env)->GetByteArrayElements(env, pubkey, 0);
+			_result[i] = tox_bootstrap_from_address(tox, _ip, (uint16_t) _ports[i], (uint8_t *) _pubkey);
+			accepted |= _result[i] != 0;
+			(*env)->ReleaseByteArrayElements(env, pubkey, _pubkey, JNI_ABORT);
+		}
+
+		free(_ip);
+
+		if (ip != NULL) {
+			(*env)->DeleteLocalRef(env, ip);
+		}
+
+		if (pubkey != NULL) {
+			(*env)->DeleteLocalRef(env, pubkey);
+		}
+	}
+
+	(*env)->ReleaseIntArrayElements(env, ports, _ports, JNI_ABORT);
+	(*env)->ReleaseIntArrayElements(env, result, _result, 0);
+
+	if (accepted) {
+		timeline_mark(globals->timeline, TIMELINE_BOOTSTRAP, TIMELINE_NO_FRIEND, start, monotonic_time_us());
+	}
+
+	UNUSED(obj);
+	return result;
+}
+
 JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_tox_1do(JNIEnv *env, jobject obj, jlong messenger)
 {
-	tox_do(((tox_jni_globals_t *) ((intptr_t) messenger))->tox);
+	STATS_ENTRY(TOX_DO);
+	tox_jni_globals_t *globals = (tox_jni_globals_t *) ((intptr_t) messenger);
+
+	tox_do(globals->tox);
+	presence_flush(globals->presence, deliver_presence, globals);
+	filesched_tick(globals->file_scheduler, globals->tox);
+
+	if (!timeline_has(globals->timeline, TIMELINE_CONNECTED) && tox_isconnected(globals->tox)) {
+		uint64_t now = monotonic_time_us();
+		timeline_mark(globals->timeline, TIMELINE_CONNECTED, TIMELINE_NO_FRIEND, now, now);
+	}
+
 	UNUSED(env);
 	UNUSED(obj);
 }
 
+JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_tox_1presence_1coalesce(JNIEnv *env, jobject obj, jlong messenger,
+		jboolean enabled)
+{
+	STATS_ENTRY(TOX_PRESENCE_COALESCE);
+	tox_jni_globals_t *globals = (tox_jni_globals_t *) ((intptr_t) messenger);
+	UNUSED(env);
+	UNUSED(obj);
+
+	/* Nothing held back may be lost when switching off between ticks */
+	presence_flush(globals->presence, deliver_presence, globals);
+	presence_set_enabled(globals->presence, enabled == JNI_TRUE);
+}
+
+JNIEXPORT jlongArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1presence_1stats(JNIEnv *env, jobject obj,
+		jlong messenger)
+{
+	STATS_ENTRY(TOX_PRESENCE_STATS);
+	int64_t stats[PRESENCE_STAT_COUNT];
+	jlongArray result;
+
+	UNUSED(obj);
+
+	presence_stats(((tox_jni_globals_t *) ((intptr_t) messenger))->presence, stats);
+	result = (*env)->NewLongArray(env, PRESENCE_STAT_COUNT);
+	(*env)->SetLongArrayRegion(env, result, 0, PRESENCE_STAT_COUNT, (jlong *) stats);
+	return result;
+}
+
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1do_1interval(JNIEnv *env, jobject obj, jlong messenger)
 {
+	STATS_ENTRY(TOX_DO_INTERVAL);
 	jint result = tox_do_interval(((tox_jni_globals_t *) ((intptr_t) messenger))->tox);
 	UNUSED(env);
 	UNUSED(obj);
@@ -191,6 +404,7 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1do_1interval(JNIEnv *env,
 
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1isconnected(JNIEnv *env, jobject obj, jlong messenger)
 {
+	STATS_ENTRY(TOX_ISCONNECTED);
 	UNUSED(env);
 	UNUSED(obj);
 	return tox_isconnected(((tox_jni_globals_t *) ((intptr_t) messenger))->tox);
@@ -198,17 +412,17 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1isconnected(JNIEnv *env, j
 
 JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_tox_1kill(JNIEnv *env, jobject jobj, jlong messenger)
 {
+	STATS_ENTRY(TOX_KILL);
 	tox_jni_globals_t *globals = (tox_jni_globals_t *) ((intptr_t) messenger);
 	tox_kill(globals->tox);
-	(*env)->DeleteGlobalRef(env, globals->handler);
-	(*env)->DeleteGlobalRef(env, globals->jtox);
 	free(globals->cache);
-	free(globals);
+	globals_free(env, globals);
 	UNUSED(jobj);
 }
 
 JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1save(JNIEnv *env, jobject obj, jlong messenger)
 {
+	STATS_ENTRY(TOX_SAVE);
 	Tox *tox = ((tox_jni_globals_t *) ((intptr_t) messenger))->tox;
 	uint32_t size = tox_size(tox);
 	uint8_t *data = malloc(size);
@@ -221,14 +435,174 @@ JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1save(JNIEnv *env, jo
 	return bytes;
 }
 
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1save_1to(JNIEnv *env, jobject obj, jlong messenger,
+		jbyteArray path, jboolean only_if_dirty)
+{
+	STATS_ENTRY(TOX_SAVE_TO);
+	tox_jni_globals_t *globals = (tox_jni_globals_t *) ((intptr_t) messenger);
+	char *_path;
+	int result;
+
+	UNUSED(obj);
+
+	if (only_if_dirty && !globals->dirty) {
+		return 0;
+	}
+
+	_path = utf8_copy_cstring(env, path);
+
+	if (_path == NULL) {
+		return -1;
+	}
+
+	result = state_save_file(globals->tox, _path);
+	free(_path);
+
+	if (result != 0) {
+		return -1;
+	}
+
+	globals->dirty = 0;
+	return 1;
+}
+
+JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1is_1dirty(JNIEnv *env, jobject obj, jlong messenger)
+{
+	STATS_ENTRY(TOX_IS_DIRTY);
+	UNUSED(env);
+	UNUSED(obj);
+	return ((tox_jni_globals_t *) ((intptr_t) messenger))->dirty ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlongArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1startup_1timeline(JNIEnv *env, jobject obj,
+		jlong messenger)
+{
+	STATS_ENTRY(TOX_GET_STARTUP_TIMELINE);
+	timeline_t *timeline = ((tox_jni_globals_t *) ((intptr_t) messenger))->timeline;
+	size_t count = timeline_count(timeline);
+	jlongArray result = (*env)->NewLongArray(env, count * TIMELINE_ENTRY_FIELDS);
+	jlong *_result = (*env)->GetLongArrayElements(env, result, 0);
+
+	timeline_export(timeline, (int64_t *) _result, count);
+	(*env)->ReleaseLongArrayElements(env, result, _result, 0);
+
+	UNUSED(obj);
+	return result;
+}
+
+JNIEXPORT jobjectArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1stats_1names(JNIEnv *env, jclass clazz)
+{
+	jclass string_class = (*env)->FindClass(env, "java/lang/String");
+	jobjectArray result = (*env)->NewObjectArray(env, STATS_PROBE_COUNT, string_class, NULL);
+	int i;
+
+	for (i = 0; i < STATS_PROBE_COUNT; i++) {
+		jstring name = (*env)->NewStringUTF(env, stats_name(i));
+		(*env)->SetObjectArrayElement(env, result, i, name);
+		(*env)->DeleteLocalRef(env, name);
+	}
+
+	UNUSED(clazz);
+	return result;
+}
+
+JNIEXPORT jlongArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1stats(JNIEnv *env, jclass clazz)
+{
+	jlongArray result = (*env)->NewLongArray(env, STATS_PROBE_COUNT * STATS_FIELDS);
+	jlong *_result = (*env)->GetLongArrayElements(env, result, 0);
+
+	stats_export((int64_t *) _result);
+	(*env)->ReleaseLongArrayElements(env, result, _result, 0);
+
+	UNUSED(clazz);
+	return result;
+}
+
+JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_tox_1trace_1set_1enabled(JNIEnv *env, jclass clazz,
+		jboolean enabled)
+{
+	trace_set_enabled(enabled == JNI_TRUE);
+	UNUSED(env);
+	UNUSED(clazz);
+}
+
+JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_tox_1trace_1lock(JNIEnv *env, jclass clazz, jboolean begin)
+{
+	trace_event(TRACE_LOCK_WAIT, begin ? TRACE_BEGIN : TRACE_END, monotonic_time_ns());
+	UNUSED(env);
+	UNUSED(clazz);
+}
+
+JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_tox_1trace_1clear(JNIEnv *env, jclass clazz)
+{
+	trace_clear();
+	UNUSED(env);
+	UNUSED(clazz);
+}
+
+JNIEXPORT jstring JNICALL Java_im_tox_jtoxcore_JTox_tox_1trace_1dump(JNIEnv *env, jclass clazz)
+{
+	char *json = trace_dump_json();
+	jstring result;
+
+	UNUSED(clazz);
+
+	if (json == NULL) {
+		return NULL;
+	}
+
+	result = (*env)->NewStringUTF(env, json);
+	free(json);
+	return result;
+}
+
 JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1load(JNIEnv *env, jobject obj, jlong messenger,
 		jbyteArray bytes, jint length)
 {
+	STATS_ENTRY(TOX_LOAD);
+	uint64_t start = monotonic_time_us();
 	jbyte *data = (*env)->GetByteArrayElements(env, bytes, 0);
+	jboolean ret =
+		tox_load(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, (uint8_t *) data, length) == 0 ?
+		JNI_FALSE : JNI_TRUE;
+	(*env)->ReleaseByteArrayElements(env, bytes, data, JNI_ABORT);
+
+	if (ret == JNI_FALSE) {
+		timeline_mark(((tox_jni_globals_t *) ((intptr_t) messenger))->timeline, TIMELINE_TOX_LOAD, TIMELINE_NO_FRIEND,
+					  start, monotonic_time_us());
+	}
+
+	((tox_jni_globals_t *) ((intptr_t) messenger))->dirty = 1;
 
 	UNUSED(obj);
-	return tox_load(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, (uint8_t *) data, length) == 0 ?
-		   JNI_FALSE : JNI_TRUE;
+	STATS_BYTES(length);
+	return ret;
+}
+
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1load_1from(JNIEnv *env, jobject obj, jlong messenger,
+		jbyteArray path)
+{
+	STATS_ENTRY(TOX_LOAD_FROM);
+	tox_jni_globals_t *globals = (tox_jni_globals_t *) ((intptr_t) messenger);
+	char *_path = utf8_copy_cstring(env, path);
+	uint64_t start = monotonic_time_us();
+	int result;
+
+	UNUSED(obj);
+
+	if (_path == NULL) {
+		return -1;
+	}
+
+	result = state_load_file(globals->tox, _path);
+	free(_path);
+
+	if (result == 0) {
+		timeline_mark(globals->timeline, TIMELINE_TOX_LOAD, TIMELINE_NO_FRIEND, start, monotonic_time_us());
+	}
+
+	globals->dirty = 1;
+	return result;
 }
 
 /**
@@ -242,12 +616,17 @@ JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1load(JNIEnv *env, jobj
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1add_1friend(JNIEnv *env, jobject obj, jlong messenger,
 		jbyteArray address, jbyteArray data, jint length)
 {
+	STATS_ENTRY(TOX_ADD_FRIEND);
 	jbyte *_address = (*env)->GetByteArrayElements(env, address, 0);
 	jbyte *_data = (*env)->GetByteArrayElements(env, data, 0);
 
 	int ret = tox_add_friend(((tox_jni_globals_t *)((intptr_t)messenger))->tox, (uint8_t *) _address, (uint8_t *) _data,
 							 length);
 
+	if (ret >= 0) {
+		((tox_jni_globals_t *) ((intptr_t) messenger))->dirty = 1;
+	}
+
 	(*env)->ReleaseByteArrayElements(env, address, _address, JNI_ABORT);
 	(*env)->ReleaseByteArrayElements(env, data, _data, JNI_ABORT);
 
@@ -258,20 +637,95 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1add_1friend(JNIEnv *env, j
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1add_1friend_1norequest(JNIEnv *env, jobject obj, jlong messenger,
 		jbyteArray address)
 {
+	STATS_ENTRY(TOX_ADD_FRIEND_NOREQUEST);
 	jbyte *_address = (*env)->GetByteArrayElements(env, address, 0);
 
 	int ret = tox_add_friend_norequest(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, (uint8_t *) _address);
+
+	if (ret >= 0) {
+		((tox_jni_globals_t *) ((intptr_t) messenger))->dirty = 1;
+	}
+
 	(*env)->ReleaseByteArrayElements(env, address, _address, JNI_ABORT);
 
 	UNUSED(obj);
 	return ret;
 }
 
+JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_tox_1request_1filter_1limits(JNIEnv *env, jobject obj,
+		jlong messenger, jdouble keyrate, jint keyburst, jdouble globalrate, jint globalburst)
+{
+	STATS_ENTRY(TOX_REQUEST_FILTER_LIMITS);
+	UNUSED(env);
+	UNUSED(obj);
+	reqfilter_limits(((tox_jni_globals_t *) ((intptr_t) messenger))->request_filter, keyrate, (uint32_t) keyburst,
+					 globalrate, (uint32_t) globalburst);
+}
+
+JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_tox_1request_1filter_1max_1length(JNIEnv *env, jobject obj,
+		jlong messenger, jint length)
+{
+	STATS_ENTRY(TOX_REQUEST_FILTER_MAX_LENGTH);
+	UNUSED(env);
+	UNUSED(obj);
+	reqfilter_max_length(((tox_jni_globals_t *) ((intptr_t) messenger))->request_filter, (uint32_t) length);
+}
+
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1request_1filter_1list(JNIEnv *env, jobject obj,
+		jlong messenger, jbyteArray clientid, jint mode)
+{
+	STATS_ENTRY(TOX_REQUEST_FILTER_LIST);
+	uint8_t key[TOX_CLIENT_ID_SIZE];
+
+	UNUSED(obj);
+
+	if ((*env)->GetArrayLength(env, clientid) != TOX_CLIENT_ID_SIZE) {
+		return -1;
+	}
+
+	(*env)->GetByteArrayRegion(env, clientid, 0, TOX_CLIENT_ID_SIZE, (jbyte *) key);
+	return reqfilter_list(((tox_jni_globals_t *) ((intptr_t) messenger))->request_filter, key, mode);
+}
+
+JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_tox_1request_1filter_1clear(JNIEnv *env, jobject obj,
+		jlong messenger)
+{
+	STATS_ENTRY(TOX_REQUEST_FILTER_CLEAR);
+	UNUSED(env);
+	UNUSED(obj);
+	reqfilter_clear(((tox_jni_globals_t *) ((intptr_t) messenger))->request_filter);
+}
+
+JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_tox_1request_1filter_1allow_1only(JNIEnv *env, jobject obj,
+		jlong messenger, jboolean allowonly)
+{
+	STATS_ENTRY(TOX_REQUEST_FILTER_ALLOW_ONLY);
+	UNUSED(env);
+	UNUSED(obj);
+	reqfilter_allow_only(((tox_jni_globals_t *) ((intptr_t) messenger))->request_filter, allowonly == JNI_TRUE);
+}
+
+JNIEXPORT jlongArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1request_1filter_1stats(JNIEnv *env, jobject obj,
+		jlong messenger)
+{
+	STATS_ENTRY(TOX_REQUEST_FILTER_STATS);
+	int64_t stats[REQFILTER_STAT_COUNT];
+	jlongArray result;
+
+	UNUSED(obj);
+
+	reqfilter_stats(((tox_jni_globals_t *) ((intptr_t) messenger))->request_filter, stats);
+	result = (*env)->NewLongArray(env, REQFILTER_STAT_COUNT);
+	(*env)->SetLongArrayRegion(env, result, 0, REQFILTER_STAT_COUNT, (jlong *) stats);
+	return result;
+}
+
 JNIEXPORT jstring JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1address(JNIEnv *env, jobject obj, jlong messenger)
 {
+	STATS_ENTRY(TOX_GET_ADDRESS);
 	jstring result;
 	uint8_t addr[TOX_FRIEND_ADDRESS_SIZE];
-	char id[ADDR_SIZE_HEX] = { 0 };
+	char id[ADDR_SIZE_HEX];
 	tox_get_address(((tox_jni_globals_t *)((intptr_t) messenger))->tox, addr);
 	addr_to_hex(addr, id);
 
@@ -280,34 +734,73 @@ JNIEXPORT jstring JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1address(JNIEnv *en
 	return result;
 }
 
+JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1address_1bytes(JNIEnv *env, jobject obj,
+		jlong messenger)
+{
+	STATS_ENTRY(TOX_GET_ADDRESS_BYTES);
+	uint8_t addr[TOX_FRIEND_ADDRESS_SIZE];
+	tox_get_address(((tox_jni_globals_t *)((intptr_t) messenger))->tox, addr);
+
+	UNUSED(obj);
+	return bytes_to_java(env, addr, TOX_FRIEND_ADDRESS_SIZE);
+}
+
 JNIEXPORT jstring JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1client_1id(JNIEnv *env, jobject obj, jlong messenger,
 		jint friendnumber)
 {
-	uint8_t address[TOX_FRIEND_ADDRESS_SIZE];
+	STATS_ENTRY(TOX_GET_CLIENT_ID);
+	uint8_t address[TOX_CLIENT_ID_SIZE];
 	jstring result;
 	UNUSED(obj);
 
 	if (tox_get_client_id(((tox_jni_globals_t *)((intptr_t) messenger))->tox, friendnumber, address) != 0) {
 		return 0;
 	} else {
-		char _address[ADDR_SIZE_HEX] = { 0 };
-		addr_to_hex(address, _address);
+		char _address[CLIENT_ID_SIZE_HEX];
+		bytes_to_hex(address, TOX_CLIENT_ID_SIZE, _address);
 		result = (*env)->NewStringUTF(env, _address);
 		return result;
 	}
 }
 
+JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1client_1id_1bytes(JNIEnv *env, jobject obj,
+		jlong messenger, jint friendnumber)
+{
+	STATS_ENTRY(TOX_GET_CLIENT_ID_BYTES);
+	uint8_t client_id[TOX_CLIENT_ID_SIZE];
+	UNUSED(obj);
+
+	if (tox_get_client_id(((tox_jni_globals_t *)((intptr_t) messenger))->tox, friendnumber, client_id) != 0) {
+		return 0;
+	}
+
+	return bytes_to_java(env, client_id, TOX_CLIENT_ID_SIZE);
+}
+
 JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1del_1friend(JNIEnv *env, jobject obj, jlong messenger,
 		jint friendnumber)
 {
+	STATS_ENTRY(TOX_DEL_FRIEND);
+	tox_jni_globals_t *globals = (tox_jni_globals_t *) ((intptr_t) messenger);
 	UNUSED(env);
 	UNUSED(obj);
-	return tox_del_friend(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, friendnumber) == 0 ? 0 : 1;
+
+	if (tox_del_friend(globals->tox, friendnumber) != 0) {
+		return 1;
+	}
+
+	globals->dirty = 1;
+	filesched_forget(globals->file_scheduler, friendnumber);
+	journal_forget(globals->journal, friendnumber);
+	presence_forget(globals->presence, friendnumber);
+	roster_forget(globals->roster, friendnumber);
+	return 0;
 }
 
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1send_1message(JNIEnv *env, jobject obj, jlong messenger,
 		jint friendnumber, jbyteArray message, jint length)
 {
+	STATS_ENTRY(TOX_SEND_MESSAGE);
 	jbyte *_message = (*env)->GetByteArrayElements(env, message, 0);
 
 	uint32_t mess_id = tox_send_message(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, friendnumber,
@@ -316,12 +809,74 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1send_1message(JNIEnv *env,
 	(*env)->ReleaseByteArrayElements(env, message, _message, JNI_ABORT);
 
 	UNUSED(obj);
+	STATS_BYTES(length);
 	return mess_id;
 }
 
+JNIEXPORT jintArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1send_1messages(JNIEnv *env, jobject obj, jlong messenger,
+		jintArray friends, jobjectArray messages)
+{
+	STATS_ENTRY(TOX_SEND_MESSAGES);
+	Tox *tox = ((tox_jni_globals_t *) ((intptr_t) messenger))->tox;
+	jsize count = (*env)->GetArrayLength(env, friends);
+	jintArray result = (*env)->NewIntArray(env, count);
+	jint *_friends = (*env)->GetIntArrayElements(env, friends, 0);
+	jint *_result = (*env)->GetIntArrayElements(env, result, 0);
+	jsize i;
+
+	for (i = 0; i < count; i++) {
+		jbyteArray message = (jbyteArray) (*env)->GetObjectArrayElement(env, messages, i);
+		jbyte *_message;
+
+		if (message == NULL) {
+			_result[i] = 0;
+			continue;
+		}
+
+		_message = (*env)->GetByteArrayElements(env, message, 0);
+		_result[i] = (jint) tox_send_message(tox, _friends[i], (uint8_t *) _message,
+		                                     (*env)->GetArrayLength(env, message));
+		(*env)->ReleaseByteArrayElements(env, message, _message, JNI_ABORT);
+		(*env)->DeleteLocalRef(env, message);
+	}
+
+	(*env)->ReleaseIntArrayElements(env, friends, _friends, JNI_ABORT);
+	(*env)->ReleaseIntArrayElements(env, result, _result, 0);
+
+	UNUSED(obj);
+	return result;
+}
+
+JNIEXPORT jintArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1broadcast(JNIEnv *env, jobject obj, jlong messenger,
+		jintArray friends, jbyteArray message)
+{
+	STATS_ENTRY(TOX_BROADCAST);
+	Tox *tox = ((tox_jni_globals_t *) ((intptr_t) messenger))->tox;
+	jsize count = (*env)->GetArrayLength(env, friends);
+	jsize length = (*env)->GetArrayLength(env, message);
+	jintArray result = (*env)->NewIntArray(env, count);
+	jint *_friends = (*env)->GetIntArrayElements(env, friends, 0);
+	jint *_result = (*env)->GetIntArrayElements(env, result, 0);
+	/* Pinned once for every recipient */
+	jbyte *_message = (*env)->GetByteArrayElements(env, message, 0);
+	jsize i;
+
+	for (i = 0; i < count; i++) {
+		_result[i] = (jint) tox_send_message(tox, _friends[i], (uint8_t *) _message, length);
+	}
+
+	(*env)->ReleaseByteArrayElements(env, message, _message, JNI_ABORT);
+	(*env)->ReleaseIntArrayElements(env, friends, _friends, JNI_ABORT);
+	(*env)->ReleaseIntArrayElements(env, result, _result, 0);
+
+	UNUSED(obj);
+	return result;
+}
+
 JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1send_1action(JNIEnv *env, jobject obj, jlong messenger,
 		jint friendnumber, jbyteArray action, jint length)
 {
+	STATS_ENTRY(TOX_SEND_ACTION);
 	jbyte *_action = (*env)->GetByteArrayElements(env, action, 0);
 
 	jboolean ret = tox_send_action(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, friendnumber, (uint8_t *) _action,
@@ -329,58 +884,64 @@ JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1send_1action(JNIEnv *e
 	(*env)->ReleaseByteArrayElements(env, action, _action, JNI_ABORT);
 
 	UNUSED(obj);
+	STATS_BYTES(length);
 	return ret;
 }
 
 JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1set_1name(JNIEnv *env, jobject obj, jlong messenger,
 		jbyteArray newname, jint length)
 {
+	STATS_ENTRY(TOX_SET_NAME);
 	jbyte *_newname = (*env)->GetByteArrayElements(env, newname, 0);
 
 	jboolean ret =
 		tox_set_name(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, (uint8_t *) _newname, length) == 0 ?
 		JNI_FALSE : JNI_TRUE;
 	(*env)->ReleaseByteArrayElements(env, newname, _newname, JNI_ABORT);
+	((tox_jni_globals_t *) ((intptr_t) messenger))->dirty = 1;
 
 	UNUSED(obj);
+	STATS_BYTES(length);
 	return ret;
 }
 
 JNIEXPORT jstring JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1self_1name(JNIEnv *env, jobject obj, jlong messenger)
 {
-	jstring _name;
-	uint8_t *name = malloc(TOX_MAX_NAME_LENGTH);
+	STATS_ENTRY(TOX_GET_SELF_NAME);
+	uint8_t name[TOX_MAX_NAME_LENGTH];
 	uint16_t length = tox_get_self_name(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, name);
 
+	UNUSED(obj);
+
 	if (length == 0) {
-		free(name);
 		return 0;
 	}
 
-	_name = (*env)->NewStringUTF(env, (char *) name);
-	free(name);
-
-	UNUSED(obj);
-	return _name;
+	/* The name is neither \0-terminated nor modified UTF-8, so NewStringUTF can not be used */
+	return utf8_new_string(env, name, length);
 }
 
 JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1set_1status_1message(JNIEnv *env, jobject obj,
 		jlong messenger, jbyteArray newstatus, jint length)
 {
+	STATS_ENTRY(TOX_SET_STATUS_MESSAGE);
 	jbyte *_newstatus = (*env)->GetByteArrayElements(env, newstatus, 0);
 	jboolean ret =
 		tox_set_status_message(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, (uint8_t *) _newstatus, length) == 0 ?
 		JNI_FALSE :
 		JNI_TRUE;
 	(*env)->ReleaseByteArrayElements(env, newstatus, _newstatus, JNI_ABORT);
+	((tox_jni_globals_t *) ((intptr_t) messenger))->dirty = 1;
 
 	UNUSED(obj);
+	STATS_BYTES(length);
 	return ret;
 }
 
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1friend_1connection_1status(JNIEnv *env, jobject obj,
 		jlong messenger, jint friendnumber)
 {
+	STATS_ENTRY(TOX_GET_FRIEND_CONNECTION_STATUS);
 	uint32_t ret = tox_get_friend_connection_status(((tox_jni_globals_t *)((intptr_t)messenger))->tox, friendnumber);
 
 	UNUSED(env);
@@ -391,6 +952,7 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1friend_1connection_1s
 JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1friend_1exists(JNIEnv *env, jobject obj, jlong messenger,
 		jint friendnumber)
 {
+	STATS_ENTRY(TOX_GET_FRIEND_EXISTS);
 	uint8_t ret = tox_friend_exists(((tox_jni_globals_t *)((intptr_t)messenger))->tox, friendnumber);
 
 	UNUSED(env);
@@ -401,6 +963,7 @@ JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1friend_1exists(JN
 JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1name(JNIEnv *env, jobject obj, jlong messenger,
 		jint friendnumber)
 {
+	STATS_ENTRY(TOX_GET_NAME);
 	jbyte *name = malloc(TOX_MAX_NAME_LENGTH);
 	int ret = tox_get_name(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, friendnumber, (uint8_t *) name);
 
@@ -417,52 +980,194 @@ JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1name(JNIEnv *en
 	}
 }
 
-/*
-JNIEXPORT jobjectArray JNICALL Java_im_tox_jtoxcore_JTox_tox_lgroup_lget_lnames(JNIEnv *env,
-        jobject obj, jlong messenger, jint groupnumber)
-{
-    int num_peers = tox_group_number_peers(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, groupnumber);
-    jbyte **names;
-    names = (jbyte **) malloc(num_peers*sizeof(jbyte*));
-    int i;
-    for (i = 0; i < num_peers; i++) {
-        names[i] = (jbyte*) malloc(TOX_MAX_NAME_LENGTH*sizeof(jbyte));
-    }
-    jshort *lengths = malloc(num_peers*sizeof(jshort));
-    jshort length;
-    int ret = tox_group_get_names(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, groupnumber, (uint8_t [][TOX_MAX_NAME_LENGTH]) names, lengths, length);
-    if (ret == -1) {
-        return NULL;
-    } else {
-        // The 2D array to return
-        jbyte** primitive2DArray = names;
-
-        // Get the array class
-        jclass byteArrayClass = (*env)->FindClass(env, "[B");
-
-        // Check if we properly got the array class
-        if (byteArrayClass == NULL) {
-            return NULL;
-        }
-
-        // Create the returnable 2D array
-        jobjectArray returnable2DArray = (*env)->NewObjectArray(env, (jsize) num_peers, byteArrayClass, NULL);
-
-        // Go through the first dimension and add the second dimension arrays
-        for (i = 0; i < num_peers; i++) {
-            jbyteArray byteArray = (*env)->NewByteArray(env, TOX_MAX_NAME_LENGTH);
-            (*env)->SetByteArrayRegion(env, byteArray, (jsize) 0, (jsize) TOX_MAX_NAME_LENGTH, (jbyte*) primitive2DArray[i]);
-            (*env)->SetObjectArrayElement(env, returnable2DArray, (jsize) i, byteArray);
-            (*env)->DeleteLocalRef(env, byteArray);
-        }
-        // Return a Java consumable 2D long array
-        return returnable2DArray;
-    }
+// GROUP CHATS
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1add_1groupchat(JNIEnv *env, jobject obj, jlong messenger)
+{
+	STATS_ENTRY(TOX_ADD_GROUPCHAT);
+	UNUSED(env);
+	UNUSED(obj);
+	return tox_add_groupchat(((tox_jni_globals_t *) ((intptr_t) messenger))->tox);
 }
-*/
+
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1del_1groupchat(JNIEnv *env, jobject obj, jlong messenger,
+		jint groupnumber)
+{
+	STATS_ENTRY(TOX_DEL_GROUPCHAT);
+	UNUSED(env);
+	UNUSED(obj);
+	return tox_del_groupchat(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, groupnumber);
+}
+
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1invite_1friend(JNIEnv *env, jobject obj, jlong messenger,
+		jint friendnumber, jint groupnumber)
+{
+	STATS_ENTRY(TOX_INVITE_FRIEND);
+	UNUSED(env);
+	UNUSED(obj);
+	return tox_invite_friend(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, friendnumber, groupnumber);
+}
+
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1join_1groupchat(JNIEnv *env, jobject obj, jlong messenger,
+		jint friendnumber, jbyteArray groupkey)
+{
+	STATS_ENTRY(TOX_JOIN_GROUPCHAT);
+	uint8_t key[TOX_CLIENT_ID_SIZE];
+
+	UNUSED(obj);
+
+	if ((*env)->GetArrayLength(env, groupkey) != TOX_CLIENT_ID_SIZE) {
+		return -1;
+	}
+
+	(*env)->GetByteArrayRegion(env, groupkey, 0, TOX_CLIENT_ID_SIZE, (jbyte *) key);
+	return tox_join_groupchat(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, friendnumber, key);
+}
+
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1group_1message_1send(JNIEnv *env, jobject obj,
+		jlong messenger, jint groupnumber, jbyteArray message, jint length)
+{
+	STATS_ENTRY(TOX_GROUP_MESSAGE_SEND);
+	jbyte *_message = (*env)->GetByteArrayElements(env, message, 0);
+	jint ret = tox_group_message_send(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, groupnumber,
+									  (uint8_t *) _message, length);
+
+	(*env)->ReleaseByteArrayElements(env, message, _message, JNI_ABORT);
+	UNUSED(obj);
+	STATS_BYTES(length);
+	return ret;
+}
+
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1group_1action_1send(JNIEnv *env, jobject obj,
+		jlong messenger, jint groupnumber, jbyteArray action, jint length)
+{
+	STATS_ENTRY(TOX_GROUP_ACTION_SEND);
+	jbyte *_action = (*env)->GetByteArrayElements(env, action, 0);
+	jint ret = tox_group_action_send(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, groupnumber,
+									 (uint8_t *) _action, length);
+
+	(*env)->ReleaseByteArrayElements(env, action, _action, JNI_ABORT);
+	UNUSED(obj);
+	STATS_BYTES(length);
+	return ret;
+}
+
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1group_1number_1peers(JNIEnv *env, jobject obj,
+		jlong messenger, jint groupnumber)
+{
+	STATS_ENTRY(TOX_GROUP_NUMBER_PEERS);
+	UNUSED(env);
+	UNUSED(obj);
+	return tox_group_number_peers(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, groupnumber);
+}
+
+JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1group_1peername(JNIEnv *env, jobject obj,
+		jlong messenger, jint groupnumber, jint peernumber)
+{
+	STATS_ENTRY(TOX_GROUP_PEERNAME);
+	uint8_t name[TOX_MAX_NAME_LENGTH];
+	int ret = tox_group_peername(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, groupnumber, peernumber, name);
+
+	UNUSED(obj);
+
+	if (ret == -1) {
+		return NULL;
+	}
+
+	return bytes_to_java(env, name, ret);
+}
+
+/**
+ * Fetch the names of all peers of a group in one go. The names are packed back to back into the
+ * returned array, and offsets, which has to hold one more element than there are peers, receives
+ * the start of each name followed by the total length. Only two java arrays are touched, however
+ * many peers the group has.
+ */
+JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1group_1get_1names(JNIEnv *env, jobject obj,
+		jlong messenger, jint groupnumber, jintArray offsets)
+{
+	STATS_ENTRY(TOX_GROUP_GET_NAMES);
+	Tox *tox = ((tox_jni_globals_t *) ((intptr_t) messenger))->tox;
+	jsize capacity = (*env)->GetArrayLength(env, offsets) - 1;
+	uint8_t (*names)[TOX_MAX_NAME_LENGTH];
+	uint16_t *lengths;
+	jint *_offsets;
+	jbyteArray result = NULL;
+	jint total = 0;
+	int count;
+	int i;
+
+	UNUSED(obj);
+
+	if (capacity <= 0) {
+		return NULL;
+	}
+
+	names = malloc((size_t) capacity * TOX_MAX_NAME_LENGTH);
+	lengths = malloc((size_t) capacity * sizeof(uint16_t));
+	_offsets = malloc(((size_t) capacity + 1) * sizeof(jint));
+
+	if (names != NULL && lengths != NULL && _offsets != NULL) {
+		count = tox_group_get_names(tox, groupnumber, names, lengths,
+									(uint16_t) (capacity > UINT16_MAX ? UINT16_MAX : capacity));
+	} else {
+		count = -1;
+	}
+
+	if (count >= 0 && count <= capacity) {
+		/* Pack the names in place; each one only ever moves towards the front */
+		for (i = 0; i < count; ++i) {
+			uint16_t length = lengths[i] < TOX_MAX_NAME_LENGTH ? lengths[i] : TOX_MAX_NAME_LENGTH;
+
+			_offsets[i] = total;
+			memmove((uint8_t *) names + total, names[i], length);
+			total += length;
+		}
+
+		for (i = count; i <= capacity; ++i) {
+			_offsets[i] = total;
+		}
+
+		result = (*env)->NewByteArray(env, total);
+
+		if (result != NULL) {
+			(*env)->SetByteArrayRegion(env, result, 0, total, (jbyte *) names);
+			(*env)->SetIntArrayRegion(env, offsets, 0, capacity + 1, _offsets);
+			STATS_BYTES(total);
+		}
+	}
+
+	free(names);
+	free(lengths);
+	free(_offsets);
+	return result;
+}
+
+JNIEXPORT jintArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1chatlist(JNIEnv *env, jobject obj, jlong messenger)
+{
+	STATS_ENTRY(TOX_GET_CHATLIST);
+	Tox *tox = ((tox_jni_globals_t *) ((intptr_t) messenger))->tox;
+	uint32_t length = tox_count_chatlist(tox);
+	int *list = malloc((length == 0 ? 1 : length) * sizeof(int));
+	uint32_t actual_length;
+	jintArray arr;
+
+	UNUSED(obj);
+
+	if (list == NULL) {
+		return NULL;
+	}
+
+	actual_length = tox_get_chatlist(tox, list, length);
+	arr = (*env)->NewIntArray(env, actual_length);
+	(*env)->SetIntArrayRegion(env, arr, 0, actual_length, (jint *) list);
+	free(list);
+	return arr;
+}
+// GROUP CHATS END
 
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1nospam(JNIEnv *env, jobject obj, jlong messenger)
 {
+	STATS_ENTRY(TOX_GET_NOSPAM);
 	int result = tox_get_nospam(((tox_jni_globals_t *) ((intptr_t) messenger))->tox);
 	UNUSED(obj);
 	UNUSED(env);
@@ -470,7 +1175,9 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1nospam(JNIEnv *env, j
 }
 JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_tox_1set_1nospam(JNIEnv *env, jobject obj, jlong messenger, jint nospam)
 {
+	STATS_ENTRY(TOX_SET_NOSPAM);
 	tox_set_nospam(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, nospam);
+	((tox_jni_globals_t *) ((intptr_t) messenger))->dirty = 1;
 	UNUSED(obj);
 	UNUSED(env);
 }
@@ -478,6 +1185,7 @@ JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_tox_1set_1nospam(JNIEnv *env, j
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1new_1file_1sender(JNIEnv *env, jobject obj, jlong messenger,
 		jint friendnumber, jlong filesize, jbyteArray filename, jint length)
 {
+	STATS_ENTRY(TOX_NEW_FILE_SENDER);
 	jbyte *_filename = (*env)->GetByteArrayElements(env, filename, 0);
 	int result = tox_new_file_sender(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, friendnumber, filesize,
 									 (uint8_t *) _filename, length);
@@ -489,6 +1197,7 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1new_1file_1sender(JNIEnv *
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1file_1send_1control(JNIEnv *env, jobject obj, jlong messenger,
 		jint friendnumber, jint send_receive, jint filenumber, jint message_id, jbyteArray data, jint length)
 {
+	STATS_ENTRY(TOX_FILE_SEND_CONTROL);
 	jbyte *_data = (*env)->GetByteArrayElements(env, data, 0);
 	int result = tox_file_send_control(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, friendnumber, send_receive,
 									   filenumber, message_id, (uint8_t *) _data, length);
@@ -500,17 +1209,20 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1file_1send_1control(JNIEnv
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1file_1send_1data(JNIEnv *env, jobject obj, jlong messenger,
 		jint friendnumber, jint filenumber, jbyteArray data, jint length)
 {
+	STATS_ENTRY(TOX_FILE_SEND_DATA);
 	jbyte *_data = (*env)->GetByteArrayElements(env, data, 0);
 	int result = tox_file_send_data(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, friendnumber, filenumber,
 									(uint8_t *) _data, length);
 	(*env)->ReleaseByteArrayElements(env, data, _data, JNI_ABORT);
 	UNUSED(obj);
+	STATS_BYTES(length);
 	return result;
 }
 
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1file_1data_1size(JNIEnv *env, jobject obj, jlong messenger,
 		jint friendnumber)
 {
+	STATS_ENTRY(TOX_FILE_DATA_SIZE);
 	int result = tox_file_data_size(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, friendnumber);
 	UNUSED(obj);
 	UNUSED(env);
@@ -520,19 +1232,107 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1file_1data_1size(JNIEnv *e
 JNIEXPORT jlong JNICALL Java_im_tox_jtoxcore_JTox_tox_1file_1data_1remaining(JNIEnv *env, jobject obj, jlong messenger,
 		jint friendnumber, jint filenumber, jint send_receive)
 {
+	STATS_ENTRY(TOX_FILE_DATA_REMAINING);
 	long result = tox_file_data_remaining(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, friendnumber, filenumber,
 										  send_receive);
 	UNUSED(obj);
 	UNUSED(env);
 	return result;
 }
+
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1file_1schedule(JNIEnv *env, jobject obj, jlong messenger,
+		jint friendnumber, jbyteArray path, jbyteArray filename, jint weight)
+{
+	STATS_ENTRY(TOX_FILE_SCHEDULE);
+	tox_jni_globals_t *globals = (tox_jni_globals_t *) ((intptr_t) messenger);
+	char *_path = utf8_copy_cstring(env, path);
+	jbyte *_filename;
+	jint result;
+
+	if (_path == NULL) {
+		return -1;
+	}
+
+	_filename = (*env)->GetByteArrayElements(env, filename, 0);
+	result = filesched_add(globals->file_scheduler, globals->tox, friendnumber, _path, (uint8_t *) _filename,
+	                       (*env)->GetArrayLength(env, filename), weight > 0 ? (uint32_t) weight : 1);
+	(*env)->ReleaseByteArrayElements(env, filename, _filename, JNI_ABORT);
+	free(_path);
+
+	UNUSED(obj);
+	return result;
+}
+
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1file_1receive(JNIEnv *env, jobject obj, jlong messenger,
+		jint friendnumber, jint filenumber, jlong filesize, jbyteArray path)
+{
+	STATS_ENTRY(TOX_FILE_RECEIVE);
+	tox_jni_globals_t *globals = (tox_jni_globals_t *) ((intptr_t) messenger);
+	char *_path = utf8_copy_cstring(env, path);
+	jint result;
+
+	if (_path == NULL) {
+		return -1;
+	}
+
+	result = journal_receive(globals->journal, globals->tox, friendnumber, (uint8_t) filenumber, (uint64_t) filesize,
+	                         _path);
+	free(_path);
+
+	UNUSED(obj);
+	return result;
+}
+
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1file_1unschedule(JNIEnv *env, jobject obj, jlong messenger,
+		jint friendnumber, jint filenumber)
+{
+	STATS_ENTRY(TOX_FILE_UNSCHEDULE);
+	tox_jni_globals_t *globals = (tox_jni_globals_t *) ((intptr_t) messenger);
+
+	UNUSED(env);
+	UNUSED(obj);
+	return filesched_remove(globals->file_scheduler, globals->tox, friendnumber, (uint8_t) filenumber);
+}
+
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_tox_1file_1set_1weight(JNIEnv *env, jobject obj, jlong messenger,
+		jint friendnumber, jint filenumber, jint weight)
+{
+	STATS_ENTRY(TOX_FILE_SET_WEIGHT);
+	tox_jni_globals_t *globals = (tox_jni_globals_t *) ((intptr_t) messenger);
+
+	UNUSED(env);
+	UNUSED(obj);
+	return filesched_set_weight(globals->file_scheduler, friendnumber, (uint8_t) filenumber,
+	                            weight > 0 ? (uint32_t) weight : 1);
+}
+
+JNIEXPORT jlongArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1file_1transfer_1stats(JNIEnv *env, jobject obj,
+		jlong messenger, jint friendnumber, jint filenumber)
+{
+	STATS_ENTRY(TOX_FILE_TRANSFER_STATS);
+	tox_jni_globals_t *globals = (tox_jni_globals_t *) ((intptr_t) messenger);
+	int64_t stats[FILESCHED_STAT_COUNT];
+	jlongArray result;
+
+	UNUSED(obj);
+
+	if (filesched_stats(globals->file_scheduler, friendnumber, (uint8_t) filenumber, stats) != 0) {
+		return NULL;
+	}
+
+	result = (*env)->NewLongArray(env, FILESCHED_STAT_COUNT);
+	(*env)->SetLongArrayRegion(env, result, 0, FILESCHED_STAT_COUNT, (jlong *) stats);
+	return result;
+}
 // FILE SENDING ENDS
 
 JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1set_1user_1status(JNIEnv *env, jobject obj, jlong messenger,
 		jint userstatus)
 {
+	STATS_ENTRY(TOX_SET_USER_STATUS);
 	UNUSED(env);
 	UNUSED(obj);
+	((tox_jni_globals_t *) ((intptr_t) messenger))->dirty = 1;
 
 	return tox_set_user_status(((tox_jni_globals_t *) ((intptr_t) messenger))->tox, userstatus) == 0 ?
 		   JNI_FALSE : JNI_TRUE;
@@ -541,6 +1341,7 @@ JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1set_1user_1status(JNIE
 JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1status_1message(JNIEnv *env, jobject obj,
 		jlong messenger, jint friendnumber)
 {
+	STATS_ENTRY(TOX_GET_STATUS_MESSAGE);
 	Tox *tox = ((tox_jni_globals_t *) ((intptr_t) messenger))->tox;
 	int size = tox_get_status_message_size(tox, friendnumber);
 	jbyte *statusmessage = malloc(size);
@@ -562,6 +1363,7 @@ JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1status_1message
 JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1getselfstatusmessage(JNIEnv *env, jobject obj,
 		jlong messenger)
 {
+	STATS_ENTRY(TOX_GETSELFSTATUSMESSAGE);
 	Tox *tox = ((tox_jni_globals_t *) ((intptr_t) messenger))->tox;
 	jbyte *status = malloc(TOX_MAX_STATUSMESSAGE_LENGTH);
 	int length = tox_get_self_status_message(tox, (uint8_t *) status,
@@ -583,6 +1385,7 @@ JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1getselfstatusmessage
 JNIEXPORT jobject JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1user_1status(JNIEnv *env, jobject obj, jlong messenger,
 		jint friendnumber)
 {
+	STATS_ENTRY(TOX_GET_USER_STATUS);
 	Tox *tox = ((tox_jni_globals_t *) ((intptr_t) messenger))->tox;
 	char *status;
 	jclass us_enum;
@@ -616,6 +1419,7 @@ JNIEXPORT jobject JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1user_1status(JNIEn
 JNIEXPORT jobject JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1self_1user_1status(JNIEnv *env, jobject obj,
 		jlong messenger)
 {
+	STATS_ENTRY(TOX_GET_SELF_USER_STATUS);
 	Tox *tox = ((tox_jni_globals_t *) ((intptr_t) messenger))->tox;
 	char *status;
 	jclass us_enum;
@@ -648,6 +1452,7 @@ JNIEXPORT jobject JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1self_1user_1status
 
 JNIEXPORT jintArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1friendlist(JNIEnv *env, jobject obj, jlong messenger)
 {
+	STATS_ENTRY(TOX_GET_FRIENDLIST);
 	Tox *tox = ((tox_jni_globals_t *) ((intptr_t) messenger))->tox;
 	uint32_t length = tox_count_friendlist(tox);
 	int *list = malloc(length);
@@ -663,6 +1468,7 @@ JNIEXPORT jintArray JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1friendlist(JNIEn
 JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1set_1user_1is_1typing
 (JNIEnv *env, jobject obj, jlong messenger, jint friendnumber, jboolean typing)
 {
+	STATS_ENTRY(TOX_SET_USER_IS_TYPING);
 	Tox *tox = ((tox_jni_globals_t *)((intptr_t) messenger))->tox;
 	uint8_t is_typing;
 
@@ -680,6 +1486,7 @@ JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1set_1user_1is_1typing
 JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1is_1typing
 (JNIEnv *env, jobject obj, jlong messenger, jint friendnumber)
 {
+	STATS_ENTRY(TOX_GET_IS_TYPING);
 	Tox *tox = ((tox_jni_globals_t *) ((intptr_t) messenger))->tox;
 
 	uint8_t is_typing = tox_get_is_typing(tox, friendnumber);
@@ -688,11 +1495,31 @@ JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_tox_1get_1is_1typing
 	UNUSED(obj);
 	return is_typing == 1 ? JNI_TRUE : JNI_FALSE;
 }
+
+JNIEXPORT jboolean JNICALL Java_im_tox_jtoxcore_JTox_utf8_1validate
+(JNIEnv *env, jclass clazz, jbyteArray data, jint offset, jint length)
+{
+	STATS_ENTRY(UTF8_VALIDATE);
+	jbyte *_data = (*env)->GetPrimitiveArrayCritical(env, data, 0);
+	int valid;
+
+	UNUSED(clazz);
+
+	if (_data == NULL) {
+		return JNI_FALSE;
+	}
+
+	valid = utf8_validate((uint8_t *) _data + offset, (size_t) length);
+	(*env)->ReleasePrimitiveArrayCritical(env, data, _data, JNI_ABORT);
+
+	return valid ? JNI_TRUE : JNI_FALSE;
+}
 ////////////////////////////// AUDIO / VIDEO////////////////////////////////////
 
 JNIEXPORT jlong JNICALL Java_im_tox_jtoxcore_JTox_toxav_1new
 (JNIEnv *env, jobject obj, jlong messenger, jint max_calls)
 {
+	STATS_ENTRY(TOXAV_NEW);
 	tox_av_jni_globals_t *globals = malloc(sizeof(tox_av_jni_globals_t));
 	Tox *tox = ((tox_jni_globals_t *) ((intptr_t) messenger))->tox;
 	JavaVM *jvm;
@@ -701,8 +1528,13 @@ JNIEXPORT jlong JNICALL Java_im_tox_jtoxcore_JTox_toxav_1new
 	jobject handler = (*env)->GetObjectField(env, obj, id);
 	jobject handlerRef = (*env)->NewGlobalRef(env, handler);
 	jobject jtoxRef = (*env)->NewGlobalRef(env, obj);
+	uint64_t start = monotonic_time_us();
 	(*env)->GetJavaVM(env, &jvm);
 	globals->toxav = toxav_new(tox, (int32_t) max_calls);
+	globals->bitrate = bitrate_new((int32_t) max_calls);
+	globals->media_stats = media_stats_new((int32_t) max_calls);
+	timeline_mark(((tox_jni_globals_t *) ((intptr_t) messenger))->timeline, TIMELINE_TOXAV_NEW, TIMELINE_NO_FRIEND,
+				  start, monotonic_time_us());
 	globals->jvm = jvm;
 	globals->handler = handlerRef;
 	globals->jtox = jtoxRef;
@@ -728,9 +1560,12 @@ JNIEXPORT jlong JNICALL Java_im_tox_jtoxcore_JTox_toxav_1new
 JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_toxav_1kill
 (JNIEnv *env, jobject obj, jlong messenger)
 {
+	STATS_ENTRY(TOXAV_KILL);
 	ToxAv *tox_av = ((tox_av_jni_globals_t *) ((intptr_t) messenger))->toxav;
 	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
 	toxav_kill(tox_av);
+	bitrate_free(globals->bitrate);
+	media_stats_free(globals->media_stats);
 	(*env)->DeleteGlobalRef(env, globals->handler);
 	(*env)->DeleteGlobalRef(env, globals->jtox);
 	free(globals->cache);
@@ -741,22 +1576,52 @@ JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_toxav_1kill
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1call
 (JNIEnv *env, jobject obj, jlong messenger, jint friend_id, jobject codec_settings, jint ringing_seconds)
 {
+	STATS_ENTRY(TOXAV_CALL);
 	ToxAvCSettings codec_settings_native;
 	int32_t id;
 	jint res;
 
-	ToxAv *tox_av = ((tox_av_jni_globals_t *) ((intptr_t) messenger))->toxav;
-	codec_settings_native = codec_settings_to_native(env, codec_settings);
-	res = toxav_call(tox_av, &id, friend_id, &codec_settings_native, ringing_seconds);
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
+	codec_settings_native = codec_settings_to_native(env, codec_settings);
+	res = toxav_call(globals->toxav, &id, friend_id, &codec_settings_native, ringing_seconds);
+
+	if (res == 0) {
+		bitrate_forget(globals->bitrate, id);
+		media_stats_reset(globals->media_stats, id, monotonic_time_ns());
+		bitrate_settings(globals->bitrate, id, &codec_settings_native);
+	}
+
+	UNUSED(obj);
+	return res;
+}
+
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1call_1compiled
+(JNIEnv *env, jobject obj, jlong messenger, jint friend_id, jlong codec_settings, jint ringing_seconds)
+{
+	STATS_ENTRY(TOXAV_CALL_COMPILED);
+	int32_t id;
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
+	ToxAvCSettings *codec_settings_native = (ToxAvCSettings *) ((intptr_t) codec_settings);
+	jint res = toxav_call(globals->toxav, &id, friend_id, codec_settings_native, ringing_seconds);
+
+	if (res == 0) {
+		bitrate_forget(globals->bitrate, id);
+		media_stats_reset(globals->media_stats, id, monotonic_time_ns());
+		bitrate_settings(globals->bitrate, id, codec_settings_native);
+	}
+
 	UNUSED(obj);
+	UNUSED(env);
 	return res;
 }
 
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1hangup
 (JNIEnv *env, jobject obj, jlong messenger, jint call_index)
 {
-	ToxAv *tox_av = ((tox_av_jni_globals_t *) ((intptr_t) messenger))->toxav;
-	jint res = toxav_hangup(tox_av, (int32_t) call_index);
+	STATS_ENTRY(TOXAV_HANGUP);
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
+	jint res = toxav_hangup(globals->toxav, (int32_t) call_index);
+	bitrate_forget(globals->bitrate, (int32_t) call_index);
 	UNUSED(obj);
 	UNUSED(env);
 	return res;
@@ -765,33 +1630,64 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1hangup
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1answer
 (JNIEnv *env, jobject obj, jlong messenger, jint call_index, jobject codec_settings)
 {
+	STATS_ENTRY(TOXAV_ANSWER);
 	ToxAvCSettings codec_settings_native;
 	jint res;
 
-	ToxAv *tox_av = ((tox_av_jni_globals_t *) ((intptr_t) messenger))->toxav;
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
 	codec_settings_native = codec_settings_to_native(env, codec_settings);
-	res = toxav_answer(tox_av, (int32_t) call_index, &codec_settings_native);
+	res = toxav_answer(globals->toxav, (int32_t) call_index, &codec_settings_native);
+
+	if (res == 0) {
+		bitrate_forget(globals->bitrate, (int32_t) call_index);
+		media_stats_reset(globals->media_stats, (int32_t) call_index, monotonic_time_ns());
+		bitrate_settings(globals->bitrate, (int32_t) call_index, &codec_settings_native);
+	}
+
+	UNUSED(obj);
+	return res;
+}
+
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1answer_1compiled
+(JNIEnv *env, jobject obj, jlong messenger, jint call_index, jlong codec_settings)
+{
+	STATS_ENTRY(TOXAV_ANSWER_COMPILED);
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
+	ToxAvCSettings *codec_settings_native = (ToxAvCSettings *) ((intptr_t) codec_settings);
+	jint res = toxav_answer(globals->toxav, (int32_t) call_index, codec_settings_native);
+
+	if (res == 0) {
+		bitrate_forget(globals->bitrate, (int32_t) call_index);
+		media_stats_reset(globals->media_stats, (int32_t) call_index, monotonic_time_ns());
+		bitrate_settings(globals->bitrate, (int32_t) call_index, codec_settings_native);
+	}
+
 	UNUSED(obj);
+	UNUSED(env);
 	return res;
 }
 
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1reject
-(JNIEnv *env, jobject obj, jlong messenger, jint call_index, jstring reason)
+(JNIEnv *env, jobject obj, jlong messenger, jint call_index, jbyteArray reason)
 {
+	STATS_ENTRY(TOXAV_REJECT);
 	ToxAv *tox_av = ((tox_av_jni_globals_t *) ((intptr_t) messenger))->toxav;
-	const char *reason_native = (*env)->GetStringUTFChars(env, reason, 0);
+	char *reason_native = utf8_copy_cstring(env, reason);
 	jint res = toxav_reject(tox_av, (int32_t) call_index, reason_native);
+	free(reason_native);
 	UNUSED(obj);
 	return res;
 }
 
 
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1cancel
-(JNIEnv *env, jobject obj, jlong messenger, jint call_index, jint peer_id, jstring reason)
+(JNIEnv *env, jobject obj, jlong messenger, jint call_index, jint peer_id, jbyteArray reason)
 {
+	STATS_ENTRY(TOXAV_CANCEL);
 	ToxAv *tox_av = ((tox_av_jni_globals_t *) ((intptr_t) messenger))->toxav;
-	const char *reason_native = (*env)->GetStringUTFChars(env, reason, 0);
+	char *reason_native = utf8_copy_cstring(env, reason);
 	jint res = toxav_cancel(tox_av, (int32_t) call_index, (int) peer_id, reason_native);
+	free(reason_native);
 	UNUSED(obj);
 	return res;
 }
@@ -799,21 +1695,46 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1cancel
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1change_1settings
 (JNIEnv *env, jobject obj, jlong messenger, jint call_index, jobject codec_settings)
 {
+	STATS_ENTRY(TOXAV_CHANGE_SETTINGS);
 	ToxAvCSettings codec_settings_native;
 	jint res;
 
-	ToxAv *tox_av = ((tox_av_jni_globals_t *) ((intptr_t) messenger))->toxav;
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
 	codec_settings_native = codec_settings_to_native(env, codec_settings);
-	res = toxav_change_settings(tox_av, (int32_t) call_index, &codec_settings_native);
+	res = toxav_change_settings(globals->toxav, (int32_t) call_index, &codec_settings_native);
+
+	if (res == 0) {
+		bitrate_settings(globals->bitrate, (int32_t) call_index, &codec_settings_native);
+	}
+
+	UNUSED(obj);
+	return res;
+}
+
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1change_1settings_1compiled
+(JNIEnv *env, jobject obj, jlong messenger, jint call_index, jlong codec_settings)
+{
+	STATS_ENTRY(TOXAV_CHANGE_SETTINGS_COMPILED);
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
+	ToxAvCSettings *codec_settings_native = (ToxAvCSettings *) ((intptr_t) codec_settings);
+	jint res = toxav_change_settings(globals->toxav, (int32_t) call_index, codec_settings_native);
+
+	if (res == 0) {
+		bitrate_settings(globals->bitrate, (int32_t) call_index, codec_settings_native);
+	}
+
 	UNUSED(obj);
+	UNUSED(env);
 	return res;
 }
 
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1stop_1call
 (JNIEnv *env, jobject obj, jlong messenger, jint call_index)
 {
-	ToxAv *tox_av = ((tox_av_jni_globals_t *) ((intptr_t) messenger))->toxav;
-	jint res = toxav_stop_call(tox_av, (int32_t) call_index);
+	STATS_ENTRY(TOXAV_STOP_CALL);
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
+	jint res = toxav_stop_call(globals->toxav, (int32_t) call_index);
+	bitrate_forget(globals->bitrate, (int32_t) call_index);
 	UNUSED(obj);
 	UNUSED(env);
 	return res;
@@ -823,6 +1744,7 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1prepare_1transmission
 (JNIEnv *env, jobject obj, jlong messenger, jint call_index,
  jint jbuf_size, jint VAD_threshold, jint support_video)
 {
+	STATS_ENTRY(TOXAV_PREPARE_TRANSMISSION);
 	ToxAv *tox_av = ((tox_av_jni_globals_t *) ((intptr_t) messenger))->toxav;
 	jint res = toxav_prepare_transmission(tox_av, (int32_t) call_index, (uint32_t) jbuf_size, (uint32_t) VAD_threshold, (int) support_video);
 	UNUSED(obj);
@@ -834,6 +1756,7 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1prepare_1transmission
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1kill_1transmission
 (JNIEnv *env, jobject obj, jlong messenger, jint call_index)
 {
+	STATS_ENTRY(TOXAV_KILL_TRANSMISSION);
 	ToxAv *tox_av = ((tox_av_jni_globals_t *) ((intptr_t) messenger))->toxav;
 	jint res = toxav_kill_transmission(tox_av, (int32_t) call_index);
 	UNUSED(obj);
@@ -845,11 +1768,21 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1send_1video
 (JNIEnv *env, jobject obj, jlong messenger, jint call_index,
  jbyteArray frame, jint frame_size)
 {
-	ToxAv *tox_av = ((tox_av_jni_globals_t *) ((intptr_t) messenger))->toxav;
+	STATS_ENTRY(TOXAV_SEND_VIDEO);
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
+	ToxAvCSettings settings;
 	jbyte *_frame = (*env)->GetByteArrayElements(env, frame, 0);
-	jint res = toxav_send_video(tox_av, (int32_t) call_index, (uint8_t *) _frame, frame_size);
+	jint res = toxav_send_video(globals->toxav, (int32_t) call_index, (uint8_t *) _frame, frame_size);
 	(*env)->ReleaseByteArrayElements(env, frame, _frame, JNI_ABORT);
+	media_stats_sent(globals->media_stats, (int32_t) call_index, 1, res, frame_size);
+
+	if (bitrate_sent(globals->bitrate, (int32_t) call_index, res, monotonic_time_us(), &settings)) {
+		bitrate_applied(globals->bitrate, (int32_t) call_index,
+						toxav_change_settings(globals->toxav, (int32_t) call_index, &settings));
+	}
+
 	UNUSED(obj);
+	STATS_BYTES(frame_size);
 	return res;
 }
 
@@ -857,11 +1790,21 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1send_1audio
 (JNIEnv *env, jobject obj, jlong messenger, jint call_index,
  jbyteArray frame, jint frame_size)
 {
-	ToxAv *tox_av = ((tox_av_jni_globals_t *) ((intptr_t) messenger))->toxav;
+	STATS_ENTRY(TOXAV_SEND_AUDIO);
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
+	ToxAvCSettings settings;
 	jbyte *_frame = (*env)->GetByteArrayElements(env, frame, 0);
-	jint res = toxav_send_audio(tox_av, (int32_t) call_index, (uint8_t *) _frame, frame_size);
+	jint res = toxav_send_audio(globals->toxav, (int32_t) call_index, (uint8_t *) _frame, frame_size);
 	(*env)->ReleaseByteArrayElements(env, frame, _frame, JNI_ABORT);
+	media_stats_sent(globals->media_stats, (int32_t) call_index, 0, res, frame_size);
+
+	if (bitrate_sent(globals->bitrate, (int32_t) call_index, res, monotonic_time_us(), &settings)) {
+		bitrate_applied(globals->bitrate, (int32_t) call_index,
+						toxav_change_settings(globals->toxav, (int32_t) call_index, &settings));
+	}
+
 	UNUSED(obj);
+	STATS_BYTES(frame_size);
 	return res;
 }
 
@@ -869,41 +1812,42 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1send_1audio
 JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_toxav_1prepare_1video_1frame
 (JNIEnv *env, jobject obj, jlong messenger, jint call_index, jint dest_max, jbyteArray data, jint width, jint height)
 {
+	STATS_ENTRY(TOXAV_PREPARE_VIDEO_FRAME);
 	jbyteArray output;
 	vpx_image_t img;
-	ToxAv *tox_av = ((tox_av_jni_globals_t *) ((intptr_t) messenger))->toxav;
-	int stride = ALIGN(width, 16);
-	int y_size = stride * height;
-	int c_stride = ALIGN(stride / 2, 16);
-	int c_size = c_stride * height / 2;
-	//int size = y_size + c_size*2;
-	int cr_offset = y_size;
-	int cb_offset = y_size + c_size;
-	uint8_t y;
-	uint8_t v;
-	uint8_t u;
-	jbyte *_data = (*env)->GetByteArrayElements(env, data, 0);
-	vpx_img_alloc(&img, VPX_IMG_FMT_YV12, width, height, 1);
-	unsigned long int y_coord, x_coord;
-
-	for (y_coord = 0; y_coord < img.d_h; ++y_coord) {
-		for (x_coord = 0; x_coord < img.d_w; ++x_coord) {
-			y = *(_data + (y_coord * stride) + x_coord);
-			img.planes[0][y * (img.stride[0] + x_coord)] = y;
-
-			if (x_coord == (x_coord / 2) * 2) {
-				v = *(_data + cr_offset + (y_coord * c_stride) + x_coord / 2);
-				img.planes[1][y * (img.stride[1] + x_coord / 2)] = v;
-				u = *(_data + cb_offset + (y_coord * c_stride) + x_coord / 2);
-				img.planes[2][y * (img.stride[2] + x_coord / 2)] = u;
-			}
-		}
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
+	jbyte *_data;
+	jbyte *dest;
+	jint res;
+	uint64_t start;
+	uint64_t end;
+
+	if (width <= 0 || height <= 0 || dest_max <= 0
+			|| (size_t) (*env)->GetArrayLength(env, data) < yuv_yv12_size((unsigned int) width, (unsigned int) height)) {
+		return NULL;
 	}
 
-	jbyte *dest = malloc(sizeof(jbyte) * dest_max);
-	jint res = toxav_prepare_video_frame(tox_av, (int32_t) call_index,
-										 (uint8_t *) dest, dest_max, &img);
+	if (vpx_img_alloc(&img, VPX_IMG_FMT_YV12, (unsigned int) width, (unsigned int) height, 1) == NULL) {
+		return NULL;
+	}
+
+	_data = (*env)->GetByteArrayElements(env, data, 0);
+	yuv_yv12_to_vpx((uint8_t *) _data, &img);
 	(*env)->ReleaseByteArrayElements(env, data, _data, JNI_ABORT);
+
+	dest = malloc(sizeof(jbyte) * dest_max);
+	start = monotonic_time_ns();
+	res = toxav_prepare_video_frame(globals->toxav, (int32_t) call_index, (uint8_t *) dest, dest_max, &img);
+	end = monotonic_time_ns();
+	bitrate_prepared(globals->bitrate, (int32_t) call_index, 1, res, (end - start) / 1000);
+	media_stats_prepared(globals->media_stats, (int32_t) call_index, 1, res, end - start, end);
+	vpx_img_free(&img);
+
+	if (res < 0) {
+		free(dest);
+		return NULL;
+	}
+
 	output = (*env)->NewByteArray(env, res);
 	(*env)->SetByteArrayRegion(env, output, 0, res, dest);
 	free(dest);
@@ -915,12 +1859,17 @@ JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_toxav_1prepare_1video_1fr
 JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_toxav_1prepare_1audio_1frame
 (JNIEnv *env, jobject obj, jlong messenger, jint call_index, jint dest_max, jintArray frame, jint frame_size)
 {
+	STATS_ENTRY(TOXAV_PREPARE_AUDIO_FRAME);
 	jbyteArray output;
 	jbyte *dest = malloc(sizeof(jbyte) * dest_max);
-	ToxAv *tox_av = ((tox_av_jni_globals_t *) ((intptr_t) messenger))->toxav;
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
 	jint *_frame = (*env)->GetIntArrayElements(env, frame, 0);
-	jint res = toxav_prepare_audio_frame(tox_av, (int32_t) call_index,
+	uint64_t start = monotonic_time_ns();
+	jint res = toxav_prepare_audio_frame(globals->toxav, (int32_t) call_index,
 										 (uint8_t *) dest, dest_max, (int16_t *) _frame, frame_size);
+	uint64_t end = monotonic_time_ns();
+	bitrate_prepared(globals->bitrate, (int32_t) call_index, 0, res, (end - start) / 1000);
+	media_stats_prepared(globals->media_stats, (int32_t) call_index, 0, res, end - start, end);
 	output = (*env)->NewByteArray(env, res);
 	(*env)->SetByteArrayRegion(env, output, 0, res, dest);
 	free(dest);
@@ -930,9 +1879,102 @@ JNIEXPORT jbyteArray JNICALL Java_im_tox_jtoxcore_JTox_toxav_1prepare_1audio_1fr
 	return output;
 }
 
+JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1bitrate_1enable
+(JNIEnv *env, jobject obj, jlong messenger, jint call_index, jint min_video_bitrate, jint min_audio_bitrate)
+{
+	STATS_ENTRY(TOXAV_BITRATE_ENABLE);
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
+
+	UNUSED(env);
+	UNUSED(obj);
+
+	if (min_video_bitrate < 0 || min_audio_bitrate < 0) {
+		return -1;
+	}
+
+	return bitrate_enable(globals->bitrate, (int32_t) call_index, (uint32_t) min_video_bitrate,
+						  (uint32_t) min_audio_bitrate, monotonic_time_us());
+}
+
+JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_toxav_1bitrate_1disable
+(JNIEnv *env, jobject obj, jlong messenger, jint call_index)
+{
+	STATS_ENTRY(TOXAV_BITRATE_DISABLE);
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
+	bitrate_disable(globals->bitrate, (int32_t) call_index);
+	UNUSED(env);
+	UNUSED(obj);
+}
+
+JNIEXPORT jlongArray JNICALL Java_im_tox_jtoxcore_JTox_toxav_1bitrate_1stats
+(JNIEnv *env, jobject obj, jlong messenger, jint call_index)
+{
+	STATS_ENTRY(TOXAV_BITRATE_STATS);
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
+	int64_t stats[BITRATE_STAT_COUNT];
+	jlongArray result;
+
+	UNUSED(obj);
+
+	if (bitrate_stats(globals->bitrate, (int32_t) call_index, stats) != 0) {
+		return NULL;
+	}
+
+	result = (*env)->NewLongArray(env, BITRATE_STAT_COUNT);
+	(*env)->SetLongArrayRegion(env, result, 0, BITRATE_STAT_COUNT, (jlong *) stats);
+	return result;
+}
+
+JNIEXPORT jlongArray JNICALL Java_im_tox_jtoxcore_JTox_toxav_1get_1call_1stats
+(JNIEnv *env, jobject obj, jlong messenger, jint call_index)
+{
+	STATS_ENTRY(TOXAV_GET_CALL_STATS);
+	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) ((intptr_t) messenger);
+	int64_t stats[MEDIA_STAT_COUNT];
+	jlongArray result;
+
+	UNUSED(obj);
+
+	if (media_stats_export(globals->media_stats, (int32_t) call_index, monotonic_time_ns(), stats) != 0) {
+		return NULL;
+	}
+
+	result = (*env)->NewLongArray(env, MEDIA_STAT_COUNT);
+	(*env)->SetLongArrayRegion(env, result, 0, MEDIA_STAT_COUNT, (jlong *) stats);
+	return result;
+}
+
+/**
+ * Convert codec settings once and keep the result, so calls made with it skip the field reads
+ */
+JNIEXPORT jlong JNICALL Java_im_tox_jtoxcore_JTox_toxav_1codec_1settings_1compile
+(JNIEnv *env, jclass clazz, jobject codec_settings)
+{
+	STATS_ENTRY(TOXAV_CODEC_SETTINGS_COMPILE);
+	ToxAvCSettings *compiled = malloc(sizeof(ToxAvCSettings));
+
+	if (compiled == NULL) {
+		return 0;
+	}
+
+	*compiled = codec_settings_to_native(env, codec_settings);
+	UNUSED(clazz);
+	return (jlong) ((intptr_t) compiled);
+}
+
+JNIEXPORT void JNICALL Java_im_tox_jtoxcore_JTox_toxav_1codec_1settings_1free
+(JNIEnv *env, jclass clazz, jlong codec_settings)
+{
+	STATS_ENTRY(TOXAV_CODEC_SETTINGS_FREE);
+	free((ToxAvCSettings *) ((intptr_t) codec_settings));
+	UNUSED(env);
+	UNUSED(clazz);
+}
+
 JNIEXPORT jobject JNICALL Java_im_tox_jtoxcore_JTox_toxav_1get_1peer_1csettings
 (JNIEnv *env, jobject obj, jlong messenger, jint call_index, jint peer)
 {
+	STATS_ENTRY(TOXAV_GET_PEER_CSETTINGS);
 	ToxAvCSettings _dest;
 	ToxAv *tox_av;
 	jobject java_codec_settings;
@@ -947,6 +1989,7 @@ JNIEXPORT jobject JNICALL Java_im_tox_jtoxcore_JTox_toxav_1get_1peer_1csettings
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1get_1peer_1id
 (JNIEnv *env, jobject obj, jlong messenger, jint call_index, jint peer)
 {
+	STATS_ENTRY(TOXAV_GET_PEER_ID);
 	ToxAv *tox_av = ((tox_av_jni_globals_t *) ((intptr_t) messenger))->toxav;
 	jint res = toxav_get_peer_id(tox_av, (int32_t) call_index, peer);
 	UNUSED(obj);
@@ -957,6 +2000,7 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1get_1peer_1id
 JNIEXPORT jobject JNICALL Java_im_tox_jtoxcore_JTox_toxav_1get_1call_1state
 (JNIEnv *env, jobject obj, jlong messenger, jint call_index)
 {
+	STATS_ENTRY(TOXAV_GET_CALL_STATE);
 	jfieldID enum_field_id;
 	jobject call_state;
 	jclass enum_class;
@@ -993,6 +2037,7 @@ JNIEXPORT jobject JNICALL Java_im_tox_jtoxcore_JTox_toxav_1get_1call_1state
 JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1capability_1supported
 (JNIEnv *env, jobject obj, jlong messenger, jint call_index, jobject capabilities)
 {
+	STATS_ENTRY(TOXAV_CAPABILITY_SUPPORTED);
 	jclass enum_class;
 	jmethodID get_name_method;
 	jstring enum_name;
@@ -1041,10 +2086,10 @@ JNIEXPORT jint JNICALL Java_im_tox_jtoxcore_JTox_toxav_1has_1activity
 /**
  * Begin Callback Section
  */
-static void callback_filecontrol(Tox *tox, int32_t friendnumber, uint8_t receive_send, uint8_t filenumber,
-								 uint8_t control_type, uint8_t *data, uint16_t length, void *rptr)
+/* Pass a file control packet on to Java */
+static void deliver_filecontrol(tox_jni_globals_t *ptr, int32_t friendnumber, uint8_t receive_send,
+								uint8_t filenumber, uint8_t control_type, const uint8_t *data, uint16_t length)
 {
-	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
 	JNIEnv *env;
 	jbyteArray _data;
 	jclass control_enum;
@@ -1053,7 +2098,6 @@ static void callback_filecontrol(Tox *tox, int32_t friendnumber, uint8_t receive
 	jobject enum_val;
 
 	ATTACH_THREAD(ptr, env);
-
 	control_enum = (*env)->FindClass(env, "im/tox/jtoxcore/ToxFileControl");
 
 	switch (control_type) {
@@ -1085,15 +2129,47 @@ static void callback_filecontrol(Tox *tox, int32_t friendnumber, uint8_t receive
 	(*env)->SetByteArrayRegion(env, _data, 0, length, (jbyte *) data);
 
     (*env)->CallVoidMethod(env, ptr->handler, ptr->cache->onFileControlMethodId, friendnumber, receive_send, filenumber, enum_val, _data);
-	UNUSED(tox);
+}
+
+static void callback_filecontrol(Tox *tox, int32_t friendnumber, uint8_t receive_send, uint8_t filenumber,
+								 uint8_t control_type, uint8_t *data, uint16_t length, void *rptr)
+{
+	STATS_ENTRY(CALLBACK_FILECONTROL);
+	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
+
+	if (receive_send == 1) {
+		filesched_control(ptr->file_scheduler, tox, friendnumber, filenumber, control_type, data, length);
+	} else if (journal_control(ptr->journal, friendnumber, filenumber, control_type) != 0) {
+		/* Finished before everything arrived, which is a failed transfer to the application */
+		control_type = TOX_FILECONTROL_KILL;
+	}
+
+	deliver_filecontrol(ptr, friendnumber, receive_send, filenumber, control_type, data, length);
 }
 
 static void callback_filedata(Tox *tox, int32_t friendnumber, uint8_t filenumber, uint8_t *data, uint16_t length,
 							  void *rptr)
 {
+	STATS_ENTRY(CALLBACK_FILEDATA);
 	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
 	JNIEnv *env;
 	jbyteArray _data;
+	int result;
+
+	STATS_BYTES(length);
+
+	/* Transfers received through JTox.receiveFile are written natively */
+	result = journal_data(ptr->journal, tox, friendnumber, filenumber, data, length);
+
+	if (result == -1) {
+		/* The transfer was killed, tell the application as if the friend had */
+		deliver_filecontrol(ptr, friendnumber, 0, filenumber, TOX_FILECONTROL_KILL, NULL, 0);
+		return;
+	}
+
+	if (result != 0) {
+		return;
+	}
 
     ATTACH_THREAD(ptr, env);
 
@@ -1101,12 +2177,12 @@ static void callback_filedata(Tox *tox, int32_t friendnumber, uint8_t filenumber
 	(*env)->SetByteArrayRegion(env, _data, 0, length, (jbyte *) data);
 
     (*env)->CallVoidMethod(env, ptr->handler, ptr->cache->onFileDataMethodId, friendnumber, filenumber, _data);
-	UNUSED(tox);
 }
 
 static void callback_filesendrequest(Tox *tox, int32_t friendnumber, uint8_t filenumber, uint64_t filesize,
 									 uint8_t *filename, uint16_t length, void *rptr)
 {
+	STATS_ENTRY(CALLBACK_FILESENDREQUEST);
 	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
 	JNIEnv *env;
 	jbyteArray _filename;
@@ -1122,88 +2198,126 @@ static void callback_filesendrequest(Tox *tox, int32_t friendnumber, uint8_t fil
 
 static void callback_friendrequest(Tox *tox, uint8_t *pubkey, uint8_t *message, uint16_t length, void *rptr)
 {
+	STATS_ENTRY(CALLBACK_FRIENDREQUEST);
 	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
 	JNIEnv *env;
-	char buf[ADDR_SIZE_HEX] = { 0 };
-	jstring _pubkey;
+	jbyteArray _pubkey;
 	jbyteArray _message;
 
-	ATTACH_THREAD(ptr, env);	
+	/* Spam is dropped here, before the thread is attached or anything is allocated */
+	if (!reqfilter_check(ptr->request_filter, pubkey, length, monotonic_time_us())) {
+		UNUSED(tox);
+		return;
+	}
+
+	ATTACH_THREAD(ptr, env);
 
-	addr_to_hex(pubkey, buf);
-	_pubkey = (*env)->NewStringUTF(env, buf);
-	_message = (*env)->NewByteArray(env, length);
-	(*env)->SetByteArrayRegion(env, _message, 0, length, (jbyte *) message);
+	_pubkey = bytes_to_java(env, pubkey, TOX_CLIENT_ID_SIZE);
+	_message = bytes_to_java(env, message, length);
 
     (*env)->CallVoidMethod(env, ptr->handler, ptr->cache->onFriendRequestMethodId, _pubkey, _message);
+	(*env)->DeleteLocalRef(env, _pubkey);
+	(*env)->DeleteLocalRef(env, _message);
 	UNUSED(tox);
+	STATS_BYTES(length);
 }
 
-static void callback_friendmessage(Tox *tox, int friendnumber, uint8_t *message, uint16_t length, void *rptr)
+/**
+ * Copy an incoming message, action, name or status message into the handler's
+ * shared direct buffer and pass only its length up. No java array is allocated
+ * here; the handler decides whether any listener needs one.
+ */
+static void dispatch_event_buffer(tox_jni_globals_t *ptr, jmethodID method, int32_t friendnumber, const uint8_t *data,
+                                  uint16_t length)
 {
-	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
-    JNIEnv *env;
-	jbyteArray _message;
+	JNIEnv *env;
+	jint copied = length < ptr->event_buffer_capacity ? length : (jint) ptr->event_buffer_capacity;
 
-    ATTACH_THREAD(ptr, env);
+	ATTACH_THREAD(ptr, env);
+
+	memcpy(ptr->event_buffer, data, copied);
+	(*env)->CallVoidMethod(env, ptr->handler, method, friendnumber, copied);
+}
 
-	_message = (*env)->NewByteArray(env, length);
-	(*env)->SetByteArrayRegion(env, _message, 0, length, (jbyte *) message);
-    (*env)->CallVoidMethod(env, ptr->handler, ptr->cache->onMessageMethodId, friendnumber, _message);
+static void callback_friendmessage(Tox *tox, int friendnumber, uint8_t *message, uint16_t length, void *rptr)
+{
+	STATS_ENTRY(CALLBACK_FRIENDMESSAGE);
+	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
 
+	dispatch_event_buffer(ptr, ptr->cache->onMessageMethodId, friendnumber, message, length);
 	UNUSED(tox);
+	STATS_BYTES(length);
 }
 
 static void callback_action(Tox *tox, int32_t friendnumber, uint8_t *action, uint16_t length, void *rptr)
 {
+	STATS_ENTRY(CALLBACK_ACTION);
 	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
-	JNIEnv *env;
-	jbyteArray _action;
-
-	ATTACH_THREAD(ptr, env);
-
-	_action = (*env)->NewByteArray(env, length);
-	(*env)->SetByteArrayRegion(env, _action, 0, length, (jbyte *) action);
-    (*env)->CallVoidMethod(env, ptr->handler, ptr->cache->onActionMethodId, friendnumber, _action);
 
+	dispatch_event_buffer(ptr, ptr->cache->onActionMethodId, friendnumber, action, length);
 	UNUSED(tox);
+	STATS_BYTES(length);
 }
 
 static void callback_namechange(Tox *tox, int32_t friendnumber, uint8_t *newname, uint16_t length, void *rptr)
 {
+	STATS_ENTRY(CALLBACK_NAMECHANGE);
 	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
-	JNIEnv *env;
-
-	jbyteArray _newname;
 
-	ATTACH_THREAD(ptr, env);
+	ptr->dirty = 1;
 
-	_newname = (*env)->NewByteArray(env, length);
-	(*env)->SetByteArrayRegion(env, _newname, 0, length, (jbyte *) newname);
-    (*env)->CallVoidMethod(env, ptr->handler, ptr->cache->onNameChangeMethodId, friendnumber, _newname);
+	if (presence_data(ptr->presence, friendnumber, PRESENCE_NAME, newname, length) != 0) {
+		dispatch_event_buffer(ptr, ptr->cache->onNameChangeMethodId, friendnumber, newname, length);
+	}
 
 	UNUSED(tox);
+	STATS_BYTES(length);
 }
 
 static void callback_statusmessage(Tox *tox, int32_t friendnumber, uint8_t *newstatus, uint16_t length, void *rptr)
 {
+	STATS_ENTRY(CALLBACK_STATUSMESSAGE);
 	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
-	JNIEnv *env;
-
-	jbyteArray _newstatus;
 
-	ATTACH_THREAD(ptr, env);
+	ptr->dirty = 1;
 
-	_newstatus = (*env)->NewByteArray(env, length);
-	(*env)->SetByteArrayRegion(env, _newstatus, 0, length, (jbyte *) newstatus);
-    (*env)->CallVoidMethod(env, ptr->handler, ptr->cache->onStatusMessageMethodId, friendnumber, _newstatus);
+	if (presence_data(ptr->presence, friendnumber, PRESENCE_STATUS_MESSAGE, newstatus, length) != 0) {
+		dispatch_event_buffer(ptr, ptr->cache->onStatusMessageMethodId, friendnumber, newstatus, length);
+	}
 
 	UNUSED(tox);
+	STATS_BYTES(length);
+}
+
+/**
+ * Hand java the roster's new memory if an update moved it
+ */
+static void update_roster(tox_jni_globals_t *ptr, int moved)
+{
+	JNIEnv *env;
+
+	if (moved == 1) {
+		ATTACH_THREAD(ptr, env);
+		publish_roster(env, ptr);
+	}
 }
 
 static void callback_userstatus(Tox *tox, int32_t friendnumber, uint8_t status, void *rptr)
 {
+	STATS_ENTRY(CALLBACK_USERSTATUS);
 	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
+
+	update_roster(ptr, roster_set_status(ptr->roster, friendnumber, status));
+
+	if (presence_value(ptr->presence, friendnumber, PRESENCE_USER_STATUS, status) != 0) {
+		deliver_userstatus(ptr, friendnumber, status);
+	}
+
+	UNUSED(tox);
+}
+
+static void deliver_userstatus(tox_jni_globals_t *ptr, int32_t friendnumber, uint8_t status)
+{
 	JNIEnv *env;
 
 	jclass us_enum;
@@ -1236,12 +2350,11 @@ static void callback_userstatus(Tox *tox, int32_t friendnumber, uint8_t status,
 	fieldID = (*env)->GetStaticFieldID(env, us_enum, enum_name, "Lim/tox/jtoxcore/ToxUserStatus;");
 	enum_val = (*env)->GetStaticObjectField(env, us_enum, fieldID);
     (*env)->CallVoidMethod(env, ptr->handler, ptr->cache->onUserStatusMethodId, friendnumber, enum_val);
-
-	UNUSED(tox);
 }
 
 static void callback_read_receipt(Tox *tox, int32_t friendnumber, uint32_t receipt, void *rptr)
 {
+	STATS_ENTRY(CALLBACK_READ_RECEIPT);
 	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
 	JNIEnv *env;
 
@@ -1253,7 +2366,24 @@ static void callback_read_receipt(Tox *tox, int32_t friendnumber, uint32_t recei
 
 static void callback_connectionstatus(Tox *tox, int32_t friendnumber, uint8_t newstatus, void *rptr)
 {
+	STATS_ENTRY(CALLBACK_CONNECTIONSTATUS);
 	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
+
+	if (newstatus != 0) {
+		uint64_t now = monotonic_time_us();
+		timeline_mark(ptr->timeline, TIMELINE_FRIEND_CONNECTED, friendnumber, now, now);
+		journal_reconnect(ptr->journal, tox, friendnumber);
+	}
+
+	update_roster(ptr, roster_set_online(ptr->roster, friendnumber, newstatus != 0));
+
+	if (presence_value(ptr->presence, friendnumber, PRESENCE_CONNECTION, newstatus != 0) != 0) {
+		deliver_connectionstatus(ptr, friendnumber, newstatus);
+	}
+}
+
+static void deliver_connectionstatus(tox_jni_globals_t *ptr, int32_t friendnumber, uint8_t newstatus)
+{
 	JNIEnv *env;
 
 	jboolean _newstatus;
@@ -1261,13 +2391,22 @@ static void callback_connectionstatus(Tox *tox, int32_t friendnumber, uint8_t ne
 	ATTACH_THREAD(ptr, env);
 	_newstatus = newstatus == 0 ? JNI_FALSE : JNI_TRUE;
     (*env)->CallVoidMethod(env, ptr->handler, ptr->cache->onConnectionStatusMethodId, friendnumber, _newstatus);
-
-	UNUSED(tox);
 }
 
 static void callback_typingstatus(Tox *tox, int32_t friendnumber, uint8_t is_typing, void *rptr)
 {
+	STATS_ENTRY(CALLBACK_TYPINGSTATUS);
 	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
+
+	if (presence_value(ptr->presence, friendnumber, PRESENCE_TYPING, is_typing != 0) != 0) {
+		deliver_typingstatus(ptr, friendnumber, is_typing);
+	}
+
+	UNUSED(tox);
+}
+
+static void deliver_typingstatus(tox_jni_globals_t *ptr, int32_t friendnumber, uint8_t is_typing)
+{
 	JNIEnv *env;
 
 	jboolean _is_typing;
@@ -1275,81 +2414,187 @@ static void callback_typingstatus(Tox *tox, int32_t friendnumber, uint8_t is_typ
 	ATTACH_THREAD(ptr, env);
 	_is_typing = is_typing == 0 ? JNI_FALSE : JNI_TRUE;
     (*env)->CallVoidMethod(env, ptr->handler, ptr->cache->onTypingChangeMethodId, friendnumber, _is_typing);
+}
+
+/**
+ * Deliver a presence event that was held back until the end of a tick
+ */
+static void deliver_presence(void *rptr, int32_t friendnumber, int kind, uint8_t value, const uint8_t *data,
+							 uint16_t length)
+{
+	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
+
+	switch (kind) {
+		case PRESENCE_CONNECTION:
+			deliver_connectionstatus(ptr, friendnumber, value);
+			break;
+
+		case PRESENCE_NAME:
+			dispatch_event_buffer(ptr, ptr->cache->onNameChangeMethodId, friendnumber, data, length);
+			break;
+
+		case PRESENCE_STATUS_MESSAGE:
+			dispatch_event_buffer(ptr, ptr->cache->onStatusMessageMethodId, friendnumber, data, length);
+			break;
+
+		case PRESENCE_USER_STATUS:
+			deliver_userstatus(ptr, friendnumber, value);
+			break;
+
+		case PRESENCE_TYPING:
+			deliver_typingstatus(ptr, friendnumber, value);
+			break;
+	}
+}
+
+static void callback_group_invite(Tox *tox, int32_t friendnumber, uint8_t *group_public_key, void *rptr)
+{
+	STATS_ENTRY(CALLBACK_GROUP_INVITE);
+	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
+	JNIEnv *env;
+	jbyteArray _key;
+
+	ATTACH_THREAD(ptr, env);
+	_key = bytes_to_java(env, group_public_key, TOX_CLIENT_ID_SIZE);
+    (*env)->CallVoidMethod(env, ptr->handler, ptr->cache->onGroupInviteMethodId, friendnumber, _key);
+	(*env)->DeleteLocalRef(env, _key);
+	UNUSED(tox);
+}
+
+/**
+ * Group chat counterpart of dispatch_event_buffer
+ */
+static void dispatch_group_event_buffer(tox_jni_globals_t *ptr, jmethodID method, int groupnumber, int peernumber,
+                                        const uint8_t *data, uint16_t length)
+{
+	JNIEnv *env;
+	jint copied = length < ptr->event_buffer_capacity ? length : (jint) ptr->event_buffer_capacity;
+
+	ATTACH_THREAD(ptr, env);
+
+	memcpy(ptr->event_buffer, data, copied);
+	(*env)->CallVoidMethod(env, ptr->handler, method, groupnumber, peernumber, copied);
+}
+
+static void callback_group_message(Tox *tox, int groupnumber, int peernumber, uint8_t *message, uint16_t length,
+								   void *rptr)
+{
+	STATS_ENTRY(CALLBACK_GROUP_MESSAGE);
+	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
+
+	dispatch_group_event_buffer(ptr, ptr->cache->onGroupMessageMethodId, groupnumber, peernumber, message, length);
+	UNUSED(tox);
+	STATS_BYTES(length);
+}
+
+static void callback_group_action(Tox *tox, int groupnumber, int peernumber, uint8_t *action, uint16_t length,
+								  void *rptr)
+{
+	STATS_ENTRY(CALLBACK_GROUP_ACTION);
+	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
+
+	dispatch_group_event_buffer(ptr, ptr->cache->onGroupActionMethodId, groupnumber, peernumber, action, length);
+	UNUSED(tox);
+	STATS_BYTES(length);
+}
 
+static void callback_group_namelist_change(Tox *tox, int groupnumber, int peernumber, uint8_t change, void *rptr)
+{
+	STATS_ENTRY(CALLBACK_GROUP_NAMELIST_CHANGE);
+	tox_jni_globals_t *ptr = (tox_jni_globals_t *) rptr;
+	JNIEnv *env;
+
+	ATTACH_THREAD(ptr, env);
+    (*env)->CallVoidMethod(env, ptr->handler, ptr->cache->onGroupNamelistChangeMethodId, groupnumber, peernumber,
+                           (jint) change);
 	UNUSED(tox);
 }
 
 static void avcallback_invite(void *tox_av, int32_t call_id, void *user_data)
 {
+	STATS_ENTRY(AVCALLBACK_INVITE);
 	avcallback_helper(call_id, user_data, "ON_INVITE");
 
 	UNUSED(tox_av);
 }
 static void avcallback_start(void *tox_av, int32_t call_id, void *user_data)
 {
+	STATS_ENTRY(AVCALLBACK_START);
 	avcallback_helper(call_id, user_data, "ON_START");
 
 	UNUSED(tox_av);
 }
 static void avcallback_cancel(void *tox_av, int32_t call_id, void *user_data)
 {
+	STATS_ENTRY(AVCALLBACK_CANCEL);
 	avcallback_helper(call_id, user_data, "ON_CANCEL");
 
 	UNUSED(tox_av);
 }
 static void avcallback_reject(void *tox_av, int32_t call_id, void *user_data)
 {
+	STATS_ENTRY(AVCALLBACK_REJECT);
 	avcallback_helper(call_id, user_data, "ON_REJECT");
 
 	UNUSED(tox_av);
 }
 static void avcallback_end(void *tox_av, int32_t call_id, void *user_data)
 {
+	STATS_ENTRY(AVCALLBACK_END);
 	avcallback_helper(call_id, user_data, "ON_END");
 
 	UNUSED(tox_av);
 }
 static void avcallback_ringing(void *tox_av, int32_t call_id, void *user_data)
 {
+	STATS_ENTRY(AVCALLBACK_RINGING);
 	avcallback_helper(call_id, user_data, "ON_RINGING");
 
 	UNUSED(tox_av);
 }
 static void avcallback_starting(void *tox_av, int32_t call_id, void *user_data)
 {
+	STATS_ENTRY(AVCALLBACK_STARTING);
 	avcallback_helper(call_id, user_data, "ON_STARTING");
 
 	UNUSED(tox_av);
 }
 static void avcallback_ending(void *tox_av, int32_t call_id, void *user_data)
 {
+	STATS_ENTRY(AVCALLBACK_ENDING);
 	avcallback_helper(call_id, user_data, "ON_ENDING");
 
 	UNUSED(tox_av);
 }
 static void avcallback_requesttimeout(void *tox_av, int32_t call_id, void *user_data)
 {
+	STATS_ENTRY(AVCALLBACK_REQUESTTIMEOUT);
 	avcallback_helper(call_id, user_data, "ON_REQUEST_TIMEOUT");
 
 	UNUSED(tox_av);
 }
 static void avcallback_peertimeout(void *tox_av, int32_t call_id, void *user_data)
 {
+	STATS_ENTRY(AVCALLBACK_PEERTIMEOUT);
 	avcallback_helper(call_id, user_data, "ON_PEER_TIMEOUT");
 
 	UNUSED(tox_av);
 }
 static void avcallback_mediachange(void *tox_av, int32_t call_id, void *user_data)
 {
+	STATS_ENTRY(AVCALLBACK_MEDIACHANGE);
 	avcallback_helper(call_id, user_data, "ON_MEDIA_CHANGE");
 
 	UNUSED(tox_av);
 }
 static void avcallback_audio(ToxAv *tox_av, int32_t call_id, int16_t *pcm_data, int pcm_data_length, void *user_data)
 {
+	STATS_ENTRY(AVCALLBACK_AUDIO);
 	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) user_data;
 	JNIEnv *env;
 	jbyteArray output;
+	uint64_t start = monotonic_time_ns();
+	uint64_t end;
 
 	ATTACH_THREAD(globals, env);
 	
@@ -1359,57 +2604,43 @@ static void avcallback_audio(ToxAv *tox_av, int32_t call_id, int16_t *pcm_data,
 
 	(*env)->CallVoidMethod(env, globals->handler, globals->cache->onAudioDataMethodId, call_id, output);
 	(*env)->DeleteLocalRef(env, output);
+	end = monotonic_time_ns();
+	media_stats_received(globals->media_stats, call_id, 0, (size_t) pcm_data_length * sizeof(int16_t),
+						 end - start, end);
 
 	UNUSED(tox_av);
+	STATS_BYTES(pcm_data_length * sizeof(int16_t));
 }
 static void avcallback_video(ToxAv *tox_av, int32_t call_id, vpx_image_t *img, void *user_data)
 {
+	STATS_ENTRY(AVCALLBACK_VIDEO);
 	tox_av_jni_globals_t *globals = (tox_av_jni_globals_t *) user_data;
     JNIEnv *env;
 	jmethodID handlermeth;
+	uint64_t start = monotonic_time_ns();
+	uint64_t end;
 
 	ATTACH_THREAD(globals, env);
 
 	//Create Android YV12 byte array from vpx_image
 	jbyteArray output;
-	int stride = ALIGN(img->d_w, 16);
-	int y_size = stride * (img->d_h);
-	int c_stride = ALIGN(stride / 2, 16);
-	int c_size = c_stride * (img->d_h) / 2;
-	int size = y_size + c_size * 2;
-	int cr_offset = y_size;
-	int cb_offset = y_size + c_size;
-	uint8_t y;
-	uint8_t v;
-	uint8_t u;
+	int size = (int) yuv_yv12_size(img->d_w, img->d_h);
 	jbyte _output[size];
-	unsigned long int y_coord, x_coord;
-
-	for (y_coord = 0; y_coord < img->d_h; ++y_coord) {
-		for (x_coord = 0; x_coord < img->d_w; ++x_coord) {
-			y = (img->planes[0][((y_coord * img->stride[0]), x_coord)]);
-			_output[(y_coord * stride) + x_coord] = y;
-
-			if (x_coord == (x_coord / 2) * 2) {
-				v = (img->planes[1][((y_coord * (img->stride[1] / 2)), x_coord / 2)]);
-				_output[cr_offset + (y_coord * c_stride) + x_coord / 2] = v;
-				u = (img->planes[2][((y_coord * (img->stride[2] / 2)), x_coord / 2)]);
-				_output[cb_offset + (y_coord * c_stride) + x_coord / 2] = u;
-			}
-		}
-	}
 
+	yuv_vpx_to_yv12(img, (uint8_t *) _output);
 	output = (*env)->NewByteArray(env, size);
 	(*env)->SetByteArrayRegion(env, output, 0, size, _output);
 
     (*env)->CallVoidMethod(env, globals->handler, globals->cache->onVideoDataMethodId, call_id, output, img->d_w, img->d_h);
+	(*env)->DeleteLocalRef(env, output);
+	end = monotonic_time_ns();
+	media_stats_received(globals->media_stats, call_id, 1, (size_t) size, end - start, end);
 
     UNUSED(tox_av);
 }
 
 Tox_Options tox_options_to_native(JNIEnv *env, jobject tox_options)
 {
-    int i;
     jclass clazz;
     jfieldID ipv6enabled_fieldid;
     jfieldID udp_enabled_fieldid;
@@ -1422,8 +2653,8 @@ Tox_Options tox_options_to_native(JNIEnv *env, jobject tox_options)
     jboolean proxy_enabled;
     jstring proxy_address;
     
-    char *proxy_address_native;
-    jint *port;
+    jint port;
+    jsize proxy_address_length;
 
 
     clazz = (*env)->FindClass(env, "im/tox/jtoxcore/ToxOptions");
@@ -1457,12 +2688,15 @@ Tox_Options tox_options_to_native(JNIEnv *env, jobject tox_options)
 
 
     	proxy_address = (*env)->GetObjectField(env, tox_options, proxy_address_fieldid);
-    	proxy_address_native = (*env)->GetStringUTFChars(env, proxy_address, JNI_FALSE);
-    	for (i = 0; i < sizeof(proxy_address_native); i++) {
-       		tox_options_native.proxy_address[i] = proxy_address_native[i];
+    	/* Host names are plain ASCII, where modified UTF-8 and UTF-8 are the same */
+    	proxy_address_length = (*env)->GetStringUTFLength(env, proxy_address);
+    	if (proxy_address_length < (jsize) sizeof(tox_options_native.proxy_address)) {
+    		(*env)->GetStringUTFRegion(env, proxy_address, 0, (*env)->GetStringLength(env, proxy_address),
+    		                           tox_options_native.proxy_address);
+    		tox_options_native.proxy_address[proxy_address_length] = '\0';
+    	} else {
+    		tox_options_native.proxy_address[0] = '\0';
     	}
-    	tox_options_native.proxy_address[sizeof(proxy_address_native)] = '\0';
-    	(*env)->ReleaseStringUTFChars(env, proxy_address, proxy_address_native);
 
     } else {
     	tox_options_native.proxy_enabled = 0;
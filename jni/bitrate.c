@@ -0,0 +1,463 @@
+/* bitrate.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "bitrate.h"
+
+/*
+ * Optional per call controller that steps the codec settings down when sending struggles and back
+ * up once it has recovered. The application keeps calling send and prepare as before; the
+ * controller watches their results and, at the end of each window, decides whether to move one
+ * level along a fixed ladder:
+ *
+ *  - the first levels scale the video bitrate by 4/5 each, down to the video floor. The maximum
+ *    resolution follows the bitrate: 3/4 of the negotiated size below half the negotiated rate,
+ *    1/2 below a quarter of it
+ *  - the remaining levels halve the audio bitrate, down to the audio floor
+ *
+ * A window is bad when too many sends failed or encoding took too long, and good when nearly all
+ * sends went through quickly and the encoder actually used most of the bitrate it was given.
+ * Windows in between reset both streaks. Stepping down takes BITRATE_DOWN_WINDOWS bad windows in
+ * a row, stepping up BITRATE_UP_WINDOWS good ones, and both streaks restart after each change, so
+ * a call does not flap between two levels.
+ *
+ * The settings passed to toxav_call, toxav_answer or toxav_change_settings are the ceiling; a
+ * manual change resets the ladder to it.
+ */
+#define BITRATE_WINDOW_US 1000000
+#define BITRATE_DOWN_WINDOWS 2
+#define BITRATE_UP_WINDOWS 5
+/* Failed sends, in percent of all sends in a window */
+#define BITRATE_BAD_FAILURES 10
+#define BITRATE_GOOD_FAILURES 1
+/* Mean time spent in toxav_prepare_*_frame */
+#define BITRATE_BAD_LATENCY_US 40000
+#define BITRATE_GOOD_LATENCY_US 15000
+/* Floors used when the application passes 0, in kbit/s and bit/s like ToxAvCSettings */
+#define BITRATE_DEFAULT_MIN_VIDEO 100
+#define BITRATE_DEFAULT_MIN_AUDIO 16000
+
+typedef struct {
+	/* Set once the call's own settings are known */
+	int known;
+	int enabled;
+	ToxAvCSettings ceiling;
+	ToxAvCSettings current;
+	/* Floors as the application asked for them, and as used for the current ceiling */
+	uint32_t requested_min_video_bitrate;
+	uint32_t requested_min_audio_bitrate;
+	uint32_t min_video_bitrate;
+	uint32_t min_audio_bitrate;
+	unsigned int level;
+	/* Level the peer last accepted, restored when a change fails */
+	unsigned int applied_level;
+	unsigned int video_levels;
+	unsigned int max_level;
+	unsigned int bad_windows;
+	unsigned int good_windows;
+	uint64_t window_start;
+	uint32_t window_sends;
+	uint32_t window_failures;
+	uint64_t window_video_bytes;
+	uint32_t window_prepares;
+	uint64_t window_latency_us;
+	int64_t stats[BITRATE_STAT_COUNT];
+} call_bitrate_t;
+
+struct bitrate_controller {
+	call_bitrate_t *calls;
+	int32_t max_calls;
+};
+
+bitrate_controller_t *bitrate_new(int32_t max_calls)
+{
+	bitrate_controller_t *controller;
+
+	if (max_calls <= 0) {
+		return NULL;
+	}
+
+	controller = calloc(1, sizeof(bitrate_controller_t));
+
+	if (controller == NULL) {
+		return NULL;
+	}
+
+	controller->calls = calloc((size_t) max_calls, sizeof(call_bitrate_t));
+
+	if (controller->calls == NULL) {
+		free(controller);
+		return NULL;
+	}
+
+	controller->max_calls = max_calls;
+	return controller;
+}
+
+void bitrate_free(bitrate_controller_t *controller)
+{
+	if (controller != NULL) {
+		free(controller->calls);
+		free(controller);
+	}
+}
+
+static call_bitrate_t *get_call(const bitrate_controller_t *controller, int32_t call_index)
+{
+	if (controller == NULL || call_index < 0 || call_index >= controller->max_calls) {
+		return NULL;
+	}
+
+	return &controller->calls[call_index];
+}
+
+static uint32_t video_bitrate_at(const call_bitrate_t *call, unsigned int level)
+{
+	uint32_t rate = call->ceiling.video_bitrate;
+	unsigned int i;
+
+	for (i = 0; i < level && rate > call->min_video_bitrate; i++) {
+		rate = rate / 5 * 4 + rate % 5 * 4 / 5;
+	}
+
+	return rate < call->min_video_bitrate ? call->min_video_bitrate : rate;
+}
+
+static uint16_t scale_dimension(uint16_t size, unsigned int numerator, unsigned int denominator)
+{
+	uint32_t scaled = (uint32_t) size * numerator / denominator & ~1u;
+
+	return scaled == 0 ? size : (uint16_t) scaled;
+}
+
+/*
+ * Count the levels of the ladder for the current ceiling and floors. Floors above the ceiling are
+ * lowered to it, and go back up with a later, higher ceiling.
+ */
+static void build_ladder(call_bitrate_t *call)
+{
+	uint32_t rate;
+
+	call->min_video_bitrate = call->requested_min_video_bitrate;
+	call->min_audio_bitrate = call->requested_min_audio_bitrate;
+
+	if (call->min_video_bitrate > call->ceiling.video_bitrate) {
+		call->min_video_bitrate = call->ceiling.video_bitrate;
+	}
+
+	if (call->min_audio_bitrate > call->ceiling.audio_bitrate) {
+		call->min_audio_bitrate = call->ceiling.audio_bitrate;
+	}
+
+	call->video_levels = 0;
+
+	if (call->ceiling.call_type == TypeVideo) {
+		while (video_bitrate_at(call, call->video_levels) > call->min_video_bitrate) {
+			call->video_levels++;
+		}
+	}
+
+	call->max_level = call->video_levels;
+
+	for (rate = call->ceiling.audio_bitrate; rate > 1 && rate / 2 >= call->min_audio_bitrate; rate /= 2) {
+		call->max_level++;
+	}
+}
+
+/*
+ * Derive the settings for the current level from the ceiling
+ */
+static void apply_level(call_bitrate_t *call)
+{
+	unsigned int video_level = call->level < call->video_levels ? call->level : call->video_levels;
+	unsigned int i;
+
+	call->current = call->ceiling;
+
+	if (call->ceiling.call_type == TypeVideo) {
+		call->current.video_bitrate = video_bitrate_at(call, video_level);
+
+		if ((uint64_t) call->current.video_bitrate * 4 <= call->ceiling.video_bitrate) {
+			call->current.max_video_width = scale_dimension(call->ceiling.max_video_width, 1, 2);
+			call->current.max_video_height = scale_dimension(call->ceiling.max_video_height, 1, 2);
+		} else if ((uint64_t) call->current.video_bitrate * 2 <= call->ceiling.video_bitrate) {
+			call->current.max_video_width = scale_dimension(call->ceiling.max_video_width, 3, 4);
+			call->current.max_video_height = scale_dimension(call->ceiling.max_video_height, 3, 4);
+		}
+	}
+
+	for (i = call->video_levels; i < call->level; i++) {
+		call->current.audio_bitrate /= 2;
+	}
+
+	call->stats[BITRATE_STAT_LEVEL] = call->level;
+	call->stats[BITRATE_STAT_VIDEO_BITRATE] = call->current.video_bitrate;
+	call->stats[BITRATE_STAT_VIDEO_WIDTH] = call->current.max_video_width;
+	call->stats[BITRATE_STAT_VIDEO_HEIGHT] = call->current.max_video_height;
+	call->stats[BITRATE_STAT_AUDIO_BITRATE] = call->current.audio_bitrate;
+}
+
+static void reset_window(call_bitrate_t *call, uint64_t now_us)
+{
+	call->window_start = now_us;
+	call->window_sends = 0;
+	call->window_failures = 0;
+	call->window_video_bytes = 0;
+	call->window_prepares = 0;
+	call->window_latency_us = 0;
+}
+
+/*
+ * Record the settings the call was set up or changed with. They become the ceiling, and a
+ * controlled call starts over from the top of the ladder.
+ */
+void bitrate_settings(bitrate_controller_t *controller, int32_t call_index, const ToxAvCSettings *settings)
+{
+	call_bitrate_t *call = get_call(controller, call_index);
+
+	if (call == NULL) {
+		return;
+	}
+
+	call->known = 1;
+	call->ceiling = *settings;
+	call->level = 0;
+	call->applied_level = 0;
+	call->bad_windows = 0;
+	call->good_windows = 0;
+
+	if (call->enabled) {
+		build_ladder(call);
+		apply_level(call);
+	}
+}
+
+/*
+ * Drop everything known about a call, when it ends
+ */
+void bitrate_forget(bitrate_controller_t *controller, int32_t call_index)
+{
+	call_bitrate_t *call = get_call(controller, call_index);
+
+	if (call != NULL) {
+		memset(call, 0, sizeof(call_bitrate_t));
+	}
+}
+
+/*
+ * Start controlling a call. Floors of 0 pick the defaults, floors above the negotiated rates are
+ * lowered to them. Returns -1 if the call's settings are not known.
+ */
+int bitrate_enable(bitrate_controller_t *controller, int32_t call_index, uint32_t min_video_bitrate,
+				   uint32_t min_audio_bitrate, uint64_t now_us)
+{
+	call_bitrate_t *call = get_call(controller, call_index);
+
+	if (call == NULL || !call->known) {
+		return -1;
+	}
+
+	call->requested_min_video_bitrate = min_video_bitrate == 0 ? BITRATE_DEFAULT_MIN_VIDEO : min_video_bitrate;
+	call->requested_min_audio_bitrate = min_audio_bitrate == 0 ? BITRATE_DEFAULT_MIN_AUDIO : min_audio_bitrate;
+
+	if (!call->enabled) {
+		call->enabled = 1;
+		call->level = 0;
+		call->applied_level = 0;
+		call->bad_windows = 0;
+		call->good_windows = 0;
+		reset_window(call, now_us);
+	}
+
+	build_ladder(call);
+
+	if (call->level > call->max_level) {
+		call->level = call->max_level;
+	}
+
+	if (call->applied_level > call->max_level) {
+		call->applied_level = call->max_level;
+	}
+
+	apply_level(call);
+	call->stats[BITRATE_STAT_ENABLED] = 1;
+	return 0;
+}
+
+/*
+ * Stop controlling a call. Its settings stay where the controller left them.
+ */
+void bitrate_disable(bitrate_controller_t *controller, int32_t call_index)
+{
+	call_bitrate_t *call = get_call(controller, call_index);
+
+	if (call != NULL) {
+		call->enabled = 0;
+		call->stats[BITRATE_STAT_ENABLED] = 0;
+	}
+}
+
+/*
+ * Record an encoded frame. size is the encoded size, or negative if encoding failed.
+ */
+void bitrate_prepared(bitrate_controller_t *controller, int32_t call_index, int video, int size, uint64_t latency_us)
+{
+	call_bitrate_t *call = get_call(controller, call_index);
+
+	if (call == NULL || !call->enabled) {
+		return;
+	}
+
+	call->window_prepares++;
+	call->window_latency_us += latency_us;
+
+	if (size > 0) {
+		call->stats[BITRATE_STAT_ENCODED_BYTES] += size;
+
+		if (video) {
+			call->window_video_bytes += (uint64_t) size;
+		}
+	}
+}
+
+/*
+ * Whether the video encoder produced less than half of its target rate in this window. Raising
+ * the target then would not change anything on the wire, so the window does not count as good.
+ */
+static int encoder_limited(const call_bitrate_t *call, uint64_t elapsed_us)
+{
+	uint64_t target_bytes;
+
+	if (call->ceiling.call_type != TypeVideo || call->window_video_bytes == 0) {
+		return 0;
+	}
+
+	/* kbit/s over elapsed_us microseconds, in bytes */
+	target_bytes = (uint64_t) call->current.video_bitrate * elapsed_us / 8000;
+	return call->window_video_bytes * 2 < target_bytes;
+}
+
+/*
+ * Record the result of a send. At the end of a window this decides whether to change level; it
+ * returns 1 with the new settings in settings if toxav_change_settings should be called, and the
+ * caller reports the outcome with bitrate_applied.
+ */
+int bitrate_sent(bitrate_controller_t *controller, int32_t call_index, int result, uint64_t now_us,
+				 ToxAvCSettings *settings)
+{
+	call_bitrate_t *call = get_call(controller, call_index);
+	uint64_t elapsed_us;
+	uint64_t latency_us;
+	int bad;
+	int good;
+
+	if (call == NULL || !call->enabled) {
+		return 0;
+	}
+
+	call->stats[BITRATE_STAT_SENDS]++;
+	call->window_sends++;
+
+	if (result < 0) {
+		call->stats[BITRATE_STAT_SEND_FAILURES]++;
+		call->window_failures++;
+	}
+
+	elapsed_us = now_us - call->window_start;
+
+	if (elapsed_us < BITRATE_WINDOW_US) {
+		return 0;
+	}
+
+	latency_us = call->window_prepares == 0 ? 0 : call->window_latency_us / call->window_prepares;
+	call->stats[BITRATE_STAT_PREPARE_LATENCY_US] = (int64_t) latency_us;
+	bad = (uint64_t) call->window_failures * 100 >= (uint64_t) call->window_sends * BITRATE_BAD_FAILURES
+		  || latency_us >= BITRATE_BAD_LATENCY_US;
+	good = !bad && (uint64_t) call->window_failures * 100 <= (uint64_t) call->window_sends * BITRATE_GOOD_FAILURES
+		   && latency_us < BITRATE_GOOD_LATENCY_US && !encoder_limited(call, elapsed_us);
+	reset_window(call, now_us);
+
+	if (bad) {
+		call->good_windows = 0;
+
+		if (++call->bad_windows < BITRATE_DOWN_WINDOWS || call->level >= call->max_level) {
+			return 0;
+		}
+
+		call->level++;
+		call->stats[BITRATE_STAT_DOWNGRADES]++;
+	} else if (good) {
+		call->bad_windows = 0;
+
+		if (++call->good_windows < BITRATE_UP_WINDOWS || call->level == 0) {
+			return 0;
+		}
+
+		call->level--;
+		call->stats[BITRATE_STAT_UPGRADES]++;
+	} else {
+		call->bad_windows = 0;
+		call->good_windows = 0;
+		return 0;
+	}
+
+	call->bad_windows = 0;
+	call->good_windows = 0;
+	apply_level(call);
+	*settings = call->current;
+	return 1;
+}
+
+/*
+ * Report the result of the toxav_change_settings call requested by bitrate_sent
+ */
+void bitrate_applied(bitrate_controller_t *controller, int32_t call_index, int result)
+{
+	call_bitrate_t *call = get_call(controller, call_index);
+
+	if (call == NULL) {
+		return;
+	}
+
+	if (result < 0) {
+		call->stats[BITRATE_STAT_CHANGE_FAILURES]++;
+		call->level = call->applied_level;
+		apply_level(call);
+	} else {
+		call->applied_level = call->level;
+	}
+}
+
+/*
+ * Fill stats with BITRATE_STAT_COUNT values. Returns -1 for an invalid call index.
+ */
+int bitrate_stats(const bitrate_controller_t *controller, int32_t call_index, int64_t *stats)
+{
+	const call_bitrate_t *call = get_call(controller, call_index);
+
+	if (call == NULL) {
+		return -1;
+	}
+
+	memcpy(stats, call->stats, sizeof(call->stats));
+	return 0;
+}
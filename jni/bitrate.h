@@ -0,0 +1,58 @@
+/* bitrate.h
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef JTOX_BITRATE_H
+#define JTOX_BITRATE_H
+
+#include <stdint.h>
+#include <tox/toxav.h>
+
+/* Layout of the array filled by bitrate_stats */
+enum {
+	BITRATE_STAT_ENABLED,
+	BITRATE_STAT_LEVEL,
+	BITRATE_STAT_VIDEO_BITRATE,
+	BITRATE_STAT_VIDEO_WIDTH,
+	BITRATE_STAT_VIDEO_HEIGHT,
+	BITRATE_STAT_AUDIO_BITRATE,
+	BITRATE_STAT_DOWNGRADES,
+	BITRATE_STAT_UPGRADES,
+	BITRATE_STAT_CHANGE_FAILURES,
+	BITRATE_STAT_SENDS,
+	BITRATE_STAT_SEND_FAILURES,
+	BITRATE_STAT_ENCODED_BYTES,
+	BITRATE_STAT_PREPARE_LATENCY_US,
+	BITRATE_STAT_COUNT
+};
+
+typedef struct bitrate_controller bitrate_controller_t;
+
+bitrate_controller_t *bitrate_new(int32_t);
+void bitrate_free(bitrate_controller_t *);
+void bitrate_settings(bitrate_controller_t *, int32_t, const ToxAvCSettings *);
+void bitrate_forget(bitrate_controller_t *, int32_t);
+int bitrate_enable(bitrate_controller_t *, int32_t, uint32_t, uint32_t, uint64_t);
+void bitrate_disable(bitrate_controller_t *, int32_t);
+void bitrate_prepared(bitrate_controller_t *, int32_t, int, int, uint64_t);
+int bitrate_sent(bitrate_controller_t *, int32_t, int, uint64_t, ToxAvCSettings *);
+void bitrate_applied(bitrate_controller_t *, int32_t, int);
+int bitrate_stats(const bitrate_controller_t *, int32_t, int64_t *);
+
+#endif
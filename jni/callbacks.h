@@ -27,9 +27,18 @@ static void callback_userstatus(Tox *, int32_t, uint8_t, void *);
 static void callback_read_receipt(Tox *, int32_t, uint32_t, void *);
 static void callback_connectionstatus(Tox *, int32_t, uint8_t, void *);
 static void callback_typingstatus(Tox *, int32_t, uint8_t, void *);
+static void deliver_userstatus(tox_jni_globals_t *, int32_t, uint8_t);
+static void deliver_connectionstatus(tox_jni_globals_t *, int32_t, uint8_t);
+static void deliver_typingstatus(tox_jni_globals_t *, int32_t, uint8_t);
+static void deliver_presence(void *, int32_t, int, uint8_t, const uint8_t *, uint16_t);
+static void deliver_filecontrol(tox_jni_globals_t *, int32_t, uint8_t, uint8_t, uint8_t, const uint8_t *, uint16_t);
 static void callback_filecontrol(Tox *, int32_t, uint8_t, uint8_t, uint8_t, uint8_t *, uint16_t, void *);
 static void callback_filedata(Tox *, int32_t, uint8_t, uint8_t *, uint16_t, void *);
 static void callback_filesendrequest(Tox *, int32_t, uint8_t, uint64_t, uint8_t *, uint16_t, void *);
+static void callback_group_invite(Tox *, int32_t, uint8_t *, void *);
+static void callback_group_message(Tox *, int, int, uint8_t *, uint16_t, void *);
+static void callback_group_action(Tox *, int, int, uint8_t *, uint16_t, void *);
+static void callback_group_namelist_change(Tox *, int, int, uint8_t, void *);
 static void avcallback_invite(void *, int32_t, void *);
 static void avcallback_start(void *, int32_t, void *);
 static void avcallback_cancel(void *, int32_t, void *);
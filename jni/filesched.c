@@ -0,0 +1,425 @@
+/* filesched.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tox/tox.h>
+#include <tox/toxav.h>
+#include <jni.h>
+
+#include "filesched.h"
+#include "utils.h"
+
+/* Largest chunk handed to tox_file_send_data, tox_file_data_size never exceeds this */
+#define FILESCHED_CHUNK_MAX 2048
+/* Upper bound on scheduling rounds per tick, so a tick stays short even when core keeps accepting */
+#define FILESCHED_MAX_ROUNDS 256
+
+typedef enum {
+	TRANSFER_WAITING,
+	TRANSFER_ACTIVE,
+	TRANSFER_PAUSED,
+	TRANSFER_DONE,
+	TRANSFER_KILLED
+} transfer_state_t;
+
+typedef struct {
+	int32_t friendnumber;
+	uint8_t filenumber;
+	transfer_state_t state;
+	FILE *file;
+	uint64_t size;
+	/* Bytes accepted by core */
+	uint64_t sent;
+	uint32_t weight;
+	/* Deficit round robin credit in bytes */
+	int64_t deficit;
+	/* A chunk read from the file that core has not accepted yet */
+	uint8_t chunk[FILESCHED_CHUNK_MAX];
+	uint16_t chunk_length;
+	int chunk_pending;
+	uint64_t started_us;
+	uint64_t finished_us;
+} file_transfer_t;
+
+struct file_scheduler {
+	file_transfer_t *transfers;
+	size_t count;
+	size_t capacity;
+	/* Transfer that goes first in the next tick, rotated so nobody is always first in line */
+	size_t cursor;
+};
+
+file_scheduler_t *filesched_new(void)
+{
+	return calloc(1, sizeof(file_scheduler_t));
+}
+
+static void transfer_close(file_transfer_t *t)
+{
+	if (t->file != NULL) {
+		fclose(t->file);
+		t->file = NULL;
+	}
+}
+
+void filesched_free(file_scheduler_t *sched)
+{
+	size_t i;
+
+	if (sched == NULL) {
+		return;
+	}
+
+	for (i = 0; i < sched->count; i++) {
+		transfer_close(&sched->transfers[i]);
+	}
+
+	free(sched->transfers);
+	free(sched);
+}
+
+static file_transfer_t *transfer_find(file_scheduler_t *sched, int32_t friendnumber, uint8_t filenumber)
+{
+	size_t i;
+
+	for (i = 0; i < sched->count; i++) {
+		if (sched->transfers[i].friendnumber == friendnumber && sched->transfers[i].filenumber == filenumber) {
+			return &sched->transfers[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void transfer_drop(file_scheduler_t *sched, file_transfer_t *t)
+{
+	transfer_close(t);
+	*t = sched->transfers[--sched->count];
+
+	if (sched->cursor >= sched->count) {
+		sched->cursor = 0;
+	}
+}
+
+/**
+ * Open the file at path and offer it to the friend. The transfer starts once the friend accepts.
+ * Returns the file number, or -1 on failure.
+ */
+int filesched_add(file_scheduler_t *sched, Tox *tox, int32_t friendnumber, const char *path,
+                  const uint8_t *filename, uint16_t filename_length, uint32_t weight)
+{
+	FILE *file = fopen(path, "rb");
+	file_transfer_t *t;
+	int64_t size;
+	int filenumber;
+
+	if (file == NULL) {
+		return -1;
+	}
+
+	if (file_seek(file, 0, SEEK_END) != 0 || (size = file_tell(file)) < 0 || file_seek(file, 0, SEEK_SET) != 0) {
+		fclose(file);
+		return -1;
+	}
+
+	filenumber = tox_new_file_sender(tox, friendnumber, (uint64_t) size, (uint8_t *) filename, filename_length);
+
+	if (filenumber < 0) {
+		fclose(file);
+		return -1;
+	}
+
+	/* Core reuses file numbers once a transfer is over */
+	t = transfer_find(sched, friendnumber, (uint8_t) filenumber);
+
+	if (t != NULL) {
+		transfer_drop(sched, t);
+	}
+
+	if (sched->count == sched->capacity) {
+		size_t capacity = sched->capacity ? sched->capacity * 2 : 8;
+		file_transfer_t *transfers = realloc(sched->transfers, capacity * sizeof(file_transfer_t));
+
+		if (transfers == NULL) {
+			tox_file_send_control(tox, friendnumber, 0, (uint8_t) filenumber, TOX_FILECONTROL_KILL, NULL, 0);
+			fclose(file);
+			return -1;
+		}
+
+		sched->transfers = transfers;
+		sched->capacity = capacity;
+	}
+
+	t = &sched->transfers[sched->count++];
+	memset(t, 0, sizeof(file_transfer_t));
+	t->friendnumber = friendnumber;
+	t->filenumber = (uint8_t) filenumber;
+	t->state = TRANSFER_WAITING;
+	t->file = file;
+	t->size = (uint64_t) size;
+	t->weight = weight ? weight : 1;
+
+	return filenumber;
+}
+
+/**
+ * Stop managing a transfer, killing it first if it is still running. Returns -1 if it is unknown.
+ */
+int filesched_remove(file_scheduler_t *sched, Tox *tox, int32_t friendnumber, uint8_t filenumber)
+{
+	file_transfer_t *t = transfer_find(sched, friendnumber, filenumber);
+
+	if (t == NULL) {
+		return -1;
+	}
+
+	if (t->state != TRANSFER_DONE && t->state != TRANSFER_KILLED) {
+		tox_file_send_control(tox, friendnumber, 0, filenumber, TOX_FILECONTROL_KILL, NULL, 0);
+	}
+
+	transfer_drop(sched, t);
+	return 0;
+}
+
+/**
+ * Drop every transfer to a deleted friend, so that a new friend with its number starts over. Core
+ * has already forgotten the transfers, so no kill is sent.
+ */
+void filesched_forget(file_scheduler_t *sched, int32_t friendnumber)
+{
+	size_t i = 0;
+
+	while (i < sched->count) {
+		if (sched->transfers[i].friendnumber == friendnumber) {
+			/* The last transfer is moved into slot i, which is looked at again */
+			transfer_drop(sched, &sched->transfers[i]);
+		} else {
+			i++;
+		}
+	}
+}
+
+int filesched_set_weight(file_scheduler_t *sched, int32_t friendnumber, uint8_t filenumber, uint32_t weight)
+{
+	file_transfer_t *t = transfer_find(sched, friendnumber, filenumber);
+
+	if (t == NULL) {
+		return -1;
+	}
+
+	t->weight = weight ? weight : 1;
+	return 0;
+}
+
+/**
+ * Apply a control packet the friend sent for one of our outgoing transfers
+ */
+void filesched_control(file_scheduler_t *sched, Tox *tox, int32_t friendnumber, uint8_t filenumber,
+                       uint8_t control_type, const uint8_t *data, uint16_t length)
+{
+	uint64_t position;
+
+	file_transfer_t *t = transfer_find(sched, friendnumber, filenumber);
+
+	if (t == NULL) {
+		return;
+	}
+
+	switch (control_type) {
+		case TOX_FILECONTROL_ACCEPT:
+			if (t->state == TRANSFER_WAITING || t->state == TRANSFER_PAUSED) {
+				t->state = TRANSFER_ACTIVE;
+
+				if (t->started_us == 0) {
+					t->started_us = monotonic_time_us();
+				}
+			}
+
+			break;
+
+		case TOX_FILECONTROL_PAUSE:
+			if (t->state == TRANSFER_ACTIVE) {
+				t->state = TRANSFER_PAUSED;
+			}
+
+			break;
+
+		case TOX_FILECONTROL_KILL:
+			t->state = TRANSFER_KILLED;
+			t->finished_us = monotonic_time_us();
+			transfer_close(t);
+			break;
+
+		case TOX_FILECONTROL_FINISHED:
+			if (t->state != TRANSFER_DONE) {
+				t->state = TRANSFER_DONE;
+				t->finished_us = monotonic_time_us();
+			}
+
+			transfer_close(t);
+			break;
+
+		case TOX_FILECONTROL_RESUME_BROKEN:
+			/* The connection dropped mid-transfer and the friend wants everything from position on */
+			if (length != sizeof(position) || t->file == NULL) {
+				break;
+			}
+
+			memcpy(&position, data, sizeof(position));
+
+			if (position > t->size || file_seek(t->file, position, SEEK_SET) != 0) {
+				break;
+			}
+
+			t->sent = position;
+			t->chunk_pending = 0;
+			t->deficit = 0;
+
+			if (tox_file_send_control(tox, friendnumber, 0, filenumber, TOX_FILECONTROL_ACCEPT, NULL, 0) == 0) {
+				t->state = TRANSFER_ACTIVE;
+			}
+
+			break;
+	}
+}
+
+/**
+ * Send chunks of one transfer until its credit for this round is spent or core stops accepting.
+ * Returns whether anything was sent.
+ */
+static int transfer_serve(file_transfer_t *t, Tox *tox)
+{
+	int max = tox_file_data_size(tox, t->friendnumber);
+	int progress = 0;
+
+	if (max <= 0) {
+		return 0;
+	}
+
+	if (max > FILESCHED_CHUNK_MAX) {
+		max = FILESCHED_CHUNK_MAX;
+	}
+
+	t->deficit += (int64_t) t->weight * max;
+
+	while (t->deficit > 0 && (t->chunk_pending || t->sent < t->size)) {
+		if (!t->chunk_pending) {
+			uint64_t left = t->size - t->sent;
+			size_t wanted = left < (uint64_t) max ? (size_t) left : (size_t) max;
+			size_t got = fread(t->chunk, 1, wanted, t->file);
+
+			if (got == 0) {
+				/* The file shrank or could not be read, nothing sensible left to send */
+				tox_file_send_control(tox, t->friendnumber, 0, t->filenumber, TOX_FILECONTROL_KILL, NULL, 0);
+				t->state = TRANSFER_KILLED;
+				t->finished_us = monotonic_time_us();
+				transfer_close(t);
+				return progress;
+			}
+
+			t->chunk_length = (uint16_t) got;
+			t->chunk_pending = 1;
+		}
+
+		if (tox_file_send_data(tox, t->friendnumber, t->filenumber, t->chunk, t->chunk_length) != 0) {
+			break;
+		}
+
+		t->sent += t->chunk_length;
+		t->deficit -= t->chunk_length;
+		t->chunk_pending = 0;
+		progress = 1;
+	}
+
+	/* A blocked transfer must not hoard credit and then burst past everyone else */
+	if (t->deficit > (int64_t) t->weight * max) {
+		t->deficit = (int64_t) t->weight * max;
+	}
+
+	if (!t->chunk_pending && t->sent >= t->size
+			&& tox_file_data_remaining(tox, t->friendnumber, t->filenumber, 0) == 0) {
+		tox_file_send_control(tox, t->friendnumber, 0, t->filenumber, TOX_FILECONTROL_FINISHED, NULL, 0);
+		t->state = TRANSFER_DONE;
+		t->finished_us = monotonic_time_us();
+		t->deficit = 0;
+		transfer_close(t);
+	}
+
+	return progress;
+}
+
+/**
+ * Hand out send slots to all active transfers, deficit round robin weighted by each transfer's weight.
+ * Rounds repeat until core stops taking data or the round limit is hit. Called after every tox_do.
+ */
+void filesched_tick(file_scheduler_t *sched, Tox *tox)
+{
+	size_t round;
+	size_t i;
+
+	if (sched->count == 0) {
+		return;
+	}
+
+	for (round = 0; round < FILESCHED_MAX_ROUNDS; round++) {
+		int progress = 0;
+
+		for (i = 0; i < sched->count; i++) {
+			file_transfer_t *t = &sched->transfers[(sched->cursor + i) % sched->count];
+
+			if (t->state == TRANSFER_ACTIVE) {
+				progress |= transfer_serve(t, tox);
+			}
+		}
+
+		if (!progress) {
+			break;
+		}
+	}
+
+	sched->cursor = (sched->cursor + 1) % sched->count;
+}
+
+/**
+ * Fill stats, which must hold FILESCHED_STAT_COUNT values. Returns -1 if the transfer is unknown.
+ */
+int filesched_stats(file_scheduler_t *sched, int32_t friendnumber, uint8_t filenumber, int64_t *stats)
+{
+	file_transfer_t *t = transfer_find(sched, friendnumber, filenumber);
+	uint64_t elapsed_us = 0;
+
+	if (t == NULL) {
+		return -1;
+	}
+
+	if (t->started_us != 0) {
+		elapsed_us = (t->finished_us ? t->finished_us : monotonic_time_us()) - t->started_us;
+	}
+
+	stats[FILESCHED_STAT_SIZE] = (int64_t) t->size;
+	stats[FILESCHED_STAT_SENT] = (int64_t) t->sent;
+	stats[FILESCHED_STAT_ELAPSED_MS] = (int64_t) (elapsed_us / 1000);
+	stats[FILESCHED_STAT_BYTES_PER_SECOND] = elapsed_us ? (int64_t) (t->sent * 1000000 / elapsed_us) : 0;
+	stats[FILESCHED_STAT_WEIGHT] = t->weight;
+	stats[FILESCHED_STAT_STATE] = t->state;
+	return 0;
+}
@@ -0,0 +1,50 @@
+/* filesched.h
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef JTOX_FILESCHED_H
+#define JTOX_FILESCHED_H
+
+#include <stdint.h>
+#include <tox/tox.h>
+
+/* Layout of the array filled by filesched_stats */
+enum {
+	FILESCHED_STAT_SIZE,
+	FILESCHED_STAT_SENT,
+	FILESCHED_STAT_ELAPSED_MS,
+	FILESCHED_STAT_BYTES_PER_SECOND,
+	FILESCHED_STAT_WEIGHT,
+	FILESCHED_STAT_STATE,
+	FILESCHED_STAT_COUNT
+};
+
+typedef struct file_scheduler file_scheduler_t;
+
+file_scheduler_t *filesched_new(void);
+void filesched_free(file_scheduler_t *);
+int filesched_add(file_scheduler_t *, Tox *, int32_t, const char *, const uint8_t *, uint16_t, uint32_t);
+int filesched_remove(file_scheduler_t *, Tox *, int32_t, uint8_t);
+void filesched_forget(file_scheduler_t *, int32_t);
+int filesched_set_weight(file_scheduler_t *, int32_t, uint8_t, uint32_t);
+void filesched_control(file_scheduler_t *, Tox *, int32_t, uint8_t, uint8_t, const uint8_t *, uint16_t);
+void filesched_tick(file_scheduler_t *, Tox *);
+int filesched_stats(file_scheduler_t *, int32_t, uint8_t, int64_t *);
+
+#endif
@@ -0,0 +1,526 @@
+/* journal.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tox/tox.h>
+#include <tox/toxav.h>
+#include <jni.h>
+
+#include "journal.h"
+#include "utils.h"
+
+/*
+ * Incoming transfers that are written to disk natively keep a journal next to the destination file.
+ * It is append-only and little-endian:
+ *
+ *   0  "JTXJ"
+ *   4  version (1 byte), 3 reserved bytes
+ *   8  block size (4 bytes)
+ *   12 file size (8 bytes)
+ *   20 one CRC-32 (4 bytes) per fully received block, in order
+ *
+ * The confirmed offset is the number of checksums times the block size. A torn trailing record is
+ * ignored, so a crash never leaves the journal claiming more than was written. When blocks have to
+ * be given up, the journal is rewritten to a temporary file and renamed over the old one.
+ */
+#define JOURNAL_MAGIC "JTXJ"
+#define JOURNAL_VERSION 1
+#define JOURNAL_HEADER_SIZE 20
+#define JOURNAL_BLOCK_SIZE (256 * 1024)
+#define JOURNAL_SUFFIX ".journal"
+#define JOURNAL_TMP_SUFFIX ".tmp"
+
+typedef struct {
+	int32_t friendnumber;
+	uint8_t filenumber;
+	int active;
+	FILE *out;
+	FILE *journal;
+	char *journal_path;
+	uint64_t size;
+	/* Bytes written to the destination file */
+	uint64_t received;
+	/* Number of checksummed blocks, and the checksums themselves */
+	uint32_t blocks;
+	uint32_t block_capacity;
+	uint32_t *checksums;
+	/* Running CRC of the block currently being received */
+	uint32_t crc;
+} incoming_transfer_t;
+
+struct journal_registry {
+	incoming_transfer_t *transfers;
+	size_t count;
+	size_t capacity;
+};
+
+static uint32_t crc_table[256];
+
+static void crc_init(void)
+{
+	uint32_t i;
+	int k;
+
+	if (crc_table[1] != 0) {
+		return;
+	}
+
+	for (i = 0; i < 256; i++) {
+		uint32_t c = i;
+
+		for (k = 0; k < 8; k++) {
+			c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+		}
+
+		crc_table[i] = c;
+	}
+}
+
+/* CRC-32 as used by zlib; start and finish with 0xFFFFFFFF xor applied by the caller */
+static uint32_t crc_update(uint32_t crc, const uint8_t *data, size_t length)
+{
+	size_t i;
+
+	for (i = 0; i < length; i++) {
+		crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+
+	return crc;
+}
+
+static void put_le(uint8_t *buf, uint64_t value, int bytes)
+{
+	int i;
+
+	for (i = 0; i < bytes; i++) {
+		buf[i] = (uint8_t) (value >> (8 * i));
+	}
+}
+
+static int write_header(FILE *journal, uint64_t size)
+{
+	uint8_t header[JOURNAL_HEADER_SIZE];
+
+	memcpy(header, JOURNAL_MAGIC, 4);
+	header[4] = JOURNAL_VERSION;
+	header[5] = header[6] = header[7] = 0;
+	put_le(header + 8, JOURNAL_BLOCK_SIZE, 4);
+	put_le(header + 12, size, 8);
+	return fwrite(header, 1, JOURNAL_HEADER_SIZE, journal) == JOURNAL_HEADER_SIZE ? 0 : -1;
+}
+
+/**
+ * Replace the journal with one holding only the first t->blocks checksums
+ */
+static int journal_rewrite(incoming_transfer_t *t)
+{
+	size_t path_length = strlen(t->journal_path);
+	char *tmp_path = malloc(path_length + sizeof(JOURNAL_TMP_SUFFIX));
+	FILE *tmp;
+	uint32_t i;
+	int result = -1;
+
+	if (tmp_path == NULL) {
+		return -1;
+	}
+
+	memcpy(tmp_path, t->journal_path, path_length);
+	memcpy(tmp_path + path_length, JOURNAL_TMP_SUFFIX, sizeof(JOURNAL_TMP_SUFFIX));
+	tmp = fopen(tmp_path, "wb");
+
+	if (tmp != NULL) {
+		result = write_header(tmp, t->size);
+
+		for (i = 0; i < t->blocks && result == 0; i++) {
+			uint8_t record[4];
+
+			put_le(record, t->checksums[i], 4);
+			result = fwrite(record, 1, sizeof(record), tmp) == sizeof(record) ? 0 : -1;
+		}
+
+		if (fclose(tmp) != 0) {
+			result = -1;
+		}
+	}
+
+	if (result == 0) {
+		fclose(t->journal);
+#ifdef WIN32
+		/* rename does not replace existing files on Windows */
+		remove(t->journal_path);
+#endif
+		result = rename(tmp_path, t->journal_path);
+		t->journal = fopen(t->journal_path, "ab");
+	} else {
+		remove(tmp_path);
+	}
+
+	free(tmp_path);
+	return t->journal != NULL ? result : -1;
+}
+
+journal_registry_t *journal_new(void)
+{
+	crc_init();
+	return calloc(1, sizeof(journal_registry_t));
+}
+
+static void transfer_close(incoming_transfer_t *t)
+{
+	if (t->out != NULL) {
+		fclose(t->out);
+		t->out = NULL;
+	}
+
+	if (t->journal != NULL) {
+		fclose(t->journal);
+		t->journal = NULL;
+	}
+
+	t->active = 0;
+}
+
+static void transfer_free(incoming_transfer_t *t)
+{
+	transfer_close(t);
+	free(t->journal_path);
+	free(t->checksums);
+}
+
+void journal_free(journal_registry_t *reg)
+{
+	size_t i;
+
+	if (reg == NULL) {
+		return;
+	}
+
+	for (i = 0; i < reg->count; i++) {
+		transfer_free(&reg->transfers[i]);
+	}
+
+	free(reg->transfers);
+	free(reg);
+}
+
+static incoming_transfer_t *transfer_find(journal_registry_t *reg, int32_t friendnumber, uint8_t filenumber)
+{
+	size_t i;
+
+	for (i = 0; i < reg->count; i++) {
+		if (reg->transfers[i].friendnumber == friendnumber && reg->transfers[i].filenumber == filenumber) {
+			return &reg->transfers[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void transfer_drop(journal_registry_t *reg, incoming_transfer_t *t)
+{
+	transfer_free(t);
+	*t = reg->transfers[--reg->count];
+}
+
+/**
+ * Start receiving a file the friend offered, writing it to path and journaling progress to
+ * path.journal, then accept the transfer. Returns 0 on success, -1 on failure.
+ */
+int journal_receive(journal_registry_t *reg, Tox *tox, int32_t friendnumber, uint8_t filenumber, uint64_t size,
+                    const char *path)
+{
+	incoming_transfer_t *t = transfer_find(reg, friendnumber, filenumber);
+	size_t path_length = strlen(path);
+
+	/* Core reuses file numbers once a transfer is over */
+	if (t != NULL) {
+		transfer_drop(reg, t);
+	}
+
+	if (reg->count == reg->capacity) {
+		size_t capacity = reg->capacity ? reg->capacity * 2 : 8;
+		incoming_transfer_t *transfers = realloc(reg->transfers, capacity * sizeof(incoming_transfer_t));
+
+		if (transfers == NULL) {
+			return -1;
+		}
+
+		reg->transfers = transfers;
+		reg->capacity = capacity;
+	}
+
+	t = &reg->transfers[reg->count];
+	memset(t, 0, sizeof(incoming_transfer_t));
+	t->friendnumber = friendnumber;
+	t->filenumber = filenumber;
+	t->size = size;
+	t->crc = 0xFFFFFFFF;
+	t->journal_path = malloc(path_length + sizeof(JOURNAL_SUFFIX));
+
+	if (t->journal_path == NULL) {
+		return -1;
+	}
+
+	memcpy(t->journal_path, path, path_length);
+	memcpy(t->journal_path + path_length, JOURNAL_SUFFIX, sizeof(JOURNAL_SUFFIX));
+	t->out = fopen(path, "w+b");
+	t->journal = fopen(t->journal_path, "wb");
+
+	if (t->out == NULL || t->journal == NULL || write_header(t->journal, size) != 0
+			|| tox_file_send_control(tox, friendnumber, 1, filenumber, TOX_FILECONTROL_ACCEPT, NULL, 0) != 0) {
+		transfer_close(t);
+		remove(path);
+		remove(t->journal_path);
+		transfer_free(t);
+		return -1;
+	}
+
+	fflush(t->journal);
+	t->active = 1;
+	reg->count++;
+	return 0;
+}
+
+/**
+ * Record the block just completed. Returns 0 on success, -1 if it could not be journaled.
+ */
+static int journal_append(incoming_transfer_t *t)
+{
+	uint8_t record[4];
+	uint32_t crc = t->crc ^ 0xFFFFFFFF;
+
+	if (t->blocks == t->block_capacity) {
+		uint32_t capacity = t->block_capacity ? t->block_capacity * 2 : 64;
+		uint32_t *checksums = realloc(t->checksums, capacity * sizeof(uint32_t));
+
+		if (checksums == NULL) {
+			t->crc = 0xFFFFFFFF;
+			return -1;
+		}
+
+		t->checksums = checksums;
+		t->block_capacity = capacity;
+	}
+
+	t->checksums[t->blocks++] = crc;
+	t->crc = 0xFFFFFFFF;
+
+	/* The block has to be on disk before the journal claims it */
+	if (fflush(t->out) != 0) {
+		return -1;
+	}
+
+	put_le(record, crc, 4);
+
+	if (fwrite(record, 1, sizeof(record), t->journal) != sizeof(record) || fflush(t->journal) != 0) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Write incoming data of a journaled transfer. Data of a transfer that failed earlier is dropped.
+ *
+ * Returns 1 if the transfer is handled here and the data should not be passed on, 0 if it is not a
+ * journaled transfer, and -1 if writing failed. The transfer has then been killed, and the partial
+ * file and its journal are kept.
+ */
+int journal_data(journal_registry_t *reg, Tox *tox, int32_t friendnumber, uint8_t filenumber,
+                 const uint8_t *data, uint16_t length)
+{
+	incoming_transfer_t *t = transfer_find(reg, friendnumber, filenumber);
+
+	if (t == NULL) {
+		return 0;
+	}
+
+	if (!t->active) {
+		return 1;
+	}
+
+	while (length > 0) {
+		uint64_t block_left = JOURNAL_BLOCK_SIZE - t->received % JOURNAL_BLOCK_SIZE;
+		uint16_t n = length < block_left ? length : (uint16_t) block_left;
+
+		if (fwrite(data, 1, n, t->out) != n) {
+			break;
+		}
+
+		t->crc = crc_update(t->crc, data, n);
+		t->received += n;
+		data += n;
+		length -= n;
+
+		if (t->received % JOURNAL_BLOCK_SIZE == 0 && journal_append(t) != 0) {
+			break;
+		}
+	}
+
+	if (length > 0) {
+		/* Stays registered, so data still in flight is dropped until the file number is reused */
+		transfer_close(t);
+		tox_file_send_control(tox, friendnumber, 1, filenumber, TOX_FILECONTROL_KILL, NULL, 0);
+		return -1;
+	}
+
+	return 1;
+}
+
+/**
+ * Apply a control packet the friend sent for one of our journaled incoming transfers.
+ *
+ * Returns -1 if the friend finished a transfer that did not arrive completely, 0 otherwise. The
+ * partial file and its journal are kept then.
+ */
+int journal_control(journal_registry_t *reg, int32_t friendnumber, uint8_t filenumber, uint8_t control_type)
+{
+	incoming_transfer_t *t = transfer_find(reg, friendnumber, filenumber);
+	int complete;
+
+	if (t == NULL) {
+		return 0;
+	}
+
+	switch (control_type) {
+		case TOX_FILECONTROL_FINISHED:
+			complete = t->active && t->received == t->size && fflush(t->out) == 0;
+			transfer_close(t);
+
+			if (!complete) {
+				transfer_drop(reg, t);
+				return -1;
+			}
+
+			remove(t->journal_path);
+			transfer_drop(reg, t);
+			break;
+
+		case TOX_FILECONTROL_KILL:
+			/* Keep the partial file and its journal around */
+			transfer_close(t);
+			transfer_drop(reg, t);
+			break;
+	}
+
+	return 0;
+}
+
+/**
+ * Drop every transfer from a deleted friend, so that a new friend with its number does not resume
+ * them. As with a kill, the partial files and their journals stay on disk.
+ */
+void journal_forget(journal_registry_t *reg, int32_t friendnumber)
+{
+	size_t i = 0;
+
+	while (i < reg->count) {
+		if (reg->transfers[i].friendnumber == friendnumber) {
+			/* The last transfer is moved into slot i, which is looked at again */
+			transfer_drop(reg, &reg->transfers[i]);
+		} else {
+			i++;
+		}
+	}
+}
+
+/**
+ * Find the longest prefix of the destination file that still matches the journal, checking from the
+ * last block backwards. Normally only the last block is read.
+ */
+static uint32_t verified_blocks(incoming_transfer_t *t)
+{
+	uint8_t buf[4096];
+	uint32_t block = t->blocks;
+
+	fflush(t->out);
+
+	while (block > 0) {
+		uint32_t crc = 0xFFFFFFFF;
+		size_t left = JOURNAL_BLOCK_SIZE;
+
+		if (file_seek(t->out, (uint64_t) (block - 1) * JOURNAL_BLOCK_SIZE, SEEK_SET) != 0) {
+			block--;
+			continue;
+		}
+
+		while (left > 0) {
+			size_t n = fread(buf, 1, left < sizeof(buf) ? left : sizeof(buf), t->out);
+
+			if (n == 0) {
+				break;
+			}
+
+			crc = crc_update(crc, buf, n);
+			left -= n;
+		}
+
+		if (left == 0 && (crc ^ 0xFFFFFFFF) == t->checksums[block - 1]) {
+			break;
+		}
+
+		block--;
+	}
+
+	return block;
+}
+
+/**
+ * The friend came back online. Ask it to resume every journaled transfer at the last verified block.
+ */
+void journal_reconnect(journal_registry_t *reg, Tox *tox, int32_t friendnumber)
+{
+	size_t i;
+
+	for (i = 0; i < reg->count; i++) {
+		incoming_transfer_t *t = &reg->transfers[i];
+		uint64_t position;
+		uint32_t verified;
+
+		if (t->friendnumber != friendnumber || !t->active) {
+			continue;
+		}
+
+		verified = verified_blocks(t);
+
+		if (verified != t->blocks) {
+			t->blocks = verified;
+
+			if (journal_rewrite(t) != 0) {
+				/* Without a journal there is nothing to resume from */
+				transfer_close(t);
+				continue;
+			}
+		}
+
+		position = (uint64_t) t->blocks * JOURNAL_BLOCK_SIZE;
+
+		if (file_seek(t->out, position, SEEK_SET) != 0) {
+			continue;
+		}
+
+		t->received = position;
+		t->crc = 0xFFFFFFFF;
+		tox_file_send_control(tox, friendnumber, 1, t->filenumber, TOX_FILECONTROL_RESUME_BROKEN,
+		                      (uint8_t *) &position, sizeof(position));
+	}
+}
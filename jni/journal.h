@@ -0,0 +1,37 @@
+/* journal.h
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef JTOX_JOURNAL_H
+#define JTOX_JOURNAL_H
+
+#include <stdint.h>
+#include <tox/tox.h>
+
+typedef struct journal_registry journal_registry_t;
+
+journal_registry_t *journal_new(void);
+void journal_free(journal_registry_t *);
+int journal_receive(journal_registry_t *, Tox *, int32_t, uint8_t, uint64_t, const char *);
+int journal_data(journal_registry_t *, Tox *, int32_t, uint8_t, const uint8_t *, uint16_t);
+int journal_control(journal_registry_t *, int32_t, uint8_t, uint8_t);
+void journal_forget(journal_registry_t *, int32_t);
+void journal_reconnect(journal_registry_t *, Tox *, int32_t);
+
+#endif
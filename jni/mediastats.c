@@ -0,0 +1,327 @@
+/* mediastats.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "mediastats.h"
+#include "stats.h"
+
+/*
+ * Media counters per call index. The send side is only entered under the JTox lock, but audio
+ * and video arrive on toxav's threads, so counters are added to atomically. Each frame rate
+ * window has a single writer. A reader may see a frame half-recorded, and the audio and video
+ * threads may race on the callback lag maximum, which skews a snapshot by at most one frame.
+ *
+ * Counters start over when a call is set up with the index, and stay readable after it ends.
+ */
+#ifdef __GNUC__
+#define MEDIA_LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define MEDIA_ADD(x, v) __atomic_fetch_add(&(x), (v), __ATOMIC_RELAXED)
+#define MEDIA_SET(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+#else
+#define MEDIA_LOAD(x) (x)
+#define MEDIA_ADD(x, v) ((x) += (v))
+#define MEDIA_SET(x, v) ((x) = (v))
+#endif
+
+/* Frame rates are measured over windows of this length */
+#define MEDIA_RATE_WINDOW_NS 1000000000ULL
+
+typedef struct {
+	uint64_t start_ns;
+	uint64_t frames;
+	/* Frames per second over the last full window */
+	uint64_t rate;
+} rate_window_t;
+
+typedef struct {
+	uint64_t count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint32_t buckets[STATS_BUCKETS];
+} latency_histogram_t;
+
+enum {
+	VIDEO_ENCODE,
+	AUDIO_ENCODE,
+	VIDEO_DECODE,
+	AUDIO_DECODE,
+	DIRECTION_COUNT
+};
+
+typedef struct {
+	uint64_t start_ns;
+	uint64_t frames[DIRECTION_COUNT];
+	rate_window_t rates[DIRECTION_COUNT];
+	uint64_t bytes_sent;
+	uint64_t bytes_received;
+	uint64_t dropped[2];
+	latency_histogram_t prepare[2];
+	latency_histogram_t callback_lag;
+} call_media_t;
+
+struct media_stats {
+	call_media_t *calls;
+	int32_t max_calls;
+};
+
+media_stats_t *media_stats_new(int32_t max_calls)
+{
+	media_stats_t *stats;
+
+	if (max_calls <= 0) {
+		return NULL;
+	}
+
+	stats = calloc(1, sizeof(media_stats_t));
+
+	if (stats == NULL) {
+		return NULL;
+	}
+
+	stats->calls = calloc((size_t) max_calls, sizeof(call_media_t));
+
+	if (stats->calls == NULL) {
+		free(stats);
+		return NULL;
+	}
+
+	stats->max_calls = max_calls;
+	return stats;
+}
+
+void media_stats_free(media_stats_t *stats)
+{
+	if (stats != NULL) {
+		free(stats->calls);
+		free(stats);
+	}
+}
+
+static call_media_t *get_call(const media_stats_t *stats, int32_t call_index)
+{
+	if (stats == NULL || call_index < 0 || call_index >= stats->max_calls) {
+		return NULL;
+	}
+
+	return &stats->calls[call_index];
+}
+
+static void count_frame(rate_window_t *window, uint64_t now_ns)
+{
+	uint64_t start = MEDIA_LOAD(window->start_ns);
+	uint64_t frames = MEDIA_LOAD(window->frames) + 1;
+
+	if (now_ns - start < MEDIA_RATE_WINDOW_NS) {
+		MEDIA_SET(window->frames, frames);
+		return;
+	}
+
+	MEDIA_SET(window->rate, frames * 1000000000ULL / (now_ns - start));
+	MEDIA_SET(window->frames, 0);
+	MEDIA_SET(window->start_ns, now_ns);
+}
+
+/*
+ * The rate over the last full window, or 0 if no frame arrived for two windows
+ */
+static uint64_t window_rate(const rate_window_t *window, uint64_t now_ns)
+{
+	if (now_ns - MEDIA_LOAD(window->start_ns) >= 2 * MEDIA_RATE_WINDOW_NS) {
+		return 0;
+	}
+
+	return MEDIA_LOAD(window->rate);
+}
+
+static void record_latency(latency_histogram_t *histogram, uint64_t ns)
+{
+	MEDIA_ADD(histogram->count, 1);
+	MEDIA_ADD(histogram->total_ns, ns);
+	MEDIA_ADD(histogram->buckets[stats_bucket(ns)], 1);
+
+	if (ns > MEDIA_LOAD(histogram->max_ns)) {
+		MEDIA_SET(histogram->max_ns, ns);
+	}
+}
+
+static uint64_t latency_mean_us(const latency_histogram_t *histogram)
+{
+	uint64_t count = MEDIA_LOAD(histogram->count);
+
+	return count == 0 ? 0 : MEDIA_LOAD(histogram->total_ns) / count / 1000;
+}
+
+/*
+ * Upper bound of the bucket the 99th percentile falls in, never more than the maximum, in
+ * microseconds
+ */
+static uint64_t latency_p99_us(const latency_histogram_t *histogram)
+{
+	uint64_t max = MEDIA_LOAD(histogram->max_ns);
+	uint64_t total = 0;
+	uint64_t seen = 0;
+	uint64_t rank;
+	uint64_t upper;
+	int i;
+
+	for (i = 0; i < STATS_BUCKETS; i++) {
+		total += MEDIA_LOAD(histogram->buckets[i]);
+	}
+
+	if (total == 0) {
+		return 0;
+	}
+
+	rank = (total * 99 + 99) / 100;
+
+	for (i = 0; i < STATS_BUCKETS; i++) {
+		uint32_t count = MEDIA_LOAD(histogram->buckets[i]);
+
+		seen += count;
+
+		if (seen >= rank && count != 0) {
+			upper = i + 1 < STATS_BUCKETS ? stats_bucket_lower(i + 1) - 1 : max;
+			return (upper < max ? upper : max) / 1000;
+		}
+	}
+
+	return max / 1000;
+}
+
+/*
+ * Start the counters of a call over, when it is set up
+ */
+void media_stats_reset(media_stats_t *stats, int32_t call_index, uint64_t now_ns)
+{
+	call_media_t *call = get_call(stats, call_index);
+	int i;
+
+	if (call == NULL) {
+		return;
+	}
+
+	memset(call, 0, sizeof(call_media_t));
+	call->start_ns = now_ns;
+
+	for (i = 0; i < DIRECTION_COUNT; i++) {
+		call->rates[i].start_ns = now_ns;
+	}
+}
+
+/*
+ * Record a frame passed through toxav_prepare_*_frame. size is the encoded size, negative if
+ * encoding failed; a failed frame counts as dropped.
+ */
+void media_stats_prepared(media_stats_t *stats, int32_t call_index, int video, int size, uint64_t latency_ns,
+						  uint64_t now_ns)
+{
+	call_media_t *call = get_call(stats, call_index);
+	int direction = video ? VIDEO_ENCODE : AUDIO_ENCODE;
+
+	if (call == NULL) {
+		return;
+	}
+
+	record_latency(&call->prepare[direction], latency_ns);
+
+	if (size < 0) {
+		MEDIA_ADD(call->dropped[direction], 1);
+		return;
+	}
+
+	MEDIA_ADD(call->frames[direction], 1);
+	count_frame(&call->rates[direction], now_ns);
+}
+
+/*
+ * Record the result of toxav_send_video or toxav_send_audio. A failed send counts as dropped.
+ */
+void media_stats_sent(media_stats_t *stats, int32_t call_index, int video, int result, int size)
+{
+	call_media_t *call = get_call(stats, call_index);
+
+	if (call == NULL) {
+		return;
+	}
+
+	if (result < 0) {
+		MEDIA_ADD(call->dropped[video ? VIDEO_ENCODE : AUDIO_ENCODE], 1);
+	} else if (size > 0) {
+		MEDIA_ADD(call->bytes_sent, (uint64_t) size);
+	}
+}
+
+/*
+ * Record a decoded frame handed to the application. size is the decoded size, lag_ns the time
+ * from toxav calling back to the handler returning.
+ */
+void media_stats_received(media_stats_t *stats, int32_t call_index, int video, size_t size, uint64_t lag_ns,
+						  uint64_t now_ns)
+{
+	call_media_t *call = get_call(stats, call_index);
+	int direction = video ? VIDEO_DECODE : AUDIO_DECODE;
+
+	if (call == NULL) {
+		return;
+	}
+
+	MEDIA_ADD(call->frames[direction], 1);
+	MEDIA_ADD(call->bytes_received, (uint64_t) size);
+	count_frame(&call->rates[direction], now_ns);
+	record_latency(&call->callback_lag, lag_ns);
+}
+
+/*
+ * Fill out with MEDIA_STAT_COUNT values. Returns -1 for an invalid call index.
+ */
+int media_stats_export(const media_stats_t *stats, int32_t call_index, uint64_t now_ns, int64_t *out)
+{
+	const call_media_t *call = get_call(stats, call_index);
+	uint64_t start;
+
+	if (call == NULL) {
+		return -1;
+	}
+
+	start = MEDIA_LOAD(call->start_ns);
+	out[MEDIA_STAT_ELAPSED_US] = start == 0 ? 0 : (int64_t) ((now_ns - start) / 1000);
+	out[MEDIA_STAT_VIDEO_FRAMES_ENCODED] = (int64_t) MEDIA_LOAD(call->frames[VIDEO_ENCODE]);
+	out[MEDIA_STAT_AUDIO_FRAMES_ENCODED] = (int64_t) MEDIA_LOAD(call->frames[AUDIO_ENCODE]);
+	out[MEDIA_STAT_VIDEO_FRAMES_DECODED] = (int64_t) MEDIA_LOAD(call->frames[VIDEO_DECODE]);
+	out[MEDIA_STAT_AUDIO_FRAMES_DECODED] = (int64_t) MEDIA_LOAD(call->frames[AUDIO_DECODE]);
+	out[MEDIA_STAT_VIDEO_ENCODE_FPS] = (int64_t) window_rate(&call->rates[VIDEO_ENCODE], now_ns);
+	out[MEDIA_STAT_AUDIO_ENCODE_FPS] = (int64_t) window_rate(&call->rates[AUDIO_ENCODE], now_ns);
+	out[MEDIA_STAT_VIDEO_DECODE_FPS] = (int64_t) window_rate(&call->rates[VIDEO_DECODE], now_ns);
+	out[MEDIA_STAT_AUDIO_DECODE_FPS] = (int64_t) window_rate(&call->rates[AUDIO_DECODE], now_ns);
+	out[MEDIA_STAT_BYTES_SENT] = (int64_t) MEDIA_LOAD(call->bytes_sent);
+	out[MEDIA_STAT_BYTES_RECEIVED] = (int64_t) MEDIA_LOAD(call->bytes_received);
+	out[MEDIA_STAT_VIDEO_PREPARE_MEAN_US] = (int64_t) latency_mean_us(&call->prepare[VIDEO_ENCODE]);
+	out[MEDIA_STAT_VIDEO_PREPARE_P99_US] = (int64_t) latency_p99_us(&call->prepare[VIDEO_ENCODE]);
+	out[MEDIA_STAT_AUDIO_PREPARE_MEAN_US] = (int64_t) latency_mean_us(&call->prepare[AUDIO_ENCODE]);
+	out[MEDIA_STAT_AUDIO_PREPARE_P99_US] = (int64_t) latency_p99_us(&call->prepare[AUDIO_ENCODE]);
+	out[MEDIA_STAT_VIDEO_FRAMES_DROPPED] = (int64_t) MEDIA_LOAD(call->dropped[VIDEO_ENCODE]);
+	out[MEDIA_STAT_AUDIO_FRAMES_DROPPED] = (int64_t) MEDIA_LOAD(call->dropped[AUDIO_ENCODE]);
+	out[MEDIA_STAT_CALLBACK_LAG_MEAN_US] = (int64_t) latency_mean_us(&call->callback_lag);
+	out[MEDIA_STAT_CALLBACK_LAG_P99_US] = (int64_t) latency_p99_us(&call->callback_lag);
+	out[MEDIA_STAT_CALLBACK_LAG_MAX_US] = (int64_t) (MEDIA_LOAD(call->callback_lag.max_ns) / 1000);
+	return 0;
+}
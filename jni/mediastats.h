@@ -0,0 +1,62 @@
+/* mediastats.h
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef JTOX_MEDIASTATS_H
+#define JTOX_MEDIASTATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Layout of the array filled by media_stats_export */
+enum {
+	MEDIA_STAT_ELAPSED_US,
+	MEDIA_STAT_VIDEO_FRAMES_ENCODED,
+	MEDIA_STAT_AUDIO_FRAMES_ENCODED,
+	MEDIA_STAT_VIDEO_FRAMES_DECODED,
+	MEDIA_STAT_AUDIO_FRAMES_DECODED,
+	MEDIA_STAT_VIDEO_ENCODE_FPS,
+	MEDIA_STAT_AUDIO_ENCODE_FPS,
+	MEDIA_STAT_VIDEO_DECODE_FPS,
+	MEDIA_STAT_AUDIO_DECODE_FPS,
+	MEDIA_STAT_BYTES_SENT,
+	MEDIA_STAT_BYTES_RECEIVED,
+	MEDIA_STAT_VIDEO_PREPARE_MEAN_US,
+	MEDIA_STAT_VIDEO_PREPARE_P99_US,
+	MEDIA_STAT_AUDIO_PREPARE_MEAN_US,
+	MEDIA_STAT_AUDIO_PREPARE_P99_US,
+	MEDIA_STAT_VIDEO_FRAMES_DROPPED,
+	MEDIA_STAT_AUDIO_FRAMES_DROPPED,
+	MEDIA_STAT_CALLBACK_LAG_MEAN_US,
+	MEDIA_STAT_CALLBACK_LAG_P99_US,
+	MEDIA_STAT_CALLBACK_LAG_MAX_US,
+	MEDIA_STAT_COUNT
+};
+
+typedef struct media_stats media_stats_t;
+
+media_stats_t *media_stats_new(int32_t);
+void media_stats_free(media_stats_t *);
+void media_stats_reset(media_stats_t *, int32_t, uint64_t);
+void media_stats_prepared(media_stats_t *, int32_t, int, int, uint64_t, uint64_t);
+void media_stats_sent(media_stats_t *, int32_t, int, int, int);
+void media_stats_received(media_stats_t *, int32_t, int, size_t, uint64_t, uint64_t);
+int media_stats_export(const media_stats_t *, int32_t, uint64_t, int64_t *);
+
+#endif
@@ -0,0 +1,295 @@
+/* presence.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "presence.h"
+
+/*
+ * Optionally holds back name, status message, user status, typing and connection events that
+ * arrive during one tox_do, and delivers only the last one of each kind per friend once the tick
+ * is over. After a reconnect core reports the whole state of every friend again, most of which
+ * has not changed, so scalar events whose final value equals the one delivered last are dropped
+ * altogether. Names and status messages are always delivered once per tick when they arrive.
+ *
+ * Friends with pending events are delivered in the order their first event of the tick arrived.
+ */
+#define PRESENCE_INITIAL_FRIENDS 16
+
+typedef struct {
+	/* One bit per kind that has an event pending in this tick */
+	uint8_t pending;
+	/* One bit per scalar kind that has been delivered at least once */
+	uint8_t known;
+	uint8_t value[PRESENCE_KIND_COUNT];
+	uint8_t delivered[PRESENCE_KIND_COUNT];
+	uint8_t *name;
+	uint16_t name_length;
+	uint8_t *status_message;
+	uint16_t status_message_length;
+	/* Bumped when the friend is forgotten, so a flush notices a listener deleted it */
+	uint32_t generation;
+} friend_presence_t;
+
+struct presence_coalescer {
+	int enabled;
+	/* Set while delivering, events caused by the listeners then go through right away */
+	int flushing;
+	friend_presence_t *friends;
+	uint32_t friend_capacity;
+	/* Friends with pending events, in order of their first event this tick */
+	int32_t *order;
+	uint32_t order_count;
+	uint32_t order_capacity;
+	int64_t stats[PRESENCE_STAT_COUNT];
+};
+
+presence_coalescer_t *presence_new(void)
+{
+	return calloc(1, sizeof(presence_coalescer_t));
+}
+
+static void friend_clear(friend_presence_t *f)
+{
+	free(f->name);
+	free(f->status_message);
+	memset(f, 0, sizeof(friend_presence_t));
+}
+
+void presence_free(presence_coalescer_t *p)
+{
+	uint32_t i;
+
+	if (p == NULL) {
+		return;
+	}
+
+	for (i = 0; i < p->friend_capacity; ++i) {
+		friend_clear(&p->friends[i]);
+	}
+
+	free(p->friends);
+	free(p->order);
+	free(p);
+}
+
+void presence_set_enabled(presence_coalescer_t *p, int enabled)
+{
+	p->enabled = enabled;
+}
+
+int presence_enabled(const presence_coalescer_t *p)
+{
+	return p->enabled;
+}
+
+/* Grow the friend table so that friendnumber fits */
+static friend_presence_t *friend_get(presence_coalescer_t *p, int32_t friendnumber)
+{
+	uint32_t capacity = p->friend_capacity == 0 ? PRESENCE_INITIAL_FRIENDS : p->friend_capacity;
+	friend_presence_t *friends;
+
+	if (friendnumber < 0) {
+		return NULL;
+	}
+
+	if ((uint32_t) friendnumber < p->friend_capacity) {
+		return &p->friends[friendnumber];
+	}
+
+	while (capacity <= (uint32_t) friendnumber) {
+		capacity *= 2;
+	}
+
+	friends = realloc(p->friends, capacity * sizeof(friend_presence_t));
+
+	if (friends == NULL) {
+		return NULL;
+	}
+
+	p->friends = friends;
+	memset(&p->friends[p->friend_capacity], 0, (capacity - p->friend_capacity) * sizeof(friend_presence_t));
+	p->friend_capacity = capacity;
+	return &p->friends[friendnumber];
+}
+
+static int mark_pending(presence_coalescer_t *p, friend_presence_t *f, int32_t friendnumber, int kind)
+{
+	if (f->pending == 0) {
+		if (p->order_count == p->order_capacity) {
+			uint32_t capacity = p->order_capacity == 0 ? PRESENCE_INITIAL_FRIENDS : p->order_capacity * 2;
+			int32_t *order = realloc(p->order, capacity * sizeof(int32_t));
+
+			if (order == NULL) {
+				return -1;
+			}
+
+			p->order = order;
+			p->order_capacity = capacity;
+		}
+
+		p->order[p->order_count++] = friendnumber;
+	} else if (f->pending & (1 << kind)) {
+		++p->stats[PRESENCE_STAT_COALESCED];
+	}
+
+	++p->stats[PRESENCE_STAT_RECEIVED];
+	f->pending |= 1 << kind;
+	return 0;
+}
+
+/*
+ * Hold back a connection, user status or typing event.
+ *
+ * Returns 0 if the event was taken, -1 if it has to be delivered right away.
+ */
+int presence_value(presence_coalescer_t *p, int32_t friendnumber, int kind, uint8_t value)
+{
+	friend_presence_t *f = friend_get(p, friendnumber);
+
+	if (f == NULL) {
+		return -1;
+	}
+
+	if (!p->enabled || p->flushing) {
+		/* Delivered right away, later events have to be compared against this one */
+		f->known |= 1 << kind;
+		f->value[kind] = value;
+		f->delivered[kind] = value;
+		return -1;
+	}
+
+	if (mark_pending(p, f, friendnumber, kind) != 0) {
+		return -1;
+	}
+
+	f->value[kind] = value;
+	return 0;
+}
+
+/*
+ * Hold back a name or status message event, copying its bytes.
+ *
+ * Returns 0 if the event was taken, -1 if it has to be delivered right away.
+ */
+int presence_data(presence_coalescer_t *p, int32_t friendnumber, int kind, const uint8_t *data, uint16_t length)
+{
+	friend_presence_t *f;
+	uint8_t **buffer;
+	uint8_t *copy;
+
+	if (!p->enabled || p->flushing || (f = friend_get(p, friendnumber)) == NULL) {
+		return -1;
+	}
+
+	buffer = kind == PRESENCE_NAME ? &f->name : &f->status_message;
+	copy = realloc(*buffer, length == 0 ? 1 : length);
+
+	if (copy == NULL) {
+		return -1;
+	}
+
+	*buffer = copy;
+	memcpy(copy, data, length);
+
+	if (kind == PRESENCE_NAME) {
+		f->name_length = length;
+	} else {
+		f->status_message_length = length;
+	}
+
+	return mark_pending(p, f, friendnumber, kind);
+}
+
+/* Drop everything known about a deleted friend, so that a new friend with its number starts over */
+void presence_forget(presence_coalescer_t *p, int32_t friendnumber)
+{
+	if (friendnumber >= 0 && (uint32_t) friendnumber < p->friend_capacity) {
+		friend_presence_t *f = &p->friends[friendnumber];
+		uint32_t generation = f->generation;
+
+		/* The friend stays in the order list, but without pending events it is skipped */
+		friend_clear(f);
+		f->generation = generation + 1;
+	}
+}
+
+/*
+ * Deliver the pending events. Listeners may cause further events, which are delivered right away
+ * and can move the friend table, or delete the friend, after which its remaining events are
+ * dropped. So the entry is looked up again after every upcall. A listener that toggles coalescing
+ * flushes again; that nested flush returns at once and the outer one delivers everything.
+ */
+void presence_flush(presence_coalescer_t *p, presence_deliver_t deliver, void *userdata)
+{
+	uint32_t i;
+	int kind;
+
+	if (p->flushing) {
+		return;
+	}
+
+	p->flushing = 1;
+
+	for (i = 0; i < p->order_count; ++i) {
+		int32_t friendnumber = p->order[i];
+		friend_presence_t *f = &p->friends[friendnumber];
+		uint8_t pending = f->pending;
+		uint32_t generation = f->generation;
+
+		f->pending = 0;
+
+		for (kind = 0; kind < PRESENCE_KIND_COUNT; ++kind) {
+			f = &p->friends[friendnumber];
+
+			if (f->generation != generation) {
+				break;
+			}
+
+			if (!(pending & (1 << kind))) {
+				continue;
+			}
+
+			if (kind == PRESENCE_NAME) {
+				deliver(userdata, friendnumber, kind, 0, f->name, f->name_length);
+			} else if (kind == PRESENCE_STATUS_MESSAGE) {
+				deliver(userdata, friendnumber, kind, 0, f->status_message, f->status_message_length);
+			} else if ((f->known & (1 << kind)) && f->delivered[kind] == f->value[kind]) {
+				++p->stats[PRESENCE_STAT_UNCHANGED];
+				continue;
+			} else {
+				f->known |= 1 << kind;
+				f->delivered[kind] = f->value[kind];
+				deliver(userdata, friendnumber, kind, f->value[kind], NULL, 0);
+			}
+
+			++p->stats[PRESENCE_STAT_DELIVERED];
+		}
+	}
+
+	p->order_count = 0;
+	p->flushing = 0;
+}
+
+void presence_stats(const presence_coalescer_t *p, int64_t *stats)
+{
+	memcpy(stats, p->stats, sizeof(p->stats));
+}
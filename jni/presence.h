@@ -0,0 +1,63 @@
+/* presence.h
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef JTOX_PRESENCE_H
+#define JTOX_PRESENCE_H
+
+#include <stdint.h>
+
+/* Kinds of presence events, in the order they are delivered for a friend */
+enum {
+	PRESENCE_CONNECTION,
+	PRESENCE_NAME,
+	PRESENCE_STATUS_MESSAGE,
+	PRESENCE_USER_STATUS,
+	PRESENCE_TYPING,
+	PRESENCE_KIND_COUNT
+};
+
+/* Layout of the array filled by presence_stats */
+enum {
+	PRESENCE_STAT_RECEIVED,
+	PRESENCE_STAT_DELIVERED,
+	PRESENCE_STAT_COALESCED,
+	PRESENCE_STAT_UNCHANGED,
+	PRESENCE_STAT_COUNT
+};
+
+typedef struct presence_coalescer presence_coalescer_t;
+
+/*
+ * Called once per surviving event by presence_flush. Scalar kinds carry their value, names and
+ * status messages their bytes.
+ */
+typedef void (*presence_deliver_t)(void *, int32_t, int, uint8_t, const uint8_t *, uint16_t);
+
+presence_coalescer_t *presence_new(void);
+void presence_free(presence_coalescer_t *);
+void presence_set_enabled(presence_coalescer_t *, int);
+int presence_enabled(const presence_coalescer_t *);
+int presence_value(presence_coalescer_t *, int32_t, int, uint8_t);
+int presence_data(presence_coalescer_t *, int32_t, int, const uint8_t *, uint16_t);
+void presence_forget(presence_coalescer_t *, int32_t);
+void presence_flush(presence_coalescer_t *, presence_deliver_t, void *);
+void presence_stats(const presence_coalescer_t *, int64_t *);
+
+#endif
@@ -0,0 +1,384 @@
+/* reqfilter.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "reqfilter.h"
+
+/*
+ * Decides whether an incoming friend request is worth an upcall. It runs inside tox_do, before
+ * anything touches the JVM, so a flood of requests costs a hash lookup each instead of two java
+ * arrays and a method call. Checks are made in this order:
+ *
+ *   1. a blocked key is dropped, an allowed key is accepted without further checks
+ *   2. in allow-only mode, every key that is not allowed is dropped
+ *   3. messages longer than the configured maximum are dropped
+ *   4. each key has a token bucket, then all requests share a global one
+ *
+ * Everything is called from tox_do or from the natives guarded by the JTox lock, so there is no
+ * locking here.
+ */
+
+/* The block and allow lists share one open addressing table, grown at 70% load */
+#define LIST_INITIAL_CAPACITY 64
+
+/*
+ * Per-key buckets live in a fixed 4-way set associative cache. A flood of random keys evicts the
+ * least recently seen bucket instead of growing memory; an evicted key starts over with a full
+ * bucket, which only matters for keys that were quiet long enough to be evicted anyway.
+ */
+#define BUCKET_SETS 1024
+#define BUCKET_WAYS 4
+
+enum {
+	SLOT_EMPTY,
+	SLOT_BLOCK,
+	SLOT_ALLOW,
+	SLOT_DELETED
+};
+
+typedef struct {
+	uint8_t key[TOX_CLIENT_ID_SIZE];
+	uint8_t state;
+} list_slot_t;
+
+typedef struct {
+	double tokens;
+	uint64_t last_us;
+} token_bucket_t;
+
+typedef struct {
+	uint8_t key[TOX_CLIENT_ID_SIZE];
+	int used;
+	token_bucket_t bucket;
+} key_bucket_t;
+
+struct request_filter {
+	uint64_t seed;
+	list_slot_t *slots;
+	size_t capacity;
+	/* Listed keys, and listed keys plus deleted slots, which both count towards the load */
+	size_t listed;
+	size_t occupied;
+	int allow_only;
+	uint32_t max_length;
+	double key_rate;
+	uint32_t key_burst;
+	double global_rate;
+	uint32_t global_burst;
+	token_bucket_t global;
+	key_bucket_t *buckets;
+	int64_t stats[REQFILTER_STAT_COUNT];
+};
+
+/* Keys are chosen by the sender, so the hash is seeded per instance */
+static uint64_t key_hash(const request_filter_t *f, const uint8_t *key)
+{
+	uint64_t h = 0xcbf29ce484222325ULL ^ f->seed;
+	int i;
+
+	for (i = 0; i < TOX_CLIENT_ID_SIZE; ++i) {
+		h ^= key[i];
+		h *= 0x100000001b3ULL;
+	}
+
+	return h ^ (h >> 29);
+}
+
+request_filter_t *reqfilter_new(uint64_t seed)
+{
+	request_filter_t *f = calloc(1, sizeof(request_filter_t));
+
+	if (f == NULL) {
+		return NULL;
+	}
+
+	f->buckets = calloc(BUCKET_SETS * BUCKET_WAYS, sizeof(key_bucket_t));
+
+	if (f->buckets == NULL) {
+		free(f);
+		return NULL;
+	}
+
+	f->seed = seed;
+	return f;
+}
+
+void reqfilter_free(request_filter_t *f)
+{
+	if (f == NULL) {
+		return;
+	}
+
+	free(f->slots);
+	free(f->buckets);
+	free(f);
+}
+
+static void bucket_reset(token_bucket_t *b, uint32_t burst, uint64_t now_us)
+{
+	b->tokens = burst;
+	b->last_us = now_us;
+}
+
+/*
+ * Refill the bucket for the time since it was last used and take one token. A rate or burst of 0
+ * disables the bucket.
+ */
+static int bucket_take(token_bucket_t *b, double rate, uint32_t burst, uint64_t now_us)
+{
+	if (rate <= 0 || burst == 0) {
+		return 1;
+	}
+
+	if (now_us > b->last_us) {
+		b->tokens += (double) (now_us - b->last_us) * rate / 1000000.0;
+
+		if (b->tokens > burst) {
+			b->tokens = burst;
+		}
+	}
+
+	b->last_us = now_us;
+
+	if (b->tokens < 1.0) {
+		return 0;
+	}
+
+	b->tokens -= 1.0;
+	return 1;
+}
+
+void reqfilter_limits(request_filter_t *f, double key_rate, uint32_t key_burst, double global_rate,
+					  uint32_t global_burst)
+{
+	f->key_rate = key_rate;
+	f->key_burst = key_burst;
+	f->global_rate = global_rate;
+	f->global_burst = global_burst;
+	/* Start every bucket over so that lowering a limit takes effect right away */
+	memset(f->buckets, 0, BUCKET_SETS * BUCKET_WAYS * sizeof(key_bucket_t));
+	f->global.tokens = global_burst;
+	f->global.last_us = 0;
+}
+
+void reqfilter_max_length(request_filter_t *f, uint32_t max_length)
+{
+	f->max_length = max_length;
+}
+
+void reqfilter_allow_only(request_filter_t *f, int allow_only)
+{
+	f->allow_only = allow_only;
+}
+
+static list_slot_t *list_find(const request_filter_t *f, const uint8_t *key)
+{
+	size_t mask = f->capacity - 1;
+	size_t i;
+
+	if (f->capacity == 0) {
+		return NULL;
+	}
+
+	for (i = key_hash(f, key) & mask; f->slots[i].state != SLOT_EMPTY; i = (i + 1) & mask) {
+		if (f->slots[i].state != SLOT_DELETED && memcmp(f->slots[i].key, key, TOX_CLIENT_ID_SIZE) == 0) {
+			return &f->slots[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Insert a key that is known not to be listed, reusing the first deleted slot on its probe path */
+static void list_insert(request_filter_t *f, const uint8_t *key, uint8_t state)
+{
+	size_t mask = f->capacity - 1;
+	size_t i = key_hash(f, key) & mask;
+
+	while (f->slots[i].state != SLOT_EMPTY && f->slots[i].state != SLOT_DELETED) {
+		i = (i + 1) & mask;
+	}
+
+	if (f->slots[i].state == SLOT_EMPTY) {
+		++f->occupied;
+	}
+
+	memcpy(f->slots[i].key, key, TOX_CLIENT_ID_SIZE);
+	f->slots[i].state = state;
+	++f->listed;
+}
+
+static int list_resize(request_filter_t *f, size_t capacity)
+{
+	list_slot_t *old = f->slots;
+	size_t old_capacity = f->capacity;
+	size_t i;
+
+	f->slots = calloc(capacity, sizeof(list_slot_t));
+
+	if (f->slots == NULL) {
+		f->slots = old;
+		return -1;
+	}
+
+	f->capacity = capacity;
+	f->listed = 0;
+	f->occupied = 0;
+
+	for (i = 0; i < old_capacity; ++i) {
+		if (old[i].state == SLOT_BLOCK || old[i].state == SLOT_ALLOW) {
+			list_insert(f, old[i].key, old[i].state);
+		}
+	}
+
+	free(old);
+	return 0;
+}
+
+/*
+ * Put a key on the block or allow list, or take it off with REQFILTER_UNLISTED. A key is on at
+ * most one list; listing it again moves it.
+ *
+ * Returns 0 on success, -1 if the table could not grow.
+ */
+int reqfilter_list(request_filter_t *f, const uint8_t *key, int mode)
+{
+	list_slot_t *slot = list_find(f, key);
+	uint8_t state = mode == REQFILTER_BLOCK ? SLOT_BLOCK : SLOT_ALLOW;
+
+	if (mode == REQFILTER_UNLISTED) {
+		if (slot != NULL) {
+			slot->state = SLOT_DELETED;
+			--f->listed;
+		}
+
+		return 0;
+	}
+
+	if (slot != NULL) {
+		slot->state = state;
+		return 0;
+	}
+
+	if ((f->occupied + 1) * 10 > f->capacity * 7) {
+		size_t capacity = f->capacity == 0 ? LIST_INITIAL_CAPACITY : f->capacity;
+
+		/* Only grow if the load is made of live keys, otherwise rehashing drops the deleted slots */
+		while ((f->listed + 1) * 10 > capacity * 7) {
+			capacity *= 2;
+		}
+
+		if (list_resize(f, capacity) != 0) {
+			return -1;
+		}
+	}
+
+	list_insert(f, key, state);
+	return 0;
+}
+
+void reqfilter_clear(request_filter_t *f)
+{
+	free(f->slots);
+	f->slots = NULL;
+	f->capacity = 0;
+	f->listed = 0;
+	f->occupied = 0;
+}
+
+static key_bucket_t *key_bucket(request_filter_t *f, const uint8_t *key, uint64_t now_us)
+{
+	key_bucket_t *set = &f->buckets[(key_hash(f, key) % BUCKET_SETS) * BUCKET_WAYS];
+	key_bucket_t *victim = &set[0];
+	int i;
+
+	for (i = 0; i < BUCKET_WAYS; ++i) {
+		if (set[i].used && memcmp(set[i].key, key, TOX_CLIENT_ID_SIZE) == 0) {
+			return &set[i];
+		}
+
+		if (!set[i].used) {
+			victim = &set[i];
+		} else if (victim->used && set[i].bucket.last_us < victim->bucket.last_us) {
+			victim = &set[i];
+		}
+	}
+
+	memcpy(victim->key, key, TOX_CLIENT_ID_SIZE);
+	victim->used = 1;
+	bucket_reset(&victim->bucket, f->key_burst, now_us);
+	return victim;
+}
+
+/*
+ * Run a request through the filters and count the outcome.
+ *
+ * Returns 1 if the request should be passed on, 0 if it should be dropped.
+ */
+int reqfilter_check(request_filter_t *f, const uint8_t *key, uint16_t length, uint64_t now_us)
+{
+	list_slot_t *slot = list_find(f, key);
+
+	if (slot != NULL && slot->state == SLOT_BLOCK) {
+		++f->stats[REQFILTER_STAT_BLOCKED];
+		return 0;
+	}
+
+	if (slot != NULL && slot->state == SLOT_ALLOW) {
+		++f->stats[REQFILTER_STAT_ACCEPTED];
+		return 1;
+	}
+
+	if (f->allow_only) {
+		++f->stats[REQFILTER_STAT_NOT_ALLOWED];
+		return 0;
+	}
+
+	if (f->max_length != 0 && length > f->max_length) {
+		++f->stats[REQFILTER_STAT_TOO_LONG];
+		return 0;
+	}
+
+	/* The key's own bucket goes first, so a single noisy key cannot use up the global budget */
+	if (f->key_rate > 0 && f->key_burst != 0
+			&& !bucket_take(&key_bucket(f, key, now_us)->bucket, f->key_rate, f->key_burst, now_us)) {
+		++f->stats[REQFILTER_STAT_KEY_RATE];
+		return 0;
+	}
+
+	if (f->global.last_us == 0) {
+		f->global.last_us = now_us;
+	}
+
+	if (!bucket_take(&f->global, f->global_rate, f->global_burst, now_us)) {
+		++f->stats[REQFILTER_STAT_GLOBAL_RATE];
+		return 0;
+	}
+
+	++f->stats[REQFILTER_STAT_ACCEPTED];
+	return 1;
+}
+
+void reqfilter_stats(const request_filter_t *f, int64_t *stats)
+{
+	memcpy(stats, f->stats, sizeof(f->stats));
+}
@@ -0,0 +1,57 @@
+/* reqfilter.h
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef JTOX_REQFILTER_H
+#define JTOX_REQFILTER_H
+
+#include <stdint.h>
+#include <tox/tox.h>
+
+/* How a key is listed, passed to reqfilter_list */
+enum {
+	REQFILTER_UNLISTED,
+	REQFILTER_BLOCK,
+	REQFILTER_ALLOW
+};
+
+/* Layout of the array filled by reqfilter_stats */
+enum {
+	REQFILTER_STAT_ACCEPTED,
+	REQFILTER_STAT_BLOCKED,
+	REQFILTER_STAT_NOT_ALLOWED,
+	REQFILTER_STAT_TOO_LONG,
+	REQFILTER_STAT_GLOBAL_RATE,
+	REQFILTER_STAT_KEY_RATE,
+	REQFILTER_STAT_COUNT
+};
+
+typedef struct request_filter request_filter_t;
+
+request_filter_t *reqfilter_new(uint64_t);
+void reqfilter_free(request_filter_t *);
+void reqfilter_limits(request_filter_t *, double, uint32_t, double, uint32_t);
+void reqfilter_max_length(request_filter_t *, uint32_t);
+int reqfilter_list(request_filter_t *, const uint8_t *, int);
+void reqfilter_clear(request_filter_t *);
+void reqfilter_allow_only(request_filter_t *, int);
+int reqfilter_check(request_filter_t *, const uint8_t *, uint16_t, uint64_t);
+void reqfilter_stats(const request_filter_t *, int64_t *);
+
+#endif
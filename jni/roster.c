@@ -0,0 +1,160 @@
+/* roster.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "roster.h"
+
+/*
+ * Connection and user status of every friend, kept up to date by the callbacks so that java can
+ * answer presence queries from a direct ByteBuffer over this memory without calling into native
+ * code. For a capacity of n friends, which is always a multiple of 64, the buffer holds
+ *
+ *   0    n / 8 bytes, bit (i & 7) of byte (i >> 3) set if friend i is online
+ *   n/8  n bytes, the user status of friend i
+ *
+ * so the capacity is 8 / 9 of the buffer size. The bit order makes the bitset readable as
+ * little-endian longs on every platform. Friends beyond the capacity are offline with status 0.
+ *
+ * Growing moves the buffer, so the caller has to hand java a new ByteBuffer whenever an update
+ * returns 1.
+ */
+#define ROSTER_INITIAL_CAPACITY 256
+
+struct roster {
+	uint8_t *buffer;
+	uint32_t capacity;
+};
+
+roster_t *roster_new(void)
+{
+	roster_t *r = calloc(1, sizeof(roster_t));
+
+	if (r == NULL) {
+		return NULL;
+	}
+
+	r->buffer = calloc(ROSTER_INITIAL_CAPACITY / 8 + ROSTER_INITIAL_CAPACITY, 1);
+
+	if (r->buffer == NULL) {
+		free(r);
+		return NULL;
+	}
+
+	r->capacity = ROSTER_INITIAL_CAPACITY;
+	return r;
+}
+
+void roster_free(roster_t *r)
+{
+	if (r == NULL) {
+		return;
+	}
+
+	free(r->buffer);
+	free(r);
+}
+
+/*
+ * Make room for friendnumber.
+ *
+ * Returns 0 if it already fitted, 1 if the buffer moved, -1 on failure.
+ */
+static int roster_reserve(roster_t *r, int32_t friendnumber)
+{
+	uint32_t capacity = r->capacity;
+	uint8_t *buffer;
+
+	if (friendnumber < 0) {
+		return -1;
+	}
+
+	if ((uint32_t) friendnumber < r->capacity) {
+		return 0;
+	}
+
+	while (capacity <= (uint32_t) friendnumber) {
+		capacity *= 2;
+	}
+
+	buffer = calloc(capacity / 8 + capacity, 1);
+
+	if (buffer == NULL) {
+		return -1;
+	}
+
+	memcpy(buffer, r->buffer, r->capacity / 8);
+	memcpy(buffer + capacity / 8, r->buffer + r->capacity / 8, r->capacity);
+	free(r->buffer);
+	r->buffer = buffer;
+	r->capacity = capacity;
+	return 1;
+}
+
+/* Returns 1 if the buffer moved, 0 if not, -1 on failure */
+int roster_set_online(roster_t *r, int32_t friendnumber, int online)
+{
+	int moved = roster_reserve(r, friendnumber);
+
+	if (moved < 0) {
+		return -1;
+	}
+
+	if (online) {
+		r->buffer[friendnumber >> 3] |= 1 << (friendnumber & 7);
+	} else {
+		r->buffer[friendnumber >> 3] &= ~(1 << (friendnumber & 7));
+	}
+
+	return moved;
+}
+
+/* Returns 1 if the buffer moved, 0 if not, -1 on failure */
+int roster_set_status(roster_t *r, int32_t friendnumber, uint8_t status)
+{
+	int moved = roster_reserve(r, friendnumber);
+
+	if (moved < 0) {
+		return -1;
+	}
+
+	r->buffer[r->capacity / 8 + friendnumber] = status;
+	return moved;
+}
+
+/* Reset a deleted friend, so that a new friend with its number starts offline */
+void roster_forget(roster_t *r, int32_t friendnumber)
+{
+	if (friendnumber >= 0 && (uint32_t) friendnumber < r->capacity) {
+		r->buffer[friendnumber >> 3] &= ~(1 << (friendnumber & 7));
+		r->buffer[r->capacity / 8 + friendnumber] = 0;
+	}
+}
+
+uint8_t *roster_buffer(const roster_t *r)
+{
+	return r->buffer;
+}
+
+size_t roster_size(const roster_t *r)
+{
+	return r->capacity / 8 + r->capacity;
+}
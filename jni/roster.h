@@ -0,0 +1,37 @@
+/* roster.h
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef JTOX_ROSTER_H
+#define JTOX_ROSTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct roster roster_t;
+
+roster_t *roster_new(void);
+void roster_free(roster_t *);
+int roster_set_online(roster_t *, int32_t, int);
+int roster_set_status(roster_t *, int32_t, uint8_t);
+void roster_forget(roster_t *, int32_t);
+uint8_t *roster_buffer(const roster_t *);
+size_t roster_size(const roster_t *);
+
+#endif
@@ -0,0 +1,253 @@
+/* state.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include <tox/tox.h>
+
+#include "state.h"
+
+/*
+ * The messenger state is written to "<path>.tmp" first, flushed to disk and then renamed over
+ * <path>, so a crash during a save leaves either the old or the new state behind, never a torn one.
+ * On POSIX systems, tox_save serializes directly into a shared mapping of the temporary file, which
+ * avoids holding a second copy of the state in memory. The file's blocks are allocated before it is
+ * mapped: touching a page the file system cannot back raises SIGBUS, which would take the JVM down
+ * when the disk is full. Loading maps the file the same way and hands the mapping to tox_load.
+ */
+#define STATE_TMP_SUFFIX ".tmp"
+
+#ifdef WIN32
+static int state_write_tmp(Tox *tox, const char *tmp_path)
+{
+	uint32_t size = tox_size(tox);
+	uint8_t *data = malloc(size);
+	FILE *out;
+	int result = -1;
+
+	if (data == NULL) {
+		return -1;
+	}
+
+	tox_save(tox, data);
+	out = fopen(tmp_path, "wb");
+
+	if (out != NULL) {
+		if (fwrite(data, 1, size, out) == size && fflush(out) == 0 && _commit(_fileno(out)) == 0) {
+			result = 0;
+		}
+
+		if (fclose(out) != 0) {
+			result = -1;
+		}
+	}
+
+	free(data);
+	return result;
+}
+#else
+static int state_write_tmp(Tox *tox, const char *tmp_path)
+{
+	uint32_t size = tox_size(tox);
+	void *map;
+	int fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	int result = -1;
+
+	if (fd == -1) {
+		return -1;
+	}
+
+	if (size == 0) {
+		result = 0;
+	} else if (posix_fallocate(fd, 0, size) == 0) {
+		map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+		if (map != MAP_FAILED) {
+			tox_save(tox, map);
+
+			if (msync(map, size, MS_SYNC) == 0) {
+				result = 0;
+			}
+
+			munmap(map, size);
+		}
+	}
+
+	if (result == 0 && fsync(fd) != 0) {
+		result = -1;
+	}
+
+	if (close(fd) != 0) {
+		result = -1;
+	}
+
+	return result;
+}
+
+/* Make the rename itself durable by syncing the directory that holds the state file */
+static void state_sync_dir(const char *path)
+{
+	const char *slash = strrchr(path, '/');
+	char *dir;
+	int fd;
+
+	if (slash == NULL) {
+		dir = strdup(".");
+	} else if (slash == path) {
+		dir = strdup("/");
+	} else {
+		dir = malloc(slash - path + 1);
+
+		if (dir != NULL) {
+			memcpy(dir, path, slash - path);
+			dir[slash - path] = '\0';
+		}
+	}
+
+	if (dir == NULL) {
+		return;
+	}
+
+	fd = open(dir, O_RDONLY);
+
+	if (fd != -1) {
+		fsync(fd);
+		close(fd);
+	}
+
+	free(dir);
+}
+#endif
+
+/**
+ * Atomically replace the file at path with the current messenger state.
+ *
+ * Returns 0 on success, -1 on failure. On failure, the file at path is left untouched.
+ */
+int state_save_file(Tox *tox, const char *path)
+{
+	size_t length = strlen(path);
+	char *tmp_path = malloc(length + sizeof(STATE_TMP_SUFFIX));
+	int result;
+
+	if (tmp_path == NULL) {
+		return -1;
+	}
+
+	memcpy(tmp_path, path, length);
+	memcpy(tmp_path + length, STATE_TMP_SUFFIX, sizeof(STATE_TMP_SUFFIX));
+	result = state_write_tmp(tox, tmp_path);
+
+	if (result == 0) {
+#ifdef WIN32
+		/* rename does not replace existing files on Windows */
+		result = MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : -1;
+#else
+		result = rename(tmp_path, path);
+
+		if (result == 0) {
+			state_sync_dir(path);
+		}
+
+#endif
+	}
+
+	if (result != 0) {
+		remove(tmp_path);
+	}
+
+	free(tmp_path);
+	return result;
+}
+
+/**
+ * Load the messenger state from the file at path.
+ *
+ * Returns 0 on success, -1 if the file could not be read or core rejected its contents.
+ */
+#ifdef WIN32
+int state_load_file(Tox *tox, const char *path)
+{
+	FILE *in = fopen(path, "rb");
+	uint8_t *data;
+	__int64 size;
+	int result = -1;
+
+	if (in == NULL) {
+		return -1;
+	}
+
+	if (_fseeki64(in, 0, SEEK_END) != 0 || (size = _ftelli64(in)) <= 0 || size > UINT32_MAX
+			|| _fseeki64(in, 0, SEEK_SET) != 0) {
+		fclose(in);
+		return -1;
+	}
+
+	data = malloc((size_t) size);
+
+	if (data != NULL && fread(data, 1, (size_t) size, in) == (size_t) size) {
+		result = tox_load(tox, data, (uint32_t) size) == 0 ? 0 : -1;
+	}
+
+	free(data);
+	fclose(in);
+	return result;
+}
+#else
+int state_load_file(Tox *tox, const char *path)
+{
+	struct stat st;
+	void *map;
+	int fd = open(path, O_RDONLY);
+	int result = -1;
+
+	if (fd == -1) {
+		return -1;
+	}
+
+	if (fstat(fd, &st) != 0 || st.st_size <= 0 || (uint64_t) st.st_size > UINT32_MAX) {
+		close(fd);
+		return -1;
+	}
+
+	/* tox_load does not take a const pointer, so map privately: stray writes never reach the file */
+	map = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (map == MAP_FAILED) {
+		return -1;
+	}
+
+	madvise(map, (size_t) st.st_size, MADV_SEQUENTIAL);
+	result = tox_load(tox, map, (uint32_t) st.st_size) == 0 ? 0 : -1;
+	munmap(map, (size_t) st.st_size);
+	return result;
+}
+#endif
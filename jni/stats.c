@@ -0,0 +1,222 @@
+/* stats.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <tox/tox.h>
+#include <tox/toxav.h>
+#include <jni.h>
+
+#include "stats.h"
+#include "threadlocal.h"
+#include "trace.h"
+#include "utils.h"
+
+/*
+ * Every thread that enters a probe gets its own shard, so recording never contends: a shard is
+ * only ever written by its thread. Shards are pushed onto a lock-free list when they are created
+ * and live until the process exits, so a reader can walk the list at any time and sum them up.
+ * When a thread exits, its shard is recycled for the next new thread, counters and all, so the
+ * totals are unaffected and there are never more shards than threads alive at once. Readers may
+ * see a probe that is being recorded half-way, which skews a snapshot by at most one call per
+ * thread.
+ */
+typedef struct {
+	uint64_t calls;
+	uint64_t bytes;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint32_t buckets[STATS_BUCKETS];
+} stats_counter_t;
+
+typedef struct stats_shard {
+	/* Must come first, recycled shards are handed out as slots */
+	threadlocal_slot_t slot;
+	struct stats_shard *next;
+	stats_counter_t counters[STATS_PROBE_COUNT];
+} stats_shard_t;
+
+#define STATS_NAME(id, name) name,
+static const char *const names[STATS_PROBE_COUNT] = {
+	STATS_PROBES(STATS_NAME)
+};
+#undef STATS_NAME
+
+static stats_shard_t *shards;
+static THREAD_LOCAL stats_shard_t *local_shard;
+
+static void stats_shard_released(void)
+{
+	local_shard = NULL;
+}
+
+static threadlocal_pool_t shard_pool = THREADLOCAL_POOL_INIT(stats_shard_released);
+
+static stats_shard_t *stats_shard(void)
+{
+	stats_shard_t *shard = local_shard;
+
+	if (shard != NULL) {
+		return shard;
+	}
+
+	shard = (stats_shard_t *) threadlocal_take(&shard_pool);
+
+	if (shard != NULL) {
+		threadlocal_bind(&shard_pool, &shard->slot);
+		local_shard = shard;
+		return shard;
+	}
+
+	shard = calloc(1, sizeof(stats_shard_t));
+
+	if (shard == NULL) {
+		return NULL;
+	}
+
+	threadlocal_bind(&shard_pool, &shard->slot);
+
+	LIST_PUSH(shards, shard);
+	local_shard = shard;
+	return shard;
+}
+
+/**
+ * Histogram bucket a latency in nanoseconds is counted in
+ */
+int stats_bucket(uint64_t ns)
+{
+	int exponent = 0;
+	uint64_t v = ns;
+
+	if (ns < (1u << STATS_SUB_BUCKET_BITS)) {
+		return (int) ns;
+	}
+
+	while (v >>= 1) {
+		exponent++;
+	}
+
+	if (exponent >= STATS_MAX_EXPONENT) {
+		return STATS_BUCKETS - 1;
+	}
+
+	return ((exponent - STATS_SUB_BUCKET_BITS + 1) << STATS_SUB_BUCKET_BITS)
+		   + (int) ((ns >> (exponent - STATS_SUB_BUCKET_BITS)) & ((1u << STATS_SUB_BUCKET_BITS) - 1));
+}
+
+/**
+ * Smallest latency in nanoseconds counted in the given bucket
+ */
+uint64_t stats_bucket_lower(int bucket)
+{
+	int exponent;
+	uint64_t sub;
+
+	if (bucket < (1 << STATS_SUB_BUCKET_BITS)) {
+		return (uint64_t) bucket;
+	}
+
+	exponent = (bucket >> STATS_SUB_BUCKET_BITS) + STATS_SUB_BUCKET_BITS - 1;
+	sub = (uint64_t) (bucket & ((1 << STATS_SUB_BUCKET_BITS) - 1));
+	return ((1ULL << STATS_SUB_BUCKET_BITS) + sub) << (exponent - STATS_SUB_BUCKET_BITS);
+}
+
+stats_probe_t stats_probe_begin(int id)
+{
+	stats_probe_t probe;
+
+	probe.id = id;
+	probe.bytes = 0;
+	probe.start_ns = monotonic_time_ns();
+
+	if (TRACE_ACTIVE()) {
+		trace_event(id, TRACE_BEGIN, probe.start_ns);
+	}
+
+	return probe;
+}
+
+void stats_probe_end(stats_probe_t *probe)
+{
+	uint64_t now = monotonic_time_ns();
+	uint64_t elapsed = now - probe->start_ns;
+	stats_shard_t *shard = stats_shard();
+	stats_counter_t *c;
+
+	if (TRACE_ACTIVE()) {
+		trace_event(probe->id, TRACE_END, now);
+	}
+
+	if (shard == NULL) {
+		return;
+	}
+
+	c = &shard->counters[probe->id];
+	ADD_RELAXED(c->calls, 1);
+	ADD_RELAXED(c->bytes, probe->bytes);
+	ADD_RELAXED(c->total_ns, elapsed);
+
+	if (elapsed > c->max_ns) {
+		STORE_RELAXED(c->max_ns, elapsed);
+	}
+
+	ADD_RELAXED(c->buckets[stats_bucket(elapsed)], 1);
+}
+
+const char *stats_name(int id)
+{
+	return id >= 0 && id < STATS_PROBE_COUNT ? names[id] : NULL;
+}
+
+/**
+ * Merge all shards into out, which holds STATS_PROBE_COUNT * STATS_FIELDS values laid out as
+ * described in stats.h.
+ */
+void stats_export(int64_t *out)
+{
+	stats_shard_t *shard;
+	int id;
+	int i;
+
+	memset(out, 0, sizeof(int64_t) * STATS_PROBE_COUNT * STATS_FIELDS);
+
+	shard = LOAD_ACQUIRE(shards);
+
+	for (; shard != NULL; shard = shard->next) {
+		for (id = 0; id < STATS_PROBE_COUNT; id++) {
+			stats_counter_t *c = &shard->counters[id];
+			int64_t *o = out + id * STATS_FIELDS;
+			int64_t max = (int64_t) LOAD_RELAXED(c->max_ns);
+
+			o[0] += (int64_t) LOAD_RELAXED(c->calls);
+			o[1] += (int64_t) LOAD_RELAXED(c->bytes);
+			o[2] += (int64_t) LOAD_RELAXED(c->total_ns);
+
+			if (max > o[3]) {
+				o[3] = max;
+			}
+
+			for (i = 0; i < STATS_BUCKETS; i++) {
+				o[4 + i] += LOAD_RELAXED(c->buckets[i]);
+			}
+		}
+	}
+}
@@ -0,0 +1,201 @@
+/* stats.h
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef JTOX_STATS_H
+#define JTOX_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * One probe per JNI entry point and per native callback. The names are what JTox.getStats()
+ * reports, so they are part of the Java API and should not be renamed.
+ */
+#define STATS_PROBES(X) \
+	X(TOX_NEW, "tox_new") \
+	X(TOX_BOOTSTRAP_FROM_ADDRESS, "tox_bootstrap_from_address") \
+	X(TOX_BOOTSTRAP_NODES, "tox_bootstrap_nodes") \
+	X(TOX_DO, "tox_do") \
+	X(TOX_DO_INTERVAL, "tox_do_interval") \
+	X(TOX_PRESENCE_COALESCE, "tox_presence_coalesce") \
+	X(TOX_PRESENCE_STATS, "tox_presence_stats") \
+	X(TOX_ISCONNECTED, "tox_isconnected") \
+	X(TOX_KILL, "tox_kill") \
+	X(TOX_SAVE, "tox_save") \
+	X(TOX_SAVE_TO, "tox_save_to") \
+	X(TOX_IS_DIRTY, "tox_is_dirty") \
+	X(TOX_GET_STARTUP_TIMELINE, "tox_get_startup_timeline") \
+	X(TOX_LOAD, "tox_load") \
+	X(TOX_LOAD_FROM, "tox_load_from") \
+	X(TOX_ADD_FRIEND, "tox_add_friend") \
+	X(TOX_ADD_FRIEND_NOREQUEST, "tox_add_friend_norequest") \
+	X(TOX_REQUEST_FILTER_LIMITS, "tox_request_filter_limits") \
+	X(TOX_REQUEST_FILTER_MAX_LENGTH, "tox_request_filter_max_length") \
+	X(TOX_REQUEST_FILTER_LIST, "tox_request_filter_list") \
+	X(TOX_REQUEST_FILTER_CLEAR, "tox_request_filter_clear") \
+	X(TOX_REQUEST_FILTER_ALLOW_ONLY, "tox_request_filter_allow_only") \
+	X(TOX_REQUEST_FILTER_STATS, "tox_request_filter_stats") \
+	X(TOX_GET_ADDRESS, "tox_get_address") \
+	X(TOX_GET_ADDRESS_BYTES, "tox_get_address_bytes") \
+	X(TOX_GET_CLIENT_ID, "tox_get_client_id") \
+	X(TOX_GET_CLIENT_ID_BYTES, "tox_get_client_id_bytes") \
+	X(TOX_DEL_FRIEND, "tox_del_friend") \
+	X(TOX_SEND_MESSAGE, "tox_send_message") \
+	X(TOX_SEND_MESSAGES, "tox_send_messages") \
+	X(TOX_BROADCAST, "tox_broadcast") \
+	X(TOX_SEND_ACTION, "tox_send_action") \
+	X(TOX_SET_NAME, "tox_set_name") \
+	X(TOX_GET_SELF_NAME, "tox_get_self_name") \
+	X(TOX_SET_STATUS_MESSAGE, "tox_set_status_message") \
+	X(TOX_GET_FRIEND_CONNECTION_STATUS, "tox_get_friend_connection_status") \
+	X(TOX_GET_FRIEND_EXISTS, "tox_get_friend_exists") \
+	X(TOX_GET_NAME, "tox_get_name") \
+	X(TOX_ADD_GROUPCHAT, "tox_add_groupchat") \
+	X(TOX_DEL_GROUPCHAT, "tox_del_groupchat") \
+	X(TOX_INVITE_FRIEND, "tox_invite_friend") \
+	X(TOX_JOIN_GROUPCHAT, "tox_join_groupchat") \
+	X(TOX_GROUP_MESSAGE_SEND, "tox_group_message_send") \
+	X(TOX_GROUP_ACTION_SEND, "tox_group_action_send") \
+	X(TOX_GROUP_NUMBER_PEERS, "tox_group_number_peers") \
+	X(TOX_GROUP_PEERNAME, "tox_group_peername") \
+	X(TOX_GROUP_GET_NAMES, "tox_group_get_names") \
+	X(TOX_GET_CHATLIST, "tox_get_chatlist") \
+	X(TOX_GET_NOSPAM, "tox_get_nospam") \
+	X(TOX_SET_NOSPAM, "tox_set_nospam") \
+	X(TOX_NEW_FILE_SENDER, "tox_new_file_sender") \
+	X(TOX_FILE_SEND_CONTROL, "tox_file_send_control") \
+	X(TOX_FILE_SEND_DATA, "tox_file_send_data") \
+	X(TOX_FILE_DATA_SIZE, "tox_file_data_size") \
+	X(TOX_FILE_DATA_REMAINING, "tox_file_data_remaining") \
+	X(TOX_FILE_SCHEDULE, "tox_file_schedule") \
+	X(TOX_FILE_RECEIVE, "tox_file_receive") \
+	X(TOX_FILE_UNSCHEDULE, "tox_file_unschedule") \
+	X(TOX_FILE_SET_WEIGHT, "tox_file_set_weight") \
+	X(TOX_FILE_TRANSFER_STATS, "tox_file_transfer_stats") \
+	X(TOX_SET_USER_STATUS, "tox_set_user_status") \
+	X(TOX_GET_STATUS_MESSAGE, "tox_get_status_message") \
+	X(TOX_GETSELFSTATUSMESSAGE, "tox_getselfstatusmessage") \
+	X(TOX_GET_USER_STATUS, "tox_get_user_status") \
+	X(TOX_GET_SELF_USER_STATUS, "tox_get_self_user_status") \
+	X(TOX_GET_FRIENDLIST, "tox_get_friendlist") \
+	X(TOX_SET_USER_IS_TYPING, "tox_set_user_is_typing") \
+	X(TOX_GET_IS_TYPING, "tox_get_is_typing") \
+	X(UTF8_VALIDATE, "utf8_validate") \
+	X(TOXAV_NEW, "toxav_new") \
+	X(TOXAV_KILL, "toxav_kill") \
+	X(TOXAV_CALL, "toxav_call") \
+	X(TOXAV_CALL_COMPILED, "toxav_call_compiled") \
+	X(TOXAV_HANGUP, "toxav_hangup") \
+	X(TOXAV_ANSWER, "toxav_answer") \
+	X(TOXAV_ANSWER_COMPILED, "toxav_answer_compiled") \
+	X(TOXAV_REJECT, "toxav_reject") \
+	X(TOXAV_CANCEL, "toxav_cancel") \
+	X(TOXAV_CHANGE_SETTINGS, "toxav_change_settings") \
+	X(TOXAV_CHANGE_SETTINGS_COMPILED, "toxav_change_settings_compiled") \
+	X(TOXAV_STOP_CALL, "toxav_stop_call") \
+	X(TOXAV_PREPARE_TRANSMISSION, "toxav_prepare_transmission") \
+	X(TOXAV_KILL_TRANSMISSION, "toxav_kill_transmission") \
+	X(TOXAV_SEND_VIDEO, "toxav_send_video") \
+	X(TOXAV_SEND_AUDIO, "toxav_send_audio") \
+	X(TOXAV_PREPARE_VIDEO_FRAME, "toxav_prepare_video_frame") \
+	X(TOXAV_PREPARE_AUDIO_FRAME, "toxav_prepare_audio_frame") \
+	X(TOXAV_BITRATE_ENABLE, "toxav_bitrate_enable") \
+	X(TOXAV_BITRATE_DISABLE, "toxav_bitrate_disable") \
+	X(TOXAV_BITRATE_STATS, "toxav_bitrate_stats") \
+	X(TOXAV_GET_CALL_STATS, "toxav_get_call_stats") \
+	X(TOXAV_CODEC_SETTINGS_COMPILE, "toxav_codec_settings_compile") \
+	X(TOXAV_CODEC_SETTINGS_FREE, "toxav_codec_settings_free") \
+	X(TOXAV_GET_PEER_CSETTINGS, "toxav_get_peer_csettings") \
+	X(TOXAV_GET_PEER_ID, "toxav_get_peer_id") \
+	X(TOXAV_GET_CALL_STATE, "toxav_get_call_state") \
+	X(TOXAV_CAPABILITY_SUPPORTED, "toxav_capability_supported") \
+	X(CALLBACK_FILECONTROL, "callback_filecontrol") \
+	X(CALLBACK_FILEDATA, "callback_filedata") \
+	X(CALLBACK_FILESENDREQUEST, "callback_filesendrequest") \
+	X(CALLBACK_FRIENDREQUEST, "callback_friendrequest") \
+	X(CALLBACK_FRIENDMESSAGE, "callback_friendmessage") \
+	X(CALLBACK_ACTION, "callback_action") \
+	X(CALLBACK_NAMECHANGE, "callback_namechange") \
+	X(CALLBACK_STATUSMESSAGE, "callback_statusmessage") \
+	X(CALLBACK_USERSTATUS, "callback_userstatus") \
+	X(CALLBACK_READ_RECEIPT, "callback_read_receipt") \
+	X(CALLBACK_CONNECTIONSTATUS, "callback_connectionstatus") \
+	X(CALLBACK_TYPINGSTATUS, "callback_typingstatus") \
+	X(CALLBACK_GROUP_INVITE, "callback_group_invite") \
+	X(CALLBACK_GROUP_MESSAGE, "callback_group_message") \
+	X(CALLBACK_GROUP_ACTION, "callback_group_action") \
+	X(CALLBACK_GROUP_NAMELIST_CHANGE, "callback_group_namelist_change") \
+	X(AVCALLBACK_INVITE, "avcallback_invite") \
+	X(AVCALLBACK_START, "avcallback_start") \
+	X(AVCALLBACK_CANCEL, "avcallback_cancel") \
+	X(AVCALLBACK_REJECT, "avcallback_reject") \
+	X(AVCALLBACK_END, "avcallback_end") \
+	X(AVCALLBACK_RINGING, "avcallback_ringing") \
+	X(AVCALLBACK_STARTING, "avcallback_starting") \
+	X(AVCALLBACK_ENDING, "avcallback_ending") \
+	X(AVCALLBACK_REQUESTTIMEOUT, "avcallback_requesttimeout") \
+	X(AVCALLBACK_PEERTIMEOUT, "avcallback_peertimeout") \
+	X(AVCALLBACK_MEDIACHANGE, "avcallback_mediachange") \
+	X(AVCALLBACK_AUDIO, "avcallback_audio") \
+	X(AVCALLBACK_VIDEO, "avcallback_video")
+
+#define STATS_ENUM(id, name) STAT_##id,
+enum {
+	STATS_PROBES(STATS_ENUM)
+	STATS_PROBE_COUNT
+};
+#undef STATS_ENUM
+
+/*
+ * Latencies are counted in log-linear buckets, 8 per power of two, which keeps the relative error
+ * below 12.5%. Values of 2^STATS_MAX_EXPONENT ns (about 68 seconds) and more land in the last bucket.
+ */
+#define STATS_SUB_BUCKET_BITS 3
+#define STATS_MAX_EXPONENT 36
+#define STATS_BUCKETS ((STATS_MAX_EXPONENT - STATS_SUB_BUCKET_BITS + 1) << STATS_SUB_BUCKET_BITS)
+/* calls, bytes, total ns, max ns, then the buckets */
+#define STATS_FIELDS (4 + STATS_BUCKETS)
+
+typedef struct {
+	int id;
+	uint64_t start_ns;
+	uint64_t bytes;
+} stats_probe_t;
+
+int stats_bucket(uint64_t);
+uint64_t stats_bucket_lower(int);
+stats_probe_t stats_probe_begin(int);
+void stats_probe_end(stats_probe_t *);
+const char *stats_name(int);
+void stats_export(int64_t *);
+
+/*
+ * STATS_ENTRY must be the first declaration of the function it measures. The probe is closed
+ * automatically on every return path. STATS_BYTES adds to the byte counter of the open probe.
+ */
+#ifdef __GNUC__
+#define STATS_ENTRY(id) stats_probe_t stats_probe __attribute__((cleanup(stats_probe_end))) = stats_probe_begin(STAT_##id)
+#define STATS_BYTES(n) (stats_probe.bytes += (uint64_t) (n))
+#else
+#define STATS_ENTRY(id) int stats_probe_unused
+#define STATS_BYTES(n) ((void) (n))
+#endif
+
+#endif
@@ -0,0 +1,99 @@
+/* threadlocal.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stddef.h>
+
+#include "threadlocal.h"
+
+#ifdef WIN32
+#define POOL_LOCK(pool) AcquireSRWLockExclusive(&(pool)->lock)
+#define POOL_UNLOCK(pool) ReleaseSRWLockExclusive(&(pool)->lock)
+#else
+#define POOL_LOCK(pool) pthread_mutex_lock(&(pool)->lock)
+#define POOL_UNLOCK(pool) pthread_mutex_unlock(&(pool)->lock)
+#endif
+
+#ifdef WIN32
+static VOID WINAPI threadlocal_release(PVOID value)
+#else
+static void threadlocal_release(void *value)
+#endif
+{
+	threadlocal_slot_t *slot = value;
+	threadlocal_pool_t *pool = slot->pool;
+
+	POOL_LOCK(pool);
+	slot->next_free = pool->free;
+	pool->free = slot;
+	POOL_UNLOCK(pool);
+
+	if (pool->released != NULL) {
+		pool->released();
+	}
+}
+
+/**
+ * Take a slot a finished thread left behind, or NULL if there is none. The caller allocates a new
+ * one then. Either way it must be passed to threadlocal_bind before use.
+ */
+threadlocal_slot_t *threadlocal_take(threadlocal_pool_t *pool)
+{
+	threadlocal_slot_t *slot;
+
+	POOL_LOCK(pool);
+
+	if (!pool->key_created) {
+#ifdef WIN32
+		pool->key = FlsAlloc(threadlocal_release);
+		pool->key_created = pool->key != FLS_OUT_OF_INDEXES;
+#else
+		pool->key_created = pthread_key_create(&pool->key, threadlocal_release) == 0;
+#endif
+	}
+
+	slot = pool->free;
+
+	if (slot != NULL) {
+		pool->free = slot->next_free;
+	}
+
+	POOL_UNLOCK(pool);
+	return slot;
+}
+
+/**
+ * Hand slot back to the pool when the calling thread exits. If no key could be created, the slot
+ * is simply never recycled.
+ */
+void threadlocal_bind(threadlocal_pool_t *pool, threadlocal_slot_t *slot)
+{
+	slot->next_free = NULL;
+	slot->pool = pool;
+
+	if (!pool->key_created) {
+		return;
+	}
+
+#ifdef WIN32
+	FlsSetValue(pool->key, slot);
+#else
+	pthread_setspecific(pool->key, slot);
+#endif
+}
@@ -0,0 +1,96 @@
+/* threadlocal.h
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef JTOX_THREADLOCAL_H
+#define JTOX_THREADLOCAL_H
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/*
+ * Thread locals and the few atomic operations the per-thread buffers need. Without GCC builtins
+ * this assumes MSVC.
+ */
+#ifdef __GNUC__
+#define THREAD_LOCAL __thread
+#define LOAD_RELAXED(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define LOAD_ACQUIRE(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define STORE_RELAXED(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+#define STORE_RELEASE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+/* x must be 32 bits wide */
+#define FETCH_ADD(x, v) __atomic_fetch_add(&(x), (v), __ATOMIC_RELAXED)
+/* Push node onto a list of structs linked through their next member */
+#define LIST_PUSH(head, node) do { \
+	(node)->next = __atomic_load_n(&(head), __ATOMIC_ACQUIRE); \
+	while (!__atomic_compare_exchange_n(&(head), &(node)->next, (node), 1, __ATOMIC_RELEASE, \
+										__ATOMIC_ACQUIRE)) { \
+	} \
+} while (0)
+#else
+#define THREAD_LOCAL __declspec(thread)
+#define LOAD_RELAXED(x) (x)
+#define LOAD_ACQUIRE(x) (x)
+#define STORE_RELAXED(x, v) ((x) = (v))
+#define STORE_RELEASE(x, v) (MemoryBarrier(), (x) = (v))
+#define FETCH_ADD(x, v) InterlockedExchangeAdd((volatile LONG *) &(x), (LONG) (v))
+#define LIST_PUSH(head, node) do { \
+	(node)->next = (head); \
+} while (InterlockedCompareExchangePointer((PVOID volatile *) &(head), (node), (node)->next) != (node)->next)
+#endif
+/* Only for values a single thread writes, so a relaxed load and store is enough */
+#define ADD_RELAXED(x, v) STORE_RELAXED(x, LOAD_RELAXED(x) + (v))
+
+/*
+ * Per-thread buffers that outlive their thread, like the stats shards, are recycled through a
+ * pool: when a thread exits its buffer goes onto the pool's free list and the next new thread
+ * takes it from there, so the number of buffers is bounded by the number of threads alive at once.
+ */
+typedef struct threadlocal_slot {
+	struct threadlocal_slot *next_free;
+	struct threadlocal_pool *pool;
+} threadlocal_slot_t;
+
+typedef struct threadlocal_pool {
+#ifdef WIN32
+	SRWLOCK lock;
+	DWORD key;
+#else
+	pthread_mutex_t lock;
+	pthread_key_t key;
+#endif
+	int key_created;
+	threadlocal_slot_t *free;
+	/* Runs on the exiting thread once its slot is back on the free list */
+	void (*released)(void);
+} threadlocal_pool_t;
+
+#ifdef WIN32
+#define THREADLOCAL_POOL_INIT(released) { SRWLOCK_INIT, 0, 0, NULL, released }
+#else
+#define THREADLOCAL_POOL_INIT(released) { PTHREAD_MUTEX_INITIALIZER, 0, 0, NULL, released }
+#endif
+
+threadlocal_slot_t *threadlocal_take(threadlocal_pool_t *);
+void threadlocal_bind(threadlocal_pool_t *, threadlocal_slot_t *);
+
+#endif
@@ -0,0 +1,166 @@
+/* timeline.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "timeline.h"
+
+/*
+ * Records when the milestones between loading the library and being fully online happened, on
+ * the monotonic clock from utils.c. Only the first occurrence of each milestone is kept, and for
+ * TIMELINE_FRIEND_CONNECTED the first occurrence per friend. All times are exported relative to
+ * the start of JNI_OnLoad, which is the earliest point native code runs.
+ */
+#define TIMELINE_INITIAL_CAPACITY 16
+/* Bounds the memory used by instances with huge friend lists */
+#define TIMELINE_MAX_ENTRIES 4096
+
+typedef struct {
+	int milestone;
+	int32_t friendnumber;
+	uint64_t start_us;
+	uint64_t end_us;
+} timeline_entry_t;
+
+struct timeline {
+	timeline_entry_t *entries;
+	size_t count;
+	size_t capacity;
+	/* One bit per milestone that has been recorded */
+	uint32_t seen;
+};
+
+/* Written once from JNI_OnLoad, before any instance exists */
+static uint64_t origin_us;
+static uint64_t onload_end_us;
+
+void timeline_onload(uint64_t start_us, uint64_t end_us)
+{
+	origin_us = start_us;
+	onload_end_us = end_us;
+}
+
+timeline_t *timeline_new(void)
+{
+	timeline_t *t = calloc(1, sizeof(timeline_t));
+
+	if (t == NULL) {
+		return NULL;
+	}
+
+	timeline_mark(t, TIMELINE_JNI_ONLOAD, TIMELINE_NO_FRIEND, origin_us, onload_end_us);
+	return t;
+}
+
+void timeline_free(timeline_t *t)
+{
+	if (t == NULL) {
+		return;
+	}
+
+	free(t->entries);
+	free(t);
+}
+
+static int timeline_find_friend(const timeline_t *t, int32_t friendnumber)
+{
+	size_t i;
+
+	for (i = 0; i < t->count; i++) {
+		if (t->entries[i].milestone == TIMELINE_FRIEND_CONNECTED && t->entries[i].friendnumber == friendnumber) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+void timeline_mark(timeline_t *t, int milestone, int32_t friendnumber, uint64_t start_us, uint64_t end_us)
+{
+	timeline_entry_t *e;
+
+	if (t == NULL || t->count == TIMELINE_MAX_ENTRIES) {
+		return;
+	}
+
+	if (milestone == TIMELINE_FRIEND_CONNECTED) {
+		if (timeline_find_friend(t, friendnumber)) {
+			return;
+		}
+	} else if (timeline_has(t, milestone)) {
+		return;
+	}
+
+	if (t->count == t->capacity) {
+		size_t capacity = t->capacity == 0 ? TIMELINE_INITIAL_CAPACITY : t->capacity * 2;
+		timeline_entry_t *entries = realloc(t->entries, capacity * sizeof(timeline_entry_t));
+
+		if (entries == NULL) {
+			return;
+		}
+
+		t->entries = entries;
+		t->capacity = capacity;
+	}
+
+	e = &t->entries[t->count++];
+	e->milestone = milestone;
+	e->friendnumber = friendnumber;
+	e->start_us = start_us;
+	e->end_us = end_us;
+	t->seen |= 1u << milestone;
+}
+
+int timeline_has(const timeline_t *t, int milestone)
+{
+	return t != NULL && (t->seen & (1u << milestone)) != 0;
+}
+
+size_t timeline_count(const timeline_t *t)
+{
+	return t == NULL ? 0 : t->count;
+}
+
+/**
+ * Write up to max entries as TIMELINE_ENTRY_FIELDS values each: milestone, friend number, start and
+ * end in microseconds since the start of JNI_OnLoad.
+ *
+ * Returns the number of entries written.
+ */
+size_t timeline_export(const timeline_t *t, int64_t *out, size_t max)
+{
+	size_t i;
+	size_t count = timeline_count(t);
+
+	if (count > max) {
+		count = max;
+	}
+
+	for (i = 0; i < count; i++) {
+		const timeline_entry_t *e = &t->entries[i];
+		out[i * TIMELINE_ENTRY_FIELDS] = e->milestone;
+		out[i * TIMELINE_ENTRY_FIELDS + 1] = e->friendnumber;
+		out[i * TIMELINE_ENTRY_FIELDS + 2] = (int64_t) (e->start_us - origin_us);
+		out[i * TIMELINE_ENTRY_FIELDS + 3] = (int64_t) (e->end_us - origin_us);
+	}
+
+	return count;
+}
@@ -0,0 +1,52 @@
+/* timeline.h
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef JTOX_TIMELINE_H
+#define JTOX_TIMELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Must match the order of im.tox.jtoxcore.ToxTimelineMilestone */
+enum {
+	TIMELINE_JNI_ONLOAD,
+	TIMELINE_TOX_NEW,
+	TIMELINE_TOX_LOAD,
+	TIMELINE_TOXAV_NEW,
+	TIMELINE_BOOTSTRAP,
+	TIMELINE_CONNECTED,
+	TIMELINE_FRIEND_CONNECTED
+};
+
+#define TIMELINE_NO_FRIEND -1
+/* Number of values per entry written by timeline_export */
+#define TIMELINE_ENTRY_FIELDS 4
+
+typedef struct timeline timeline_t;
+
+void timeline_onload(uint64_t, uint64_t);
+timeline_t *timeline_new(void);
+void timeline_free(timeline_t *);
+void timeline_mark(timeline_t *, int, int32_t, uint64_t, uint64_t);
+int timeline_has(const timeline_t *, int);
+size_t timeline_count(const timeline_t *);
+size_t timeline_export(const timeline_t *, int64_t *, size_t);
+
+#endif
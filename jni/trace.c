@@ -0,0 +1,210 @@
+/* trace.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tox/tox.h>
+#include <tox/toxav.h>
+#include <jni.h>
+
+#include "threadlocal.h"
+#include "trace.h"
+#include "utils.h"
+
+/*
+ * Each thread that records an event gets its own ring of TRACE_RING_SIZE events, so recording
+ * takes no lock. When a ring is full, the oldest events are overwritten. Rings are linked into a
+ * lock-free list and never freed, and recycled when their thread exits, the same way as the stats
+ * shards. A recycled ring keeps its tid, so threads that ran one after another share a track.
+ *
+ * A dump walks all rings and writes the events in the Chrome trace event format, which Perfetto
+ * and chrome://tracing load directly. An event that is being overwritten while the dump copies it
+ * may come out garbled; stop tracing before dumping for an exact picture.
+ */
+#define TRACE_RING_SIZE 16384
+
+typedef struct {
+	uint64_t ts_ns;
+	uint16_t name;
+	char phase;
+} trace_event_t;
+
+typedef struct trace_ring {
+	/* Must come first, recycled rings are handed out as slots */
+	threadlocal_slot_t slot;
+	struct trace_ring *next;
+	uint32_t tid;
+	/* Total number of events ever written, the slot is head % TRACE_RING_SIZE */
+	uint64_t head;
+	trace_event_t events[TRACE_RING_SIZE];
+} trace_ring_t;
+
+volatile int trace_on;
+
+static trace_ring_t *rings;
+static uint32_t next_tid = 1;
+/* Events before this point were cleared */
+static uint64_t epoch_ns;
+static THREAD_LOCAL trace_ring_t *local_ring;
+
+static void trace_ring_released(void)
+{
+	local_ring = NULL;
+}
+
+static threadlocal_pool_t ring_pool = THREADLOCAL_POOL_INIT(trace_ring_released);
+
+static trace_ring_t *trace_ring(void)
+{
+	trace_ring_t *ring = local_ring;
+
+	if (ring != NULL) {
+		return ring;
+	}
+
+	ring = (trace_ring_t *) threadlocal_take(&ring_pool);
+
+	if (ring != NULL) {
+		threadlocal_bind(&ring_pool, &ring->slot);
+		local_ring = ring;
+		return ring;
+	}
+
+	ring = calloc(1, sizeof(trace_ring_t));
+
+	if (ring == NULL) {
+		return NULL;
+	}
+
+	threadlocal_bind(&ring_pool, &ring->slot);
+	ring->tid = FETCH_ADD(next_tid, 1);
+	LIST_PUSH(rings, ring);
+	local_ring = ring;
+	return ring;
+}
+
+void trace_set_enabled(int enabled)
+{
+	trace_on = enabled;
+}
+
+void trace_event(int name, char phase, uint64_t ts_ns)
+{
+	trace_ring_t *ring = trace_ring();
+	trace_event_t *e;
+	uint64_t head;
+
+	if (ring == NULL) {
+		return;
+	}
+
+	head = ring->head;
+	e = &ring->events[head % TRACE_RING_SIZE];
+	e->ts_ns = ts_ns;
+	e->name = (uint16_t) name;
+	e->phase = phase;
+	STORE_RELEASE(ring->head, head + 1);
+}
+
+void trace_clear(void)
+{
+	STORE_RELAXED(epoch_ns, monotonic_time_ns());
+}
+
+static const char *trace_name(int name)
+{
+	if (name == TRACE_LOCK_WAIT) {
+		return "jtox_lock_wait";
+	}
+
+	return stats_name(name);
+}
+
+/* Longest event: the fixed text, a 20 digit timestamp, a 10 digit tid and the name */
+#define TRACE_MAX_EVENT 160
+
+/**
+ * Render all recorded events as a Chrome trace JSON object. The buffer starts out sized for the
+ * events recorded so far and grows if more arrive while dumping.
+ *
+ * Returns a string the caller must free, or NULL if out of memory.
+ */
+char *trace_dump_json(void)
+{
+	uint64_t epoch = LOAD_RELAXED(epoch_ns);
+	/* Rings created from here on are added in front of this one and are not part of the dump */
+	trace_ring_t *all = LOAD_ACQUIRE(rings);
+	size_t capacity = 64;
+	size_t length = 0;
+	trace_ring_t *ring;
+	char *out;
+	int first = 1;
+
+	for (ring = all; ring != NULL; ring = ring->next) {
+		uint64_t head = LOAD_ACQUIRE(ring->head);
+
+		capacity += (size_t) (head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE) * TRACE_MAX_EVENT;
+	}
+
+	out = malloc(capacity);
+
+	if (out == NULL) {
+		return NULL;
+	}
+
+	length += sprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+	for (ring = all; ring != NULL; ring = ring->next) {
+		uint64_t head = LOAD_ACQUIRE(ring->head);
+		uint64_t i = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+
+		for (; i < head; i++) {
+			trace_event_t e = ring->events[i % TRACE_RING_SIZE];
+			const char *name = trace_name(e.name);
+
+			if (e.ts_ns < epoch || name == NULL) {
+				continue;
+			}
+
+			/* Keep room for this event and the closing brackets */
+			if (capacity - length < TRACE_MAX_EVENT + 3) {
+				char *grown = realloc(out, capacity * 2);
+
+				if (grown == NULL) {
+					free(out);
+					return NULL;
+				}
+
+				out = grown;
+				capacity *= 2;
+			}
+
+			length += sprintf(out + length,
+							  "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":1,\"tid\":%u}",
+							  first ? "" : ",", name, e.phase, (unsigned long long) (e.ts_ns / 1000),
+							  (unsigned) (e.ts_ns % 1000), ring->tid);
+			first = 0;
+		}
+	}
+
+	sprintf(out + length, "]}");
+	return out;
+}
@@ -0,0 +1,47 @@
+/* trace.h
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef JTOX_TRACE_H
+#define JTOX_TRACE_H
+
+#include <stdint.h>
+
+#include "stats.h"
+
+/* Trace names are the stats probes, followed by events that only exist in traces */
+enum {
+	TRACE_LOCK_WAIT = STATS_PROBE_COUNT,
+	TRACE_NAME_COUNT
+};
+
+#define TRACE_BEGIN 'B'
+#define TRACE_END 'E'
+
+extern volatile int trace_on;
+
+void trace_set_enabled(int);
+void trace_event(int, char, uint64_t);
+void trace_clear(void);
+char *trace_dump_json(void);
+
+/* Cheap enough to leave in hot paths: a single load when tracing is off */
+#define TRACE_ACTIVE() (trace_on != 0)
+
+#endif
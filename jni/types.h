@@ -14,6 +14,12 @@ typedef struct {
    jmethodID onAudioDataMethodId;
    jmethodID onVideoDataMethodId;
    jmethodID onAvCallbackMethodId;
+   jmethodID onGroupInviteMethodId;
+   jmethodID onGroupMessageMethodId;
+   jmethodID onGroupActionMethodId;
+   jmethodID onGroupNamelistChangeMethodId;
+   jfieldID eventBufferFieldId;
+   jfieldID presenceBufferFieldId;
 } cachedId;
 
 typedef struct {
@@ -22,6 +28,16 @@ typedef struct {
     jobject handler;
     jobject jtox;
     cachedId *cache;
+    uint8_t *event_buffer;
+    jlong event_buffer_capacity;
+    struct file_scheduler *file_scheduler;
+    struct journal_registry *journal;
+    struct request_filter *request_filter;
+    struct presence_coalescer *presence;
+    struct roster *roster;
+    /* Set whenever state that ends up in tox_save changes, cleared by a successful save */
+    int dirty;
+    struct timeline *timeline;
 } tox_jni_globals_t;
 
 typedef struct {
@@ -30,4 +46,6 @@ typedef struct {
     jobject handler;
     jobject jtox;
     cachedId *cache;
+    struct bitrate_controller *bitrate;
+    struct media_stats *media_stats;
 } tox_av_jni_globals_t;
@@ -0,0 +1,255 @@
+/* utf8.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "utf8.h"
+
+#define REPLACEMENT_CHARACTER 0xFFFD
+#define STACK_STRING_LENGTH 512
+
+/**
+ * Return the number of leading ASCII bytes. Scans 16 bytes at a time with SSE2 where available,
+ * otherwise 8 bytes at a time in a machine word.
+ */
+size_t utf8_ascii_prefix(const uint8_t *data, size_t length)
+{
+	size_t i = 0;
+	uint64_t word;
+
+#ifdef __SSE2__
+
+	while (i + 16 <= length) {
+		__m128i chunk = _mm_loadu_si128((const __m128i *) (data + i));
+
+		if (_mm_movemask_epi8(chunk) != 0) {
+			break;
+		}
+
+		i += 16;
+	}
+
+#endif
+
+	while (i + 8 <= length) {
+		memcpy(&word, data + i, sizeof(word));
+
+		if ((word & 0x8080808080808080ULL) != 0) {
+			break;
+		}
+
+		i += 8;
+	}
+
+	while (i < length && data[i] < 0x80) {
+		i++;
+	}
+
+	return i;
+}
+
+/**
+ * Decode one multi-byte sequence starting at data. The allowed range of the second byte depends on
+ * the lead byte, which rejects overlong forms, surrogates and code points above U+10FFFF as soon
+ * as they can be told apart.
+ *
+ * @return the length of the sequence, or 0 if it is not valid UTF-8. In that case invalid is set
+ *         to the length of the maximal subpart, the longest start of a valid sequence, at least 1
+ */
+static size_t decode_sequence(const uint8_t *data, size_t length, uint32_t *code_point, size_t *invalid)
+{
+	uint8_t lead = data[0];
+	uint8_t low = 0x80;
+	uint8_t high = 0xBF;
+	uint32_t cp;
+	size_t needed;
+	size_t i;
+
+	*invalid = 1;
+
+	if (lead >= 0xC2 && lead <= 0xDF) {
+		needed = 2;
+		cp = lead & 0x1F;
+	} else if (lead >= 0xE0 && lead <= 0xEF) {
+		needed = 3;
+		cp = lead & 0x0F;
+		low = lead == 0xE0 ? 0xA0 : low;
+		high = lead == 0xED ? 0x9F : high;
+	} else if (lead >= 0xF0 && lead <= 0xF4) {
+		needed = 4;
+		cp = lead & 0x07;
+		low = lead == 0xF0 ? 0x90 : low;
+		high = lead == 0xF4 ? 0x8F : high;
+	} else {
+		return 0;
+	}
+
+	for (i = 1; i < needed; i++) {
+		if (i == length || data[i] < low || data[i] > high) {
+			*invalid = i;
+			return 0;
+		}
+
+		cp = (cp << 6) | (data[i] & 0x3F);
+		low = 0x80;
+		high = 0xBF;
+	}
+
+	*code_point = cp;
+	return needed;
+}
+
+/**
+ * Check whether the given buffer is well-formed standard UTF-8
+ *
+ * @return 1 if valid, 0 otherwise
+ */
+int utf8_validate(const uint8_t *data, size_t length)
+{
+	size_t i = 0;
+	size_t n;
+	size_t invalid;
+	uint32_t cp;
+
+	while (i < length) {
+		i += utf8_ascii_prefix(data + i, length - i);
+
+		if (i == length) {
+			break;
+		}
+
+		n = decode_sequence(data + i, length - i, &cp, &invalid);
+
+		if (n == 0) {
+			return 0;
+		}
+
+		i += n;
+	}
+
+	return 1;
+}
+
+/**
+ * Convert standard UTF-8 to UTF-16. Each maximal subpart of an ill-formed sequence is replaced by
+ * one U+FFFD, as the Unicode standard recommends and the java decoder does: a truncated sequence
+ * becomes a single U+FFFD, a stray continuation byte one each. The output buffer must have room
+ * for length code units.
+ *
+ * @return the number of UTF-16 code units written
+ */
+size_t utf8_to_utf16(const uint8_t *data, size_t length, jchar *out)
+{
+	size_t i = 0;
+	size_t o = 0;
+	size_t ascii;
+	size_t n;
+	size_t invalid;
+	uint32_t cp;
+
+	while (i < length) {
+		ascii = utf8_ascii_prefix(data + i, length - i);
+
+		while (ascii-- > 0) {
+			out[o++] = data[i++];
+		}
+
+		if (i == length) {
+			break;
+		}
+
+		n = decode_sequence(data + i, length - i, &cp, &invalid);
+
+		if (n == 0) {
+			out[o++] = REPLACEMENT_CHARACTER;
+			i += invalid;
+		} else if (cp >= 0x10000) {
+			cp -= 0x10000;
+			out[o++] = (jchar) (0xD800 + (cp >> 10));
+			out[o++] = (jchar) (0xDC00 + (cp & 0x3FF));
+			i += n;
+		} else {
+			out[o++] = (jchar) cp;
+			i += n;
+		}
+	}
+
+	return o;
+}
+
+/**
+ * Create a java String from standard UTF-8. Unlike NewStringUTF, this neither needs a \0-terminated
+ * buffer nor expects java's modified UTF-8.
+ */
+jstring utf8_new_string(JNIEnv *env, const uint8_t *data, size_t length)
+{
+	jchar stack_buf[STACK_STRING_LENGTH];
+	jchar *buf = stack_buf;
+	jstring result;
+	size_t units;
+
+	if (length > STACK_STRING_LENGTH) {
+		buf = malloc(length * sizeof(jchar));
+
+		if (buf == NULL) {
+			return NULL;
+		}
+	}
+
+	units = utf8_to_utf16(data, length, buf);
+	result = (*env)->NewString(env, buf, (jsize) units);
+
+	if (buf != stack_buf) {
+		free(buf);
+	}
+
+	return result;
+}
+
+/**
+ * Copy a java byte array holding UTF-8 text into a newly allocated, \0-terminated C string.
+ * The caller has to free the result.
+ *
+ * @return the string, or NULL if array is null or allocation failed
+ */
+char *utf8_copy_cstring(JNIEnv *env, jbyteArray array)
+{
+	jsize length;
+	char *result;
+
+	if (array == NULL) {
+		return NULL;
+	}
+
+	length = (*env)->GetArrayLength(env, array);
+	result = malloc(length + 1);
+
+	if (result == NULL) {
+		return NULL;
+	}
+
+	(*env)->GetByteArrayRegion(env, array, 0, length, (jbyte *) result);
+	result[length] = '\0';
+	return result;
+}
@@ -0,0 +1,34 @@
+/* utf8.h
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef JTOX_UTF8_H
+#define JTOX_UTF8_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <jni.h>
+
+size_t utf8_ascii_prefix(const uint8_t *, size_t);
+int utf8_validate(const uint8_t *, size_t);
+size_t utf8_to_utf16(const uint8_t *, size_t, jchar *);
+jstring utf8_new_string(JNIEnv *, const uint8_t *, size_t);
+char *utf8_copy_cstring(JNIEnv *, jbyteArray);
+
+#endif
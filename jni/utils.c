@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #ifdef WIN32
 #include <winsock2.h>
 #include <windows.h>
@@ -19,9 +20,36 @@
 #endif
 #define ALIGN(x, y) y*((x + (y-1))/y)
 
-ToxAvCSettings codec_settings_to_native(JNIEnv *env, jobject codec_settings)
+static const char hex_digits[] = "0123456789ABCDEF";
+
+/**
+ * Encode length bytes as upper case hexadecimal into buf, which must hold length * 2 + 1 chars.
+ * The result is \0-terminated.
+ */
+void bytes_to_hex(const uint8_t *bytes, size_t length, char *buf)
 {
+	size_t i;
+
+	for (i = 0; i < length; i++) {
+		buf[2 * i] = hex_digits[bytes[i] >> 4];
+		buf[2 * i + 1] = hex_digits[bytes[i] & 0x0F];
+	}
+
+	buf[2 * length] = '\0';
+}
+
+/**
+ * Native call types indexed by ToxCallType ordinal
+ */
+static const ToxAvCallType call_types[] = { TypeAudio, TypeVideo };
+#define CALL_TYPE_COUNT (sizeof(call_types) / sizeof(call_types[0]))
+
+/**
+ * Class, field and method ids for ToxCodecSettings and ToxCallType, looked up once
+ */
+static struct {
 	jclass clazz;
+	jmethodID init_method;
 	jfieldID call_type_id;
 	jfieldID video_bitrate_id;
 	jfieldID max_video_width_id;
@@ -30,89 +58,109 @@ ToxAvCSettings codec_settings_to_native(JNIEnv *env, jobject codec_settings)
 	jfieldID audio_frame_duration_id;
 	jfieldID audio_sample_rate_id;
 	jfieldID audio_channels_id;
-	jobject call_type_obj;
-	jint video_bitrate;
-	jint max_video_width;
-	jint max_video_height;
-	jint audio_bitrate;
-	jint audio_frame_duration;
-	jint audio_sample_rate;
-	jint audio_channels;
-	ToxAvCallType call_type;
+	jmethodID ordinal_method;
+	jobject call_type_values[CALL_TYPE_COUNT];
+	volatile int cached;
+} codec_ids;
+
+/**
+ * Look up the ids used to convert codec settings. Called from JNI_OnLoad, and again lazily if the
+ * library was loaded some other way. Returns 0 on success, -1 if a class could not be found.
+ */
+int codec_settings_cache(JNIEnv *env)
+{
+	static const char *const call_type_names[] = { "TYPE_AUDIO", "TYPE_VIDEO" };
+	jclass clazz;
 	jclass enum_class;
-	jmethodID get_name_method;
-	jstring enum_name;
-	const char *enum_name_native;
-	ToxAvCSettings codec_settings_native;
+	jfieldID enum_field_id;
+	size_t i;
+
+	if (codec_ids.cached) {
+		return 0;
+	}
 
-	//Get java class for struct, and its field ids
 	clazz = (*env)->FindClass(env, "im/tox/jtoxcore/ToxCodecSettings");
-	call_type_id = (*env)->GetFieldID(env, clazz, "call_type", "Lim/tox/jtoxcore/ToxCallType;");
-	video_bitrate_id = (*env)->GetFieldID(env, clazz, "video_bitrate", "I");
-	max_video_width_id = (*env)->GetFieldID(env, clazz, "max_video_width", "I");
-	max_video_height_id = (*env)->GetFieldID(env, clazz, "max_video_height", "I");
-	audio_bitrate_id = (*env)->GetFieldID(env, clazz, "audio_bitrate", "I");
-	audio_frame_duration_id = (*env)->GetFieldID(env, clazz, "audio_frame_duration", "I");
-	audio_sample_rate_id = (*env)->GetFieldID(env, clazz, "audio_sample_rate", "I");
-	audio_channels_id = (*env)->GetFieldID(env, clazz, "audio_channels", "I");
-
-	//Get calltype java enum from call settings class
-	call_type_obj = (*env)->GetObjectField(env, codec_settings, call_type_id);
-	//Get remaining class members
-	video_bitrate = (*env)->GetIntField(env, codec_settings, video_bitrate_id);
-	max_video_width = (*env)->GetIntField(env, codec_settings, max_video_width_id);
-	max_video_height = (*env)->GetIntField(env, codec_settings, max_video_height_id);
-	audio_bitrate = (*env)->GetIntField(env, codec_settings, audio_bitrate_id);
-	audio_frame_duration = (*env)->GetIntField(env, codec_settings, audio_frame_duration_id);
-	audio_sample_rate = (*env)->GetIntField(env, codec_settings, audio_sample_rate_id);
-	audio_channels = (*env)->GetIntField(env, codec_settings, audio_channels_id);
-
-	//Turn calltype java enum into c enum
 	enum_class = (*env)->FindClass(env, "im/tox/jtoxcore/ToxCallType");
-	get_name_method = (*env)->GetMethodID(env, enum_class, "name", "()Ljava/lang/String;");
-	enum_name = (jstring)(*env)->CallObjectMethod(env, call_type_obj, get_name_method);
-	enum_name_native = (*env)->GetStringUTFChars(env, enum_name, 0);
-
-	if (strcmp(enum_name_native, "TYPE_AUDIO") == 0) {
-		call_type = TypeAudio;
-	} else if (strcmp(enum_name_native, "TYPE_VIDEO") == 0) {
-		call_type = TypeVideo;
+
+	if (clazz == NULL || enum_class == NULL) {
+		return -1;
+	}
+
+	codec_ids.clazz = (*env)->NewGlobalRef(env, clazz);
+	codec_ids.init_method = (*env)->GetMethodID(env, clazz, "<init>", "(Lim/tox/jtoxcore/ToxCallType;IIIIIII)V");
+	codec_ids.call_type_id = (*env)->GetFieldID(env, clazz, "call_type", "Lim/tox/jtoxcore/ToxCallType;");
+	codec_ids.video_bitrate_id = (*env)->GetFieldID(env, clazz, "video_bitrate", "I");
+	codec_ids.max_video_width_id = (*env)->GetFieldID(env, clazz, "max_video_width", "I");
+	codec_ids.max_video_height_id = (*env)->GetFieldID(env, clazz, "max_video_height", "I");
+	codec_ids.audio_bitrate_id = (*env)->GetFieldID(env, clazz, "audio_bitrate", "I");
+	codec_ids.audio_frame_duration_id = (*env)->GetFieldID(env, clazz, "audio_frame_duration", "I");
+	codec_ids.audio_sample_rate_id = (*env)->GetFieldID(env, clazz, "audio_sample_rate", "I");
+	codec_ids.audio_channels_id = (*env)->GetFieldID(env, clazz, "audio_channels", "I");
+	codec_ids.ordinal_method = (*env)->GetMethodID(env, enum_class, "ordinal", "()I");
+
+	for (i = 0; i < CALL_TYPE_COUNT; i++) {
+		enum_field_id = (*env)->GetStaticFieldID(env, enum_class, call_type_names[i], "Lim/tox/jtoxcore/ToxCallType;");
+		codec_ids.call_type_values[i] = (*env)->NewGlobalRef(env,
+										(*env)->GetStaticObjectField(env, enum_class, enum_field_id));
+	}
+
+	(*env)->DeleteLocalRef(env, clazz);
+	(*env)->DeleteLocalRef(env, enum_class);
+	codec_ids.cached = 1;
+	return 0;
+}
+
+ToxAvCSettings codec_settings_to_native(JNIEnv *env, jobject codec_settings)
+{
+	jobject call_type_obj;
+	jint ordinal;
+	ToxAvCSettings codec_settings_native = av_DefaultSettings;
+
+	if (codec_settings == NULL || codec_settings_cache(env) != 0) {
+		return codec_settings_native;
 	}
 
-	codec_settings_native.call_type = call_type;
-	codec_settings_native.video_bitrate = video_bitrate;
-	codec_settings_native.max_video_width = max_video_width;
-	codec_settings_native.max_video_height = max_video_height;
-	codec_settings_native.audio_bitrate = audio_bitrate;
-	codec_settings_native.audio_frame_duration = audio_frame_duration;
-	codec_settings_native.audio_sample_rate = audio_sample_rate;
-	codec_settings_native.audio_channels = audio_channels;
+	//Turn calltype java enum into c enum, unknown or null types keep the default
+	call_type_obj = (*env)->GetObjectField(env, codec_settings, codec_ids.call_type_id);
+
+	if (call_type_obj != NULL) {
+		ordinal = (*env)->CallIntMethod(env, call_type_obj, codec_ids.ordinal_method);
+
+		if (ordinal >= 0 && (size_t) ordinal < CALL_TYPE_COUNT) {
+			codec_settings_native.call_type = call_types[ordinal];
+		}
+
+		(*env)->DeleteLocalRef(env, call_type_obj);
+	}
+
+	codec_settings_native.video_bitrate = (*env)->GetIntField(env, codec_settings, codec_ids.video_bitrate_id);
+	codec_settings_native.max_video_width = (*env)->GetIntField(env, codec_settings, codec_ids.max_video_width_id);
+	codec_settings_native.max_video_height = (*env)->GetIntField(env, codec_settings, codec_ids.max_video_height_id);
+	codec_settings_native.audio_bitrate = (*env)->GetIntField(env, codec_settings, codec_ids.audio_bitrate_id);
+	codec_settings_native.audio_frame_duration = (*env)->GetIntField(env, codec_settings,
+			codec_ids.audio_frame_duration_id);
+	codec_settings_native.audio_sample_rate = (*env)->GetIntField(env, codec_settings, codec_ids.audio_sample_rate_id);
+	codec_settings_native.audio_channels = (*env)->GetIntField(env, codec_settings, codec_ids.audio_channels_id);
 	return codec_settings_native;
 }
 
 jobject codec_settings_to_java(JNIEnv *env, ToxAvCSettings codec_settings_native)
 {
-	jclass clazz;
-	jclass enum_class;
-	jfieldID enum_field_id;
-	jobject call_type;
-	jmethodID init_method;
-
-	//Turn calltype c enum into java enum
-	enum_class = (*env)->FindClass(env, "im/tox/jtoxcore/ToxCallType");
+	jobject call_type = NULL;
+	size_t i;
 
-	if (codec_settings_native.call_type == TypeAudio) {
-		enum_field_id = (*env)->GetStaticFieldID(env, enum_class, "TYPE_AUDIO", "Lim/tox/jtoxcore/ToxCallType;");
-	} else if (codec_settings_native.call_type == TypeVideo) {
-		enum_field_id = (*env)->GetStaticFieldID(env, enum_class, "TYPE_VIDEO", "Lim/tox/jtoxcore/ToxCallType;");
+	if (codec_settings_cache(env) != 0) {
+		return NULL;
 	}
 
-	call_type = (*env)->GetStaticObjectField(env, enum_class, enum_field_id);
+	//Turn calltype c enum into java enum
+	for (i = 0; i < CALL_TYPE_COUNT; i++) {
+		if (call_types[i] == codec_settings_native.call_type) {
+			call_type = codec_ids.call_type_values[i];
+		}
+	}
 
-	//Get java class for struct, and create java object
-	clazz = (*env)->FindClass(env, "im/tox/jtoxcore/ToxCodecSettings");
-	init_method = (*env)->GetMethodID(env, clazz, "<init>", "(Lim/tox/jtoxcore/ToxCallType;IIIIIII)V");
-	jobject codec_settings = (*env)->NewObject(env, clazz, init_method
+	return (*env)->NewObject(env, codec_ids.clazz, codec_ids.init_method
 							 , call_type
 							 , (jint) codec_settings_native.video_bitrate
 							 , (jint) codec_settings_native.max_video_width
@@ -121,8 +169,7 @@ jobject codec_settings_to_java(JNIEnv *env, ToxAvCSettings codec_settings_native
 							 , (jint) codec_settings_native.audio_frame_duration
 							 , (jint) codec_settings_native.audio_sample_rate
 							 , (jint) codec_settings_native.audio_channels
-											  );
-	return codec_settings;
+							);
 }
 
 void avcallback_helper(int32_t call_id, void *user_data, char *enum_name)
@@ -143,4 +190,31 @@ void avcallback_helper(int32_t call_id, void *user_data, char *enum_name)
     (*env)->CallVoidMethod(env, globals->handler, globals->cache->onAvCallbackMethodId, call_id, callback_id);
 }
 
+/**
+ * Nanoseconds since an arbitrary point in the past. Unaffected by changes to the wall clock.
+ */
+uint64_t monotonic_time_ns(void)
+{
+#ifdef WIN32
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (uint64_t) (counter.QuadPart / frequency.QuadPart) * 1000000000
+		   + (uint64_t) (counter.QuadPart % frequency.QuadPart) * 1000000000 / frequency.QuadPart;
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
 
+/**
+ * Microseconds since an arbitrary point in the past. Unaffected by changes to the wall clock.
+ */
+uint64_t monotonic_time_us(void)
+{
+	return monotonic_time_ns() / 1000;
+}
@@ -1,4 +1,20 @@
+#include <stddef.h>
+#include <stdint.h>
 #include <jni.h>
+
+/* Seek and tell with 64 bit offsets, for files larger than 2 GiB on 32 bit platforms */
+#ifdef WIN32
+#define file_seek(f, offset, whence) _fseeki64(f, (__int64) (offset), whence)
+#define file_tell(f) _ftelli64(f)
+#else
+#define file_seek(f, offset, whence) fseeko(f, (off_t) (offset), whence)
+#define file_tell(f) ftello(f)
+#endif
+
+void bytes_to_hex(const uint8_t *, size_t, char *);
+uint64_t monotonic_time_us(void);
+uint64_t monotonic_time_ns(void);
+int codec_settings_cache(JNIEnv *);
 ToxAvCSettings codec_settings_to_native(JNIEnv *, jobject);
 jobject codec_settings_to_java(JNIEnv *, ToxAvCSettings);
 void avcallback_helper(int32_t, void *, char *);
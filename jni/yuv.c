@@ -0,0 +1,104 @@
+/* yuv.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <string.h>
+#include "yuv.h"
+
+/*
+ * Conversion between vpx images and the YV12 layout Android uses for camera and display buffers:
+ * a Y plane with its stride aligned to 16 bytes, followed by the Cr and Cb planes at half the
+ * width and height, whose strides are aligned to 16 bytes as well.
+ */
+#define ALIGN16(x) (((x) + 15) & ~15u)
+
+typedef struct {
+	unsigned int stride;
+	unsigned int c_stride;
+	size_t cr_offset;
+	size_t cb_offset;
+	size_t size;
+} yv12_layout_t;
+
+static yv12_layout_t yv12_layout(unsigned int width, unsigned int height)
+{
+	yv12_layout_t layout;
+	size_t c_size;
+
+	layout.stride = ALIGN16(width);
+	layout.c_stride = ALIGN16(layout.stride / 2);
+	c_size = (size_t) layout.c_stride * (height / 2);
+	layout.cr_offset = (size_t) layout.stride * height;
+	layout.cb_offset = layout.cr_offset + c_size;
+	layout.size = layout.cb_offset + c_size;
+	return layout;
+}
+
+/**
+ * Size in bytes of a YV12 buffer for a picture of the given dimensions
+ */
+size_t yuv_yv12_size(unsigned int width, unsigned int height)
+{
+	return yv12_layout(width, height).size;
+}
+
+/**
+ * Copy the visible area of img into out, which must hold yuv_yv12_size(img->d_w, img->d_h) bytes.
+ * Padding at the end of each row is left untouched.
+ */
+void yuv_vpx_to_yv12(const vpx_image_t *img, uint8_t *out)
+{
+	yv12_layout_t layout = yv12_layout(img->d_w, img->d_h);
+	unsigned int c_width = (img->d_w + 1) / 2;
+	unsigned int row;
+
+	for (row = 0; row < img->d_h; row++) {
+		memcpy(out + (size_t) row * layout.stride, img->planes[VPX_PLANE_Y] + (size_t) row * img->stride[VPX_PLANE_Y],
+			   img->d_w);
+	}
+
+	for (row = 0; row < img->d_h / 2; row++) {
+		memcpy(out + layout.cr_offset + (size_t) row * layout.c_stride,
+			   img->planes[VPX_PLANE_V] + (size_t) row * img->stride[VPX_PLANE_V], c_width);
+		memcpy(out + layout.cb_offset + (size_t) row * layout.c_stride,
+			   img->planes[VPX_PLANE_U] + (size_t) row * img->stride[VPX_PLANE_U], c_width);
+	}
+}
+
+/**
+ * Copy a YV12 buffer of img->d_w by img->d_h pixels into the planes of img
+ */
+void yuv_yv12_to_vpx(const uint8_t *in, vpx_image_t *img)
+{
+	yv12_layout_t layout = yv12_layout(img->d_w, img->d_h);
+	unsigned int c_width = (img->d_w + 1) / 2;
+	unsigned int row;
+
+	for (row = 0; row < img->d_h; row++) {
+		memcpy(img->planes[VPX_PLANE_Y] + (size_t) row * img->stride[VPX_PLANE_Y], in + (size_t) row * layout.stride,
+			   img->d_w);
+	}
+
+	for (row = 0; row < img->d_h / 2; row++) {
+		memcpy(img->planes[VPX_PLANE_V] + (size_t) row * img->stride[VPX_PLANE_V],
+			   in + layout.cr_offset + (size_t) row * layout.c_stride, c_width);
+		memcpy(img->planes[VPX_PLANE_U] + (size_t) row * img->stride[VPX_PLANE_U],
+			   in + layout.cb_offset + (size_t) row * layout.c_stride, c_width);
+	}
+}
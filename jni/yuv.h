@@ -0,0 +1,32 @@
+/* yuv.h
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef JTOX_YUV_H
+#define JTOX_YUV_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vpx/vpx_image.h>
+
+size_t yuv_yv12_size(unsigned int, unsigned int);
+void yuv_vpx_to_yv12(const vpx_image_t *, uint8_t *);
+void yuv_yv12_to_vpx(const uint8_t *, vpx_image_t *);
+
+#endif
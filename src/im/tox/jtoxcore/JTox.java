@@ -21,10 +21,21 @@
 
 package im.tox.jtoxcore;
 
-import java.io.UnsupportedEncodingException;
+import java.io.File;
+import java.io.IOException;
+import java.net.InetAddress;
 import java.net.UnknownHostException;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.nio.charset.Charset;
 import java.util.*;
+import java.util.concurrent.Callable;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.TimeoutException;
 import java.util.concurrent.locks.ReentrantLock;
 
 import im.tox.jtoxcore.callbacks.CallbackHandler;
@@ -51,6 +62,327 @@ public class JTox<F extends ToxFriend> {
 	 */
 	public static final int TOX_MAX_NICKNAME_LENGTH = 128;
 
+	/**
+	 * Maximum length of a single message or action in Bytes. Non-ASCII
+	 * characters take multiple Bytes.
+	 */
+	public static final int TOX_MAX_MESSAGE_LENGTH = 1368;
+
+	/**
+	 * Size of a client id (public key) in Bytes
+	 */
+	public static final int TOX_CLIENT_ID_SIZE = 32;
+
+	/**
+	 * Size of a friend address in Bytes. This is the client id followed by the
+	 * nospam value and a checksum.
+	 */
+	public static final int TOX_FRIEND_ADDRESS_SIZE = TOX_CLIENT_ID_SIZE + 4 + 2;
+
+	/**
+	 * Index of the file size in the array returned by
+	 * {@link #getFileTransferStats(int, int)}
+	 */
+	public static final int FILE_STAT_SIZE = 0;
+
+	/**
+	 * Index of the number of bytes core has accepted so far
+	 */
+	public static final int FILE_STAT_SENT = 1;
+
+	/**
+	 * Index of the milliseconds since the friend accepted the transfer, up to
+	 * when it ended
+	 */
+	public static final int FILE_STAT_ELAPSED_MS = 2;
+
+	/**
+	 * Index of the average throughput in bytes per second
+	 */
+	public static final int FILE_STAT_BYTES_PER_SECOND = 3;
+
+	/**
+	 * Index of the scheduling weight
+	 */
+	public static final int FILE_STAT_WEIGHT = 4;
+
+	/**
+	 * Index of the transfer state: 0 waiting for the friend to accept, 1
+	 * sending, 2 paused, 3 finished, 4 killed
+	 */
+	public static final int FILE_STAT_STATE = 5;
+
+	/**
+	 * Index of the number of friend requests passed on to the handler in the
+	 * array returned by {@link #getFriendRequestFilterStats()}
+	 */
+	public static final int REQUEST_STAT_ACCEPTED = 0;
+
+	/**
+	 * Index of the number of requests dropped because the key is blocked
+	 */
+	public static final int REQUEST_STAT_BLOCKED = 1;
+
+	/**
+	 * Index of the number of requests dropped because the key is not allowed
+	 * while {@link #setFriendRequestAllowlistOnly(boolean)} is on
+	 */
+	public static final int REQUEST_STAT_NOT_ALLOWED = 2;
+
+	/**
+	 * Index of the number of requests dropped for a message that is too long
+	 */
+	public static final int REQUEST_STAT_TOO_LONG = 3;
+
+	/**
+	 * Index of the number of requests dropped by the global rate limit
+	 */
+	public static final int REQUEST_STAT_GLOBAL_RATE = 4;
+
+	/**
+	 * Index of the number of requests dropped by the per-key rate limit
+	 */
+	public static final int REQUEST_STAT_KEY_RATE = 5;
+
+	/**
+	 * Index of the number of presence events core reported in the array
+	 * returned by {@link #getPresenceCoalescingStats()}
+	 */
+	public static final int PRESENCE_STAT_RECEIVED = 0;
+
+	/**
+	 * Index of the number of presence events passed on to the handler
+	 */
+	public static final int PRESENCE_STAT_DELIVERED = 1;
+
+	/**
+	 * Index of the number of presence events replaced by a later one of the
+	 * same kind for the same friend within a tick
+	 */
+	public static final int PRESENCE_STAT_COALESCED = 2;
+
+	/**
+	 * Index of the number of connection, user status and typing events dropped
+	 * because their final value was the one delivered last
+	 */
+	public static final int PRESENCE_STAT_UNCHANGED = 3;
+
+	/**
+	 * Index of the bitrate controller state, 1 while it is on and 0 otherwise,
+	 * in the array returned by {@link #avGetBitrateStats(int)}
+	 */
+	public static final int BITRATE_STAT_ENABLED = 0;
+
+	/**
+	 * Index of the current step down the ladder, 0 is the negotiated settings
+	 */
+	public static final int BITRATE_STAT_LEVEL = 1;
+
+	/**
+	 * Index of the video bitrate in kbit/s the controller last chose
+	 */
+	public static final int BITRATE_STAT_VIDEO_BITRATE = 2;
+
+	/**
+	 * Index of the maximum video width in pixels the controller last chose.
+	 * Frames passed to {@link #avPrepareVideoFrame} have to be scaled down to
+	 * it by the application.
+	 */
+	public static final int BITRATE_STAT_VIDEO_WIDTH = 3;
+
+	/**
+	 * Index of the maximum video height in pixels the controller last chose.
+	 * Frames passed to {@link #avPrepareVideoFrame} have to be scaled down to
+	 * it by the application.
+	 */
+	public static final int BITRATE_STAT_VIDEO_HEIGHT = 4;
+
+	/**
+	 * Index of the audio bitrate in bit/s the controller last chose
+	 */
+	public static final int BITRATE_STAT_AUDIO_BITRATE = 5;
+
+	/**
+	 * Index of the number of steps down
+	 */
+	public static final int BITRATE_STAT_DOWNGRADES = 6;
+
+	/**
+	 * Index of the number of steps back up
+	 */
+	public static final int BITRATE_STAT_UPGRADES = 7;
+
+	/**
+	 * Index of the number of settings changes toxav refused
+	 */
+	public static final int BITRATE_STAT_CHANGE_FAILURES = 8;
+
+	/**
+	 * Index of the number of frames sent while controlled
+	 */
+	public static final int BITRATE_STAT_SENDS = 9;
+
+	/**
+	 * Index of the number of frames toxav failed to send
+	 */
+	public static final int BITRATE_STAT_SEND_FAILURES = 10;
+
+	/**
+	 * Index of the number of bytes produced by the encoders
+	 */
+	public static final int BITRATE_STAT_ENCODED_BYTES = 11;
+
+	/**
+	 * Index of the mean time spent encoding a frame in the last window, in
+	 * microseconds
+	 */
+	public static final int BITRATE_STAT_PREPARE_LATENCY_US = 12;
+
+	/**
+	 * Index of the time since the call was set up, in microseconds, in the array
+	 * returned by {@link #avGetCallStats(int)}
+	 */
+	public static final int MEDIA_STAT_ELAPSED_US = 0;
+
+	/**
+	 * Index of the number of video frames encoded
+	 */
+	public static final int MEDIA_STAT_VIDEO_FRAMES_ENCODED = 1;
+
+	/**
+	 * Index of the number of audio frames encoded
+	 */
+	public static final int MEDIA_STAT_AUDIO_FRAMES_ENCODED = 2;
+
+	/**
+	 * Index of the number of video frames received
+	 */
+	public static final int MEDIA_STAT_VIDEO_FRAMES_DECODED = 3;
+
+	/**
+	 * Index of the number of audio frames received
+	 */
+	public static final int MEDIA_STAT_AUDIO_FRAMES_DECODED = 4;
+
+	/**
+	 * Index of video frames encoded per second, over the last second
+	 */
+	public static final int MEDIA_STAT_VIDEO_ENCODE_FPS = 5;
+
+	/**
+	 * Index of audio frames encoded per second, over the last second
+	 */
+	public static final int MEDIA_STAT_AUDIO_ENCODE_FPS = 6;
+
+	/**
+	 * Index of video frames received per second, over the last second
+	 */
+	public static final int MEDIA_STAT_VIDEO_DECODE_FPS = 7;
+
+	/**
+	 * Index of audio frames received per second, over the last second
+	 */
+	public static final int MEDIA_STAT_AUDIO_DECODE_FPS = 8;
+
+	/**
+	 * Index of the number of encoded bytes sent
+	 */
+	public static final int MEDIA_STAT_BYTES_SENT = 9;
+
+	/**
+	 * Index of the number of decoded bytes handed to the handler, as PCM and
+	 * YV12
+	 */
+	public static final int MEDIA_STAT_BYTES_RECEIVED = 10;
+
+	/**
+	 * Index of the mean time to encode a video frame, in microseconds
+	 */
+	public static final int MEDIA_STAT_VIDEO_PREPARE_MEAN_US = 11;
+
+	/**
+	 * Index of the 99th percentile time to encode a video frame, in microseconds
+	 */
+	public static final int MEDIA_STAT_VIDEO_PREPARE_P99_US = 12;
+
+	/**
+	 * Index of the mean time to encode an audio frame, in microseconds
+	 */
+	public static final int MEDIA_STAT_AUDIO_PREPARE_MEAN_US = 13;
+
+	/**
+	 * Index of the 99th percentile time to encode an audio frame, in microseconds
+	 */
+	public static final int MEDIA_STAT_AUDIO_PREPARE_P99_US = 14;
+
+	/**
+	 * Index of the number of video frames that failed to encode or send
+	 */
+	public static final int MEDIA_STAT_VIDEO_FRAMES_DROPPED = 15;
+
+	/**
+	 * Index of the number of audio frames that failed to encode or send
+	 */
+	public static final int MEDIA_STAT_AUDIO_FRAMES_DROPPED = 16;
+
+	/**
+	 * Index of the mean time from toxav handing over a received frame to
+	 * the handler returning, in microseconds
+	 */
+	public static final int MEDIA_STAT_CALLBACK_LAG_MEAN_US = 17;
+
+	/**
+	 * Index of the 99th percentile of the callback lag, in microseconds
+	 */
+	public static final int MEDIA_STAT_CALLBACK_LAG_P99_US = 18;
+
+	/**
+	 * Index of the longest callback lag, in microseconds
+	 */
+	public static final int MEDIA_STAT_CALLBACK_LAG_MAX_US = 19;
+
+	/**
+	 * Maximum time {@link #bootstrap(List)} waits for host names to resolve,
+	 * in milliseconds
+	 */
+	public static final int BOOTSTRAP_RESOLVE_TIMEOUT = 5000;
+
+	/**
+	 * Maximum number of host names {@link #bootstrap(List)} resolves at once
+	 */
+	private static final int BOOTSTRAP_RESOLVE_THREADS = 8;
+
+	/**
+	 * Looking up a charset by name is not free, so it is done once
+	 */
+	private static final Charset UTF8 = Charset.forName("UTF-8");
+
+	/**
+	 * User statuses by their native value, which matches the ordinal
+	 */
+	private static final ToxUserStatus[] USER_STATUSES = ToxUserStatus.values();
+
+	private static final char[] HEX_DIGITS = "0123456789ABCDEF".toCharArray();
+
+	/**
+	 * Lookup table for hex decoding, -1 marks characters that are not
+	 * hexadecimal digits
+	 */
+	private static final byte[] HEX_VALUES = new byte[128];
+
+	static {
+		Arrays.fill(HEX_VALUES, (byte) -1);
+
+		for (int i = 0; i < 10; i++) {
+			HEX_VALUES['0' + i] = (byte) i;
+		}
+
+		for (int i = 0; i < 6; i++) {
+			HEX_VALUES['A' + i] = (byte) (10 + i);
+			HEX_VALUES['a' + i] = (byte) (10 + i);
+		}
+	}
+
 	static {
 		System.loadLibrary("jtoxcore");
 	}
@@ -63,10 +395,32 @@ public class JTox<F extends ToxFriend> {
 	private static Map < Integer, JTox<? >> instances = new HashMap < Integer, JTox<? >> ();
 	private static ReentrantLock instanceLock = new ReentrantLock();
 	private static int instanceCounter = 0;
+
+	/**
+	 * Probe names never change while the library is loaded, so they are
+	 * fetched once
+	 */
+	private static volatile String[] statsNames;
+
+	/**
+	 * Mirrors the native tracing switch, so lock waits are only traced while
+	 * tracing is on
+	 */
+	private static volatile boolean tracing;
 	private final int instanceNumber;
 
 	private CallbackHandler<F> handler;
 	private FriendList<F> friendList;
+	private final ToxMessageQueue messageQueue;
+
+	/**
+	 * Bootstrap bookkeeping, guarded by {@link #lock}. bootstrapStarted is the
+	 * {@link System#nanoTime()} of the first bootstrap call, or -1.
+	 */
+	private ToxNodeCache nodeCache;
+	private final Set<ToxNode> bootstrapNodes = new LinkedHashSet<ToxNode>();
+	private long bootstrapStarted = -1;
+	private long timeToConnected = -1;
 
 	/**
 	 * This field contains the lock used for thread safety
@@ -79,6 +433,15 @@ public class JTox<F extends ToxFriend> {
 	private final long messengerPointer;
 
 	private final long avPointer;
+
+	/**
+	 * Online bitset and user statuses of all friends, kept up to date by the
+	 * native callbacks. For a capacity of n friends, the first n / 8 bytes
+	 * hold one bit per friend, read as little-endian longs, and the next n
+	 * bytes the user statuses. The native side replaces the buffer when it
+	 * grows, so it is only read with the lock held and never handed out.
+	 */
+	private ByteBuffer presenceBuffer;
 	/**
 	 * Native call to tox_new
 	 *
@@ -93,16 +456,22 @@ public class JTox<F extends ToxFriend> {
 	 * @param friendList
 	 *            the friendlist to use with this instance
 	 * @param handler
-	 *            the callback handler for this instance
+	 *            the callback handler for this instance, not used by any
+	 *            other live instance
 	 * @throws ToxException
 	 *             when the native call indicates an error
+	 * @throws IllegalArgumentException
+	 *             if handler is already used by another instance
 	 */
 	public JTox(FriendList<F> friendList, CallbackHandler<F> handler, ToxOptions toxOptions) throws ToxException {
+		handler.attach();
 		this.friendList = friendList;
 		this.handler = handler;
+		this.messageQueue = new ToxMessageQueue();
 		long pointer = tox_new(toxOptions);
 
 		if (pointer == 0) {
+			handler.detach();
 			throw new ToxException(ToxError.TOX_UNKNOWN);
 		}
 
@@ -110,6 +479,8 @@ public class JTox<F extends ToxFriend> {
 		long avPointer = toxav_new(this.messengerPointer, 16);
 
 		if (avPointer == 0) {
+			tox_kill(pointer);
+			handler.detach();
 			throw new ToxException(ToxError.TOX_UNKNOWN);
 		}
 
@@ -146,6 +517,26 @@ public class JTox<F extends ToxFriend> {
 		this.load(data);
 	}
 
+	/**
+	 * Creates a new instance of JTox and stores the pointer to the internal
+	 * struct in messengerPointer. Also attempts to load the specified profile
+	 * into this instance, without reading it into the Java heap first.
+	 *
+	 * @param profile
+	 *            the file to load the data for the new tox instance from
+	 * @param friendList
+	 *            friend list to use with this tox instance
+	 * @param handler
+	 *            callback handler to use with this instance
+	 * @throws ToxException
+	 *             when the native call indicates an error
+	 * @see #load(File)
+	 */
+	public JTox(File profile, FriendList<F> friendList, CallbackHandler<F> handler, ToxOptions toxOptions) throws ToxException {
+		this(friendList, handler, toxOptions);
+		this.load(profile);
+	}
+
 	/**
 	 * Native call to tox_get_address
 	 *
@@ -167,7 +558,7 @@ public class JTox<F extends ToxFriend> {
 	public String getAddress() throws ToxException {
 		String address;
 
-		this.lock.lock();
+		acquireLock();
 
 		try {
 			checkPointer();
@@ -183,6 +574,34 @@ public class JTox<F extends ToxFriend> {
 		return address;
 	}
 
+	/**
+	 * Native call to tox_get_address
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct.
+	 *
+	 * @return the client's binary address
+	 */
+	private native byte[] tox_get_address_bytes(long messengerPointer);
+
+	/**
+	 * Get our own address in binary form, without encoding it as hex
+	 *
+	 * @return our client's address, {@link #TOX_FRIEND_ADDRESS_SIZE} bytes
+	 * @throws ToxException
+	 *             when the instance has been killed
+	 */
+	public byte[] getAddressBytes() throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+			return tox_get_address_bytes(this.messengerPointer);
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
 	/**
 	 * Native call to tox_get_self_user_status
 	 *
@@ -201,7 +620,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public ToxUserStatus getSelfUserStatus() throws ToxException {
-		this.lock.lock();
+		acquireLock();
 
 		try {
 			checkPointer();
@@ -243,7 +662,7 @@ public class JTox<F extends ToxFriend> {
 
 		boolean error;
 
-		this.lock.lock();
+		acquireLock();
 
 		try {
 			checkPointer();
@@ -275,7 +694,7 @@ public class JTox<F extends ToxFriend> {
 	 *             if the instance has been killed
 	 */
 	public String getSelfName() throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		String name;
 
 		try {
@@ -326,7 +745,7 @@ public class JTox<F extends ToxFriend> {
 
 		boolean error;
 
-		this.lock.lock();
+		acquireLock();
 
 		try {
 			checkPointer();
@@ -368,7 +787,7 @@ public class JTox<F extends ToxFriend> {
 
 		boolean error;
 
-		this.lock.lock();
+		acquireLock();
 
 		try {
 			checkPointer();
@@ -417,7 +836,9 @@ public class JTox<F extends ToxFriend> {
 		byte[] dataArray = getStringBytes(data);
 		byte[] addressArray = hexToByteArray(address);
 		int errcode;
-		this.lock.lock();
+
+		checkKeyLength(addressArray, TOX_FRIEND_ADDRESS_SIZE, TOX_FRIEND_ADDRESS_SIZE, "Address");
+		acquireLock();
 
 		try {
 			checkPointer();
@@ -430,34 +851,71 @@ public class JTox<F extends ToxFriend> {
 	}
 
 	/**
-	 * Native call to tox_add_friend_norequest
-	 *
-	 * @param messengerPointer
-	 *            pointer to the internal messenger struct
-	 * @param address
-	 *            the address of the client you want to add
-	 * @return the local number of the friend in your list
-	 */
-	private native int tox_add_friend_norequest(long messengerPointer, byte[] address);
-
-	/**
-	 * Confirm a friend request, or add a friend to your own list without
-	 * sending them a friend request. If successful, the Friend is added to the
-	 * list, and a reference to the friend is returned.
+	 * Add a friend by binary address. Behaves like
+	 * {@link #addFriend(String, String)}, but skips the hex decoding.
 	 *
 	 * @param address
-	 *            address of the friend to add
+	 *            the address of the friend, {@link #TOX_FRIEND_ADDRESS_SIZE}
+	 *            bytes
+	 * @param data
+	 *            an optional message you want to send to your friend
 	 * @return the friend
 	 * @throws ToxException
-	 *             if the instance was killed or an error occurred when adding
-	 *             the friend
+	 *             if the instance has been killed or an error code is returned
+	 *             by the native tox_addfriend call
 	 * @throws FriendExistsException
 	 *             if the friend already exists
+	 * @throws IllegalArgumentException
+	 *             if address is not {@link #TOX_FRIEND_ADDRESS_SIZE} bytes
 	 */
-	public F confirmRequest(String address) throws ToxException, FriendExistsException {
-		byte[] addressArray = hexToByteArray(address);
+	public F addFriend(byte[] address, String data) throws ToxException, FriendExistsException {
+		byte[] dataArray = getStringBytes(data);
+		int errcode;
+
+		checkKeyLength(address, TOX_FRIEND_ADDRESS_SIZE, TOX_FRIEND_ADDRESS_SIZE, "Address");
+		acquireLock();
+
+		try {
+			checkPointer();
+			errcode = tox_add_friend(this.messengerPointer, address, dataArray, dataArray.length);
+		} finally {
+			this.lock.unlock();
+		}
+
+		return getFriendOrFail(address, errcode);
+	}
+
+	/**
+	 * Native call to tox_add_friend_norequest
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @param address
+	 *            the address of the client you want to add
+	 * @return the local number of the friend in your list
+	 */
+	private native int tox_add_friend_norequest(long messengerPointer, byte[] address);
+
+	/**
+	 * Confirm a friend request, or add a friend to your own list without
+	 * sending them a friend request. If successful, the Friend is added to the
+	 * list, and a reference to the friend is returned.
+	 *
+	 * @param address
+	 *            address of the friend to add
+	 * @return the friend
+	 * @throws ToxException
+	 *             if the instance was killed or an error occurred when adding
+	 *             the friend
+	 * @throws FriendExistsException
+	 *             if the friend already exists
+	 */
+	public F confirmRequest(String address) throws ToxException, FriendExistsException {
+		byte[] addressArray = hexToByteArray(address);
 		int errcode;
-		this.lock.lock();
+
+		checkKeyLength(addressArray, TOX_CLIENT_ID_SIZE, TOX_FRIEND_ADDRESS_SIZE, "Client id");
+		acquireLock();
 
 		try {
 			checkPointer();
@@ -470,6 +928,58 @@ public class JTox<F extends ToxFriend> {
 		return getFriendOrFail(address, errcode);
 	}
 
+	/**
+	 * Confirm a friend request by binary client id, as delivered to
+	 * {@link im.tox.jtoxcore.callbacks.OnRawFriendRequestCallback}.
+	 *
+	 * @param clientId
+	 *            client id of the friend to add
+	 * @return the friend
+	 * @throws ToxException
+	 *             if the instance was killed or an error occurred when adding
+	 *             the friend
+	 * @throws FriendExistsException
+	 *             if the friend already exists
+	 * @throws IllegalArgumentException
+	 *             if clientId is neither {@link #TOX_CLIENT_ID_SIZE} nor
+	 *             {@link #TOX_FRIEND_ADDRESS_SIZE} bytes
+	 */
+	public F confirmRequest(byte[] clientId) throws ToxException, FriendExistsException {
+		int errcode;
+
+		checkKeyLength(clientId, TOX_CLIENT_ID_SIZE, TOX_FRIEND_ADDRESS_SIZE, "Client id");
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			errcode = tox_add_friend_norequest(this.messengerPointer, clientId);
+		} finally {
+			this.lock.unlock();
+		}
+
+		return getFriendOrFail(clientId, errcode);
+	}
+
+	/**
+	 * Native code reads a fixed number of bytes from keys and addresses, so
+	 * shorter arrays must never reach it
+	 */
+	private static void checkKeyLength(byte[] key, int size, int alternativeSize, String what) {
+		if (key.length != size && key.length != alternativeSize) {
+			throw new IllegalArgumentException(what + " must be " + size
+					+ (size == alternativeSize ? "" : " or " + alternativeSize) + " bytes, got " + key.length);
+		}
+	}
+
+	private F getFriendOrFail(byte[] address, int errcode) throws FriendExistsException, ToxException {
+		if (errcode >= 0) {
+			return getFriendOrFail(byteArrayToHex(address), errcode);
+		}
+
+		throw new ToxException(errcode);
+	}
+
 	private F getFriendOrFail(String address, int errcode) throws FriendExistsException, ToxException {
 		if (errcode >= 0) {
 			F friend = this.friendList.addFriend(errcode);
@@ -480,6 +990,216 @@ public class JTox<F extends ToxFriend> {
 		throw new ToxException(errcode);
 	}
 
+	/**
+	 * Native call to set the friend request rate limits
+	 */
+	private native void tox_request_filter_limits(long messengerPointer, double keyRate, int keyBurst,
+			double globalRate, int globalBurst);
+
+	/**
+	 * Native call to set the longest friend request message that is passed on
+	 */
+	private native void tox_request_filter_max_length(long messengerPointer, int length);
+
+	/**
+	 * Native call to put a key on the block or allow list, or take it off
+	 *
+	 * @param mode
+	 *            0 to unlist, 1 to block, 2 to allow
+	 * @return 0 on success, -1 on failure
+	 */
+	private native int tox_request_filter_list(long messengerPointer, byte[] clientId, int mode);
+
+	/**
+	 * Native call to empty the block and allow lists
+	 */
+	private native void tox_request_filter_clear(long messengerPointer);
+
+	/**
+	 * Native call to switch allow-only mode
+	 */
+	private native void tox_request_filter_allow_only(long messengerPointer, boolean allowOnly);
+
+	/**
+	 * Native call to read the friend request filter counters
+	 *
+	 * @return the counters, indexed by the REQUEST_STAT_ constants
+	 */
+	private native long[] tox_request_filter_stats(long messengerPointer);
+
+	/**
+	 * Rate limit incoming friend requests. Each key gets a token bucket that
+	 * holds up to perKeyBurst requests and refills at perKeyRate per second;
+	 * all requests then share a second bucket with the global limits. Requests
+	 * over either limit are dropped natively and never reach the callback. A
+	 * rate or burst of 0 turns the respective limit off, which is the default.
+	 *
+	 * @param perKeyRate
+	 *            requests per second allowed from a single key
+	 * @param perKeyBurst
+	 *            requests a single key can send at once
+	 * @param globalRate
+	 *            requests per second allowed in total
+	 * @param globalBurst
+	 *            requests that can arrive at once in total
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 * @throws IllegalArgumentException
+	 *             if a rate or burst is negative, or a rate is NaN
+	 */
+	public void setFriendRequestLimits(double perKeyRate, int perKeyBurst, double globalRate, int globalBurst)
+			throws ToxException {
+		if (!(perKeyRate >= 0) || perKeyBurst < 0 || !(globalRate >= 0) || globalBurst < 0) {
+			throw new IllegalArgumentException("Friend request limits must not be negative");
+		}
+
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			tox_request_filter_limits(this.messengerPointer, perKeyRate, perKeyBurst, globalRate, globalBurst);
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * Drop friend requests whose message is longer than the given length, in
+	 * bytes. 0, the default, accepts any length.
+	 *
+	 * @param length
+	 *            the longest message passed on
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 */
+	public void setFriendRequestMaxLength(int length) throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			tox_request_filter_max_length(this.messengerPointer, length);
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * Drop all friend requests from the given key
+	 *
+	 * @param clientId
+	 *            the key, {@link #TOX_CLIENT_ID_SIZE} bytes
+	 * @throws ToxException
+	 *             if the instance has been killed or the key could not be
+	 *             listed
+	 */
+	public void blockFriendRequests(byte[] clientId) throws ToxException {
+		listFriendRequestKey(clientId, 1);
+	}
+
+	/**
+	 * Always pass on friend requests from the given key, regardless of rate
+	 * limits, message length and allow-only mode
+	 *
+	 * @param clientId
+	 *            the key, {@link #TOX_CLIENT_ID_SIZE} bytes
+	 * @throws ToxException
+	 *             if the instance has been killed or the key could not be
+	 *             listed
+	 */
+	public void allowFriendRequests(byte[] clientId) throws ToxException {
+		listFriendRequestKey(clientId, 2);
+	}
+
+	/**
+	 * Take a key off the block or allow list
+	 *
+	 * @param clientId
+	 *            the key, {@link #TOX_CLIENT_ID_SIZE} bytes
+	 * @throws ToxException
+	 *             if the instance has been killed or the key has the wrong
+	 *             size
+	 */
+	public void unlistFriendRequestKey(byte[] clientId) throws ToxException {
+		listFriendRequestKey(clientId, 0);
+	}
+
+	private void listFriendRequestKey(byte[] clientId, int mode) throws ToxException {
+		int result;
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			result = tox_request_filter_list(this.messengerPointer, clientId, mode);
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (result == -1) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+	}
+
+	/**
+	 * Empty the block and allow lists
+	 *
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 */
+	public void clearFriendRequestLists() throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			tox_request_filter_clear(this.messengerPointer);
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * Only pass on friend requests from keys on the allow list
+	 *
+	 * @param allowOnly
+	 *            true to drop requests from every other key
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 */
+	public void setFriendRequestAllowlistOnly(boolean allowOnly) throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			tox_request_filter_allow_only(this.messengerPointer, allowOnly);
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * Get the counters of the friend request filter since the instance was
+	 * created
+	 *
+	 * @return the counters, indexed by the REQUEST_STAT_ constants
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 */
+	public long[] getFriendRequestFilterStats() throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			return tox_request_filter_stats(this.messengerPointer);
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
 	/**
 	 * Native call to tox_del_friend
 	 *
@@ -501,507 +1221,1738 @@ public class JTox<F extends ToxFriend> {
 	 */
 	public void deleteFriend(int friendnumber) throws ToxException {
 		boolean error;
-		this.lock.lock();
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			error = tox_del_friend(this.messengerPointer, friendnumber);
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (error) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+
+		this.messageQueue.clear(friendnumber);
+		this.friendList.removeFriend(friendnumber);
+	}
+
+	/**
+	 * Native call to tox_send_message
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @param friendnumber
+	 *            the number of the friend
+	 * @param message
+	 *            the message
+	 * @param length
+	 *            length of the message in bytes
+	 * @return the message ID on success, 0 on failure
+	 */
+	private native int tox_send_message(long messengerPointer, int friendnumber, byte[] message, int length);
+
+	/**
+	 * Sends a message to the specified friend. Add the message ID of the sent
+	 * message to the list of sent messages of the receiving friend.
+	 *
+	 * @param friend
+	 *            the friend
+	 * @param message
+	 *            the message
+	 * @return the message ID of the sent message. This is stored in the Friend's list of sent
+     *            messages. This value is also passed to the read receipt callback if the message
+     *            was received and should be compared to your list of stored values.
+	 * @throws ToxException
+	 *             if the instance has been killed or the message was not sent
+	 */
+	public int sendMessage(F friend, String message) throws ToxException {
+		byte[] messageArray = getStringBytes(message);
+		int result;
+
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			result = tox_send_message(this.messengerPointer, friend.getFriendnumber(), messageArray,
+									  messageArray.length);
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (result == 0) {
+			throw new ToxException(ToxError.TOX_SEND_FAILED);
+		}
+
+		return result;
+	}
+
+	/**
+	 * Queue a message for the given friend. It is sent from within
+	 * {@link #doTox()} and retried there until core accepts it. Messages
+	 * longer than {@link #TOX_MAX_MESSAGE_LENGTH} are split.
+	 *
+	 * @param friend
+	 *            the friend
+	 * @param message
+	 *            the message
+	 * @return the queue's ID for the message, 0 if it was dropped
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 * @throws InterruptedException
+	 *             if interrupted while waiting for space in the queue
+	 * @see #queueMessage(int, byte[])
+	 */
+	public int queueMessage(F friend, String message) throws ToxException, InterruptedException {
+		return queueMessage(friend.getFriendnumber(), getStringBytes(message));
+	}
+
+	/**
+	 * Queue a message for the given friend. It is sent from within
+	 * {@link #doTox()} and retried there until core accepts it, in the order
+	 * it was queued. When the friend's queue is full, the policy of
+	 * {@link #getMessageQueue()} applies. A blocking policy never blocks when
+	 * called from a callback, since that would stall the very loop draining
+	 * the queue; the message is dropped instead. If the friend is deleted
+	 * before the message is sent, it is dropped and reported to the queue's
+	 * failed callback.
+	 *
+	 * @param friendnumber
+	 *            the friend's number
+	 * @param message
+	 *            the UTF-8 encoded message
+	 * @return the queue's ID for the message, 0 if it was dropped. The
+	 *         queue's sent callback maps it to the message ID of the read
+	 *         receipt.
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 * @throws InterruptedException
+	 *             if interrupted while waiting for space in the queue
+	 */
+	public int queueMessage(int friendnumber, byte[] message) throws ToxException, InterruptedException {
+		checkPointer();
+
+		return this.messageQueue.offer(friendnumber, message, !this.lock.isHeldByCurrentThread());
+	}
+
+	/**
+	 * Get the outgoing message queue, to configure it or read its metrics
+	 *
+	 * @return the outgoing message queue of this instance
+	 */
+	public ToxMessageQueue getMessageQueue() {
+		return this.messageQueue;
+	}
+
+	/**
+	 * Sends queued chunks. Only used from within doTox, with the lock held.
+	 */
+	private final ToxMessageQueue.Sender queueSender = new ToxMessageQueue.Sender() {
+
+		@Override
+		public int send(int friendnumber, byte[] chunk) {
+			return tox_send_message(JTox.this.messengerPointer, friendnumber, chunk, chunk.length);
+		}
+
+		@Override
+		public boolean friendExists(int friendnumber) {
+			return tox_get_friend_exists(JTox.this.messengerPointer, friendnumber);
+		}
+	};
+
+	/**
+	 * Native call to tox_send_message for a batch of friends and messages
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @param friends
+	 *            the numbers of the friends
+	 * @param messages
+	 *            the messages, one per friend
+	 * @return the message ID for each friend, 0 where sending failed
+	 */
+	private native int[] tox_send_messages(long messengerPointer, int[] friends, byte[][] messages);
+
+	/**
+	 * Native call to tox_send_message for the same message to many friends
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @param friends
+	 *            the numbers of the friends
+	 * @param message
+	 *            the message
+	 * @return the message ID for each friend, 0 where sending failed
+	 */
+	private native int[] tox_broadcast(long messengerPointer, int[] friends, byte[] message);
+
+	/**
+	 * Sends a batch of messages with a single native call. The message at
+	 * index i is sent to the friend at index i. Unlike
+	 * {@link #sendMessage(ToxFriend, String)}, a failure for one friend does
+	 * not throw; check the returned IDs instead.
+	 *
+	 * @param friends
+	 *            the friend numbers
+	 * @param messages
+	 *            the UTF-8 encoded messages, one per friend
+	 * @return the message ID for each friend, or 0 if sending to that friend
+	 *         failed
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 * @throws IllegalArgumentException
+	 *             if friends and messages differ in length
+	 */
+	public int[] sendMessages(int[] friends, byte[][] messages) throws ToxException {
+		if (friends.length != messages.length) {
+			throw new IllegalArgumentException("Got " + friends.length + " friends but " + messages.length
+					+ " messages");
+		}
+
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			return tox_send_messages(this.messengerPointer, friends, messages);
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * Sends the same message to all given friends with a single native call.
+	 * The message is pinned once and handed to core for every recipient. A
+	 * failure for one friend does not throw; check the returned IDs instead.
+	 *
+	 * @param friends
+	 *            the friend numbers
+	 * @param message
+	 *            the UTF-8 encoded message
+	 * @return the message ID for each friend, or 0 if sending to that friend
+	 *         failed
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 */
+	public int[] broadcast(int[] friends, byte[] message) throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			return tox_broadcast(this.messengerPointer, friends, message);
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * Native call to tox_send_action
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @param friendnumber
+	 *            the number of the friend
+	 * @param action
+	 *            the action to send
+	 * @param length
+	 *            length of the action in bytes
+	 * @return false on success, true on failure
+	 */
+	private native boolean tox_send_action(long messengerPointer, int friendnumber, byte[] action, int length);
+
+	/**
+	 * Sends an IRC-like /me-action to a friend
+	 *
+	 * @param friend
+	 *            the friend
+	 * @param action
+	 *            the action
+	 * @throws ToxException
+	 *             if the instance has been killed or the send failed
+	 */
+	public void sendAction(F friend, String action) throws ToxException {
+		byte[] actionArray = getStringBytes(action);
+		boolean error;
+
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			error = tox_send_action(this.messengerPointer, friend.getFriendnumber(), actionArray, actionArray.length);
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (error) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+	}
+
+	/**
+	 * Native call to tox_set_user_is_typing
+	 * @param messengerPointer pointer to the internal messenger struct
+	 * @param friendnumber the friend's number
+	 * @param typing <code>true</code> indicates we are typing, <code>false</code> indicates we stopped typing
+	 * @return false on success, true on failure
+	 */
+	private native boolean tox_set_user_is_typing(long messengerPointer, int friendnumber, boolean typing);
+
+	/**
+	 * Indicate to the specified friend that we are currently typing
+	 * @param friendnumber the friend's number
+	 * @param typing <code>true</code> indicates we are typing, <code>false</code> indicates we stopped typing
+	 * @throws ToxException if the instance has been killed
+	 */
+	public void sendIsTyping(int friendnumber, boolean typing) throws ToxException {
+		boolean error;
+
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			error = tox_set_user_is_typing(this.messengerPointer, friendnumber, typing);
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (error) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+	}
+
+	/**
+	 * Native call to tox_do
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 */
+	private native void tox_do(long messengerPointer);
+
+	/**
+	 * The main tox loop that needs to be run at least 20 times per second. When
+	 * implementing this, either use it in a main loop to guarantee execution,
+	 * or start an asynchronous Thread or Service to do it for you. Messages
+	 * waiting in the outgoing message queue are sent at the end of each call.
+	 *
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 */
+	public void doTox() throws ToxException {
+		ToxNodeCache cache = null;
+		List<ToxNode> connectedVia = null;
+
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			tox_do(this.messengerPointer);
+			this.messageQueue.drain(this.queueSender);
+
+			if (this.bootstrapStarted != -1 && this.timeToConnected == -1 && tox_isconnected(this.messengerPointer) != 0) {
+				this.timeToConnected = TimeUnit.NANOSECONDS.toMillis(System.nanoTime() - this.bootstrapStarted);
+				cache = this.nodeCache;
+				connectedVia = new ArrayList<ToxNode>(this.bootstrapNodes);
+			}
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (cache != null && !connectedVia.isEmpty()) {
+			cache.recordConnected(connectedVia, this.timeToConnected);
+
+			try {
+				cache.save();
+			} catch (IOException e) {
+				// The cache only speeds up the next start, losing an update is harmless
+			}
+		}
+	}
+
+	private native int tox_do_interval(long messengerPointer);
+
+	/**
+	 * Return the time in milliseconds before doTox() should be called again
+	 * for optimal performance.
+	 * @return time in ms, -1 on failure
+	 * @throws ToxException
+	 */
+	public int doToxInterval() throws ToxException {
+		acquireLock();
+		int result = -1;
+
+		try {
+			checkPointer();
+
+			result = tox_do_interval(this.messengerPointer);
+		} finally {
+			this.lock.unlock();
+		}
+
+		return result;
+	}
+
+	/**
+	 * Native call to switch presence coalescing
+	 */
+	private native void tox_presence_coalesce(long messengerPointer, boolean enabled);
+
+	/**
+	 * Native call to read the presence coalescing counters
+	 *
+	 * @return the counters, indexed by the PRESENCE_STAT_ constants
+	 */
+	private native long[] tox_presence_stats(long messengerPointer);
+
+	/**
+	 * Hold back name, status message, user status, typing and connection
+	 * events until the end of each {@link #doTox()}, and only deliver the last
+	 * one of each kind per friend. Connection, user status and typing events
+	 * whose final value is the one delivered last are dropped. This saves a lot
+	 * of callbacks after a reconnect, when core reports every friend's state
+	 * again. Off by default; switching it off delivers whatever is still held
+	 * back.
+	 *
+	 * @param enabled
+	 *            true to coalesce presence events
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 */
+	public void setPresenceCoalescing(boolean enabled) throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			tox_presence_coalesce(this.messengerPointer, enabled);
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * Get the presence coalescing counters since the instance was created.
+	 * Events are only counted while coalescing is on.
+	 *
+	 * @return the counters, indexed by the PRESENCE_STAT_ constants
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 */
+	public long[] getPresenceCoalescingStats() throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			return tox_presence_stats(this.messengerPointer);
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * Native call to tox_bootstrap_from_address
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @param ip
+	 *            UTF-8 encoded ip address or host name to bootstrap with
+	 * @param port
+	 *            port to bootstrap with
+	 * @param pubkey
+	 *            public key of the bootstrap node
+	 */
+	private native int tox_bootstrap_from_address(long messengerPointer, byte[] ip, int port, byte[] pubkey);
+
+	/**
+	 * Method used to bootstrap the client's connection.
+	 *
+	 * @param host
+	 *            Hostname or IP(v4, v6) address to connect to. If the hostname
+	 *            contains non-ASCII characters, convert it to punycode when
+	 *            calling this method.
+	 * @param port
+	 *            port to connect to
+	 * @param pubkey
+	 *            public key of the bootstrap node
+	 * @throws ToxException
+	 *             if the instance has been killed or an invalid port was
+	 *             specified
+	 * @throws UnknownHostException
+	 *             if the host could not be resolved or the IP address was
+	 *             invalid
+	 */
+	public void bootstrap(String host, int port, String pubkey) throws ToxException, UnknownHostException {
+		bootstrap(host, port, hexToByteArray(pubkey));
+	}
+
+	/**
+	 * Method used to bootstrap the client's connection with a binary public
+	 * key.
+	 *
+	 * @param host
+	 *            Hostname or IP(v4, v6) address to connect to
+	 * @param port
+	 *            port to connect to
+	 * @param pubkeyArray
+	 *            public key of the bootstrap node, {@link #TOX_CLIENT_ID_SIZE}
+	 *            bytes
+	 * @throws ToxException
+	 *             if the instance has been killed or an invalid port was
+	 *             specified
+	 * @throws UnknownHostException
+	 *             if the host could not be resolved or the IP address was
+	 *             invalid
+	 * @throws IllegalArgumentException
+	 *             if pubkeyArray is not {@link #TOX_CLIENT_ID_SIZE} bytes
+	 */
+	public void bootstrap(String host, int port, byte[] pubkeyArray) throws ToxException, UnknownHostException {
+		boolean error;
+
+		checkKeyLength(pubkeyArray, TOX_CLIENT_ID_SIZE, TOX_CLIENT_ID_SIZE, "Public key");
+
+		if (port < 0 || port > 65535) {
+			throw new ToxException(ToxError.TOX_INVALID_PORT);
+		}
+
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			error = tox_bootstrap_from_address(this.messengerPointer, getStringBytes(host), port, pubkeyArray) == 0;
+
+			if (!error && this.bootstrapStarted == -1) {
+				this.bootstrapStarted = System.nanoTime();
+			}
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (error) {
+			throw new UnknownHostException(host);
+		}
+	}
+
+	/**
+	 * Native call to tox_isconnected
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 */
+	private native int tox_isconnected(long messengerPointer);
+
+	/**
+	 * Check if the client is connected to the DHT
+	 *
+	 * @return true if connected, false otherwise
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 */
+	public boolean isConnected() throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			return tox_isconnected(this.messengerPointer) != 0;
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * Native call to bootstrap from several nodes at once
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @param ips
+	 *            UTF-8 encoded addresses of the nodes
+	 * @param ports
+	 *            ports of the nodes
+	 * @param pubkeys
+	 *            public keys of the nodes
+	 * @return for every node, 0 on failure and non-zero on success
+	 */
+	private native int[] tox_bootstrap_nodes(long messengerPointer, byte[][] ips, int[] ports, byte[][] pubkeys);
+
+	/**
+	 * Bootstrap from several nodes in one call. Host names are resolved in
+	 * parallel, waiting at most {@link #BOOTSTRAP_RESOLVE_TIMEOUT}
+	 * milliseconds, and all nodes that resolved are handed to the core
+	 * together. If a {@link ToxNodeCache} is set, its best ranked nodes come
+	 * first, and nodes that could not be resolved are recorded as failures.
+	 *
+	 * @param nodes
+	 *            the nodes to bootstrap from
+	 * @return the number of nodes the core accepted
+	 * @throws ToxException
+	 *             if the instance has been killed or no node could be used
+	 */
+	public int bootstrap(List<ToxNode> nodes) throws ToxException {
+		ToxNodeCache cache;
+
+		acquireLock();
+
+		try {
+			cache = this.nodeCache;
+		} finally {
+			this.lock.unlock();
+		}
+
+		final List<ToxNode> ranked = cache == null ? new ArrayList<ToxNode>(nodes) : cache.rank(nodes);
+		List<Future<String>> lookups = new ArrayList<Future<String>>(ranked.size());
+		ExecutorService resolver = Executors.newFixedThreadPool(Math.max(1,
+				Math.min(ranked.size(), BOOTSTRAP_RESOLVE_THREADS)));
+		long deadline = System.nanoTime() + TimeUnit.MILLISECONDS.toNanos(BOOTSTRAP_RESOLVE_TIMEOUT);
+
+		for (final ToxNode node : ranked) {
+			lookups.add(resolver.submit(new Callable<String>() {
+				@Override
+				public String call() throws UnknownHostException {
+					return InetAddress.getByName(node.getHost()).getHostAddress();
+				}
+			}));
+		}
+
+		resolver.shutdown();
+
+		List<ToxNode> resolved = new ArrayList<ToxNode>(ranked.size());
+		List<byte[]> ips = new ArrayList<byte[]>(ranked.size());
+
+		for (int i = 0; i < ranked.size(); i++) {
+			try {
+				ips.add(getStringBytes(lookups.get(i).get(Math.max(0, deadline - System.nanoTime()),
+						TimeUnit.NANOSECONDS)));
+				resolved.add(ranked.get(i));
+			} catch (ExecutionException e) {
+				if (cache != null) {
+					cache.recordFailure(ranked.get(i));
+				}
+			} catch (TimeoutException e) {
+				lookups.get(i).cancel(true);
+
+				if (cache != null) {
+					cache.recordFailure(ranked.get(i));
+				}
+			} catch (InterruptedException e) {
+				resolver.shutdownNow();
+				Thread.currentThread().interrupt();
+				break;
+			}
+		}
+
+		int[] ports = new int[resolved.size()];
+		byte[][] pubkeys = new byte[resolved.size()][];
+
+		for (int i = 0; i < ports.length; i++) {
+			ports[i] = resolved.get(i).getPort();
+			pubkeys[i] = resolved.get(i).publicKey();
+		}
+
+		int accepted = 0;
+
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			int[] result = tox_bootstrap_nodes(this.messengerPointer, ips.toArray(new byte[ips.size()][]), ports,
+					pubkeys);
+
+			for (int i = 0; i < result.length; i++) {
+				if (result[i] != 0) {
+					this.bootstrapNodes.add(resolved.get(i));
+					accepted++;
+				}
+			}
+
+			if (accepted > 0 && this.bootstrapStarted == -1) {
+				this.bootstrapStarted = System.nanoTime();
+			}
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (accepted == 0) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+
+		return accepted;
+	}
+
+	/**
+	 * Set the cache used to rank bootstrap nodes. Once connected, the time it
+	 * took is recorded in the cache, which is then saved.
+	 *
+	 * @param cache
+	 *            the cache to use, or null to stop using one
+	 */
+	public void setNodeCache(ToxNodeCache cache) {
+		acquireLock();
+
+		try {
+			this.nodeCache = cache;
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * @return the cache used to rank bootstrap nodes, or null
+	 */
+	public ToxNodeCache getNodeCache() {
+		acquireLock();
+
+		try {
+			return this.nodeCache;
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * Get the time it took from the first bootstrap call to being connected
+	 * to the DHT. The connection is checked on every {@link #doTox()}.
+	 *
+	 * @return the time in milliseconds, or -1 if not connected yet
+	 */
+	public long getTimeToConnected() {
+		acquireLock();
+
+		try {
+			return this.timeToConnected;
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * Native call to export the startup timeline
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @return four values per event: milestone ordinal, friend number, start
+	 *         and end in microseconds
+	 */
+	private native long[] tox_get_startup_timeline(long messengerPointer);
+
+	/**
+	 * Get the milestones this instance went through since the native library
+	 * was loaded: library initialization, creating the messenger, loading
+	 * saved data, creating the A/V session, the first accepted bootstrap,
+	 * the first DHT connection and each friend's first time online. The
+	 * timestamps come from a monotonic clock, so they can be compared to
+	 * each other but not to wall clock time.
+	 *
+	 * @return a snapshot of the timeline
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 */
+	public ToxStartupTimeline getStartupTimeline() throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			return new ToxStartupTimeline(tox_get_startup_timeline(this.messengerPointer));
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * Native call to get the names of all statistics probes
+	 *
+	 * @return the names, in probe order
+	 */
+	private static native String[] tox_get_stats_names();
+
+	/**
+	 * Native call to merge the statistics of all threads
+	 *
+	 * @return {@link ToxCallStats#FIELDS} values per probe, in probe order
+	 */
+	private static native long[] tox_get_stats();
+
+	/**
+	 * Get call counts, byte counts and latency histograms for every native
+	 * entry point and every callback. Recording is always on: each call costs
+	 * two reads of the monotonic clock and a few increments in a counter
+	 * block private to the calling thread. Reading merges the blocks of all
+	 * threads.
+	 *
+	 * @return a snapshot of the statistics of all tox instances in this
+	 *         process
+	 */
+	public static ToxStats getStats() {
+		String[] names = statsNames;
+
+		if (names == null) {
+			names = tox_get_stats_names();
+			statsNames = names;
+		}
+
+		return new ToxStats(names, tox_get_stats());
+	}
+
+	/**
+	 * Native call to switch tracing on or off
+	 */
+	private static native void tox_trace_set_enabled(boolean enabled);
+
+	/**
+	 * Native call to record the begin or end of a wait for an instance lock
+	 */
+	private static native void tox_trace_lock(boolean begin);
+
+	/**
+	 * Native call to drop all trace events recorded so far
+	 */
+	private static native void tox_trace_clear();
+
+	/**
+	 * Native call to render the trace as Chrome trace JSON
+	 *
+	 * @return the JSON, or null if out of memory
+	 */
+	private static native String tox_trace_dump();
+
+	/**
+	 * Switch tracing on or off. While on, the native library records begin
+	 * and end events for every native entry point, including
+	 * {@link #doTox()} and the A/V frame calls, for every callback it
+	 * dispatches, and for every time a thread had to wait for the lock of a
+	 * JTox instance. Events go to a fixed size ring buffer per thread, so the
+	 * most recent events are kept. While off, the cost is a single check per
+	 * call.
+	 *
+	 * @param enabled
+	 *            whether to record trace events
+	 */
+	public static void setTracingEnabled(boolean enabled) {
+		tracing = enabled;
+		tox_trace_set_enabled(enabled);
+	}
+
+	/**
+	 * @return whether trace events are being recorded
+	 */
+	public static boolean isTracingEnabled() {
+		return tracing;
+	}
+
+	/**
+	 * Drop all trace events recorded so far
+	 */
+	public static void clearTrace() {
+		tox_trace_clear();
+	}
+
+	/**
+	 * Render the recorded trace events in the Chrome trace event format. The
+	 * result can be loaded into Perfetto or chrome://tracing. Timestamps are
+	 * in microseconds on the monotonic clock; thread ids are assigned by the
+	 * library and do not match operating system ids.
+	 *
+	 * @return the trace as JSON
+	 * @throws ToxException
+	 *             if the native library ran out of memory
+	 */
+	public static String dumpTrace() throws ToxException {
+		String json = tox_trace_dump();
+
+		if (json == null) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+
+		return json;
+	}
+
+	/**
+	 * Take the instance lock, recording the wait in the trace if the lock is
+	 * contended and tracing is on
+	 */
+	private void acquireLock() {
+		if (!tracing) {
+			this.lock.lock();
+			return;
+		}
+
+		if (this.lock.tryLock()) {
+			return;
+		}
+
+		tox_trace_lock(true);
+		this.lock.lock();
+		tox_trace_lock(false);
+	}
+
+	/**
+	 * Native call to tox_kill
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 */
+	private native void tox_kill(long messengerPointer);
+
+	/**
+	 * Kills the current instance, triggering a cleanup of all internal data
+	 * structures. All subsequent calls on any method in this class will result
+	 * in a {@link ToxException} with {@link ToxError#TOX_KILLED_INSTANCE} as an
+	 * error code.
+	 *
+	 * @throws ToxException
+	 *             in case the instance has already been killed
+	 */
+	public void killTox() throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			validPointers.remove(this.messengerPointer);
+			tox_kill(this.messengerPointer);
+
+			checkAvPointer();
+			validPointers.remove(this.avPointer);
+			toxav_kill(this.avPointer);
+		} finally {
+			this.lock.unlock();
+		}
+
+		this.messageQueue.close();
+		this.handler.detach();
+		instances.remove(this.instanceNumber);
+	}
+
+	/**
+	 * Native call to tox_save
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @return a byte array containing the saved data
+	 */
+	private native byte[] tox_save(long messengerPointer);
+
+	/**
+	 * Save the internal messenger data to a byte array, which can be saved to a
+	 * file or database
+	 *
+	 * @return a byte array containing the saved data
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 */
+	public byte[] save() throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			return tox_save(this.messengerPointer);
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * Native call to save the messenger state to a file
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @param path
+	 *            UTF-8 encoded path of the file to replace
+	 * @param onlyIfDirty
+	 *            whether to skip the save if nothing changed since the last
+	 *            one
+	 * @return 1 if the state was saved, 0 if it was skipped, -1 on failure
+	 */
+	private native int tox_save_to(long messengerPointer, byte[] path, boolean onlyIfDirty);
+
+	/**
+	 * Native call to check whether the state changed since the last save
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @return true if there are unsaved changes
+	 */
+	private native boolean tox_is_dirty(long messengerPointer);
+
+	/**
+	 * Save the internal messenger data directly to a file
+	 *
+	 * @param file
+	 *            the file to write the data to
+	 * @throws ToxException
+	 *             if the instance has been killed or the file could not be
+	 *             written
+	 * @see #saveTo(File, boolean)
+	 */
+	public void saveTo(File file) throws ToxException {
+		saveTo(file, false);
+	}
+
+	/**
+	 * Save the internal messenger data directly to a file. The data is
+	 * serialized natively into a temporary file next to the target, synced to
+	 * disk and then renamed over the target, so the data never has to be
+	 * copied to the Java heap and a crash during the save cannot leave a
+	 * partially written file behind.
+	 *
+	 * @param file
+	 *            the file to write the data to
+	 * @param onlyIfDirty
+	 *            if true, nothing is written when neither our profile nor our
+	 *            friends changed since the last successful save
+	 * @return true if the data was written, false if the save was skipped
+	 * @throws ToxException
+	 *             if the instance has been killed or the file could not be
+	 *             written
+	 */
+	public boolean saveTo(File file, boolean onlyIfDirty) throws ToxException {
+		byte[] path = getStringBytes(file.getPath());
+		int result;
+
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			result = tox_save_to(this.messengerPointer, path, onlyIfDirty);
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (result == -1) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+
+		return result == 1;
+	}
+
+	/**
+	 * Check whether our profile or friend list changed since the last
+	 * successful {@link #saveTo(File, boolean)}. A fresh instance is always
+	 * dirty.
+	 *
+	 * @return true if there are unsaved changes
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 */
+	public boolean isDirty() throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			return tox_is_dirty(this.messengerPointer);
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * Native call to tox_load
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @param data
+	 *            a byte array containing the data to load
+	 * @param length
+	 *            the length of the byte array
+	 * @return false on success, true on failure
+	 */
+	private native boolean tox_load(long messengerPointer, byte[] data, int length);
+
+	/**
+	 * Load the specified data into this tox instance.
+	 *
+	 * @param data
+	 *            a byte array containing the data to load
+	 * @throws ToxException
+	 *             if the instance has been killed, or an error occurred while
+	 *             loading
+	 */
+	private void load(byte[] data) throws ToxException {
+		boolean error;
+
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			error = tox_load(this.messengerPointer, data, data.length);
+			refreshList();
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (error) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+	}
+
+	/**
+	 * Native call to load a file into the tox instance
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @param path
+	 *            UTF-8 encoded path of the file to load
+	 * @return 0 on success, -1 on failure
+	 */
+	private native int tox_load_from(long messengerPointer, byte[] path);
+
+	/**
+	 * Load a file previously written by {@link #saveTo(File)} or containing
+	 * the data returned by {@link #save()} into this tox instance. The file is
+	 * memory-mapped and handed to the core directly, so it is never copied to
+	 * the Java heap.
+	 *
+	 * @param profile
+	 *            the file to load
+	 * @throws ToxException
+	 *             if the instance has been killed, the file could not be read
+	 *             or an error occurred while loading
+	 */
+	public void load(File profile) throws ToxException {
+		byte[] path = getStringBytes(profile.getPath());
+		int result;
+
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			result = tox_load_from(this.messengerPointer, path);
+			refreshList();
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (result == -1) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+	}
+
+	/**
+	 * Refresh the friend list, looking for new friends, status changes, name
+	 * changes etc. Generally, the core should keep this
+	 *
+	 * @throws ToxException
+	 *             if the instance was killed, or an internal error occured
+	 */
+	public void refreshList() throws ToxException {
+		for (int i : getInternalFriendList()) {
+			this.friendList.addFriendIfNotExists(i);
+			refreshClientId(i);
+			refreshFriendName(i);
+			refreshStatusMessage(i);
+			refreshUserStatus(i);
+			this.friendList.getByFriendNumber(i).setOnline(isFriendOnline(i));
+		}
+	}
+
+	/**
+	 * Native call to tox_get_friendlist
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @return array containing valid friend numbers
+	 */
+	private native int[] tox_get_friendlist(long messengerPointer);
+
+	/**
+	 * Get a list of all currently valid friend numbers.
+	 *
+	 * @return ArrayList containing the
+	 * @throws ToxException
+	 *             if the instance was killed, or the list was not retrieved
+	 */
+	private int[] getInternalFriendList() throws ToxException {
+		int[] ids;
+
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			ids = tox_get_friendlist(this.messengerPointer);
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (ids == null) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+
+		return ids;
+	}
+
+	/**
+	 * Native call to tox_get_client_id
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @param friendnumber
+	 *            local number of the friend
+	 * @return the public key of the specified friend
+	 */
+	private native String tox_get_client_id(long messengerPointer, int friendnumber);
+
+	/**
+	 * Refresh the client ID for a given friend.
+	 *
+	 * @param friendnumber
+	 *            the friendnumber
+	 * @throws ToxException
+	 *             if the instance has been killed, or an error occurred when
+	 *             attempting to fetch the client id
+	 */
+	public void refreshClientId(int friendnumber) throws ToxException {
+		String result;
+		acquireLock();
 
 		try {
 			checkPointer();
 
-			error = tox_del_friend(this.messengerPointer, friendnumber);
+			result = tox_get_client_id(this.messengerPointer, friendnumber);
 		} finally {
 			this.lock.unlock();
 		}
 
-		if (error) {
+		if (result == null || result.equals("")) {
 			throw new ToxException(ToxError.TOX_UNKNOWN);
 		}
 
-		this.friendList.removeFriend(friendnumber);
+		this.friendList.getByFriendNumber(friendnumber).setId(result);
 	}
 
 	/**
-	 * Native call to tox_send_message
+	 * Native call to tox_get_client_id
 	 *
 	 * @param messengerPointer
 	 *            pointer to the internal messenger struct
 	 * @param friendnumber
-	 *            the number of the friend
-	 * @param message
-	 *            the message
-	 * @param length
-	 *            length of the message in bytes
-	 * @return the message ID on success, 0 on failure
+	 *            local number of the friend
+	 * @return the binary public key of the specified friend, null on failure
 	 */
-	private native int tox_send_message(long messengerPointer, int friendnumber, byte[] message, int length);
+	private native byte[] tox_get_client_id_bytes(long messengerPointer, int friendnumber);
 
 	/**
-	 * Sends a message to the specified friend. Add the message ID of the sent
-	 * message to the list of sent messages of the receiving friend.
+	 * Get the binary client id of a friend, without encoding it as hex.
 	 *
-	 * @param friend
-	 *            the friend
-	 * @param message
-	 *            the message
-	 * @return the message ID of the sent message. This is stored in the Friend's list of sent
-     *            messages. This value is also passed to the read receipt callback if the message
-     *            was received and should be compared to your list of stored values.
+	 * @param friendnumber
+	 *            the friendnumber
+	 * @return the client id, {@link #TOX_CLIENT_ID_SIZE} bytes
 	 * @throws ToxException
-	 *             if the instance has been killed or the message was not sent
+	 *             if the instance has been killed, or an error occurred when
+	 *             attempting to fetch the client id
 	 */
-	public int sendMessage(F friend, String message) throws ToxException {
-		byte[] messageArray = getStringBytes(message);
-		int result;
-
-		this.lock.lock();
+	public byte[] getClientIdBytes(int friendnumber) throws ToxException {
+		byte[] result;
+		acquireLock();
 
 		try {
 			checkPointer();
 
-			result = tox_send_message(this.messengerPointer, friend.getFriendnumber(), messageArray,
-									  messageArray.length);
+			result = tox_get_client_id_bytes(this.messengerPointer, friendnumber);
 		} finally {
 			this.lock.unlock();
 		}
 
-		if (result == 0) {
-			throw new ToxException(ToxError.TOX_SEND_FAILED);
+		if (result == null) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
 		}
 
 		return result;
 	}
 
 	/**
-	 * Native call to tox_send_action
+	 * Native call to tox_get_friend_connection_status
 	 *
-	 * @param messengerPointer
-	 *            pointer to the internal messenger struct
 	 * @param friendnumber
-	 *            the number of the friend
-	 * @param action
-	 *            the action to send
-	 * @param length
-	 *            length of the action in bytes
-	 * @return false on success, true on failure
+	 *            the friend's number
+	 * @return connecting status of a friend
 	 */
-	private native boolean tox_send_action(long messengerPointer, int friendnumber, byte[] action, int length);
+	private native int tox_get_friend_connection_status(long messengerPointer, int friendnumber);
 
 	/**
-	 * Sends an IRC-like /me-action to a friend
+	 * Refresh the connection status for a given friend
 	 *
-	 * @param friend
-	 *            the friend
-	 * @param action
-	 *            the action
+	 * @param friendnumber
+	 *            the friendnumber
 	 * @throws ToxException
-	 *             if the instance has been killed or the send failed
+	 *             if the instance has been killed, or an error occurred when
+	 *             attempting to fetch the connection status
 	 */
-	public void sendAction(F friend, String action) throws ToxException {
-		byte[] actionArray = getStringBytes(action);
-		boolean error;
-
-		this.lock.lock();
+	public void refreshFriendConnectionStatus(int friendnumber) throws ToxException {
+		acquireLock();
+		int result;
 
 		try {
 			checkPointer();
-
-			error = tox_send_action(this.messengerPointer, friend.getFriendnumber(), actionArray, actionArray.length);
+			result = tox_get_friend_connection_status(this.messengerPointer, friendnumber);
 		} finally {
 			this.lock.unlock();
 		}
 
-		if (error) {
+		if (result == -1) {
 			throw new ToxException(ToxError.TOX_UNKNOWN);
 		}
+
+		F friend = this.friendList.getByFriendNumber(friendnumber);
+
+		if (result == 0) {
+			friend.setOnline(false);
+		} else {
+			friend.setOnline(true);
+		}
 	}
 
 	/**
-	 * Native call to tox_set_user_is_typing
-	 * @param messengerPointer pointer to the internal messenger struct
-	 * @param friendnumber the friend's number
-	 * @param typing <code>true</code> indicates we are typing, <code>false</code> indicates we stopped typing
-	 * @return false on success, true on failure
+	 * Number of friends the presence buffer currently covers
 	 */
-	private native boolean tox_set_user_is_typing(long messengerPointer, int friendnumber, boolean typing);
+	private int presenceCapacity() {
+		return this.presenceBuffer.capacity() / 9 * 8;
+	}
 
 	/**
-	 * Indicate to the specified friend that we are currently typing
-	 * @param friendnumber the friend's number
-	 * @param typing <code>true</code> indicates we are typing, <code>false</code> indicates we stopped typing
-	 * @throws ToxException if the instance has been killed
+	 * Check whether a friend is online, as last reported by core. Unlike
+	 * {@link #refreshFriendConnectionStatus(int)}, this does not call into
+	 * native code.
+	 *
+	 * @param friendnumber
+	 *            the friend's number
+	 * @return true if the friend is online, false if it is offline or does not
+	 *         exist
+	 * @throws ToxException
+	 *             if the instance has been killed
 	 */
-	public void sendIsTyping(int friendnumber, boolean typing) throws ToxException {
-		boolean error;
-
-		this.lock.lock();
+	public boolean isFriendOnline(int friendnumber) throws ToxException {
+		acquireLock();
 
 		try {
 			checkPointer();
 
-			error = tox_set_user_is_typing(this.messengerPointer, friendnumber, typing);
+			if (friendnumber < 0 || friendnumber >= presenceCapacity()) {
+				return false;
+			}
+
+			return (this.presenceBuffer.get(friendnumber >>> 3) & (1 << (friendnumber & 7))) != 0;
 		} finally {
 			this.lock.unlock();
 		}
+	}
 
-		if (error) {
-			throw new ToxException(ToxError.TOX_UNKNOWN);
+	/**
+	 * Count the friends that are online, without calling into native code
+	 *
+	 * @return the number of online friends
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 */
+	public int getOnlineFriendCount() throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			ByteBuffer bits = this.presenceBuffer.order(ByteOrder.LITTLE_ENDIAN);
+			int count = 0;
+
+			for (int i = 0; i < presenceCapacity() / 8; i += 8) {
+				count += Long.bitCount(bits.getLong(i));
+			}
+
+			return count;
+		} finally {
+			this.lock.unlock();
 		}
 	}
 
 	/**
-	 * Native call to tox_do
+	 * Get the numbers of all online friends in ascending order, without
+	 * calling into native code
 	 *
-	 * @param messengerPointer
-	 *            pointer to the internal messenger struct
+	 * @return the friend numbers
+	 * @throws ToxException
+	 *             if the instance has been killed
 	 */
-	private native void tox_do(long messengerPointer);
+	public int[] getOnlineFriendNumbers() throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			ByteBuffer bits = this.presenceBuffer.order(ByteOrder.LITTLE_ENDIAN);
+			int words = presenceCapacity() / 64;
+			int count = 0;
+
+			for (int i = 0; i < words; i++) {
+				count += Long.bitCount(bits.getLong(i * 8));
+			}
+
+			int[] result = new int[count];
+			int n = 0;
+
+			for (int i = 0; i < words && n < count; i++) {
+				long word = bits.getLong(i * 8);
+
+				while (word != 0) {
+					result[n++] = i * 64 + Long.numberOfTrailingZeros(word);
+					word &= word - 1;
+				}
+			}
+
+			return result;
+		} finally {
+			this.lock.unlock();
+		}
+	}
 
 	/**
-	 * The main tox loop that needs to be run at least 20 times per second. When
-	 * implementing this, either use it in a main loop to guarantee execution,
-	 * or start an asynchronous Thread or Service to do it for you.
+	 * Get a friend's user status as last reported by core, without calling
+	 * into native code
 	 *
+	 * @param friendnumber
+	 *            the friend's number
+	 * @return the user status, {@link ToxUserStatus#TOX_USERSTATUS_NONE} if
+	 *         core has not reported one
 	 * @throws ToxException
 	 *             if the instance has been killed
 	 */
-	public void doTox() throws ToxException {
-		this.lock.lock();
+	public ToxUserStatus getLastUserStatus(int friendnumber) throws ToxException {
+		acquireLock();
 
 		try {
 			checkPointer();
 
-			tox_do(this.messengerPointer);
+			int capacity = presenceCapacity();
+
+			if (friendnumber < 0 || friendnumber >= capacity) {
+				return ToxUserStatus.TOX_USERSTATUS_NONE;
+			}
+
+			int status = this.presenceBuffer.get(capacity / 8 + friendnumber) & 0xFF;
+			return status < USER_STATUSES.length ? USER_STATUSES[status] : ToxUserStatus.TOX_USERSTATUS_INVALID;
 		} finally {
 			this.lock.unlock();
 		}
 	}
 
-	private native int tox_do_interval(long messengerPointer);
-
 	/**
-	 * Return the time in milliseconds before doTox() should be called again
-	 * for optimal performance.
-	 * @return time in ms, -1 on failure
+	 * Checks if there exists a friend with given friendnumber.
+	 *
+	 * @param friendnumber
+	 *            the friendnumber
 	 * @throws ToxException
+	 *             if the instance has been killed, or an error occurred when
+	 *             attempting to fetch the connection status
 	 */
-	public int doToxInterval() throws ToxException {
-		this.lock.lock();
-		int result = -1;
+	private native boolean tox_get_friend_exists(long messengerPointer, int friendnumber);
+
+	/**
+	 * Check whether a friend with the given friendnumber exists
+	 *
+	 * @param friendnumber
+	 *            the friendnumber
+	 */
+	public boolean toxFriendExists(int friendnumber) throws ToxException {
+		boolean exists;
+
+		acquireLock();
 
 		try {
 			checkPointer();
-
-			result = tox_do_interval(this.messengerPointer);
+			exists = tox_get_friend_exists(this.messengerPointer, friendnumber);
 		} finally {
 			this.lock.unlock();
 		}
 
-		return result;
+		return exists;
 	}
+
 	/**
-	 * Native call to tox_bootstrap_from_address
+	 * Native call to tox_get_name
 	 *
 	 * @param messengerPointer
 	 *            pointer to the internal messenger struct
-	 * @param ip
-	 *            ip address to bootstrap with
-	 * @param port
-	 *            port to bootstrap with
-	 * @param pubkey
-	 *            public key of the bootstrap node
+	 * @param friendnumber
+	 *            the friend's number
+	 * @return the specified friend's name
 	 */
-	private native int tox_bootstrap_from_address(long messengerPointer, String ip, int port, byte[] pubkey);
+	private native byte[] tox_get_name(long messengerPointer, int friendnumber);
 
 	/**
-	 * Method used to bootstrap the client's connection.
+	 * Refresh the specified friend's name
 	 *
-	 * @param host
-	 *            Hostname or IP(v4, v6) address to connect to. If the hostname
-	 *            contains non-ASCII characters, convert it to punycode when
-	 *            calling this method.
-	 * @param port
-	 *            port to connect to
-	 * @param pubkey
-	 *            public key of the bootstrap node
+	 * @param friendnumber
+	 *            the friend's number
 	 * @throws ToxException
-	 *             if the instance has been killed or an invalid port was
-	 *             specified
-	 * @throws UnknownHostException
-	 *             if the host could not be resolved or the IP address was
-	 *             invalid
+	 *             if the instance has been killed or an error occurred
 	 */
-	public void bootstrap(String host, int port, String pubkey) throws ToxException, UnknownHostException {
-		byte[] pubkeyArray = hexToByteArray(pubkey);
-		boolean error;
-
-		if (port < 0 || port > 65535) {
-			throw new ToxException(ToxError.TOX_INVALID_PORT);
-		}
+	public void refreshFriendName(int friendnumber) throws ToxException {
+		byte[] name;
 
-		this.lock.lock();
+		acquireLock();
 
 		try {
 			checkPointer();
 
-			error = tox_bootstrap_from_address(this.messengerPointer, host, port, pubkeyArray) == 0;
+			name = tox_get_name(this.messengerPointer, friendnumber);
 		} finally {
 			this.lock.unlock();
 		}
 
-		if (error) {
-			throw new UnknownHostException(host);
+		if (name == null) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
 		}
+
+		this.friendList.getByFriendNumber(friendnumber).setName(getByteString(name));
 	}
 
 	/**
-	 * Native call to tox_isconnected
+	 * Native call to tox_get_status_message
 	 *
 	 * @param messengerPointer
 	 *            pointer to the internal messenger struct
+	 * @param friendnumber
+	 *            the friend's number
+	 * @return the status message
 	 */
-	private native int tox_isconnected(long messengerPointer);
+	private native byte[] tox_get_status_message(long messengerPointer, int friendnumber);
 
 	/**
-	 * Check if the client is connected to the DHT
+	 * Refresh the friend's status message.
 	 *
-	 * @return true if connected, false otherwise
+	 * @param friendnumber
+	 *            the friend's number
 	 * @throws ToxException
-	 *             if the instance has been killed
+	 *             if the instance has been killed, or an error occurred while
+	 *             getting the status message
 	 */
-	public boolean isConnected() throws ToxException {
-		this.lock.lock();
+	public void refreshStatusMessage(int friendnumber) throws ToxException {
+		byte[] status;
+
+		acquireLock();
 
 		try {
 			checkPointer();
 
-			return tox_isconnected(this.messengerPointer) != 0;
+			status = tox_get_status_message(this.messengerPointer, friendnumber);
 		} finally {
 			this.lock.unlock();
 		}
+
+		if (status == null) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+
+		this.friendList.getByFriendNumber(friendnumber).setStatusMessage(getByteString(status));
 	}
 
 	/**
-	 * Native call to tox_kill
+	 * Native call to tox_get_userstatus
 	 *
 	 * @param messengerPointer
 	 *            pointer to the internal messenger struct
+	 * @param friendnumber
+	 *            the friend's number
+	 * @return the friend's status
 	 */
-	private native void tox_kill(long messengerPointer);
+	private native ToxUserStatus tox_get_user_status(long messengerPointer, int friendnumber);
 
 	/**
-	 * Kills the current instance, triggering a cleanup of all internal data
-	 * structures. All subsequent calls on any method in this class will result
-	 * in a {@link ToxException} with {@link ToxError#TOX_KILLED_INSTANCE} as an
-	 * error code.
+	 * Refresh status for the specified friend
 	 *
+	 * @param friendnumber
+	 *            the friend's number
 	 * @throws ToxException
-	 *             in case the instance has already been killed
+	 *             if the instance has been killed
 	 */
-	public void killTox() throws ToxException {
-		this.lock.lock();
+	public void refreshUserStatus(int friendnumber) throws ToxException {
+		ToxUserStatus status = ToxUserStatus.TOX_USERSTATUS_INVALID;
+
+		acquireLock();
 
 		try {
 			checkPointer();
 
-			validPointers.remove(this.messengerPointer);
-			tox_kill(this.messengerPointer);
-
-			checkAvPointer();
-			validPointers.remove(this.avPointer);
-			toxav_kill(this.avPointer);
+			status = tox_get_user_status(this.messengerPointer, friendnumber);
 		} finally {
 			this.lock.unlock();
 		}
 
-		instances.remove(this.instanceNumber);
+		this.friendList.getByFriendNumber(friendnumber).setStatus(status);
 	}
 
 	/**
-	 * Native call to tox_save
-	 *
-	 * @param messengerPointer
-	 *            pointer to the internal messenger struct
-	 * @return a byte array containing the saved data
+	 * Native call to tox_get_is_typing
+	 * @param messengerPointer pointer to the internal messenger struct
+	 * @param friendnumber the friend's number
+	 * @return <code>true</code> if the friend is typing, <code>false</code> otherwise
 	 */
-	private native byte[] tox_save(long messengerPointer);
+	private native boolean tox_get_is_typing(long messengerPointer, int friendnumber);
 
 	/**
-	 * Save the internal messenger data to a byte array, which can be saved to a
-	 * file or database
-	 *
-	 * @return a byte array containing the saved data
-	 * @throws ToxException
-	 *             if the instance has been killed
+	 * Refresh the typing status for the specified friend
+	 * @param friendnumber the friend's number
+	 * @throws ToxException if the instance has been killed
 	 */
-	public byte[] save() throws ToxException {
-		this.lock.lock();
+	public void refreshTypingStatus(int friendnumber) throws ToxException {
+		boolean result;
+		acquireLock();
 
 		try {
 			checkPointer();
 
-			return tox_save(this.messengerPointer);
+			result = tox_get_is_typing(this.messengerPointer, friendnumber);
 		} finally {
 			this.lock.unlock();
 		}
+
+		this.friendList.getByFriendNumber(friendnumber).setTyping(result);
 	}
 
+	/****** GROUP CHAT FUNCTIONS ******/
+
 	/**
-	 * Native call to tox_load
+	 * Native call to tox_add_groupchat
 	 *
-	 * @param messengerPointer
-	 *            pointer to the internal messenger struct
-	 * @param data
-	 *            a byte array containing the data to load
-	 * @param length
-	 *            the length of the byte array
-	 * @return false on success, true on failure
+	 * @return group number on success, -1 on failure
 	 */
-	private native boolean tox_load(long messengerPointer, byte[] data, int length);
+	private native int tox_add_groupchat(long messengerPointer);
 
 	/**
-	 * Load the specified data into this tox instance.
+	 * Create a new group chat
 	 *
-	 * @param data
-	 *            a byte array containing the data to load
+	 * @return the group number
 	 * @throws ToxException
-	 *             if the instance has been killed, or an error occurred while
-	 *             loading
+	 *             if the instance has been killed or the group could not be
+	 *             created
 	 */
-	private void load(byte[] data) throws ToxException {
-		boolean error;
-
-		this.lock.lock();
+	public int createGroup() throws ToxException {
+		int result;
+		acquireLock();
 
 		try {
 			checkPointer();
 
-			error = tox_load(this.messengerPointer, data, data.length);
-			refreshList();
+			result = tox_add_groupchat(this.messengerPointer);
 		} finally {
 			this.lock.unlock();
 		}
 
-		if (error) {
+		if (result == -1) {
 			throw new ToxException(ToxError.TOX_UNKNOWN);
 		}
-	}
 
-	/**
-	 * Refresh the friend list, looking for new friends, status changes, name
-	 * changes etc. Generally, the core should keep this
-	 *
-	 * @throws ToxException
-	 *             if the instance was killed, or an internal error occured
-	 */
-	public void refreshList() throws ToxException {
-		for (int i : getInternalFriendList()) {
-			this.friendList.addFriendIfNotExists(i);
-			refreshClientId(i);
-			refreshFriendName(i);
-			refreshStatusMessage(i);
-			refreshUserStatus(i);
-			refreshFriendConnectionStatus(i);
-		}
+		return result;
 	}
 
 	/**
-	 * Native call to tox_get_friendlist
+	 * Native call to tox_del_groupchat
 	 *
-	 * @param messengerPointer
-	 *            pointer to the internal messenger struct
-	 * @return array containing valid friend numbers
+	 * @return 0 on success, -1 on failure
 	 */
-	private native int[] tox_get_friendlist(long messengerPointer);
+	private native int tox_del_groupchat(long messengerPointer, int groupnumber);
 
 	/**
-	 * Get a list of all currently valid friend numbers.
+	 * Leave a group chat
 	 *
-	 * @return ArrayList containing the
+	 * @param groupnumber
+	 *            the group to leave
 	 * @throws ToxException
-	 *             if the instance was killed, or the list was not retrieved
+	 *             if the instance has been killed or the group does not exist
 	 */
-	private int[] getInternalFriendList() throws ToxException {
-		int[] ids;
-
-		this.lock.lock();
+	public void deleteGroup(int groupnumber) throws ToxException {
+		int result;
+		acquireLock();
 
 		try {
 			checkPointer();
 
-			ids = tox_get_friendlist(this.messengerPointer);
+			result = tox_del_groupchat(this.messengerPointer, groupnumber);
 		} finally {
 			this.lock.unlock();
 		}
 
-		if (ids == null) {
+		if (result == -1) {
 			throw new ToxException(ToxError.TOX_UNKNOWN);
 		}
-
-		return ids;
 	}
 
 	/**
-	 * Native call to tox_get_client_id
+	 * Native call to tox_invite_friend
 	 *
-	 * @param messengerPointer
-	 *            pointer to the internal messenger struct
-	 * @param friendnumber
-	 *            local number of the friend
-	 * @return the public key of the specified friend
+	 * @return 0 on success, -1 on failure
 	 */
-	private native String tox_get_client_id(long messengerPointer, int friendnumber);
+	private native int tox_invite_friend(long messengerPointer, int friendnumber, int groupnumber);
 
 	/**
-	 * Refresh the client ID for a given friend.
+	 * Invite a friend to a group chat
 	 *
-	 * @param friendnumber
-	 *            the friendnumber
+	 * @param friend
+	 *            the friend to invite
+	 * @param groupnumber
+	 *            the group to invite them to
 	 * @throws ToxException
-	 *             if the instance has been killed, or an error occurred when
-	 *             attempting to fetch the client id
+	 *             if the instance has been killed or the invite could not be
+	 *             sent
 	 */
-	public void refreshClientId(int friendnumber) throws ToxException {
-		String result;
-		this.lock.lock();
+	public void inviteToGroup(F friend, int groupnumber) throws ToxException {
+		int result;
+		acquireLock();
 
 		try {
 			checkPointer();
 
-			result = tox_get_client_id(this.messengerPointer, friendnumber);
+			result = tox_invite_friend(this.messengerPointer, friend.getFriendnumber(), groupnumber);
 		} finally {
 			this.lock.unlock();
 		}
 
-		if (result == null || result.equals("")) {
+		if (result == -1) {
 			throw new ToxException(ToxError.TOX_UNKNOWN);
 		}
-
-		this.friendList.getByFriendNumber(friendnumber).setId(result);
 	}
 
 	/**
-	 * Native call to tox_get_friend_connection_status
+	 * Native call to tox_join_groupchat
 	 *
-	 * @param friendnumber
-	 *            the friend's number
-	 * @return connecting status of a friend
+	 * @return group number on success, -1 on failure
 	 */
-	private native int tox_get_friend_connection_status(long messengerPointer, int friendnumber);
+	private native int tox_join_groupchat(long messengerPointer, int friendnumber, byte[] groupPublicKey);
 
 	/**
-	 * Refresh the connection status for a given friend
+	 * Join a group chat a friend invited us to, as delivered to
+	 * {@link im.tox.jtoxcore.callbacks.OnGroupInviteCallback}
 	 *
-	 * @param friendnumber
-	 *            the friendnumber
+	 * @param friend
+	 *            the friend who sent the invite
+	 * @param groupPublicKey
+	 *            the public key of the group, {@link #TOX_CLIENT_ID_SIZE}
+	 *            bytes
+	 * @return the group number
 	 * @throws ToxException
-	 *             if the instance has been killed, or an error occurred when
-	 *             attempting to fetch the connection status
+	 *             if the instance has been killed or the group could not be
+	 *             joined
 	 */
-	public void refreshFriendConnectionStatus(int friendnumber) throws ToxException {
-		this.lock.lock();
+	public int joinGroup(F friend, byte[] groupPublicKey) throws ToxException {
 		int result;
+		acquireLock();
 
 		try {
 			checkPointer();
-			result = tox_get_friend_connection_status(this.messengerPointer, friendnumber);
+
+			result = tox_join_groupchat(this.messengerPointer, friend.getFriendnumber(), groupPublicKey);
 		} finally {
 			this.lock.unlock();
 		}
@@ -1010,279 +2961,234 @@ public class JTox<F extends ToxFriend> {
 			throw new ToxException(ToxError.TOX_UNKNOWN);
 		}
 
-		F friend = this.friendList.getByFriendNumber(friendnumber);
-
-		if (result == 0) {
-			friend.setOnline(false);
-		} else {
-			friend.setOnline(true);
-		}
+		return result;
 	}
 
 	/**
-	 * Checks if there exists a friend with given friendnumber.
+	 * Native call to tox_group_message_send
 	 *
-	 * @param friendnumber
-	 *            the friendnumber
-	 * @throws ToxException
-	 *             if the instance has been killed, or an error occurred when
-	 *             attempting to fetch the connection status
+	 * @return 0 on success, -1 on failure
 	 */
-	private native boolean tox_get_friend_exists(long messengerPointer, int friendnumber);
+	private native int tox_group_message_send(long messengerPointer, int groupnumber, byte[] message, int length);
 
 	/**
-	 * Check whether a friend with the given friendnumber exists
+	 * Send a message to a group chat
 	 *
-	 * @param friendnumber
-	 *            the friendnumber
+	 * @param groupnumber
+	 *            the group
+	 * @param message
+	 *            the message
+	 * @throws ToxException
+	 *             if the instance has been killed or the send failed
 	 */
-	public boolean toxFriendExists(int friendnumber) throws ToxException {
-		boolean exists;
-
-		this.lock.lock();
+	public void sendGroupMessage(int groupnumber, String message) throws ToxException {
+		byte[] messageArray = getStringBytes(message);
+		int result;
+		acquireLock();
 
 		try {
 			checkPointer();
-			exists = tox_get_friend_exists(this.messengerPointer, friendnumber);
+
+			result = tox_group_message_send(this.messengerPointer, groupnumber, messageArray, messageArray.length);
 		} finally {
 			this.lock.unlock();
 		}
 
-		return exists;
+		if (result == -1) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
 	}
 
 	/**
-	 * Native call to tox_get_name
+	 * Native call to tox_group_action_send
 	 *
-	 * @param messengerPointer
-	 *            pointer to the internal messenger struct
-	 * @param friendnumber
-	 *            the friend's number
-	 * @return the specified friend's name
+	 * @return 0 on success, -1 on failure
 	 */
-	private native byte[] tox_get_name(long messengerPointer, int friendnumber);
+	private native int tox_group_action_send(long messengerPointer, int groupnumber, byte[] action, int length);
 
 	/**
-	 * Refresh the specified friend's name
+	 * Send an IRC-like /me-action to a group chat
 	 *
-	 * @param friendnumber
-	 *            the friend's number
+	 * @param groupnumber
+	 *            the group
+	 * @param action
+	 *            the action
 	 * @throws ToxException
-	 *             if the instance has been killed or an error occurred
+	 *             if the instance has been killed or the send failed
 	 */
-	public void refreshFriendName(int friendnumber) throws ToxException {
-		byte[] name;
-
-		this.lock.lock();
+	public void sendGroupAction(int groupnumber, String action) throws ToxException {
+		byte[] actionArray = getStringBytes(action);
+		int result;
+		acquireLock();
 
 		try {
 			checkPointer();
 
-			name = tox_get_name(this.messengerPointer, friendnumber);
+			result = tox_group_action_send(this.messengerPointer, groupnumber, actionArray, actionArray.length);
 		} finally {
 			this.lock.unlock();
 		}
 
-		if (name == null) {
+		if (result == -1) {
 			throw new ToxException(ToxError.TOX_UNKNOWN);
 		}
-
-		this.friendList.getByFriendNumber(friendnumber).setName(getByteString(name));
 	}
 
 	/**
-	 * Native call to tox_get_status_message
+	 * Native call to tox_group_number_peers
 	 *
-	 * @param messengerPointer
-	 *            pointer to the internal messenger struct
-	 * @param friendnumber
-	 *            the friend's number
-	 * @return the status message
+	 * @return the number of peers, -1 on failure
 	 */
-	private native byte[] tox_get_status_message(long messengerPointer, int friendnumber);
+	private native int tox_group_number_peers(long messengerPointer, int groupnumber);
 
 	/**
-	 * Refresh the friend's status message.
+	 * Get the number of peers in a group chat, including ourselves
 	 *
-	 * @param friendnumber
-	 *            the friend's number
+	 * @param groupnumber
+	 *            the group
+	 * @return the number of peers
 	 * @throws ToxException
-	 *             if the instance has been killed, or an error occurred while
-	 *             getting the status message
+	 *             if the instance has been killed or the group does not exist
 	 */
-	public void refreshStatusMessage(int friendnumber) throws ToxException {
-		byte[] status;
-
-		this.lock.lock();
+	public int getGroupPeerCount(int groupnumber) throws ToxException {
+		int result;
+		acquireLock();
 
 		try {
 			checkPointer();
 
-			status = tox_get_status_message(this.messengerPointer, friendnumber);
+			result = tox_group_number_peers(this.messengerPointer, groupnumber);
 		} finally {
 			this.lock.unlock();
 		}
 
-		if (status == null) {
+		if (result == -1) {
 			throw new ToxException(ToxError.TOX_UNKNOWN);
 		}
 
-		this.friendList.getByFriendNumber(friendnumber).setStatusMessage(getByteString(status));
+		return result;
 	}
 
 	/**
-	 * Native call to tox_get_userstatus
+	 * Native call to tox_group_peername
 	 *
-	 * @param messengerPointer
-	 *            pointer to the internal messenger struct
-	 * @param friendnumber
-	 *            the friend's number
-	 * @return the friend's status
+	 * @return the UTF-8 encoded name, null on failure
 	 */
-	private native ToxUserStatus tox_get_user_status(long messengerPointer, int friendnumber);
+	private native byte[] tox_group_peername(long messengerPointer, int groupnumber, int peernumber);
 
 	/**
-	 * Refresh status for the specified friend
+	 * Get the name of a single peer. Use {@link #getGroupPeerNames(int)} to
+	 * get all of them.
 	 *
-	 * @param friendnumber
-	 *            the friend's number
+	 * @param groupnumber
+	 *            the group
+	 * @param peernumber
+	 *            the peer
+	 * @return the peer's name
 	 * @throws ToxException
-	 *             if the instance has been killed
+	 *             if the instance has been killed or the peer does not exist
 	 */
-	public void refreshUserStatus(int friendnumber) throws ToxException {
-		ToxUserStatus status = ToxUserStatus.TOX_USERSTATUS_INVALID;
-
-		this.lock.lock();
+	public String getGroupPeerName(int groupnumber, int peernumber) throws ToxException {
+		byte[] name;
+		acquireLock();
 
 		try {
 			checkPointer();
 
-			status = tox_get_user_status(this.messengerPointer, friendnumber);
+			name = tox_group_peername(this.messengerPointer, groupnumber, peernumber);
 		} finally {
 			this.lock.unlock();
 		}
 
-		this.friendList.getByFriendNumber(friendnumber).setStatus(status);
+		if (name == null) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+
+		return getByteString(name);
 	}
 
 	/**
-	 * Native call to tox_get_is_typing
-	 * @param messengerPointer pointer to the internal messenger struct
-	 * @param friendnumber the friend's number
-	 * @return <code>true</code> if the friend is typing, <code>false</code> otherwise
+	 * Native call to tox_group_get_names. The names come back packed into one
+	 * array.
+	 *
+	 * @param offsets
+	 *            one element more than there are peers, receives the start of
+	 *            each name followed by the total length
+	 * @return the packed names, null on failure
 	 */
-	private native boolean tox_get_is_typing(long messengerPointer, int friendnumber);
+	private native byte[] tox_group_get_names(long messengerPointer, int groupnumber, int[] offsets);
 
 	/**
-	 * Refresh the typing status for the specified friend
-	 * @param friendnumber the friend's number
-	 * @throws ToxException if the instance has been killed
+	 * Get the names of all peers in a group chat. They are fetched in one
+	 * native call and kept packed in a single array, so this stays cheap for
+	 * groups with hundreds of peers.
+	 *
+	 * @param groupnumber
+	 *            the group
+	 * @return the names, indexed by peer number
+	 * @throws ToxException
+	 *             if the instance has been killed or the group does not exist
 	 */
-	public void refreshTypingStatus(int friendnumber) throws ToxException {
-		boolean result;
-		this.lock.lock();
+	public ToxGroupNames getGroupPeerNames(int groupnumber) throws ToxException {
+		byte[] names = null;
+		int[] offsets = null;
+		acquireLock();
 
 		try {
 			checkPointer();
 
-			result = tox_get_is_typing(this.messengerPointer, friendnumber);
+			int peers = tox_group_number_peers(this.messengerPointer, groupnumber);
+
+			if (peers > 0) {
+				offsets = new int[peers + 1];
+				names = tox_group_get_names(this.messengerPointer, groupnumber, offsets);
+			} else if (peers == 0) {
+				offsets = new int[1];
+				names = new byte[0];
+			}
 		} finally {
 			this.lock.unlock();
 		}
 
-		this.friendList.getByFriendNumber(friendnumber).setTyping(result);
-	}
-
-	/****** GROUP CHAT FUNCTIONS ******/
-
-	/**
-	 * Creates a new groupchat and puts it in the chats array.
-	 * @param messengerPointer pointer to the internal messenger struct
-	 * @return group number on success, -1 on failure
-	 *
-	private native int tox_add_groupchat(long messengerPointer);
-
-	/**
-	 * Delete a groupchat from the chats array.
-	 * @param messengerPointer pointer to the internal messenger struct
-	 * @param groupnumber group to delete
-	 * @return false on success, true on failure
-	 *
-	private native boolean tox_del_groupchat(long messengerPointer, int groupnumber);
+		if (names == null) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
 
-	/**
-	 * Return the name of peernumber who is in groupnumber
-	 * @param messengerPointer pointer to the internal messenger struct
-	 * @param groupnumber
-	 * @param peernumber
-	 * @return the name of the peer as a byte array
-	 *
-	private native byte[] tox_group_peername(long messengerPointer, int groupnumber, int peernumber);
+		return new ToxGroupNames(names, offsets);
+	}
 
 	/**
-	 * Invite friendnumber to groupnumber
-	 * @param messengerPointer pointer to the internal messenger struct
-	 * @param friendnumber
-	 * @param groupnumber
-	 * @return false on success, true on failure
+	 * Native call to tox_get_chatlist
 	 *
-	private native boolean tox_invite_friend(long messengerPointer, int friendnumber, int groupnumber);
+	 * @return the numbers of all groups
+	 */
+	private native int[] tox_get_chatlist(long messengerPointer);
 
 	/**
-	 * Join a group (you need to have been invited first.)
-	 * @param messengerPointer pointer to the internal messenger struct
-	 * @param friendnumber
-	 * @param friend_group_public_key
-	 * @return group number on success, -1 on failure
+	 * Get the numbers of all group chats we are in
 	 *
-	private native int tox_join_groupchat(long messengerPointer, int friendnumber,
-	                                      byte[] friend_group_public_key);
+	 * @return the group numbers
+	 * @throws ToxException
+	 *             if the instance has been killed
+	 */
+	public int[] getGroupList() throws ToxException {
+		int[] result;
+		acquireLock();
 
-	/**
-	 * Sends a group message
-	 * @param messengerPointer pointer to the internal messenger struct
-	 * @param groupnumber
-	 * @param message
-	 * @param length
-	 * @return false on success, true on failure
-	 *
-	private native boolean tox_group_message_send(long messengerPointer, int groupnumber,
-	                                              byte[] message, int length);
+		try {
+			checkPointer();
 
-	/**
-	 * Send a group action
-	 * @param messengerPointer
-	 * @param groupnumber
-	 * @param action
-	 * @param length
-	 * @return false on success, true on failure
-	 *
-	private native boolean tox_group_action_send(long messengerPointer, int groupnumber,
-	                                         byte[] action, int length);
+			result = tox_get_chatlist(this.messengerPointer);
+		} finally {
+			this.lock.unlock();
+		}
 
-	/**
-	 * Return the number of peers in the group chat on success.
-	 * @param messengerPointer
-	 * @param groupnumber
-	 * @return the number of peers in the group chat on success, -1 on failure
-	 *
-	private native int tox_group_number_peers(long messengerPointer, int groupnumber);
+		if (result == null) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
 
-	*
-	private native byte[][] tox_group_get_names(long messengerPointer, int groupnumber);
-
-	public byte[][] toxGroupGetNames(int groupnumber) throws ToxException {
-	    byte[][] result;
-	    this.lock.lock();
-	    try {
-	        checkPointer();
-	        result = tox_group_get_names(this.messengerPointer, groupnumber);
-	    } finally {
-	        this.lock.unlock();
-	    }
-	    return result;
+		return result;
 	}
-	*/
 
 	/****** GROUP CHAT FUNCTIONS END ******/
 
@@ -1295,7 +3201,7 @@ public class JTox<F extends ToxFriend> {
 	 */
 	public int getNospam() throws ToxException {
 		int result;
-		this.lock.lock();
+		acquireLock();
 
 		try {
 			checkPointer();
@@ -1315,7 +3221,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public void setNospam(int nospam) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 
 		try {
 			checkPointer();
@@ -1340,8 +3246,8 @@ public class JTox<F extends ToxFriend> {
 	 */
 	public int newFileSender(int friendnumber, long filesize, String filename) throws ToxException {
 		int result;
-		byte[] _filename = filename.getBytes(Charset.forName("UTF-8"));
-		this.lock.lock();
+		byte[] _filename = getStringBytes(filename);
+		acquireLock();
 
 		try {
 			checkPointer();
@@ -1379,7 +3285,7 @@ public class JTox<F extends ToxFriend> {
 			send_receive = 1;
 		}
 
-		this.lock.lock();
+		acquireLock();
 
 		try {
 			checkPointer();
@@ -1404,7 +3310,7 @@ public class JTox<F extends ToxFriend> {
 	 */
 	public int fileSendData(int friendnumber, int filenumber, byte[] data) throws ToxException {
 		int result;
-		this.lock.lock();
+		acquireLock();
 
 		try {
 			checkPointer();
@@ -1424,51 +3330,303 @@ public class JTox<F extends ToxFriend> {
 	 * @return size in bytes on success, -1 on failure
 	 * @throws ToxException
 	 */
-	public int fileDataSize(int friendnumber) throws ToxException {
+	public int fileDataSize(int friendnumber) throws ToxException {
+		int result;
+		acquireLock();
+
+		try {
+			checkPointer();
+			result = tox_file_data_size(this.messengerPointer, friendnumber);
+		} finally {
+			this.lock.unlock();
+		}
+
+		return result;
+	}
+
+	private native long tox_file_data_remaining(long messengerPointer, int friendnumber, int filenumber, int send_receive);
+
+	/**
+	 * Give the number of bytes left to be sent/received.
+	 * sending is true if we want a file we are sending, false if we want one we are receiving
+	 * @param friendnumber
+	 * @param filenumber
+	 * @param sending
+	 * @return number of bytes left on success, 0 on failure
+	 * @throws ToxException
+	 */
+	public long fileDataRemaining(int friendnumber, int filenumber, boolean sending) throws ToxException {
+		long result;
+		int send_receive;
+
+		if (sending) {
+			send_receive = 0;
+		} else {
+			send_receive = 1;
+		}
+
+		acquireLock();
+
+		try {
+			checkPointer();
+			result = tox_file_data_remaining(this.messengerPointer, friendnumber, filenumber, send_receive);
+		} finally {
+			this.lock.unlock();
+		}
+
+		return result;
+	}
+
+	/**
+	 * Native call to hand a file to the native transfer scheduler
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @param friendnumber
+	 *            the friend to send to
+	 * @param path
+	 *            UTF-8 encoded path of the file to read from
+	 * @param filename
+	 *            UTF-8 encoded file name to offer to the friend
+	 * @param weight
+	 *            share of the bandwidth relative to other transfers
+	 * @return the file number on success, -1 on failure
+	 */
+	private native int tox_file_schedule(long messengerPointer, int friendnumber, byte[] path, byte[] filename,
+										 int weight);
+
+	/**
+	 * Native call to accept an incoming file and write it to disk natively
+	 *
+	 * @param messengerPointer
+	 *            pointer to the internal messenger struct
+	 * @param friendnumber
+	 *            the friend sending the file
+	 * @param filenumber
+	 *            the file number from the file send request
+	 * @param filesize
+	 *            the file size from the file send request
+	 * @param path
+	 *            UTF-8 encoded path of the destination file
+	 * @return 0 on success, -1 on failure
+	 */
+	private native int tox_file_receive(long messengerPointer, int friendnumber, int filenumber, long filesize,
+										byte[] path);
+
+	/**
+	 * Accept an incoming file and have it written to disk natively, with a
+	 * resume journal. Progress is journaled next to the destination, in a file
+	 * with ".journal" appended to its name, as a checksum per received block.
+	 * When the friend goes offline and comes back during the transfer, the
+	 * last verified block is looked up and the friend is asked to resume from
+	 * there with {@link ToxFileControl#TOX_FILECONTROL_RESUME_BROKEN}, so only
+	 * the missing tail is sent again. The journal is deleted once the transfer
+	 * finishes, and kept if it is killed.
+	 * <p/>
+	 * If the file cannot be written, the transfer is killed. If the friend
+	 * reports it finished before all of filesize arrived, it has failed as
+	 * well. Either way OnFileControlCallbacks see
+	 * {@link ToxFileControl#TOX_FILECONTROL_KILL} and the partial file and
+	 * its journal are kept.
+	 * <p/>
+	 * Data of such a transfer is not passed to OnFileDataCallbacks.
+	 *
+	 * @param friendnumber
+	 *            the friend sending the file
+	 * @param filenumber
+	 *            the file number from the file send request
+	 * @param filesize
+	 *            the file size from the file send request
+	 * @param destination
+	 *            where to write the file. Existing files are overwritten.
+	 * @throws ToxException
+	 *             if the instance has been killed, the destination or journal
+	 *             could not be created or the transfer could not be accepted
+	 */
+	public void receiveFile(int friendnumber, int filenumber, long filesize, File destination) throws ToxException {
+		byte[] path = getStringBytes(destination.getPath());
+		int result;
+
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			result = tox_file_receive(this.messengerPointer, friendnumber, filenumber, filesize, path);
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (result == -1) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+	}
+
+	/**
+	 * Native call to remove a transfer from the scheduler
+	 *
+	 * @return 0 on success, -1 if the transfer is unknown
+	 */
+	private native int tox_file_unschedule(long messengerPointer, int friendnumber, int filenumber);
+
+	/**
+	 * Native call to change the weight of a scheduled transfer
+	 *
+	 * @return 0 on success, -1 if the transfer is unknown
+	 */
+	private native int tox_file_set_weight(long messengerPointer, int friendnumber, int filenumber, int weight);
+
+	/**
+	 * Native call to read the statistics of a scheduled transfer
+	 *
+	 * @return the statistics, null if the transfer is unknown
+	 */
+	private native long[] tox_file_transfer_stats(long messengerPointer, int friendnumber, int filenumber);
+
+	/**
+	 * Offer a file to a friend and let the native scheduler send it with
+	 * weight 1
+	 *
+	 * @param friendnumber
+	 *            the friend to send to
+	 * @param file
+	 *            the file to send
+	 * @return the file number of the new transfer
+	 * @throws ToxException
+	 *             if the instance has been killed, the file could not be opened
+	 *             or core refused the transfer
+	 * @see #sendFile(int, File, int)
+	 */
+	public int sendFile(int friendnumber, File file) throws ToxException {
+		return sendFile(friendnumber, file, 1);
+	}
+
+	/**
+	 * Offer a file to a friend and let the native scheduler send it. Once the
+	 * friend accepts, the data is read and sent from within {@link #doTox()},
+	 * with every active outgoing transfer getting a share of the send slots
+	 * proportional to its weight. There is no need to call
+	 * {@link #fileSendData(int, int, byte[])} for such a transfer; pause,
+	 * resume, kill and finish are handled as well. When the friend asks to
+	 * resume a broken transfer, sending continues from the requested offset.
+	 *
+	 * @param friendnumber
+	 *            the friend to send to
+	 * @param file
+	 *            the file to send. Its name is offered to the friend.
+	 * @param weight
+	 *            share of the bandwidth relative to other transfers, at least
+	 *            1
+	 * @return the file number of the new transfer
+	 * @throws ToxException
+	 *             if the instance has been killed, the file could not be opened
+	 *             or core refused the transfer
+	 */
+	public int sendFile(int friendnumber, File file, int weight) throws ToxException {
+		byte[] path = getStringBytes(file.getPath());
+		byte[] filename = getStringBytes(file.getName());
+		int result;
+
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			result = tox_file_schedule(this.messengerPointer, friendnumber, path, filename, weight);
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (result == -1) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+
+		return result;
+	}
+
+	/**
+	 * Change the share of the bandwidth a scheduled transfer gets
+	 *
+	 * @param friendnumber
+	 *            the friend the file is sent to
+	 * @param filenumber
+	 *            the file number returned by {@link #sendFile(int, File, int)}
+	 * @param weight
+	 *            the new weight, at least 1
+	 * @throws ToxException
+	 *             if the instance has been killed or the transfer is unknown
+	 */
+	public void setFileTransferWeight(int friendnumber, int filenumber, int weight) throws ToxException {
+		int result;
+
+		acquireLock();
+
+		try {
+			checkPointer();
+
+			result = tox_file_set_weight(this.messengerPointer, friendnumber, filenumber, weight);
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (result == -1) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+	}
+
+	/**
+	 * Stop a scheduled transfer, killing it if it is still running, and
+	 * forget its statistics
+	 *
+	 * @param friendnumber
+	 *            the friend the file is sent to
+	 * @param filenumber
+	 *            the file number returned by {@link #sendFile(int, File, int)}
+	 * @throws ToxException
+	 *             if the instance has been killed or the transfer is unknown
+	 */
+	public void cancelFile(int friendnumber, int filenumber) throws ToxException {
 		int result;
-		this.lock.lock();
+
+		acquireLock();
 
 		try {
 			checkPointer();
-			result = tox_file_data_size(this.messengerPointer, friendnumber);
+
+			result = tox_file_unschedule(this.messengerPointer, friendnumber, filenumber);
 		} finally {
 			this.lock.unlock();
 		}
 
-		return result;
+		if (result == -1) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
 	}
 
-	private native long tox_file_data_remaining(long messengerPointer, int friendnumber, int filenumber, int send_receive);
-
 	/**
-	 * Give the number of bytes left to be sent/received.
-	 * sending is true if we want a file we are sending, false if we want one we are receiving
+	 * Get the statistics of a scheduled transfer. Finished and killed
+	 * transfers keep theirs until cancelled or until core reuses the file
+	 * number.
+	 *
 	 * @param friendnumber
+	 *            the friend the file is sent to
 	 * @param filenumber
-	 * @param sending
-	 * @return number of bytes left on success, 0 on failure
+	 *            the file number returned by {@link #sendFile(int, File, int)}
+	 * @return the statistics, indexed by the FILE_STAT_ constants, or null if
+	 *         the transfer is unknown
 	 * @throws ToxException
+	 *             if the instance has been killed
 	 */
-	public long fileDataRemaining(int friendnumber, int filenumber, boolean sending) throws ToxException {
-		long result;
-		int send_receive;
-
-		if (sending) {
-			send_receive = 0;
-		} else {
-			send_receive = 1;
-		}
-
-		this.lock.lock();
+	public long[] getFileTransferStats(int friendnumber, int filenumber) throws ToxException {
+		acquireLock();
 
 		try {
 			checkPointer();
-			result = tox_file_data_remaining(this.messengerPointer, friendnumber, filenumber, send_receive);
+
+			return tox_file_transfer_stats(this.messengerPointer, friendnumber, filenumber);
 		} finally {
 			this.lock.unlock();
 		}
-
-		return result;
 	}
 	/****** FILE SENDING FUNCTIONS END ******/
 
@@ -1530,7 +3688,7 @@ public class JTox<F extends ToxFriend> {
 	 * @return a byte array
 	 */
 	public static byte[] getStringBytes(String in) {
-		return (in).getBytes(Charset.forName("UTF-8"));
+		return in.getBytes(UTF8);
 	}
 
 	/**
@@ -1541,11 +3699,67 @@ public class JTox<F extends ToxFriend> {
 	 * @return an UTF-8 String based on the given byte array
 	 */
 	public static String getByteString(byte[] in) {
-		try {
-			return new String(in, "UTF-8");
-		} catch (UnsupportedEncodingException e) {
-			throw new InternalError("UTF-8 support is needed to continue.");
+		return new String(in, UTF8);
+	}
+
+	/**
+	 * Turns the given part of a byte array into a String, decoding it as UTF-8
+	 *
+	 * @param in
+	 *            the byte array to convert
+	 * @param offset
+	 *            index of the first byte to decode
+	 * @param length
+	 *            number of bytes to decode
+	 * @return the decoded String
+	 */
+	public static String getByteString(byte[] in, int offset, int length) {
+		return new String(in, offset, length, UTF8);
+	}
+
+	/**
+	 * Native UTF-8 validation
+	 *
+	 * @param data
+	 *            the data to check
+	 * @param offset
+	 *            index of the first byte to check
+	 * @param length
+	 *            number of bytes to check
+	 * @return true if the range is well-formed UTF-8
+	 */
+	private static native boolean utf8_validate(byte[] data, int offset, int length);
+
+	/**
+	 * Check whether the given bytes are well-formed UTF-8 without decoding
+	 * them. Useful for raw callbacks that forward text without turning it into
+	 * a String.
+	 *
+	 * @param data
+	 *            the data to check
+	 * @return true if the data is well-formed UTF-8
+	 */
+	public static boolean isValidUtf8(byte[] data) {
+		return isValidUtf8(data, 0, data.length);
+	}
+
+	/**
+	 * Check whether the given part of a byte array is well-formed UTF-8
+	 *
+	 * @param data
+	 *            the data to check
+	 * @param offset
+	 *            index of the first byte to check
+	 * @param length
+	 *            number of bytes to check
+	 * @return true if the range is well-formed UTF-8
+	 */
+	public static boolean isValidUtf8(byte[] data, int offset, int length) {
+		if (offset < 0 || length < 0 || offset + length > data.length) {
+			throw new IndexOutOfBoundsException();
 		}
+
+		return utf8_validate(data, offset, length);
 	}
 
 	/**
@@ -1554,17 +3768,53 @@ public class JTox<F extends ToxFriend> {
 	 * @param in
 	 *            String to convert
 	 * @return byte array representation of the hexadecimal String
+	 * @throws IllegalArgumentException
+	 *             if in has an odd length or contains a non-hexadecimal
+	 *             character
 	 */
 	public static byte[] hexToByteArray(String in) {
 		int length = in.length();
+
+		if (length % 2 != 0) {
+			throw new IllegalArgumentException("Odd number of hexadecimal digits: " + length);
+		}
+
 		byte[] out = new byte[length / 2];
 
 		for (int i = 0; i < length; i += 2) {
-			out[i / 2] = (byte) ((Character.digit(in.charAt(i), 16) << 4) + Character.digit(in.charAt(i + 1), 16));
+			out[i / 2] = (byte) ((hexValue(in.charAt(i)) << 4) | hexValue(in.charAt(i + 1)));
 		}
 
 		return out;
 	}
+
+	private static int hexValue(char c) {
+		int value = c < HEX_VALUES.length ? HEX_VALUES[c] : -1;
+
+		if (value < 0) {
+			throw new IllegalArgumentException("Not a hexadecimal digit: " + c);
+		}
+
+		return value;
+	}
+
+	/**
+	 * Convert a given byte array to an upper case hexadecimal String.
+	 *
+	 * @param in
+	 *            byte array to convert
+	 * @return hexadecimal representation of the byte array
+	 */
+	public static String byteArrayToHex(byte[] in) {
+		char[] out = new char[in.length * 2];
+
+		for (int i = 0; i < in.length; i++) {
+			out[2 * i] = HEX_DIGITS[(in[i] >> 4) & 0x0F];
+			out[2 * i + 1] = HEX_DIGITS[in[i] & 0x0F];
+		}
+
+		return new String(out);
+	}
 	///////////////////////AUDIO / VIDEO///////////////////////////////////////////////
 	/**
 	 * Native call to toxav_new
@@ -1606,7 +3856,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public int avCall(int user, ToxCodecSettings csettings, int ringingSeconds) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		int ret;
 
 		try {
@@ -1619,6 +3869,37 @@ public class JTox<F extends ToxFriend> {
 		return ret;
 	}
 
+	/**
+	 * Native call to toxav_call with compiled codec settings
+	 */
+	private native int toxav_call_compiled(long avPointer, int user, long csettings, int ringing_seconds);
+
+	/**
+	 * Call user using friend_id, with settings compiled by
+	 * {@link ToxCodecSettings#compile()}
+	 * @param user friend_id of the user
+	 * @param csettings compiled codec settings
+	 * @param ringingSeconds seconds to ring
+	 * @return 0 on success, otherwise error value
+	 * @throws ToxException if csettings was closed
+	 */
+	public int avCall(int user, ToxCompiledCodecSettings csettings, int ringingSeconds) throws ToxException {
+		acquireLock();
+		int ret;
+
+		try {
+			checkPointer();
+
+			synchronized (csettings) {
+				ret = toxav_call_compiled(this.avPointer, user, csettings.getHandle(), ringingSeconds);
+			}
+		} finally {
+			this.lock.unlock();
+		}
+
+		return ret;
+	}
+
 	/**
 	* Hangup active call.
 	*
@@ -1634,7 +3915,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public int avHangup(int callIndex) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		int ret;
 
 		try {
@@ -1665,7 +3946,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public int avAnswer(int callIndex, ToxCodecSettings csettings) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		int ret;
 
 		try {
@@ -1678,6 +3959,36 @@ public class JTox<F extends ToxFriend> {
 		return ret;
 	}
 
+	/**
+	 * Native call to toxav_answer with compiled codec settings
+	 */
+	private native int toxav_answer_compiled(long avPointer, int call_index, long csettings);
+
+	/**
+	 * Answer incoming call, with settings compiled by
+	 * {@link ToxCodecSettings#compile()}
+	 * @param callIndex call index
+	 * @param csettings compiled codec settings
+	 * @return 0 on success
+	 * @throws ToxException if csettings was closed
+	 */
+	public int avAnswer(int callIndex, ToxCompiledCodecSettings csettings) throws ToxException {
+		acquireLock();
+		int ret;
+
+		try {
+			checkPointer();
+
+			synchronized (csettings) {
+				ret = toxav_answer_compiled(this.avPointer, callIndex, csettings.getHandle());
+			}
+		} finally {
+			this.lock.unlock();
+		}
+
+		return ret;
+	}
+
 	/**
 	* Reject incomming call.
 	*
@@ -1686,7 +3997,7 @@ public class JTox<F extends ToxFriend> {
 	* @param reason Optional reason. Set NULL if none.
 	* @return int
 	*/
-	private native int toxav_reject(long avPointer, int call_index, String reason);
+	private native int toxav_reject(long avPointer, int call_index, byte[] reason);
 
 	/**
 	 * Reject incoming call
@@ -1696,12 +4007,12 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public int avReject(int callIndex, String reason) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		int ret;
 
 		try {
 			checkPointer();
-			ret = toxav_reject(this.avPointer, callIndex, reason);
+			ret = toxav_reject(this.avPointer, callIndex, reason == null ? null : getStringBytes(reason));
 		} finally {
 			this.lock.unlock();
 		}
@@ -1718,7 +4029,7 @@ public class JTox<F extends ToxFriend> {
 	* @param peer_id peer friend_id
 	* @return 0 on success
 	*/
-	private native int toxav_cancel(long avPointer, int call_index, int peer_id, String reason);
+	private native int toxav_cancel(long avPointer, int call_index, int peer_id, byte[] reason);
 
 	/**
     * Cancel outgoing request
@@ -1729,12 +4040,12 @@ public class JTox<F extends ToxFriend> {
     * @throws ToxException
     */
 	public int avCancel(int callIndex, int peerId, String reason) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		int ret;
 
 		try {
 			checkPointer();
-			ret = toxav_cancel(this.avPointer, callIndex, peerId, reason);
+			ret = toxav_cancel(this.avPointer, callIndex, peerId, reason == null ? null : getStringBytes(reason));
 		} finally {
 			this.lock.unlock();
 		}
@@ -1760,7 +4071,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public int avChangeSettings(int callIndex, ToxCodecSettings csettings) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		int ret;
 
 		try {
@@ -1773,6 +4084,75 @@ public class JTox<F extends ToxFriend> {
 		return ret;
 	}
 
+	/**
+	 * Native call to toxav_change_settings with compiled codec settings
+	 */
+	private native int toxav_change_settings_compiled(long avPointer, int call_index, long csettings);
+
+	/**
+	 * Change call settings, with settings compiled by
+	 * {@link ToxCodecSettings#compile()}
+	 * @param callIndex
+	 * @param csettings compiled codec settings
+	 * @return 0 on success
+	 * @throws ToxException if csettings was closed
+	 */
+	public int avChangeSettings(int callIndex, ToxCompiledCodecSettings csettings) throws ToxException {
+		acquireLock();
+		int ret;
+
+		try {
+			checkPointer();
+
+			synchronized (csettings) {
+				ret = toxav_change_settings_compiled(this.avPointer, callIndex, csettings.getHandle());
+			}
+		} finally {
+			this.lock.unlock();
+		}
+
+		return ret;
+	}
+
+	/**
+	 * Native call to convert codec settings into a malloc'd ToxAvCSettings
+	 */
+	private static native long toxav_codec_settings_compile(ToxCodecSettings csettings);
+
+	/**
+	 * Backs {@link ToxCodecSettings#compile()}
+	 *
+	 * @param csettings
+	 *            the settings to convert
+	 * @return the native handle
+	 * @throws ToxException
+	 *             if the native settings could not be allocated
+	 */
+	static long compileCodecSettings(ToxCodecSettings csettings) throws ToxException {
+		long handle = toxav_codec_settings_compile(csettings);
+
+		if (handle == 0) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+
+		return handle;
+	}
+
+	/**
+	 * Native call to free settings returned by toxav_codec_settings_compile
+	 */
+	private static native void toxav_codec_settings_free(long csettings);
+
+	/**
+	 * Backs {@link ToxCompiledCodecSettings#close()}
+	 *
+	 * @param handle
+	 *            the native handle
+	 */
+	static void freeCodecSettings(long handle) {
+		toxav_codec_settings_free(handle);
+	}
+
 	/**
 	* Terminate transmission. Note that transmission will be terminated without informing remote peer.
 	*
@@ -1789,7 +4169,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public int avStopCall(int callIndex) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		int ret;
 
 		try {
@@ -1825,7 +4205,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public int avPrepareTransmission(int callIndex, int jBufSize, int VADThreshold, boolean supportVideo) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		int ret;
 		int s;
 
@@ -1861,7 +4241,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public int avKillTransmission(int callIndex) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		int ret;
 
 		try {
@@ -1893,7 +4273,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public int avSendVideo(int callIndex, byte[] frame) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		int ret;
 
 		try {
@@ -1926,7 +4306,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public int avSendAudio(int callIndex, byte[] frame) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		int ret;
 
 		try {
@@ -1957,13 +4337,15 @@ public class JTox<F extends ToxFriend> {
 	 * @param callIndex
 	 * @param destMax
 	 * @param data
+	 *            the frame in YV12 layout, as delivered by the Android camera
 	 * @param width
 	 * @param height
 	 * @return The encoded video frame
 	 * @throws ToxException
+	 *             if data is too short for the given size, or encoding failed
 	 */
 	public byte[] avPrepareVideoFrame(int callIndex, int destMax, byte[] data, int width, int height) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		byte[] ret;
 
 		try {
@@ -1973,6 +4355,10 @@ public class JTox<F extends ToxFriend> {
 			this.lock.unlock();
 		}
 
+		if (ret == null) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+
 		return ret;
 	}
 
@@ -1998,7 +4384,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public byte[] avPrepareAudioFrame(int callIndex, int destMax, int[] data, int frameSize) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		byte[] ret;
 
 		try {
@@ -2011,6 +4397,148 @@ public class JTox<F extends ToxFriend> {
 		return ret;
 	}
 
+	/**
+	 * Native call to start the bitrate controller of a call
+	 */
+	private native int toxav_bitrate_enable(long avPointer, int call_index, int min_video_bitrate, int min_audio_bitrate);
+
+	/**
+	 * Let the binding adapt a call's codec settings to the connection. It
+	 * watches failed sends and encoding time, and steps down the video bitrate
+	 * and resolution, then the audio bitrate, when sending struggles for a few
+	 * seconds. Once sending has been healthy for a while longer it steps back
+	 * up, never beyond the settings the call was set up or last changed with.
+	 * Each step is a call to toxav_change_settings; the choices can be followed
+	 * with {@link #avGetBitrateStats(int)}.
+	 * <p>
+	 * Frames are not scaled by the binding. Lowering the resolution only
+	 * takes effect if the application reads
+	 * {@link #BITRATE_STAT_VIDEO_WIDTH} and {@link #BITRATE_STAT_VIDEO_HEIGHT}
+	 * and downscales its frames to fit before passing them to
+	 * {@link #avPrepareVideoFrame}. Larger frames are rejected by the encoder.
+	 * <p>
+	 * A floor above the call's settings is lowered to them, and goes back up
+	 * if the settings are later changed to allow it.
+	 *
+	 * @param callIndex
+	 *            the call index
+	 * @param minVideoBitrate
+	 *            lowest video bitrate in kbit/s, 0 for the default of 100
+	 * @param minAudioBitrate
+	 *            lowest audio bitrate in bit/s, 0 for the default of 16000
+	 * @throws ToxException
+	 *             if the call was not set up through this instance, or a
+	 *             bitrate is negative
+	 */
+	public void avEnableBitrateControl(int callIndex, int minVideoBitrate, int minAudioBitrate) throws ToxException {
+		acquireLock();
+		int ret;
+
+		try {
+			checkPointer();
+			ret = toxav_bitrate_enable(this.avPointer, callIndex, minVideoBitrate, minAudioBitrate);
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (ret != 0) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+	}
+
+	/**
+	 * Native call to stop the bitrate controller of a call
+	 */
+	private native void toxav_bitrate_disable(long avPointer, int call_index);
+
+	/**
+	 * Stop adapting a call's codec settings. The call keeps the settings the
+	 * controller chose last.
+	 *
+	 * @param callIndex
+	 *            the call index
+	 * @throws ToxException
+	 */
+	public void avDisableBitrateControl(int callIndex) throws ToxException {
+		acquireLock();
+
+		try {
+			checkPointer();
+			toxav_bitrate_disable(this.avPointer, callIndex);
+		} finally {
+			this.lock.unlock();
+		}
+	}
+
+	/**
+	 * Native call to read the bitrate controller's counters
+	 */
+	private native long[] toxav_bitrate_stats(long avPointer, int call_index);
+
+	/**
+	 * Get the decisions and counters of a call's bitrate controller. Counters
+	 * start over when a new call is set up with the same index.
+	 *
+	 * @param callIndex
+	 *            the call index
+	 * @return the values, indexed by the BITRATE_STAT_ constants
+	 * @throws ToxException
+	 *             if the call index is out of range
+	 */
+	public long[] avGetBitrateStats(int callIndex) throws ToxException {
+		acquireLock();
+		long[] ret;
+
+		try {
+			checkPointer();
+			ret = toxav_bitrate_stats(this.avPointer, callIndex);
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (ret == null) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+
+		return ret;
+	}
+
+	/**
+	 * Native call to read the media counters of a call
+	 */
+	private native long[] toxav_get_call_stats(long avPointer, int call_index);
+
+	/**
+	 * Get the media counters of a call: frames and frame rates in both
+	 * directions, bytes sent and received, encoding times, dropped frames and
+	 * how long the handler takes to accept received frames. Counters start
+	 * over when a call is set up with the same index, and stay readable after
+	 * the call ends.
+	 *
+	 * @param callIndex
+	 *            the call index
+	 * @return the values, indexed by the MEDIA_STAT_ constants
+	 * @throws ToxException
+	 *             if the call index is out of range
+	 */
+	public long[] avGetCallStats(int callIndex) throws ToxException {
+		acquireLock();
+		long[] ret;
+
+		try {
+			checkPointer();
+			ret = toxav_get_call_stats(this.avPointer, callIndex);
+		} finally {
+			this.lock.unlock();
+		}
+
+		if (ret == null) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+
+		return ret;
+	}
+
 	/**
 	* Get peer transmission type. It can either be audio or video.
 	*
@@ -2029,7 +4557,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public ToxCodecSettings avGetPeerCodecSettings(int callIndex, int peer) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		ToxCodecSettings ret;
 
 		try {
@@ -2060,7 +4588,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public int avGetPeerId(int callIndex, int peer) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		int ret;
 
 		try {
@@ -2089,7 +4617,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public ToxAvCallState avGetCallState(int callIndex) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		ToxAvCallState ret;
 
 		try {
@@ -2118,7 +4646,7 @@ public class JTox<F extends ToxFriend> {
 	 * @throws ToxException
 	 */
 	public boolean avCapabilitySupported(int callIndex, ToxAvCapabilities capability) throws ToxException {
-		this.lock.lock();
+		acquireLock();
 		int ret;
 
 		try {
@@ -0,0 +1,43 @@
+/* ToxBackpressurePolicy.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+package im.tox.jtoxcore;
+
+/**
+ * Enum for what the outgoing message queue does when a friend's queue is full
+ *
+ * @author sonOfRa
+ *
+ */
+public enum ToxBackpressurePolicy {
+	/**
+	 * Wait until the queue has drained enough to hold the message
+	 */
+	BLOCK,
+	/**
+	 * Discard the new message
+	 */
+	DROP,
+	/**
+	 * Discard the new message and hand it to the queue-full callback
+	 */
+	CALLBACK;
+}
@@ -0,0 +1,161 @@
+/* ToxCallStats.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+package im.tox.jtoxcore;
+
+/**
+ * Counters and latency histogram of a single native entry point or
+ * callback, merged over all threads. Part of a {@link ToxStats} snapshot.
+ * <p/>
+ * Latencies are counted in log-linear buckets with 8 buckets per power of
+ * two, so percentiles are accurate to within 12.5%.
+ *
+ * @author sonOfRa
+ *
+ */
+public final class ToxCallStats {
+
+	static final int SUB_BUCKET_BITS = 3;
+	static final int MAX_EXPONENT = 36;
+	static final int BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+	/**
+	 * Number of values per probe in the array returned by the native call
+	 */
+	static final int FIELDS = 4 + BUCKETS;
+
+	private final String name;
+	private final long calls;
+	private final long bytes;
+	private final long totalNanos;
+	private final long maxNanos;
+	private final long[] buckets;
+
+	ToxCallStats(String name, long[] raw, int offset) {
+		this.name = name;
+		this.calls = raw[offset];
+		this.bytes = raw[offset + 1];
+		this.totalNanos = raw[offset + 2];
+		this.maxNanos = raw[offset + 3];
+		this.buckets = new long[BUCKETS];
+		System.arraycopy(raw, offset + 4, this.buckets, 0, BUCKETS);
+	}
+
+	/**
+	 * Smallest latency in nanoseconds counted in the given bucket
+	 */
+	static long bucketLowerBound(int bucket) {
+		if (bucket < (1 << SUB_BUCKET_BITS)) {
+			return bucket;
+		}
+
+		int exponent = (bucket >> SUB_BUCKET_BITS) + SUB_BUCKET_BITS - 1;
+		long sub = bucket & ((1 << SUB_BUCKET_BITS) - 1);
+		return ((1L << SUB_BUCKET_BITS) + sub) << (exponent - SUB_BUCKET_BITS);
+	}
+
+	/**
+	 * @return the native function name, e.g. "tox_send_message" or
+	 *         "callback_friendmessage"
+	 */
+	public String getName() {
+		return this.name;
+	}
+
+	/**
+	 * @return how often the function was called
+	 */
+	public long getCalls() {
+		return this.calls;
+	}
+
+	/**
+	 * @return payload bytes passed through the function, for functions that
+	 *         carry messages, file data or media
+	 */
+	public long getBytes() {
+		return this.bytes;
+	}
+
+	/**
+	 * @return total time spent in the function, in nanoseconds
+	 */
+	public long getTotalNanos() {
+		return this.totalNanos;
+	}
+
+	/**
+	 * @return the longest single call, in nanoseconds
+	 */
+	public long getMaxNanos() {
+		return this.maxNanos;
+	}
+
+	/**
+	 * @return the mean latency in nanoseconds, 0 if never called
+	 */
+	public long getMeanNanos() {
+		return this.calls == 0 ? 0 : this.totalNanos / this.calls;
+	}
+
+	/**
+	 * Estimate a latency percentile from the histogram
+	 *
+	 * @param percentile
+	 *            the percentile, between 0 and 100
+	 * @return the upper bound of the bucket the percentile falls in, in
+	 *         nanoseconds, never more than {@link #getMaxNanos()}. 0 if never
+	 *         called.
+	 */
+	public long getPercentileNanos(double percentile) {
+		long total = 0;
+
+		for (long count : this.buckets) {
+			total += count;
+		}
+
+		if (total == 0) {
+			return 0;
+		}
+
+		long rank = (long) Math.ceil(total * Math.min(100, Math.max(0, percentile)) / 100);
+		long seen = 0;
+
+		for (int i = 0; i < BUCKETS; i++) {
+			seen += this.buckets[i];
+
+			if (seen >= rank && this.buckets[i] != 0) {
+				long upper = i + 1 < BUCKETS ? bucketLowerBound(i + 1) - 1 : this.maxNanos;
+				return Math.min(upper, this.maxNanos);
+			}
+		}
+
+		return this.maxNanos;
+	}
+
+	@Override
+	public String toString() {
+		return "{\"name\":\"" + this.name + "\",\"calls\":" + this.calls + ",\"bytes\":" + this.bytes
+				+ ",\"total_ns\":" + this.totalNanos + ",\"mean_ns\":" + getMeanNanos() + ",\"p50_ns\":"
+				+ getPercentileNanos(50) + ",\"p99_ns\":" + getPercentileNanos(99) + ",\"max_ns\":" + this.maxNanos
+				+ "}";
+	}
+}
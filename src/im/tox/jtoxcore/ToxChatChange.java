@@ -0,0 +1,42 @@
+/* ToxChatChange.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+package im.tox.jtoxcore;
+
+/**
+ * Enum for the ways the peer list of a group chat can change
+ *
+ * @author sonOfRa
+ *
+ */
+public enum ToxChatChange {
+	/**
+	 * A peer joined the group
+	 */
+	TOX_CHAT_CHANGE_PEER_ADD,
+	/**
+	 * A peer left the group
+	 */
+	TOX_CHAT_CHANGE_PEER_DEL,
+	/**
+	 * A peer changed their name
+	 */
+	TOX_CHAT_CHANGE_PEER_NAME;
+}
@@ -47,4 +47,16 @@ public class ToxCodecSettings {
 		this.audio_sample_rate = asr;
 		this.audio_channels = ac;
 	}
+
+	/**
+	 * Convert these settings to their native form once, for reuse across
+	 * many calls
+	 *
+	 * @return the compiled settings, to be closed when no longer needed
+	 * @throws ToxException
+	 *             if the native settings could not be allocated
+	 */
+	public ToxCompiledCodecSettings compile() throws ToxException {
+		return new ToxCompiledCodecSettings(JTox.compileCodecSettings(this));
+	}
 }
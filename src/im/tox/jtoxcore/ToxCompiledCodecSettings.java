@@ -0,0 +1,76 @@
+/* ToxCompiledCodecSettings.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+package im.tox.jtoxcore;
+
+import java.io.Closeable;
+
+/**
+ * Codec settings already converted to their native form, created with
+ * {@link ToxCodecSettings#compile()}. Passing one to avCall, avAnswer or
+ * avChangeSettings skips reading the settings object field by field, so the
+ * same instance can be reused for any number of calls. Later changes to the
+ * ToxCodecSettings it was compiled from are not seen.
+ *
+ * @author sonOfRa
+ *
+ */
+public final class ToxCompiledCodecSettings implements Closeable {
+
+	private long handle;
+
+	ToxCompiledCodecSettings(long handle) {
+		this.handle = handle;
+	}
+
+	/**
+	 * @return the native handle
+	 * @throws ToxException
+	 *             if the settings were already closed
+	 */
+	long getHandle() throws ToxException {
+		if (this.handle == 0) {
+			throw new ToxException(ToxError.TOX_UNKNOWN);
+		}
+
+		return this.handle;
+	}
+
+	/**
+	 * Free the native settings. Calls made with these settings afterwards
+	 * throw a ToxException.
+	 */
+	@Override
+	public synchronized void close() {
+		if (this.handle != 0) {
+			JTox.freeCodecSettings(this.handle);
+			this.handle = 0;
+		}
+	}
+
+	@Override
+	protected void finalize() throws Throwable {
+		try {
+			close();
+		} finally {
+			super.finalize();
+		}
+	}
+}
@@ -0,0 +1,102 @@
+/* ToxGroupNames.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+package im.tox.jtoxcore;
+
+/**
+ * The names of all peers in a group chat, fetched with a single native call.
+ * The names are packed back to back into one byte array; peer i's name
+ * occupies the bytes from {@link #getOffset(int)} up to, but not including,
+ * getOffset(i + 1). Nothing is decoded until a name is asked for.
+ *
+ * @author sonOfRa
+ *
+ */
+public final class ToxGroupNames {
+
+	private final byte[] names;
+	private final int[] offsets;
+
+	/**
+	 * @param names
+	 *            the UTF-8 encoded names, back to back
+	 * @param offsets
+	 *            start of each name in names, followed by the total length
+	 */
+	ToxGroupNames(byte[] names, int[] offsets) {
+		this.names = names;
+		this.offsets = offsets;
+	}
+
+	/**
+	 * @return the number of peers
+	 */
+	public int size() {
+		return this.offsets.length - 1;
+	}
+
+	/**
+	 * @param peernumber
+	 *            the peer's number
+	 * @return index of the peer's name in {@link #getBuffer()}
+	 */
+	public int getOffset(int peernumber) {
+		return this.offsets[peernumber];
+	}
+
+	/**
+	 * @param peernumber
+	 *            the peer's number
+	 * @return length of the peer's name in bytes
+	 */
+	public int getLength(int peernumber) {
+		return this.offsets[peernumber + 1] - this.offsets[peernumber];
+	}
+
+	/**
+	 * @param peernumber
+	 *            the peer's number
+	 * @return the peer's name
+	 */
+	public String getName(int peernumber) {
+		return JTox.getByteString(this.names, getOffset(peernumber), getLength(peernumber));
+	}
+
+	/**
+	 * @param peernumber
+	 *            the peer's number
+	 * @return a copy of the peer's UTF-8 encoded name
+	 */
+	public byte[] getNameBytes(int peernumber) {
+		byte[] name = new byte[getLength(peernumber)];
+		System.arraycopy(this.names, getOffset(peernumber), name, 0, name.length);
+		return name;
+	}
+
+	/**
+	 * Get the packed names without copying them. The array must not be
+	 * modified.
+	 *
+	 * @return the UTF-8 encoded names, back to back
+	 */
+	public byte[] getBuffer() {
+		return this.names;
+	}
+}
@@ -0,0 +1,462 @@
+/* ToxMessageQueue.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+package im.tox.jtoxcore;
+
+import java.util.ArrayDeque;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.Iterator;
+import java.util.List;
+import java.util.Map;
+
+import im.tox.jtoxcore.callbacks.OnMessageQueueFullCallback;
+import im.tox.jtoxcore.callbacks.OnQueuedMessageFailedCallback;
+import im.tox.jtoxcore.callbacks.OnQueuedMessageSentCallback;
+
+/**
+ * Bounded per-friend queue for outgoing messages. Messages are queued through
+ * {@link JTox#queueMessage(int, byte[])} and sent from within
+ * {@link JTox#doTox()}. A message core refuses to take, for example because
+ * its send queue is full or the friend is offline, stays at the head of the
+ * friend's queue and is retried on the next tick, so order is preserved. If
+ * core refuses because the friend no longer exists, everything queued for it
+ * is dropped and reported to the failed callback.
+ * <p/>
+ * Messages longer than {@link JTox#TOX_MAX_MESSAGE_LENGTH} are split at UTF-8
+ * character boundaries. The capacity and all depths are counted in these
+ * chunks.
+ * <p/>
+ * Each queued message gets an ID from the queue. Once core accepts a chunk,
+ * the sent callback maps that ID to the message ID core assigned, which is
+ * what read receipts carry.
+ *
+ * @author sonOfRa
+ *
+ */
+public final class ToxMessageQueue {
+
+	/**
+	 * Default number of chunks that can be queued for a single friend
+	 */
+	public static final int DEFAULT_CAPACITY = 64;
+
+	/**
+	 * Where {@link #drain(Sender)} sends to. Implemented by JTox on top of
+	 * the native calls.
+	 */
+	interface Sender {
+
+		/**
+		 * @return the message ID core assigned, 0 if it refused the chunk
+		 */
+		int send(int friendnumber, byte[] chunk);
+
+		/**
+		 * @return whether core still knows the friend
+		 */
+		boolean friendExists(int friendnumber);
+	}
+
+	/**
+	 * A queued chunk and the ID of the message it belongs to
+	 */
+	private static final class Chunk {
+		final int id;
+		final byte[] data;
+
+		Chunk(int id, byte[] data) {
+			this.id = id;
+			this.data = data;
+		}
+	}
+
+	private final Map<Integer, ArrayDeque<Chunk>> queues = new HashMap<Integer, ArrayDeque<Chunk>>();
+	private int capacity = DEFAULT_CAPACITY;
+	private ToxBackpressurePolicy policy = ToxBackpressurePolicy.BLOCK;
+	private OnMessageQueueFullCallback queueFullCallback;
+	private OnQueuedMessageSentCallback sentCallback;
+	private OnQueuedMessageFailedCallback failedCallback;
+	private boolean closed;
+	private int nextId = 1;
+
+	private int depth;
+	private int maxDepth;
+	private long sentCount;
+	private long droppedCount;
+	private long retryCount;
+	private long failedCount;
+
+	ToxMessageQueue() {
+	}
+
+	/**
+	 * Split a message into chunks core will accept, without cutting a
+	 * multi-byte character in half
+	 *
+	 * @param message
+	 *            the UTF-8 encoded message
+	 * @return the chunks, in order
+	 */
+	public static List<byte[]> split(byte[] message) {
+		List<byte[]> chunks = new ArrayList<byte[]>();
+		int offset = 0;
+
+		while (message.length - offset > JTox.TOX_MAX_MESSAGE_LENGTH) {
+			int end = offset + JTox.TOX_MAX_MESSAGE_LENGTH;
+
+			// Back off until the next chunk starts on a lead byte
+			while (end > offset && (message[end] & 0xC0) == 0x80) {
+				end--;
+			}
+
+			// Not UTF-8 at all, cut where we have to
+			if (end == offset) {
+				end = offset + JTox.TOX_MAX_MESSAGE_LENGTH;
+			}
+
+			chunks.add(Arrays.copyOfRange(message, offset, end));
+			offset = end;
+		}
+
+		chunks.add(offset == 0 ? message : Arrays.copyOfRange(message, offset, message.length));
+		return chunks;
+	}
+
+	/**
+	 * Queue a message for the given friend, applying the backpressure policy
+	 * if it does not fit. All chunks of a message are queued together or not
+	 * at all.
+	 *
+	 * @param friendnumber
+	 *            the friend to send to
+	 * @param message
+	 *            the UTF-8 encoded message
+	 * @param mayBlock
+	 *            whether the BLOCK policy may wait. Must be false on the
+	 *            thread that drains the queue.
+	 * @return the queue's ID for the message, 0 if it was dropped
+	 * @throws InterruptedException
+	 *             if interrupted while waiting for space
+	 */
+	synchronized int offer(int friendnumber, byte[] message, boolean mayBlock) throws InterruptedException {
+		if (message.length == 0) {
+			throw new IllegalArgumentException("Cannot queue an empty message");
+		}
+
+		List<byte[]> chunks = split(message);
+
+		if (chunks.size() > this.capacity) {
+			throw new IllegalArgumentException("Message needs " + chunks.size() + " chunks, queue capacity is "
+					+ this.capacity);
+		}
+
+		while (!this.closed && getDepth(friendnumber) + chunks.size() > this.capacity) {
+			if (this.policy != ToxBackpressurePolicy.BLOCK || !mayBlock) {
+				this.droppedCount++;
+
+				if (this.policy == ToxBackpressurePolicy.CALLBACK && this.queueFullCallback != null) {
+					this.queueFullCallback.execute(friendnumber, message);
+				}
+
+				return 0;
+			}
+
+			wait();
+		}
+
+		if (this.closed) {
+			this.droppedCount++;
+			return 0;
+		}
+
+		ArrayDeque<Chunk> queue = this.queues.get(friendnumber);
+
+		if (queue == null) {
+			queue = new ArrayDeque<Chunk>();
+			this.queues.put(friendnumber, queue);
+		}
+
+		int id = this.nextId;
+		this.nextId = id == Integer.MAX_VALUE ? 1 : id + 1;
+
+		for (byte[] chunk : chunks) {
+			queue.add(new Chunk(id, chunk));
+		}
+
+		this.depth += chunks.size();
+		this.maxDepth = Math.max(this.maxDepth, this.depth);
+		return id;
+	}
+
+	/**
+	 * Send as much as core accepts. Each friend's queue is sent in order up to
+	 * its first refused chunk, which is retried on the next call, unless the
+	 * friend no longer exists. The sent and failed callbacks run afterwards,
+	 * on the calling thread, without the queue locked. For JTox, the instance
+	 * lock must be held.
+	 *
+	 * @param sender
+	 *            where to send to
+	 */
+	void drain(Sender sender) {
+		List<int[]> sent = new ArrayList<int[]>();
+		List<int[]> failed = new ArrayList<int[]>();
+		OnQueuedMessageSentCallback sentCallback;
+		OnQueuedMessageFailedCallback failedCallback;
+
+		synchronized (this) {
+			boolean freed = false;
+			Iterator<Map.Entry<Integer, ArrayDeque<Chunk>>> it = this.queues.entrySet().iterator();
+
+			while (it.hasNext()) {
+				Map.Entry<Integer, ArrayDeque<Chunk>> entry = it.next();
+				int friendnumber = entry.getKey();
+				ArrayDeque<Chunk> queue = entry.getValue();
+
+				while (!queue.isEmpty()) {
+					Chunk chunk = queue.peekFirst();
+					int messageId = sender.send(friendnumber, chunk.data);
+
+					if (messageId == 0) {
+						if (sender.friendExists(friendnumber)) {
+							this.retryCount++;
+							break;
+						}
+
+						int lastId = 0;
+
+						for (Chunk dropped : queue) {
+							if (dropped.id != lastId) {
+								failed.add(new int[] { friendnumber, dropped.id });
+								lastId = dropped.id;
+							}
+						}
+
+						this.depth -= queue.size();
+						this.failedCount += queue.size();
+						queue.clear();
+						freed = true;
+						break;
+					}
+
+					queue.pollFirst();
+					this.depth--;
+					this.sentCount++;
+					sent.add(new int[] { friendnumber, chunk.id, messageId });
+					freed = true;
+				}
+
+				if (queue.isEmpty()) {
+					it.remove();
+				}
+			}
+
+			if (freed) {
+				notifyAll();
+			}
+
+			sentCallback = this.sentCallback;
+			failedCallback = this.failedCallback;
+		}
+
+		if (sentCallback != null) {
+			for (int[] s : sent) {
+				sentCallback.execute(s[0], s[1], s[2]);
+			}
+		}
+
+		if (failedCallback != null) {
+			for (int[] f : failed) {
+				failedCallback.execute(f[0], f[1]);
+			}
+		}
+	}
+
+	/**
+	 * Drop everything and release any blocked producers. Called when the
+	 * instance is killed.
+	 */
+	synchronized void close() {
+		this.closed = true;
+		clear();
+	}
+
+	/**
+	 * Discard all messages queued for the given friend
+	 *
+	 * @param friendnumber
+	 *            the friend
+	 */
+	public synchronized void clear(int friendnumber) {
+		ArrayDeque<Chunk> queue = this.queues.remove(friendnumber);
+
+		if (queue != null) {
+			this.depth -= queue.size();
+			this.droppedCount += queue.size();
+			notifyAll();
+		}
+	}
+
+	/**
+	 * Discard all queued messages
+	 */
+	public synchronized void clear() {
+		for (ArrayDeque<Chunk> queue : this.queues.values()) {
+			this.droppedCount += queue.size();
+		}
+
+		this.queues.clear();
+		this.depth = 0;
+		notifyAll();
+	}
+
+	/**
+	 * @param friendnumber
+	 *            the friend
+	 * @return number of chunks waiting to be sent to the given friend
+	 */
+	public synchronized int getDepth(int friendnumber) {
+		ArrayDeque<Chunk> queue = this.queues.get(friendnumber);
+		return queue == null ? 0 : queue.size();
+	}
+
+	/**
+	 * @return number of chunks waiting to be sent to all friends
+	 */
+	public synchronized int getDepth() {
+		return this.depth;
+	}
+
+	/**
+	 * @return the highest total depth seen so far
+	 */
+	public synchronized int getMaxDepth() {
+		return this.maxDepth;
+	}
+
+	/**
+	 * @return number of chunks core has accepted from this queue
+	 */
+	public synchronized long getSentCount() {
+		return this.sentCount;
+	}
+
+	/**
+	 * @return number of chunks that were refused by core and kept for a retry
+	 */
+	public synchronized long getRetryCount() {
+		return this.retryCount;
+	}
+
+	/**
+	 * @return number of chunks dropped because their friend no longer exists
+	 */
+	public synchronized long getFailedCount() {
+		return this.failedCount;
+	}
+
+	/**
+	 * @return number of messages rejected because a queue was full, plus
+	 *         chunks discarded by {@link #clear()}
+	 */
+	public synchronized long getDroppedCount() {
+		return this.droppedCount;
+	}
+
+	/**
+	 * @return number of chunks that can be queued per friend
+	 */
+	public synchronized int getCapacity() {
+		return this.capacity;
+	}
+
+	/**
+	 * Set the number of chunks that can be queued per friend. Already queued
+	 * chunks are kept even if they exceed the new capacity.
+	 *
+	 * @param capacity
+	 *            the new capacity, at least 1
+	 */
+	public synchronized void setCapacity(int capacity) {
+		if (capacity < 1) {
+			throw new IllegalArgumentException("Capacity must be at least 1");
+		}
+
+		this.capacity = capacity;
+		notifyAll();
+	}
+
+	/**
+	 * @return what happens when a friend's queue is full
+	 */
+	public synchronized ToxBackpressurePolicy getPolicy() {
+		return this.policy;
+	}
+
+	/**
+	 * Set what happens when a friend's queue is full. Producers already
+	 * blocked are woken up to re-check the policy.
+	 *
+	 * @param policy
+	 *            the new policy
+	 */
+	public synchronized void setPolicy(ToxBackpressurePolicy policy) {
+		this.policy = policy;
+		notifyAll();
+	}
+
+	/**
+	 * Set the callback invoked for rejected messages under the
+	 * {@link ToxBackpressurePolicy#CALLBACK} policy. It runs on the producing
+	 * thread with the queue locked, so it must not queue messages itself.
+	 *
+	 * @param callback
+	 *            the callback, or null to just drop
+	 */
+	public synchronized void setQueueFullCallback(OnMessageQueueFullCallback callback) {
+		this.queueFullCallback = callback;
+	}
+
+	/**
+	 * Set the callback told about each chunk core accepts, with the message
+	 * ID read receipts will carry. A message that was split is reported once
+	 * per chunk, all with the same queue ID.
+	 *
+	 * @param callback
+	 *            the callback, or null for none
+	 */
+	public synchronized void setSentCallback(OnQueuedMessageSentCallback callback) {
+		this.sentCallback = callback;
+	}
+
+	/**
+	 * Set the callback told about messages dropped because their friend no
+	 * longer exists
+	 *
+	 * @param callback
+	 *            the callback, or null for none
+	 */
+	public synchronized void setFailedCallback(OnQueuedMessageFailedCallback callback) {
+		this.failedCallback = callback;
+	}
+}
@@ -0,0 +1,126 @@
+/* ToxNode.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+package im.tox.jtoxcore;
+
+import java.util.Arrays;
+
+/**
+ * A bootstrap node: host name or IP address, port and public key. Nodes are
+ * equal if all three are equal, so they can be used as keys in a
+ * {@link ToxNodeCache}.
+ *
+ * @author sonOfRa
+ *
+ */
+public final class ToxNode {
+
+	private final String host;
+	private final int port;
+	private final byte[] publicKey;
+
+	/**
+	 * Create a new node
+	 *
+	 * @param host
+	 *            Hostname or IP(v4, v6) address of the node
+	 * @param port
+	 *            port the node listens on
+	 * @param publicKey
+	 *            public key of the node, {@link JTox#TOX_CLIENT_ID_SIZE} bytes
+	 */
+	public ToxNode(String host, int port, byte[] publicKey) {
+		if (port < 0 || port > 65535) {
+			throw new IllegalArgumentException("Invalid port " + port);
+		}
+
+		if (publicKey.length != JTox.TOX_CLIENT_ID_SIZE) {
+			throw new IllegalArgumentException("Public key must be " + JTox.TOX_CLIENT_ID_SIZE + " bytes");
+		}
+
+		this.host = host;
+		this.port = port;
+		this.publicKey = publicKey.clone();
+	}
+
+	/**
+	 * Create a new node
+	 *
+	 * @param host
+	 *            Hostname or IP(v4, v6) address of the node
+	 * @param port
+	 *            port the node listens on
+	 * @param publicKey
+	 *            public key of the node as a hexadecimal string
+	 */
+	public ToxNode(String host, int port, String publicKey) {
+		this(host, port, JTox.hexToByteArray(publicKey));
+	}
+
+	/**
+	 * @return the host name or address of this node
+	 */
+	public String getHost() {
+		return this.host;
+	}
+
+	/**
+	 * @return the port of this node
+	 */
+	public int getPort() {
+		return this.port;
+	}
+
+	/**
+	 * @return a copy of the public key of this node
+	 */
+	public byte[] getPublicKey() {
+		return this.publicKey.clone();
+	}
+
+	byte[] publicKey() {
+		return this.publicKey;
+	}
+
+	@Override
+	public boolean equals(Object o) {
+		if (this == o) {
+			return true;
+		}
+
+		if (!(o instanceof ToxNode)) {
+			return false;
+		}
+
+		ToxNode other = (ToxNode) o;
+		return this.port == other.port && this.host.equals(other.host) && Arrays.equals(this.publicKey, other.publicKey);
+	}
+
+	@Override
+	public int hashCode() {
+		return (this.host.hashCode() * 31 + this.port) * 31 + Arrays.hashCode(this.publicKey);
+	}
+
+	@Override
+	public String toString() {
+		return this.host + " " + this.port + " " + JTox.byteArrayToHex(this.publicKey);
+	}
+}
@@ -0,0 +1,273 @@
+/* ToxNodeCache.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+package im.tox.jtoxcore;
+
+import java.io.BufferedReader;
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileNotFoundException;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.InputStreamReader;
+import java.io.OutputStreamWriter;
+import java.io.Writer;
+import java.nio.charset.Charset;
+import java.util.ArrayList;
+import java.util.Collection;
+import java.util.Collections;
+import java.util.Comparator;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * Local cache of bootstrap nodes, ranked by how quickly bootstrapping from
+ * them led to a DHT connection. Set it with
+ * {@link JTox#setNodeCache(ToxNodeCache)}: {@link JTox#bootstrap(List)} then
+ * tries the best ranked nodes first, and once the instance is connected the
+ * time it took is credited to every node of the batch and the cache is written
+ * back to its file.
+ * <p/>
+ * Core does not report which node it reached first, so the ranking only
+ * separates nodes across batches and starts. Nodes that could not be resolved
+ * or never led to a connection sink to the bottom.
+ * <p/>
+ * The file holds one node per line:
+ * <code>host port publickey millis successes failures</code>
+ *
+ * @author sonOfRa
+ *
+ */
+public final class ToxNodeCache {
+
+	private static final Charset UTF8 = Charset.forName("UTF-8");
+
+	/**
+	 * Weight of a new measurement in the moving average, in percent
+	 */
+	private static final int SMOOTHING_PERCENT = 25;
+
+	private final File file;
+	private final Map<ToxNode, Entry> entries = new LinkedHashMap<ToxNode, Entry>();
+
+	private static final class Entry {
+		long millis = -1;
+		int successes;
+		int failures;
+	}
+
+	/**
+	 * Best first: nodes with a measured connect time ordered by that time,
+	 * then unmeasured nodes, then nodes that only ever failed
+	 */
+	private final Comparator<ToxNode> ranking = new Comparator<ToxNode>() {
+		@Override
+		public int compare(ToxNode a, ToxNode b) {
+			int ca = rankClass(a);
+			int cb = rankClass(b);
+
+			if (ca != cb) {
+				return ca < cb ? -1 : 1;
+			}
+
+			Entry ea = ToxNodeCache.this.entries.get(a);
+			Entry eb = ToxNodeCache.this.entries.get(b);
+
+			if (ca == 0) {
+				return ea.millis < eb.millis ? -1 : (ea.millis == eb.millis ? 0 : 1);
+			}
+
+			if (ca == 2) {
+				return ea.failures < eb.failures ? -1 : (ea.failures == eb.failures ? 0 : 1);
+			}
+
+			return 0;
+		}
+	};
+
+	/**
+	 * Create a cache backed by the given file. Call {@link #load()} to read
+	 * nodes from a previous run.
+	 *
+	 * @param file
+	 *            the file to load from and save to
+	 */
+	public ToxNodeCache(File file) {
+		this.file = file;
+	}
+
+	private int rankClass(ToxNode node) {
+		Entry entry = this.entries.get(node);
+
+		if (entry == null || (entry.successes == 0 && entry.failures == 0)) {
+			return 1;
+		}
+
+		return entry.successes > 0 ? 0 : 2;
+	}
+
+	private Entry entry(ToxNode node) {
+		Entry entry = this.entries.get(node);
+
+		if (entry == null) {
+			entry = new Entry();
+			this.entries.put(node, entry);
+		}
+
+		return entry;
+	}
+
+	/**
+	 * Read the cache file. A missing file leaves the cache empty, malformed
+	 * lines are skipped.
+	 *
+	 * @throws IOException
+	 *             if the file exists but could not be read
+	 */
+	public synchronized void load() throws IOException {
+		BufferedReader reader;
+
+		try {
+			reader = new BufferedReader(new InputStreamReader(new FileInputStream(this.file), UTF8));
+		} catch (FileNotFoundException e) {
+			return;
+		}
+
+		try {
+			String line;
+
+			while ((line = reader.readLine()) != null) {
+				String[] fields = line.trim().split("\\s+");
+
+				if (fields.length != 6) {
+					continue;
+				}
+
+				try {
+					Entry entry = entry(new ToxNode(fields[0], Integer.parseInt(fields[1]), fields[2]));
+					entry.millis = Long.parseLong(fields[3]);
+					entry.successes = Integer.parseInt(fields[4]);
+					entry.failures = Integer.parseInt(fields[5]);
+				} catch (IllegalArgumentException e) {
+					// Also covers NumberFormatException
+					continue;
+				}
+			}
+		} finally {
+			reader.close();
+		}
+	}
+
+	/**
+	 * Write the cache file. The nodes are written to a temporary file next to
+	 * it first, which then replaces the old file.
+	 *
+	 * @throws IOException
+	 *             if the file could not be written
+	 */
+	public synchronized void save() throws IOException {
+		File tmp = new File(this.file.getPath() + ".tmp");
+		Writer writer = new OutputStreamWriter(new FileOutputStream(tmp), UTF8);
+
+		try {
+			for (Map.Entry<ToxNode, Entry> e : this.entries.entrySet()) {
+				Entry entry = e.getValue();
+				writer.write(e.getKey() + " " + entry.millis + " " + entry.successes + " " + entry.failures + "\n");
+			}
+		} finally {
+			writer.close();
+		}
+
+		// renameTo does not replace existing files on every platform
+		if (!tmp.renameTo(this.file) && !(this.file.delete() && tmp.renameTo(this.file))) {
+			tmp.delete();
+			throw new IOException("Could not replace " + this.file);
+		}
+	}
+
+	/**
+	 * Order nodes best first. Cached nodes that are not in the given
+	 * collection are included as well, so a client can start from nodes that
+	 * worked before even when its built-in list changed.
+	 *
+	 * @param nodes
+	 *            the nodes the client knows about
+	 * @return the given and cached nodes, best ranked first
+	 */
+	public synchronized List<ToxNode> rank(Collection<ToxNode> nodes) {
+		List<ToxNode> ranked = new ArrayList<ToxNode>(this.entries.keySet());
+
+		for (ToxNode node : nodes) {
+			if (!this.entries.containsKey(node)) {
+				ranked.add(node);
+			}
+		}
+
+		Collections.sort(ranked, this.ranking);
+		return ranked;
+	}
+
+	/**
+	 * Credit a time to connected to every node of a bootstrap batch
+	 *
+	 * @param nodes
+	 *            the nodes that were bootstrapped from
+	 * @param millis
+	 *            milliseconds from bootstrapping to being connected
+	 */
+	public synchronized void recordConnected(Collection<ToxNode> nodes, long millis) {
+		for (ToxNode node : nodes) {
+			Entry entry = entry(node);
+
+			if (entry.millis < 0) {
+				entry.millis = millis;
+			} else {
+				entry.millis += (millis - entry.millis) * SMOOTHING_PERCENT / 100;
+			}
+
+			entry.successes++;
+		}
+	}
+
+	/**
+	 * Record that a node could not be used, for example because its host
+	 * name did not resolve
+	 *
+	 * @param node
+	 *            the node that failed
+	 */
+	public synchronized void recordFailure(ToxNode node) {
+		entry(node).failures++;
+	}
+
+	/**
+	 * Get the smoothed time to connected of a node
+	 *
+	 * @param node
+	 *            the node to look up
+	 * @return the time in milliseconds, or -1 if never measured
+	 */
+	public synchronized long getConnectMillis(ToxNode node) {
+		Entry entry = this.entries.get(node);
+		return entry == null ? -1 : entry.millis;
+	}
+}
@@ -0,0 +1,107 @@
+/* ToxStartupTimeline.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+package im.tox.jtoxcore;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+
+/**
+ * Snapshot of the milestones a tox instance went through on its way from
+ * loading the native library to being fully online, as returned by
+ * {@link JTox#getStartupTimeline()}. Each milestone is recorded once, the
+ * first time it is reached; friends coming online are recorded once per
+ * friend. Events are in the order they were recorded.
+ *
+ * @author sonOfRa
+ *
+ */
+public final class ToxStartupTimeline {
+
+	/**
+	 * Number of values per event in the array returned by the native call
+	 */
+	private static final int FIELDS = 4;
+
+	private final List<ToxTimelineEvent> events;
+
+	ToxStartupTimeline(long[] raw) {
+		List<ToxTimelineEvent> events = new ArrayList<ToxTimelineEvent>(raw.length / FIELDS);
+		ToxTimelineMilestone[] milestones = ToxTimelineMilestone.values();
+
+		for (int i = 0; i + FIELDS <= raw.length; i += FIELDS) {
+			events.add(new ToxTimelineEvent(milestones[(int) raw[i]], (int) raw[i + 1], raw[i + 2], raw[i + 3]));
+		}
+
+		this.events = Collections.unmodifiableList(events);
+	}
+
+	/**
+	 * @return all recorded events, in the order they were recorded
+	 */
+	public List<ToxTimelineEvent> getEvents() {
+		return this.events;
+	}
+
+	/**
+	 * Look up the first event for a milestone
+	 *
+	 * @param milestone
+	 *            the milestone to look for
+	 * @return the event, or null if the milestone has not been reached
+	 */
+	public ToxTimelineEvent get(ToxTimelineMilestone milestone) {
+		for (ToxTimelineEvent event : this.events) {
+			if (event.getMilestone() == milestone) {
+				return event;
+			}
+		}
+
+		return null;
+	}
+
+	/**
+	 * Dump the timeline as a JSON object, for logging or shipping to a
+	 * metrics backend:
+	 * <code>{"unit":"us","events":[{"milestone":"TOX_NEW","start_us":..,"end_us":..},..]}</code>
+	 *
+	 * @return the timeline as JSON
+	 */
+	public String toJson() {
+		StringBuilder sb = new StringBuilder("{\"unit\":\"us\",\"events\":[");
+
+		for (int i = 0; i < this.events.size(); i++) {
+			if (i > 0) {
+				sb.append(',');
+			}
+
+			sb.append(this.events.get(i));
+		}
+
+		return sb.append("]}").toString();
+	}
+
+	@Override
+	public String toString() {
+		return toJson();
+	}
+}
@@ -0,0 +1,96 @@
+/* ToxStats.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+package im.tox.jtoxcore;
+
+import java.util.Collections;
+import java.util.LinkedHashMap;
+import java.util.Map;
+
+/**
+ * Snapshot of the call counters and latency histograms the native library
+ * keeps for every JNI entry point and every callback it dispatches, as
+ * returned by {@link JTox#getStats()}. The counters cover all tox instances
+ * in the process and count from the moment the library was loaded.
+ *
+ * @author sonOfRa
+ *
+ */
+public final class ToxStats {
+
+	private final Map<String, ToxCallStats> calls;
+
+	ToxStats(String[] names, long[] raw) {
+		Map<String, ToxCallStats> calls = new LinkedHashMap<String, ToxCallStats>();
+
+		for (int i = 0; i < names.length; i++) {
+			calls.put(names[i], new ToxCallStats(names[i], raw, i * ToxCallStats.FIELDS));
+		}
+
+		this.calls = Collections.unmodifiableMap(calls);
+	}
+
+	/**
+	 * @return the statistics of every probe, keyed by native function name
+	 */
+	public Map<String, ToxCallStats> getAll() {
+		return this.calls;
+	}
+
+	/**
+	 * @param name
+	 *            native function name, e.g. "tox_do"
+	 * @return the statistics of that function, or null if there is no such
+	 *         probe
+	 */
+	public ToxCallStats get(String name) {
+		return this.calls.get(name);
+	}
+
+	/**
+	 * Dump the statistics of all probes that were called at least once as a
+	 * JSON array
+	 *
+	 * @return the statistics as JSON
+	 */
+	public String toJson() {
+		StringBuilder sb = new StringBuilder("[");
+
+		for (ToxCallStats stats : this.calls.values()) {
+			if (stats.getCalls() == 0) {
+				continue;
+			}
+
+			if (sb.length() > 1) {
+				sb.append(',');
+			}
+
+			sb.append(stats);
+		}
+
+		return sb.append(']').toString();
+	}
+
+	@Override
+	public String toString() {
+		return toJson();
+	}
+}
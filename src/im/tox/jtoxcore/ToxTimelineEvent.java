@@ -0,0 +1,96 @@
+/* ToxTimelineEvent.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+package im.tox.jtoxcore;
+
+/**
+ * A single entry of a {@link ToxStartupTimeline}. Times are in microseconds
+ * on a monotonic clock, relative to the moment the native library started
+ * loading.
+ *
+ * @author sonOfRa
+ *
+ */
+public final class ToxTimelineEvent {
+
+	private final ToxTimelineMilestone milestone;
+	private final int friendnumber;
+	private final long startMicros;
+	private final long endMicros;
+
+	ToxTimelineEvent(ToxTimelineMilestone milestone, int friendnumber, long startMicros, long endMicros) {
+		this.milestone = milestone;
+		this.friendnumber = friendnumber;
+		this.startMicros = startMicros;
+		this.endMicros = endMicros;
+	}
+
+	/**
+	 * @return the milestone that was reached
+	 */
+	public ToxTimelineMilestone getMilestone() {
+		return this.milestone;
+	}
+
+	/**
+	 * @return the friend that came online for
+	 *         {@link ToxTimelineMilestone#FRIEND_CONNECTED}, -1 otherwise
+	 */
+	public int getFriendnumber() {
+		return this.friendnumber;
+	}
+
+	/**
+	 * @return when the step leading to the milestone started
+	 */
+	public long getStartMicros() {
+		return this.startMicros;
+	}
+
+	/**
+	 * @return when the milestone was reached
+	 */
+	public long getEndMicros() {
+		return this.endMicros;
+	}
+
+	/**
+	 * @return how long the step took. Zero for milestones that are observed
+	 *         rather than timed, such as connection changes.
+	 */
+	public long getDurationMicros() {
+		return this.endMicros - this.startMicros;
+	}
+
+	@Override
+	public String toString() {
+		StringBuilder sb = new StringBuilder();
+		sb.append("{\"milestone\":\"").append(this.milestone.name()).append('"');
+
+		if (this.friendnumber >= 0) {
+			sb.append(",\"friend\":").append(this.friendnumber);
+		}
+
+		sb.append(",\"start_us\":").append(this.startMicros);
+		sb.append(",\"end_us\":").append(this.endMicros);
+		return sb.append('}').toString();
+	}
+}
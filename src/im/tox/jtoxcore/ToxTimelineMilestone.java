@@ -0,0 +1,61 @@
+/* ToxTimelineMilestone.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+package im.tox.jtoxcore;
+
+/**
+ * Enum for the milestones recorded in a {@link ToxStartupTimeline}. The order
+ * matches the native recorder.
+ *
+ * @author sonOfRa
+ *
+ */
+public enum ToxTimelineMilestone {
+	/**
+	 * The native library was loaded and initialized
+	 */
+	JNI_ONLOAD,
+	/**
+	 * The messenger was created
+	 */
+	TOX_NEW,
+	/**
+	 * Saved data was loaded into the messenger. Failed loads are not
+	 * recorded.
+	 */
+	TOX_LOAD,
+	/**
+	 * The A/V session was created
+	 */
+	TOXAV_NEW,
+	/**
+	 * The first bootstrap call that the core accepted
+	 */
+	BOOTSTRAP,
+	/**
+	 * The messenger was first connected to the DHT, as seen by doTox
+	 */
+	CONNECTED,
+	/**
+	 * A friend came online for the first time
+	 */
+	FRIEND_CONNECTED;
+}
@@ -21,12 +21,13 @@
 
 package im.tox.jtoxcore.callbacks;
 
-import java.util.ArrayList;
-import java.util.Collections;
+import java.nio.ByteBuffer;
 import java.util.List;
+import java.util.concurrent.atomic.AtomicBoolean;
 
 import im.tox.jtoxcore.FriendList;
 import im.tox.jtoxcore.JTox;
+import im.tox.jtoxcore.ToxChatChange;
 import im.tox.jtoxcore.ToxFriend;
 import im.tox.jtoxcore.ToxFileControl;
 import im.tox.jtoxcore.ToxUserStatus;
@@ -43,49 +44,206 @@ import im.tox.jtoxcore.ToxAvCallbackID;
  */
 public class CallbackHandler<F extends ToxFriend> {
 
-	private List<OnActionCallback<F>> onActionCallbacks;
-	private List<OnConnectionStatusCallback<F>> onConnectionStatusCallbacks;
-	private List<OnFriendRequestCallback> onFriendRequestCallbacks;
-	private List<OnMessageCallback<F>> onMessageCallbacks;
-	private List<OnNameChangeCallback<F>> onNameChangeCallbacks;
-	private List<OnReadReceiptCallback<F>> onReadReceiptCallbacks;
-	private List<OnStatusMessageCallback<F>> onStatusMessageCallbacks;
-	private List<OnUserStatusCallback<F>> onUserStatusCallbacks;
-	private List<OnTypingChangeCallback<F>> onTypingChangeCallbacks;
-	private List<OnFileControlCallback<F>> onFileControlCallbacks;
-	private List<OnFileDataCallback<F>> onFileDataCallbacks;
-	private List<OnFileSendRequestCallback<F>> onFileSendRequestCallbacks;
-	private List<OnAvCallbackCallback<F>> onAvCallbackCallbacks;
-	private List<OnVideoDataCallback<F>> onVideoDataCallbacks;
-	private List<OnAudioDataCallback<F>> onAudioDataCallbacks;
+	/**
+	 * Size of the shared event buffer. The message length limit also bounds
+	 * actions, names and status messages.
+	 */
+	private static final int EVENT_BUFFER_SIZE = JTox.TOX_MAX_MESSAGE_LENGTH;
+
+	/**
+	 * Peer list changes by their native value, which matches the ordinal
+	 */
+	private static final ToxChatChange[] CHAT_CHANGES = ToxChatChange.values();
+
+	/**
+	 * Direct buffer the native library copies incoming messages, actions,
+	 * names and status messages into. Only touched from within tox_do.
+	 */
+	private final ByteBuffer eventBuffer;
+	private final ByteBuffer eventView;
+
+	/**
+	 * Set while a JTox instance uses this handler. Each instance writes the
+	 * event buffer from its own tox_do, so a handler can only serve one.
+	 */
+	private final AtomicBoolean attached = new AtomicBoolean();
+
+	private final CallbackRegistry<OnActionCallback<F>> onActionCallbacks;
+	private final CallbackRegistry<OnRawActionCallback<F>> onRawActionCallbacks;
+	private final CallbackRegistry<OnActionBufferCallback> onActionBufferCallbacks;
+	private final CallbackRegistry<OnConnectionStatusCallback<F>> onConnectionStatusCallbacks;
+	private final CallbackRegistry<OnFriendRequestCallback> onFriendRequestCallbacks;
+	private final CallbackRegistry<OnRawFriendRequestCallback> onRawFriendRequestCallbacks;
+	private final CallbackRegistry<OnMessageCallback<F>> onMessageCallbacks;
+	private final CallbackRegistry<OnRawMessageCallback<F>> onRawMessageCallbacks;
+	private final CallbackRegistry<OnMessageBufferCallback> onMessageBufferCallbacks;
+	private final CallbackRegistry<OnNameChangeCallback<F>> onNameChangeCallbacks;
+	private final CallbackRegistry<OnRawNameChangeCallback<F>> onRawNameChangeCallbacks;
+	private final CallbackRegistry<OnNameChangeBufferCallback> onNameChangeBufferCallbacks;
+	private final CallbackRegistry<OnReadReceiptCallback<F>> onReadReceiptCallbacks;
+	private final CallbackRegistry<OnStatusMessageCallback<F>> onStatusMessageCallbacks;
+	private final CallbackRegistry<OnRawStatusMessageCallback<F>> onRawStatusMessageCallbacks;
+	private final CallbackRegistry<OnStatusMessageBufferCallback> onStatusMessageBufferCallbacks;
+	private final CallbackRegistry<OnUserStatusCallback<F>> onUserStatusCallbacks;
+	private final CallbackRegistry<OnTypingChangeCallback<F>> onTypingChangeCallbacks;
+	private final CallbackRegistry<OnFileControlCallback<F>> onFileControlCallbacks;
+	private final CallbackRegistry<OnFileDataCallback<F>> onFileDataCallbacks;
+	private final CallbackRegistry<OnFileSendRequestCallback<F>> onFileSendRequestCallbacks;
+	private final CallbackRegistry<OnAvCallbackCallback<F>> onAvCallbackCallbacks;
+	private final CallbackRegistry<OnVideoDataCallback<F>> onVideoDataCallbacks;
+	private final CallbackRegistry<OnAudioDataCallback<F>> onAudioDataCallbacks;
+	private final CallbackRegistry<OnGroupInviteCallback<F>> onGroupInviteCallbacks;
+	private final CallbackRegistry<OnGroupMessageCallback> onGroupMessageCallbacks;
+	private final CallbackRegistry<OnRawGroupMessageCallback> onRawGroupMessageCallbacks;
+	private final CallbackRegistry<OnGroupMessageBufferCallback> onGroupMessageBufferCallbacks;
+	private final CallbackRegistry<OnGroupActionCallback> onGroupActionCallbacks;
+	private final CallbackRegistry<OnRawGroupActionCallback> onRawGroupActionCallbacks;
+	private final CallbackRegistry<OnGroupActionBufferCallback> onGroupActionBufferCallbacks;
+	private final CallbackRegistry<OnGroupNamelistChangeCallback> onGroupNamelistChangeCallbacks;
 
 	private FriendList<F> friendlist;
 
+	private volatile CallbackRecorder recorder;
+
 	/**
-	 * Default constructor for CallbackHandler. Initializes all Lists as
-	 * synchronized lists.
+	 * Default constructor for CallbackHandler. Initializes all listener
+	 * registries as empty copy-on-write registries.
 	 *
 	 * @param friendlist
 	 *            the friendlist of the jtox instance that this handler is
 	 *            attached to
 	 */
+	@SuppressWarnings("unchecked")
 	public CallbackHandler(FriendList<F> friendlist) {
 		this.friendlist = friendlist;
-		this.onActionCallbacks = Collections.synchronizedList(new ArrayList<OnActionCallback<F>>());
-		this.onConnectionStatusCallbacks = Collections.synchronizedList(new ArrayList<OnConnectionStatusCallback<F>>());
-		this.onFriendRequestCallbacks = Collections.synchronizedList(new ArrayList<OnFriendRequestCallback>());
-		this.onMessageCallbacks = Collections.synchronizedList(new ArrayList<OnMessageCallback<F>>());
-		this.onNameChangeCallbacks = Collections.synchronizedList(new ArrayList<OnNameChangeCallback<F>>());
-		this.onReadReceiptCallbacks = Collections.synchronizedList(new ArrayList<OnReadReceiptCallback<F>>());
-		this.onStatusMessageCallbacks = Collections.synchronizedList(new ArrayList<OnStatusMessageCallback<F>>());
-		this.onUserStatusCallbacks = Collections.synchronizedList(new ArrayList<OnUserStatusCallback<F>>());
-		this.onTypingChangeCallbacks = Collections.synchronizedList(new ArrayList<OnTypingChangeCallback<F>>());
-		this.onFileControlCallbacks = Collections.synchronizedList(new ArrayList<OnFileControlCallback<F>>());
-		this.onFileDataCallbacks = Collections.synchronizedList(new ArrayList<OnFileDataCallback<F>>());
-		this.onFileSendRequestCallbacks = Collections.synchronizedList(new ArrayList<OnFileSendRequestCallback<F>>());
-		this.onAvCallbackCallbacks = Collections.synchronizedList(new ArrayList<OnAvCallbackCallback<F>>());
-		this.onVideoDataCallbacks = Collections.synchronizedList(new ArrayList<OnVideoDataCallback<F>>());
-		this.onAudioDataCallbacks = Collections.synchronizedList(new ArrayList<OnAudioDataCallback<F>>());
+		this.eventBuffer = ByteBuffer.allocateDirect(EVENT_BUFFER_SIZE);
+		this.eventView = this.eventBuffer.asReadOnlyBuffer();
+		this.onActionCallbacks = new CallbackRegistry<OnActionCallback<F>>(new OnActionCallback[0]);
+		this.onRawActionCallbacks = new CallbackRegistry<OnRawActionCallback<F>>(new OnRawActionCallback[0]);
+		this.onActionBufferCallbacks = new CallbackRegistry<OnActionBufferCallback>(new OnActionBufferCallback[0]);
+		this.onConnectionStatusCallbacks = new CallbackRegistry<OnConnectionStatusCallback<F>>(new OnConnectionStatusCallback[0]);
+		this.onFriendRequestCallbacks = new CallbackRegistry<OnFriendRequestCallback>(new OnFriendRequestCallback[0]);
+		this.onRawFriendRequestCallbacks = new CallbackRegistry<OnRawFriendRequestCallback>(new OnRawFriendRequestCallback[0]);
+		this.onMessageCallbacks = new CallbackRegistry<OnMessageCallback<F>>(new OnMessageCallback[0]);
+		this.onRawMessageCallbacks = new CallbackRegistry<OnRawMessageCallback<F>>(new OnRawMessageCallback[0]);
+		this.onMessageBufferCallbacks = new CallbackRegistry<OnMessageBufferCallback>(new OnMessageBufferCallback[0]);
+		this.onNameChangeCallbacks = new CallbackRegistry<OnNameChangeCallback<F>>(new OnNameChangeCallback[0]);
+		this.onRawNameChangeCallbacks = new CallbackRegistry<OnRawNameChangeCallback<F>>(new OnRawNameChangeCallback[0]);
+		this.onNameChangeBufferCallbacks = new CallbackRegistry<OnNameChangeBufferCallback>(new OnNameChangeBufferCallback[0]);
+		this.onReadReceiptCallbacks = new CallbackRegistry<OnReadReceiptCallback<F>>(new OnReadReceiptCallback[0]);
+		this.onStatusMessageCallbacks = new CallbackRegistry<OnStatusMessageCallback<F>>(new OnStatusMessageCallback[0]);
+		this.onRawStatusMessageCallbacks = new CallbackRegistry<OnRawStatusMessageCallback<F>>(new OnRawStatusMessageCallback[0]);
+		this.onStatusMessageBufferCallbacks = new CallbackRegistry<OnStatusMessageBufferCallback>(new OnStatusMessageBufferCallback[0]);
+		this.onUserStatusCallbacks = new CallbackRegistry<OnUserStatusCallback<F>>(new OnUserStatusCallback[0]);
+		this.onTypingChangeCallbacks = new CallbackRegistry<OnTypingChangeCallback<F>>(new OnTypingChangeCallback[0]);
+		this.onFileControlCallbacks = new CallbackRegistry<OnFileControlCallback<F>>(new OnFileControlCallback[0]);
+		this.onFileDataCallbacks = new CallbackRegistry<OnFileDataCallback<F>>(new OnFileDataCallback[0]);
+		this.onFileSendRequestCallbacks = new CallbackRegistry<OnFileSendRequestCallback<F>>(new OnFileSendRequestCallback[0]);
+		this.onAvCallbackCallbacks = new CallbackRegistry<OnAvCallbackCallback<F>>(new OnAvCallbackCallback[0]);
+		this.onVideoDataCallbacks = new CallbackRegistry<OnVideoDataCallback<F>>(new OnVideoDataCallback[0]);
+		this.onAudioDataCallbacks = new CallbackRegistry<OnAudioDataCallback<F>>(new OnAudioDataCallback[0]);
+		this.onGroupInviteCallbacks = new CallbackRegistry<OnGroupInviteCallback<F>>(new OnGroupInviteCallback[0]);
+		this.onGroupMessageCallbacks = new CallbackRegistry<OnGroupMessageCallback>(new OnGroupMessageCallback[0]);
+		this.onRawGroupMessageCallbacks = new CallbackRegistry<OnRawGroupMessageCallback>(new OnRawGroupMessageCallback[0]);
+		this.onGroupMessageBufferCallbacks = new CallbackRegistry<OnGroupMessageBufferCallback>(new OnGroupMessageBufferCallback[0]);
+		this.onGroupActionCallbacks = new CallbackRegistry<OnGroupActionCallback>(new OnGroupActionCallback[0]);
+		this.onRawGroupActionCallbacks = new CallbackRegistry<OnRawGroupActionCallback>(new OnRawGroupActionCallback[0]);
+		this.onGroupActionBufferCallbacks = new CallbackRegistry<OnGroupActionBufferCallback>(new OnGroupActionBufferCallback[0]);
+		this.onGroupNamelistChangeCallbacks = new CallbackRegistry<OnGroupNamelistChangeCallback>(new OnGroupNamelistChangeCallback[0]);
+	}
+
+	/**
+	 * Reset the read-only view of the event buffer to cover the given number
+	 * of bytes
+	 *
+	 * @param length
+	 *            number of valid bytes in the event buffer
+	 * @return the view, positioned at 0 and limited to length
+	 */
+	private ByteBuffer eventView(int length) {
+		this.eventView.clear();
+		this.eventView.limit(length);
+		return this.eventView;
+	}
+
+	/**
+	 * Claim this handler for a JTox instance. Called by the JTox constructor.
+	 *
+	 * @throws IllegalArgumentException
+	 *             if another live JTox instance already uses this handler
+	 */
+	public void attach() {
+		if (!this.attached.compareAndSet(false, true)) {
+			throw new IllegalArgumentException("CallbackHandler is already used by another JTox instance");
+		}
+	}
+
+	/**
+	 * Release this handler, so another JTox instance can use it. Called when
+	 * the instance is killed.
+	 */
+	public void detach() {
+		this.attached.set(false);
+	}
+
+	/**
+	 * Start or stop recording the callbacks this handler receives
+	 *
+	 * @param recorder
+	 *            the recorder to write to, or null to stop recording
+	 */
+	public void setRecorder(CallbackRecorder recorder) {
+		this.recorder = recorder;
+	}
+
+	/**
+	 * @return the current recorder, or null if not recording
+	 */
+	public CallbackRecorder getRecorder() {
+		return this.recorder;
+	}
+
+	/**
+	 * Copy data into the event buffer, as the native library does before
+	 * invoking a buffered hook. Used by {@link CallbackReplayer}.
+	 *
+	 * @param data
+	 *            the bytes to place at the start of the buffer
+	 * @param length
+	 *            number of bytes to copy
+	 * @return number of bytes copied, which is what the hook must be passed:
+	 *         length, clamped to the size of the buffer
+	 */
+	int fillEventBuffer(byte[] data, int length) {
+		int filled = Math.min(length, EVENT_BUFFER_SIZE);
+
+		this.eventBuffer.clear();
+		this.eventBuffer.put(data, 0, filled);
+		return filled;
+	}
+
+	/**
+	 * Make sure a friend exists in the friend list, so replayed events for
+	 * friends that are not known locally can be dispatched
+	 *
+	 * @param friendnumber
+	 *            the friend number from the log
+	 */
+	void ensureFriend(int friendnumber) {
+		this.friendlist.addFriendIfNotExists(friendnumber);
+	}
+
+	/**
+	 * Copy the current contents of the event buffer into a new array
+	 *
+	 * @param length
+	 *            number of valid bytes in the event buffer
+	 * @return a copy of the bytes
+	 */
+	private byte[] eventBytes(int length) {
+		byte[] bytes = new byte[length];
+		eventView(length).get(bytes);
+		return bytes;
 	}
 
 	/**
@@ -93,18 +251,41 @@ public class CallbackHandler<F extends ToxFriend> {
 	 *
 	 * @param friendnumber
 	 *            friend who sent the action
-	 * @param action
-	 *            the action
+	 * @param length
+	 *            length of the action in the event buffer
 	 */
-	@SuppressWarnings("unused")
-	private void onAction(int friendnumber, byte[] action) {
-		String actionString = JTox.getByteString(action);
+	void onAction(int friendnumber, int length) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.buffered(CallbackRecorder.ACTION, friendnumber, this.eventBuffer, length);
+		}
+
+		for (OnActionBufferCallback callback : this.onActionBufferCallbacks.snapshot()) {
+			callback.execute(friendnumber, eventView(length), 0, length);
+		}
+
+		if (this.onRawActionCallbacks.isEmpty() && this.onActionCallbacks.isEmpty()) {
+			return;
+		}
+
+		byte[] action = eventBytes(length);
 		F friend = this.friendlist.getByFriendNumber(friendnumber);
 
-		synchronized (this.onActionCallbacks) {
-			for (OnActionCallback<F> callback : this.onActionCallbacks) {
-				callback.execute(friend, actionString);
-			}
+		for (OnRawActionCallback<F> callback : this.onRawActionCallbacks.snapshot()) {
+			callback.execute(friend, action);
+		}
+
+		OnActionCallback<F>[] callbacks = this.onActionCallbacks.snapshot();
+
+		if (callbacks.length == 0) {
+			return;
+		}
+
+		String actionString = JTox.getByteString(action);
+
+		for (OnActionCallback<F> callback : callbacks) {
+			callback.execute(friend, actionString);
 		}
 	}
 
@@ -143,9 +324,7 @@ public class CallbackHandler<F extends ToxFriend> {
 	 *            callbacks to add
 	 */
 	public <T extends OnActionCallback<F>> void registerOnActionCallbacks(List<T> callbacks) {
-		for (T callback : callbacks) {
-			registerOnActionCallback(callback);
-		}
+		this.onActionCallbacks.addAll(callbacks);
 	}
 
 	/**
@@ -160,6 +339,62 @@ public class CallbackHandler<F extends ToxFriend> {
 		registerOnActionCallbacks(callbacks);
 	}
 
+	/**
+	 * Add the specified callback for receiving actions as UTF-8 bytes
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnRawActionCallback(OnRawActionCallback<F> callback) {
+		this.onRawActionCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback for receiving actions as UTF-8 bytes
+	 *
+	 * @param callback
+	 *            callback to remove
+	 */
+	public void unregisterOnRawActionCallback(OnRawActionCallback<F> callback) {
+		this.onRawActionCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks for receiving actions as UTF-8 bytes
+	 */
+	public void clearOnRawActionCallbacks() {
+		this.onRawActionCallbacks.clear();
+	}
+
+	/**
+	 * Add the specified callback for receiving actions from the shared event
+	 * buffer
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnActionBufferCallback(OnActionBufferCallback callback) {
+		this.onActionBufferCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback for receiving actions from the shared
+	 * event buffer
+	 *
+	 * @param callback
+	 *            callback to remove
+	 */
+	public void unregisterOnActionBufferCallback(OnActionBufferCallback callback) {
+		this.onActionBufferCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks for receiving actions from the shared event buffer
+	 */
+	public void clearOnActionBufferCallbacks() {
+		this.onActionBufferCallbacks.clear();
+	}
+
 	/**
 	 * Hook for native API to invoke callback methods
 	 *
@@ -168,15 +403,18 @@ public class CallbackHandler<F extends ToxFriend> {
 	 * @param online
 	 *            friend's status
 	 */
-	@SuppressWarnings("unused")
-	private void onConnectionStatus(int friendnumber, boolean online) {
+	void onConnectionStatus(int friendnumber, boolean online) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.friendFlag(CallbackRecorder.CONNECTION_STATUS, friendnumber, online ? 1 : 0);
+		}
+
 		F friend = this.friendlist.getByFriendNumber(friendnumber);
 		friend.setOnline(online);
 
-		synchronized (this.onConnectionStatusCallbacks) {
-			for (OnConnectionStatusCallback<F> cb : this.onConnectionStatusCallbacks) {
-				cb.execute(friend, online);
-			}
+		for (OnConnectionStatusCallback<F> cb : this.onConnectionStatusCallbacks.snapshot()) {
+			cb.execute(friend, online);
 		}
 	}
 
@@ -215,9 +453,7 @@ public class CallbackHandler<F extends ToxFriend> {
 	 *            callbacks to set
 	 */
 	public <T extends OnConnectionStatusCallback<F>> void registerOnConnectionStatusCallbacks(List<T> callbacks) {
-		for (T callback : callbacks) {
-			registerOnConnectionStatusCallback(callback);
-		}
+		this.onConnectionStatusCallbacks.addAll(callbacks);
 	}
 
 	/**
@@ -233,21 +469,36 @@ public class CallbackHandler<F extends ToxFriend> {
 	}
 
 	/**
-	 * Hook for native API to invoke callback methods
+	 * Hook for native API to invoke callback methods. The public key is only
+	 * hex encoded if a String based callback is registered.
 	 *
 	 * @param publicKey
-	 *            the public key of the friend
+	 *            the binary public key of the friend
 	 * @param message
 	 *            the message they sent with the request
 	 */
-	@SuppressWarnings("unused")
-	private void onFriendRequest(String publicKey, byte[] message) {
+	void onFriendRequest(byte[] publicKey, byte[] message) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.friendRequest(publicKey, message);
+		}
+
+		for (OnRawFriendRequestCallback cb : this.onRawFriendRequestCallbacks.snapshot()) {
+			cb.execute(publicKey, message);
+		}
+
+		OnFriendRequestCallback[] callbacks = this.onFriendRequestCallbacks.snapshot();
+
+		if (callbacks.length == 0) {
+			return;
+		}
+
+		String publicKeyString = JTox.byteArrayToHex(publicKey);
 		String messageString = JTox.getByteString(message);
 
-		synchronized (this.onFriendRequestCallbacks) {
-			for (OnFriendRequestCallback cb : this.onFriendRequestCallbacks) {
-				cb.execute(publicKey, messageString);
-			}
+		for (OnFriendRequestCallback cb : callbacks) {
+			cb.execute(publicKeyString, messageString);
 		}
 	}
 
@@ -285,9 +536,7 @@ public class CallbackHandler<F extends ToxFriend> {
 	 *            callbacks to add
 	 */
 	public <T extends OnFriendRequestCallback> void registerOnFriendRequestCallbacks(List<T> callbacks) {
-		for (T callback : callbacks) {
-			registerOnFriendRequestCallback(callback);
-		}
+		this.onFriendRequestCallbacks.addAll(callbacks);
 	}
 
 	/**
@@ -301,6 +550,33 @@ public class CallbackHandler<F extends ToxFriend> {
 		registerOnFriendRequestCallbacks(callbacks);
 	}
 
+	/**
+	 * Add the specified binary friend request callback
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnRawFriendRequestCallback(OnRawFriendRequestCallback callback) {
+		this.onRawFriendRequestCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified binary friend request callback
+	 *
+	 * @param callback
+	 *            callback to remove
+	 */
+	public void unregisterOnRawFriendRequestCallback(OnRawFriendRequestCallback callback) {
+		this.onRawFriendRequestCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all binary friend request callbacks
+	 */
+	public void clearOnRawFriendRequestCallbacks() {
+		this.onRawFriendRequestCallbacks.clear();
+	}
+
 	/**
 	 * Hook for native API to invoke callback methods
 	 *
@@ -309,8 +585,13 @@ public class CallbackHandler<F extends ToxFriend> {
 	 * @param message
 	 *            the message
 	 */
-	@SuppressWarnings("unused")
-	private void onFileControl(int friendnumber, int receive_send, int file_number, ToxFileControl control_type, byte[] data) {
+	void onFileControl(int friendnumber, int receive_send, int file_number, ToxFileControl control_type, byte[] data) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.fileControl(friendnumber, receive_send, file_number, control_type, data);
+		}
+
 		F friend = this.friendlist.getByFriendNumber(friendnumber);
 		boolean sending;
 
@@ -320,10 +601,8 @@ public class CallbackHandler<F extends ToxFriend> {
 			sending = false;
 		}
 
-		synchronized (this.onMessageCallbacks) {
-			for (OnFileControlCallback<F> cb : this.onFileControlCallbacks) {
-				cb.execute(friend, sending, file_number, control_type, data);
-			}
+		for (OnFileControlCallback<F> cb : this.onFileControlCallbacks.snapshot()) {
+			cb.execute(friend, sending, file_number, control_type, data);
 		}
 	}
 
@@ -361,9 +640,7 @@ public class CallbackHandler<F extends ToxFriend> {
 	 *            callbacks to add
 	 */
 	public <T extends OnFileControlCallback<F>> void registerOnFileControlCallbacks(List<T> callbacks) {
-		for (T callback : callbacks) {
-			registerOnFileControlCallback(callback);
-		}
+		this.onFileControlCallbacks.addAll(callbacks);
 	}
 
 	/**
@@ -384,14 +661,17 @@ public class CallbackHandler<F extends ToxFriend> {
 	 * @param message
 	 *            the message
 	 */
-	@SuppressWarnings("unused")
-	private void onFileData(int friendnumber, int filenumber, byte[] data) {
+	void onFileData(int friendnumber, int filenumber, byte[] data) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.fileData(friendnumber, filenumber, data);
+		}
+
 		F friend = this.friendlist.getByFriendNumber(friendnumber);
 
-		synchronized (this.onMessageCallbacks) {
-			for (OnFileDataCallback<F> cb : this.onFileDataCallbacks) {
-				cb.execute(friend, filenumber, data);
-			}
+		for (OnFileDataCallback<F> cb : this.onFileDataCallbacks.snapshot()) {
+			cb.execute(friend, filenumber, data);
 		}
 	}
 
@@ -429,9 +709,7 @@ public class CallbackHandler<F extends ToxFriend> {
 	 *            callbacks to add
 	 */
 	public <T extends OnFileDataCallback<F>> void registerOnFileDataCallbacks(List<T> callbacks) {
-		for (T callback : callbacks) {
-			registerOnFileDataCallback(callback);
-		}
+		this.onFileDataCallbacks.addAll(callbacks);
 	}
 
 	/**
@@ -452,14 +730,17 @@ public class CallbackHandler<F extends ToxFriend> {
 	 * @param message
 	 *            the message
 	 */
-	@SuppressWarnings("unused")
-	private void onFileSendRequest(int friendnumber, int filenumber, long filesize, byte[] filename) {
+	void onFileSendRequest(int friendnumber, int filenumber, long filesize, byte[] filename) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.fileSendRequest(friendnumber, filenumber, filesize, filename);
+		}
+
 		F friend = this.friendlist.getByFriendNumber(friendnumber);
 
-		synchronized (this.onMessageCallbacks) {
-			for (OnFileSendRequestCallback<F> cb : this.onFileSendRequestCallbacks) {
-				cb.execute(friend, filenumber, filesize, filename);
-			}
+		for (OnFileSendRequestCallback<F> cb : this.onFileSendRequestCallbacks.snapshot()) {
+			cb.execute(friend, filenumber, filesize, filename);
 		}
 	}
 
@@ -497,9 +778,7 @@ public class CallbackHandler<F extends ToxFriend> {
 	 *            callbacks to add
 	 */
 	public <T extends OnFileSendRequestCallback<F>> void registerOnFileSendRequestCallbacks(List<T> callbacks) {
-		for (T callback : callbacks) {
-			registerOnFileSendRequestCallback(callback);
-		}
+		this.onFileSendRequestCallbacks.addAll(callbacks);
 	}
 
 	/**
@@ -517,18 +796,41 @@ public class CallbackHandler<F extends ToxFriend> {
 	 *
 	 * @param friendnumber
 	 *            the friend who sent the message
-	 * @param message
-	 *            the message
+	 * @param length
+	 *            length of the message in the event buffer
 	 */
-	@SuppressWarnings("unused")
-	private void onMessage(int friendnumber, byte[] message) {
+	void onMessage(int friendnumber, int length) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.buffered(CallbackRecorder.MESSAGE, friendnumber, this.eventBuffer, length);
+		}
+
+		for (OnMessageBufferCallback callback : this.onMessageBufferCallbacks.snapshot()) {
+			callback.execute(friendnumber, eventView(length), 0, length);
+		}
+
+		if (this.onRawMessageCallbacks.isEmpty() && this.onMessageCallbacks.isEmpty()) {
+			return;
+		}
+
+		byte[] message = eventBytes(length);
 		F friend = this.friendlist.getByFriendNumber(friendnumber);
+
+		for (OnRawMessageCallback<F> cb : this.onRawMessageCallbacks.snapshot()) {
+			cb.execute(friend, message);
+		}
+
+		OnMessageCallback<F>[] callbacks = this.onMessageCallbacks.snapshot();
+
+		if (callbacks.length == 0) {
+			return;
+		}
+
 		String messageString = JTox.getByteString(message);
 
-		synchronized (this.onMessageCallbacks) {
-			for (OnMessageCallback<F> cb : this.onMessageCallbacks) {
-				cb.execute(friend, messageString);
-			}
+		for (OnMessageCallback<F> cb : callbacks) {
+			cb.execute(friend, messageString);
 		}
 	}
 
@@ -566,9 +868,7 @@ public class CallbackHandler<F extends ToxFriend> {
 	 *            callbacks to add
 	 */
 	public <T extends OnMessageCallback<F>> void registerOnMessageCallbacks(List<T> callbacks) {
-		for (T callback : callbacks) {
-			registerOnMessageCallback(callback);
-		}
+		this.onMessageCallbacks.addAll(callbacks);
 	}
 
 	/**
@@ -582,24 +882,94 @@ public class CallbackHandler<F extends ToxFriend> {
 		registerOnMessageCallbacks(callbacks);
 	}
 
+	/**
+	 * Add the specified callback for receiving messages as UTF-8 bytes
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnRawMessageCallback(OnRawMessageCallback<F> callback) {
+		this.onRawMessageCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback for receiving messages as UTF-8 bytes
+	 *
+	 * @param callback
+	 *            callback to remove
+	 */
+	public void unregisterOnRawMessageCallback(OnRawMessageCallback<F> callback) {
+		this.onRawMessageCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks for receiving messages as UTF-8 bytes
+	 */
+	public void clearOnRawMessageCallbacks() {
+		this.onRawMessageCallbacks.clear();
+	}
+
+	/**
+	 * Add the specified callback for receiving messages from the shared event
+	 * buffer
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnMessageBufferCallback(OnMessageBufferCallback callback) {
+		this.onMessageBufferCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback for receiving messages from the shared
+	 * event buffer
+	 *
+	 * @param callback
+	 *            callback to remove
+	 */
+	public void unregisterOnMessageBufferCallback(OnMessageBufferCallback callback) {
+		this.onMessageBufferCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks for receiving messages from the shared event buffer
+	 */
+	public void clearOnMessageBufferCallbacks() {
+		this.onMessageBufferCallbacks.clear();
+	}
+
 	/**
 	 * Hook for native API to invoke callback methods
 	 *
 	 * @param friendnumber
 	 *            friend who changed their name
-	 * @param newname
-	 *            friend's new name
+	 * @param length
+	 *            length of the friend's new name in the event buffer
 	 */
-	@SuppressWarnings("unused")
-	private void onNameChange(int friendnumber, byte[] newname) {
+	void onNameChange(int friendnumber, int length) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.buffered(CallbackRecorder.NAME_CHANGE, friendnumber, this.eventBuffer, length);
+		}
+
+		for (OnNameChangeBufferCallback callback : this.onNameChangeBufferCallbacks.snapshot()) {
+			callback.execute(friendnumber, eventView(length), 0, length);
+		}
+
+		// The friend list always has to be kept up to date, so the name is
+		// decoded even without further listeners
+		byte[] newname = eventBytes(length);
 		F friend = this.friendlist.getByFriendNumber(friendnumber);
 		String newnameString = JTox.getByteString(newname);
 		friend.setName(newnameString);
 
-		synchronized (this.onNameChangeCallbacks) {
-			for (OnNameChangeCallback<F> cb : this.onNameChangeCallbacks) {
-				cb.execute(friend, newnameString);
-			}
+		for (OnRawNameChangeCallback<F> cb : this.onRawNameChangeCallbacks.snapshot()) {
+			cb.execute(friend, newname);
+		}
+
+		for (OnNameChangeCallback<F> cb : this.onNameChangeCallbacks.snapshot()) {
+			cb.execute(friend, newnameString);
 		}
 	}
 
@@ -637,9 +1007,7 @@ public class CallbackHandler<F extends ToxFriend> {
 	 *            callbacks to add
 	 */
 	public <T extends OnNameChangeCallback<F>> void addOnNameChangeCallbacks(List<T> callbacks) {
-		for (T callback : callbacks) {
-			registerOnNameChangeCallback(callback);
-		}
+		this.onNameChangeCallbacks.addAll(callbacks);
 	}
 
 	/**
@@ -653,6 +1021,62 @@ public class CallbackHandler<F extends ToxFriend> {
 		addOnNameChangeCallbacks(callbacks);
 	}
 
+	/**
+	 * Add the specified callback for receiving name changes as UTF-8 bytes
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnRawNameChangeCallback(OnRawNameChangeCallback<F> callback) {
+		this.onRawNameChangeCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback for receiving name changes as UTF-8 bytes
+	 *
+	 * @param callback
+	 *            callback to remove
+	 */
+	public void unregisterOnRawNameChangeCallback(OnRawNameChangeCallback<F> callback) {
+		this.onRawNameChangeCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks for receiving name changes as UTF-8 bytes
+	 */
+	public void clearOnRawNameChangeCallbacks() {
+		this.onRawNameChangeCallbacks.clear();
+	}
+
+	/**
+	 * Add the specified callback for receiving name changes from the shared event
+	 * buffer
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnNameChangeBufferCallback(OnNameChangeBufferCallback callback) {
+		this.onNameChangeBufferCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback for receiving name changes from the shared
+	 * event buffer
+	 *
+	 * @param callback
+	 *            callback to remove
+	 */
+	public void unregisterOnNameChangeBufferCallback(OnNameChangeBufferCallback callback) {
+		this.onNameChangeBufferCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks for receiving name changes from the shared event buffer
+	 */
+	public void clearOnNameChangeBufferCallbacks() {
+		this.onNameChangeBufferCallbacks.clear();
+	}
+
 	/**
 	 * Hook for native API to invoke callback methods
 	 *
@@ -661,14 +1085,17 @@ public class CallbackHandler<F extends ToxFriend> {
 	 * @param receipt
 	 *            number of the receipt
 	 */
-	@SuppressWarnings("unused")
-	private void onReadReceipt(int friendnumber, int receipt) {
+	void onReadReceipt(int friendnumber, int receipt) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.friendFlag(CallbackRecorder.READ_RECEIPT, friendnumber, receipt);
+		}
+
 		F friend = this.friendlist.getByFriendNumber(friendnumber);
 
-		synchronized (this.onReadReceiptCallbacks) {
-			for (OnReadReceiptCallback<F> cb : this.onReadReceiptCallbacks) {
-				cb.execute(friend, receipt);
-			}
+		for (OnReadReceiptCallback<F> cb : this.onReadReceiptCallbacks.snapshot()) {
+			cb.execute(friend, receipt);
 		}
 	}
 
@@ -706,9 +1133,7 @@ public class CallbackHandler<F extends ToxFriend> {
 	 *            callbacks to add
 	 */
 	public <T extends OnReadReceiptCallback<F>> void registerOnReadReceiptCallbacks(List<T> callbacks) {
-		for (T callback : callbacks) {
-			registerOnReadReceiptCallback(callback);
-		}
+		this.onReadReceiptCallbacks.addAll(callbacks);
 	}
 
 	/**
@@ -727,19 +1152,31 @@ public class CallbackHandler<F extends ToxFriend> {
 	 *
 	 * @param friendnumber
 	 *            the friend who changed their method
-	 * @param statusmessage
-	 *            the friend's new status message
+	 * @param length
+	 *            length of the friend's new status message in the event buffer
 	 */
-	@SuppressWarnings("unused")
-	private void onStatusMessage(int friendnumber, byte[] statusmessage) {
+	void onStatusMessage(int friendnumber, int length) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.buffered(CallbackRecorder.STATUS_MESSAGE, friendnumber, this.eventBuffer, length);
+		}
+
+		for (OnStatusMessageBufferCallback callback : this.onStatusMessageBufferCallbacks.snapshot()) {
+			callback.execute(friendnumber, eventView(length), 0, length);
+		}
+
+		byte[] statusmessage = eventBytes(length);
 		String newStatus = JTox.getByteString(statusmessage);
 		F friend = this.friendlist.getByFriendNumber(friendnumber);
 		friend.setStatusMessage(newStatus);
 
-		synchronized (this.onStatusMessageCallbacks) {
-			for (OnStatusMessageCallback<F> cb : this.onStatusMessageCallbacks) {
-				cb.execute(friend, newStatus);
-			}
+		for (OnRawStatusMessageCallback<F> cb : this.onRawStatusMessageCallbacks.snapshot()) {
+			cb.execute(friend, statusmessage);
+		}
+
+		for (OnStatusMessageCallback<F> cb : this.onStatusMessageCallbacks.snapshot()) {
+			cb.execute(friend, newStatus);
 		}
 	}
 
@@ -777,9 +1214,7 @@ public class CallbackHandler<F extends ToxFriend> {
 	 *            callbacks to add
 	 */
 	public <T extends OnStatusMessageCallback<F>> void registerOnStatusMessageCallbacks(List<T> callbacks) {
-		for (T callback : callbacks) {
-			registerOnStatusMessageCallback(callback);
-		}
+		this.onStatusMessageCallbacks.addAll(callbacks);
 	}
 
 	/**
@@ -794,22 +1229,81 @@ public class CallbackHandler<F extends ToxFriend> {
 	}
 
 	/**
-	 * Hook for native API to invoke callback methods
+	 * Add the specified callback for receiving status message changes as UTF-8 bytes
 	 *
-	 * @param friendnumber
-	 *            the friend who changed their status
-	 * @param status
-	 *            the new status
+	 * @param callback
+	 *            callback to add
 	 */
-	@SuppressWarnings("unused")
-	private void onUserStatus(int friendnumber, ToxUserStatus status) {
-		F friend = this.friendlist.getByFriendNumber(friendnumber);
+	public void registerOnRawStatusMessageCallback(OnRawStatusMessageCallback<F> callback) {
+		this.onRawStatusMessageCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback for receiving status message changes as UTF-8 bytes
+	 *
+	 * @param callback
+	 *            callback to remove
+	 */
+	public void unregisterOnRawStatusMessageCallback(OnRawStatusMessageCallback<F> callback) {
+		this.onRawStatusMessageCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks for receiving status message changes as UTF-8 bytes
+	 */
+	public void clearOnRawStatusMessageCallbacks() {
+		this.onRawStatusMessageCallbacks.clear();
+	}
+
+	/**
+	 * Add the specified callback for receiving status message changes from the shared event
+	 * buffer
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnStatusMessageBufferCallback(OnStatusMessageBufferCallback callback) {
+		this.onStatusMessageBufferCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback for receiving status message changes from the shared
+	 * event buffer
+	 *
+	 * @param callback
+	 *            callback to remove
+	 */
+	public void unregisterOnStatusMessageBufferCallback(OnStatusMessageBufferCallback callback) {
+		this.onStatusMessageBufferCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks for receiving status message changes from the shared event buffer
+	 */
+	public void clearOnStatusMessageBufferCallbacks() {
+		this.onStatusMessageBufferCallbacks.clear();
+	}
+
+	/**
+	 * Hook for native API to invoke callback methods
+	 *
+	 * @param friendnumber
+	 *            the friend who changed their status
+	 * @param status
+	 *            the new status
+	 */
+	void onUserStatus(int friendnumber, ToxUserStatus status) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.userStatus(friendnumber, status);
+		}
+
+		F friend = this.friendlist.getByFriendNumber(friendnumber);
 		friend.setStatus(status);
 
-		synchronized (this.onUserStatusCallbacks) {
-			for (OnUserStatusCallback<F> cb : this.onUserStatusCallbacks) {
-				cb.execute(friend, status);
-			}
+		for (OnUserStatusCallback<F> cb : this.onUserStatusCallbacks.snapshot()) {
+			cb.execute(friend, status);
 		}
 	}
 
@@ -847,9 +1341,7 @@ public class CallbackHandler<F extends ToxFriend> {
 	 *            callbacks to add
 	 */
 	public <T extends OnUserStatusCallback<F>> void registerOnUserStatusCallbacks(List<T> callbacks) {
-		for (T callback : callbacks) {
-			registerOnUserStatusCallback(callback);
-		}
+		this.onUserStatusCallbacks.addAll(callbacks);
 	}
 
 	/**
@@ -871,15 +1363,18 @@ public class CallbackHandler<F extends ToxFriend> {
 	 * @param isTyping
 	 *            <code>true</code> if the user is typing now, <code>false</code>otherwise
 	 */
-	@SuppressWarnings("unused")
-	private void onTypingChange(int friendnumber, boolean isTyping) {
+	void onTypingChange(int friendnumber, boolean isTyping) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.friendFlag(CallbackRecorder.TYPING_CHANGE, friendnumber, isTyping ? 1 : 0);
+		}
+
 		F friend = this.friendlist.getByFriendNumber(friendnumber);
 		friend.setTyping(isTyping);
 
-		synchronized (this.onTypingChangeCallbacks) {
-			for (OnTypingChangeCallback<F> callback : this.onTypingChangeCallbacks) {
-				callback.execute(friend, isTyping);
-			}
+		for (OnTypingChangeCallback<F> callback : this.onTypingChangeCallbacks.snapshot()) {
+			callback.execute(friend, isTyping);
 		}
 	}
 
@@ -913,9 +1408,7 @@ public class CallbackHandler<F extends ToxFriend> {
 	 * @param callbacks the callbacks to add
 	 */
 	public <T extends OnTypingChangeCallback<F>> void registerOnTypingChangeCallbacks(List<T> callbacks) {
-		for (T callback : callbacks) {
-			registerOnTypingChangeCallback(callback);
-		}
+		this.onTypingChangeCallbacks.addAll(callbacks);
 	}
 
 	/**
@@ -934,12 +1427,15 @@ public class CallbackHandler<F extends ToxFriend> {
 	 * @param status
 	 *            the new status
 	 */
-	@SuppressWarnings("unused")
-	private void onAvCallback(int call_id, ToxAvCallbackID callback_id) {
-		synchronized (this.onAvCallbackCallbacks) {
-			for (OnAvCallbackCallback<F> cb : this.onAvCallbackCallbacks) {
-				cb.execute(call_id, callback_id);
-			}
+	void onAvCallback(int call_id, ToxAvCallbackID callback_id) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.avCallback(call_id, callback_id);
+		}
+
+		for (OnAvCallbackCallback<F> cb : this.onAvCallbackCallbacks.snapshot()) {
+			cb.execute(call_id, callback_id);
 		}
 	}
 	/**
@@ -972,9 +1468,7 @@ public class CallbackHandler<F extends ToxFriend> {
 	 * @param callbacks the callbacks to add
 	 */
 	public <T extends OnAvCallbackCallback<F>> void registerOnAvCallbackCallbacks(List<T> callbacks) {
-		for (T callback : callbacks) {
-			registerOnAvCallbackCallback(callback);
-		}
+		this.onAvCallbackCallbacks.addAll(callbacks);
 	}
 
 	/**
@@ -993,12 +1487,15 @@ public class CallbackHandler<F extends ToxFriend> {
 	 * @param status
 	 *            the new status
 	 */
-	@SuppressWarnings("unused")
-	private void onVideoData(int call_id, byte[] data, int width, int height) {
-		synchronized (this.onVideoDataCallbacks) {
-			for (OnVideoDataCallback<F> cb : this.onVideoDataCallbacks) {
-				cb.execute(call_id, data, width, height);
-			}
+	void onVideoData(int call_id, byte[] data, int width, int height) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.videoData(call_id, data, width, height);
+		}
+
+		for (OnVideoDataCallback<F> cb : this.onVideoDataCallbacks.snapshot()) {
+			cb.execute(call_id, data, width, height);
 		}
 	}
 	/**
@@ -1031,9 +1528,7 @@ public class CallbackHandler<F extends ToxFriend> {
 	 * @param callbacks the callbacks to add
 	 */
 	public <T extends OnVideoDataCallback<F>> void registerOnVideoDataCallbacks(List<T> callbacks) {
-		for (T callback : callbacks) {
-			registerOnVideoDataCallback(callback);
-		}
+		this.onVideoDataCallbacks.addAll(callbacks);
 	}
 
 	/**
@@ -1052,13 +1547,15 @@ public class CallbackHandler<F extends ToxFriend> {
 	 * @param status
 	 *            the new status
 	 */
-	@SuppressWarnings("unused")
-	private void onAudioData(int call_id, byte[] pcm_data) {
+	void onAudioData(int call_id, byte[] pcm_data) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.audioData(call_id, pcm_data);
+		}
 
-		synchronized (this.onAudioDataCallbacks) {
-			for (OnAudioDataCallback<F> cb : this.onAudioDataCallbacks) {
-				cb.execute(call_id, pcm_data);
-			}
+		for (OnAudioDataCallback<F> cb : this.onAudioDataCallbacks.snapshot()) {
+			cb.execute(call_id, pcm_data);
 		}
 	}
 	/**
@@ -1091,9 +1588,7 @@ public class CallbackHandler<F extends ToxFriend> {
 	 * @param callbacks the callbacks to add
 	 */
 	public <T extends OnAudioDataCallback<F>> void registerOnAudioDataCallbacks(List<T> callbacks) {
-		for (T callback : callbacks) {
-			registerOnAudioDataCallback(callback);
-		}
+		this.onAudioDataCallbacks.addAll(callbacks);
 	}
 
 	/**
@@ -1104,4 +1599,436 @@ public class CallbackHandler<F extends ToxFriend> {
 		clearOnAudioDataCallbacks();
 		registerOnAudioDataCallbacks(callbacks);
 	}
+
+	/**
+	 * Hook for native API to invoke callback methods
+	 *
+	 * @param friendnumber
+	 *            the friend who sent the invite
+	 * @param groupPublicKey
+	 *            the public key of the group
+	 */
+	void onGroupInvite(int friendnumber, byte[] groupPublicKey) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.groupInvite(friendnumber, groupPublicKey);
+		}
+
+		F friend = this.friendlist.getByFriendNumber(friendnumber);
+
+		for (OnGroupInviteCallback<F> callback : this.onGroupInviteCallbacks.snapshot()) {
+			callback.execute(friend, groupPublicKey);
+		}
+	}
+
+	/**
+	 * Add the specified callback
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnGroupInviteCallback(OnGroupInviteCallback<F> callback) {
+		this.onGroupInviteCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback
+	 * @param callback callback to remove
+	 */
+	public void unregisterOnGroupInviteCallback(OnGroupInviteCallback<F> callback) {
+		this.onGroupInviteCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks
+	 */
+	public void clearOnGroupInviteCallbacks() {
+		this.onGroupInviteCallbacks.clear();
+	}
+
+	/**
+	 * Add the specified callbacks
+	 * @param callbacks the callbacks to add
+	 */
+	public <T extends OnGroupInviteCallback<F>> void registerOnGroupInviteCallbacks(List<T> callbacks) {
+		this.onGroupInviteCallbacks.addAll(callbacks);
+	}
+
+	/**
+	 * Set the specified callbacks. All previously existing callbacks will be removed
+	 * @param callbacks the callbacks to set
+	 */
+	public <T extends OnGroupInviteCallback<F>> void setOnGroupInviteCallbacks(List<T> callbacks) {
+		clearOnGroupInviteCallbacks();
+		registerOnGroupInviteCallbacks(callbacks);
+	}
+
+	/**
+	 * Hook for native API to invoke callback methods
+	 *
+	 * @param groupnumber
+	 *            the group the message was sent to
+	 * @param peernumber
+	 *            the peer who sent the message
+	 * @param length
+	 *            length of the message in the event buffer
+	 */
+	void onGroupMessage(int groupnumber, int peernumber, int length) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.groupBuffered(CallbackRecorder.GROUP_MESSAGE, groupnumber, peernumber, this.eventBuffer, length);
+		}
+
+		for (OnGroupMessageBufferCallback callback : this.onGroupMessageBufferCallbacks.snapshot()) {
+			callback.execute(groupnumber, peernumber, eventView(length), 0, length);
+		}
+
+		if (this.onRawGroupMessageCallbacks.isEmpty() && this.onGroupMessageCallbacks.isEmpty()) {
+			return;
+		}
+
+		byte[] message = eventBytes(length);
+
+		for (OnRawGroupMessageCallback callback : this.onRawGroupMessageCallbacks.snapshot()) {
+			callback.execute(groupnumber, peernumber, message);
+		}
+
+		OnGroupMessageCallback[] callbacks = this.onGroupMessageCallbacks.snapshot();
+
+		if (callbacks.length == 0) {
+			return;
+		}
+
+		String messageString = JTox.getByteString(message);
+
+		for (OnGroupMessageCallback callback : callbacks) {
+			callback.execute(groupnumber, peernumber, messageString);
+		}
+	}
+
+	/**
+	 * Add the specified callback for receiving group messages
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnGroupMessageCallback(OnGroupMessageCallback callback) {
+		this.onGroupMessageCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback for receiving group messages
+	 *
+	 * @param callback
+	 *            callback to remove
+	 */
+	public void unregisterOnGroupMessageCallback(OnGroupMessageCallback callback) {
+		this.onGroupMessageCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks for receiving group messages
+	 */
+	public void clearOnGroupMessageCallbacks() {
+		this.onGroupMessageCallbacks.clear();
+	}
+
+	/**
+	 * Add all specified callbacks
+	 *
+	 * @param callbacks
+	 *            callbacks to add
+	 */
+	public <T extends OnGroupMessageCallback> void registerOnGroupMessageCallbacks(List<T> callbacks) {
+		this.onGroupMessageCallbacks.addAll(callbacks);
+	}
+
+	/**
+	 * Set the specified callbacks. This removes all previously set callbacks
+	 *
+	 * @param callbacks
+	 *            callbacks to set
+	 */
+	public <T extends OnGroupMessageCallback> void setOnGroupMessageCallbacks(List<T> callbacks) {
+		clearOnGroupMessageCallbacks();
+		registerOnGroupMessageCallbacks(callbacks);
+	}
+
+	/**
+	 * Add the specified callback for receiving group messages as UTF-8 bytes
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnRawGroupMessageCallback(OnRawGroupMessageCallback callback) {
+		this.onRawGroupMessageCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback for receiving group messages as UTF-8
+	 * bytes
+	 *
+	 * @param callback
+	 *            callback to remove
+	 */
+	public void unregisterOnRawGroupMessageCallback(OnRawGroupMessageCallback callback) {
+		this.onRawGroupMessageCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks for receiving group messages as UTF-8 bytes
+	 */
+	public void clearOnRawGroupMessageCallbacks() {
+		this.onRawGroupMessageCallbacks.clear();
+	}
+
+	/**
+	 * Add the specified callback for receiving group messages from the shared
+	 * event buffer
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnGroupMessageBufferCallback(OnGroupMessageBufferCallback callback) {
+		this.onGroupMessageBufferCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback for receiving group messages from the
+	 * shared event buffer
+	 *
+	 * @param callback
+	 *            callback to remove
+	 */
+	public void unregisterOnGroupMessageBufferCallback(OnGroupMessageBufferCallback callback) {
+		this.onGroupMessageBufferCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks for receiving group messages from the shared event
+	 * buffer
+	 */
+	public void clearOnGroupMessageBufferCallbacks() {
+		this.onGroupMessageBufferCallbacks.clear();
+	}
+
+	/**
+	 * Hook for native API to invoke callback methods
+	 *
+	 * @param groupnumber
+	 *            the group the action was sent to
+	 * @param peernumber
+	 *            the peer who sent the action
+	 * @param length
+	 *            length of the action in the event buffer
+	 */
+	void onGroupAction(int groupnumber, int peernumber, int length) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.groupBuffered(CallbackRecorder.GROUP_ACTION, groupnumber, peernumber, this.eventBuffer, length);
+		}
+
+		for (OnGroupActionBufferCallback callback : this.onGroupActionBufferCallbacks.snapshot()) {
+			callback.execute(groupnumber, peernumber, eventView(length), 0, length);
+		}
+
+		if (this.onRawGroupActionCallbacks.isEmpty() && this.onGroupActionCallbacks.isEmpty()) {
+			return;
+		}
+
+		byte[] action = eventBytes(length);
+
+		for (OnRawGroupActionCallback callback : this.onRawGroupActionCallbacks.snapshot()) {
+			callback.execute(groupnumber, peernumber, action);
+		}
+
+		OnGroupActionCallback[] callbacks = this.onGroupActionCallbacks.snapshot();
+
+		if (callbacks.length == 0) {
+			return;
+		}
+
+		String actionString = JTox.getByteString(action);
+
+		for (OnGroupActionCallback callback : callbacks) {
+			callback.execute(groupnumber, peernumber, actionString);
+		}
+	}
+
+	/**
+	 * Add the specified callback for receiving group actions
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnGroupActionCallback(OnGroupActionCallback callback) {
+		this.onGroupActionCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback for receiving group actions
+	 *
+	 * @param callback
+	 *            callback to remove
+	 */
+	public void unregisterOnGroupActionCallback(OnGroupActionCallback callback) {
+		this.onGroupActionCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks for receiving group actions
+	 */
+	public void clearOnGroupActionCallbacks() {
+		this.onGroupActionCallbacks.clear();
+	}
+
+	/**
+	 * Add all specified callbacks
+	 *
+	 * @param callbacks
+	 *            callbacks to add
+	 */
+	public <T extends OnGroupActionCallback> void registerOnGroupActionCallbacks(List<T> callbacks) {
+		this.onGroupActionCallbacks.addAll(callbacks);
+	}
+
+	/**
+	 * Set the specified callbacks. This removes all previously set callbacks
+	 *
+	 * @param callbacks
+	 *            callbacks to set
+	 */
+	public <T extends OnGroupActionCallback> void setOnGroupActionCallbacks(List<T> callbacks) {
+		clearOnGroupActionCallbacks();
+		registerOnGroupActionCallbacks(callbacks);
+	}
+
+	/**
+	 * Add the specified callback for receiving group actions as UTF-8 bytes
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnRawGroupActionCallback(OnRawGroupActionCallback callback) {
+		this.onRawGroupActionCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback for receiving group actions as UTF-8
+	 * bytes
+	 *
+	 * @param callback
+	 *            callback to remove
+	 */
+	public void unregisterOnRawGroupActionCallback(OnRawGroupActionCallback callback) {
+		this.onRawGroupActionCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks for receiving group actions as UTF-8 bytes
+	 */
+	public void clearOnRawGroupActionCallbacks() {
+		this.onRawGroupActionCallbacks.clear();
+	}
+
+	/**
+	 * Add the specified callback for receiving group actions from the shared
+	 * event buffer
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnGroupActionBufferCallback(OnGroupActionBufferCallback callback) {
+		this.onGroupActionBufferCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback for receiving group actions from the
+	 * shared event buffer
+	 *
+	 * @param callback
+	 *            callback to remove
+	 */
+	public void unregisterOnGroupActionBufferCallback(OnGroupActionBufferCallback callback) {
+		this.onGroupActionBufferCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks for receiving group actions from the shared event
+	 * buffer
+	 */
+	public void clearOnGroupActionBufferCallbacks() {
+		this.onGroupActionBufferCallbacks.clear();
+	}
+
+	/**
+	 * Hook for native API to invoke callback methods
+	 *
+	 * @param groupnumber
+	 *            the group whose peer list changed
+	 * @param peernumber
+	 *            the peer that changed
+	 * @param change
+	 *            native value of the change
+	 */
+	void onGroupNamelistChange(int groupnumber, int peernumber, int change) {
+		CallbackRecorder recorder = this.recorder;
+
+		if (recorder != null) {
+			recorder.groupNamelistChange(groupnumber, peernumber, change);
+		}
+
+		if (change < 0 || change >= CHAT_CHANGES.length) {
+			return;
+		}
+
+		for (OnGroupNamelistChangeCallback callback : this.onGroupNamelistChangeCallbacks.snapshot()) {
+			callback.execute(groupnumber, peernumber, CHAT_CHANGES[change]);
+		}
+	}
+
+	/**
+	 * Add the specified callback
+	 *
+	 * @param callback
+	 *            callback to add
+	 */
+	public void registerOnGroupNamelistChangeCallback(OnGroupNamelistChangeCallback callback) {
+		this.onGroupNamelistChangeCallbacks.add(callback);
+	}
+
+	/**
+	 * Remove the specified callback
+	 * @param callback callback to remove
+	 */
+	public void unregisterOnGroupNamelistChangeCallback(OnGroupNamelistChangeCallback callback) {
+		this.onGroupNamelistChangeCallbacks.remove(callback);
+	}
+
+	/**
+	 * Remove all callbacks
+	 */
+	public void clearOnGroupNamelistChangeCallbacks() {
+		this.onGroupNamelistChangeCallbacks.clear();
+	}
+
+	/**
+	 * Add the specified callbacks
+	 * @param callbacks the callbacks to add
+	 */
+	public <T extends OnGroupNamelistChangeCallback> void registerOnGroupNamelistChangeCallbacks(List<T> callbacks) {
+		this.onGroupNamelistChangeCallbacks.addAll(callbacks);
+	}
+
+	/**
+	 * Set the specified callbacks. All previously existing callbacks will be removed
+	 * @param callbacks the callbacks to set
+	 */
+	public <T extends OnGroupNamelistChangeCallback> void setOnGroupNamelistChangeCallbacks(List<T> callbacks) {
+		clearOnGroupNamelistChangeCallbacks();
+		registerOnGroupNamelistChangeCallbacks(callbacks);
+	}
 }
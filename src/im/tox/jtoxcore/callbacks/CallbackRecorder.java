@@ -0,0 +1,406 @@
+/* CallbackRecorder.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+package im.tox.jtoxcore.callbacks;
+
+import im.tox.jtoxcore.ToxAvCallbackID;
+import im.tox.jtoxcore.ToxFileControl;
+import im.tox.jtoxcore.ToxUserStatus;
+
+import java.io.BufferedOutputStream;
+import java.io.IOException;
+import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.util.HashMap;
+import java.util.Map;
+
+/**
+ * Records the callbacks a {@link CallbackHandler} receives into a compact
+ * binary log, for later replay with {@link CallbackReplayer}. Attach it with
+ * {@link CallbackHandler#setRecorder(CallbackRecorder)}.
+ * <p/>
+ * Every event is stored with the time since the previous one. Lengths of
+ * messages, names, file chunks and media frames are always kept. Their
+ * contents are only kept if payloads are enabled; otherwise the replay
+ * substitutes filler of the same length, and public keys of friend requests
+ * and group invites are replaced by pseudonyms that stay the same for the
+ * same key.
+ * <p/>
+ * Recording never throws from within a callback. If writing fails, recording
+ * stops and the error is available from {@link #getError()}.
+ *
+ * @author sonOfRa
+ *
+ */
+public final class CallbackRecorder {
+
+	static final int MAGIC = 0x4A545845; // "JTXE"
+	static final int VERSION = 1;
+	static final int FLAG_PAYLOADS = 1;
+
+	static final int FRIEND_REQUEST = 1;
+	static final int MESSAGE = 2;
+	static final int ACTION = 3;
+	static final int NAME_CHANGE = 4;
+	static final int STATUS_MESSAGE = 5;
+	static final int USER_STATUS = 6;
+	static final int TYPING_CHANGE = 7;
+	static final int CONNECTION_STATUS = 8;
+	static final int READ_RECEIPT = 9;
+	static final int FILE_SEND_REQUEST = 10;
+	static final int FILE_CONTROL = 11;
+	static final int FILE_DATA = 12;
+	static final int AV_CALLBACK = 13;
+	static final int AUDIO_DATA = 14;
+	static final int VIDEO_DATA = 15;
+	static final int GROUP_INVITE = 16;
+	static final int GROUP_MESSAGE = 17;
+	static final int GROUP_ACTION = 18;
+	static final int GROUP_NAMELIST_CHANGE = 19;
+
+	private final OutputStream out;
+	private final boolean payloads;
+	private final Map<ByteBuffer, Integer> pseudonyms = new HashMap<ByteBuffer, Integer>();
+	private long last;
+	private long events;
+	private IOException error;
+	private boolean closed;
+
+	/**
+	 * Create a recorder that writes to the given stream, which is closed by
+	 * {@link #close()}
+	 *
+	 * @param out
+	 *            where to write the log
+	 * @param payloads
+	 *            whether to store the contents of messages, names, requests,
+	 *            file chunks and media frames, or only their lengths
+	 * @throws IOException
+	 *             if the header could not be written
+	 */
+	public CallbackRecorder(OutputStream out, boolean payloads) throws IOException {
+		this.out = new BufferedOutputStream(out, 65536);
+		this.payloads = payloads;
+		writeInt(MAGIC);
+		this.out.write(VERSION);
+		this.out.write(payloads ? FLAG_PAYLOADS : 0);
+		writeLong(System.currentTimeMillis());
+		this.last = System.nanoTime();
+	}
+
+	/**
+	 * @return the number of events recorded so far
+	 */
+	public synchronized long getEventCount() {
+		return this.events;
+	}
+
+	/**
+	 * @return the error that stopped recording, or null
+	 */
+	public synchronized IOException getError() {
+		return this.error;
+	}
+
+	/**
+	 * Write out buffered events
+	 *
+	 * @throws IOException
+	 *             if writing failed, now or during recording
+	 */
+	public synchronized void flush() throws IOException {
+		if (this.error != null) {
+			throw this.error;
+		}
+
+		this.out.flush();
+	}
+
+	/**
+	 * Flush and close the underlying stream. Events arriving later are
+	 * ignored. Closing a closed recorder has no effect.
+	 *
+	 * @throws IOException
+	 *             if writing failed, now or during recording
+	 */
+	public synchronized void close() throws IOException {
+		if (this.closed) {
+			return;
+		}
+
+		this.closed = true;
+		IOException failed = this.error;
+
+		if (failed == null) {
+			this.error = new IOException("Recorder is closed");
+		}
+
+		this.out.close();
+
+		if (failed != null) {
+			throw failed;
+		}
+	}
+
+	synchronized void friendRequest(byte[] publicKey, byte[] message) {
+		if (begin(FRIEND_REQUEST)) {
+			try {
+				writeKey(publicKey);
+				writePayload(message, 0, message.length);
+			} catch (IOException e) {
+				fail(e);
+			}
+		}
+	}
+
+	synchronized void buffered(int type, int friendnumber, ByteBuffer buffer, int length) {
+		if (begin(type)) {
+			try {
+				writeVarLong(friendnumber);
+				writeVarLong(length);
+
+				if (this.payloads) {
+					for (int i = 0; i < length; i++) {
+						this.out.write(buffer.get(i));
+					}
+				}
+			} catch (IOException e) {
+				fail(e);
+			}
+		}
+	}
+
+	synchronized void friendFlag(int type, int friendnumber, int value) {
+		if (begin(type)) {
+			try {
+				writeVarLong(friendnumber);
+				writeVarLong(value & 0xFFFFFFFFL);
+			} catch (IOException e) {
+				fail(e);
+			}
+		}
+	}
+
+	void userStatus(int friendnumber, ToxUserStatus status) {
+		friendFlag(USER_STATUS, friendnumber, status.ordinal());
+	}
+
+	synchronized void fileSendRequest(int friendnumber, int filenumber, long filesize, byte[] filename) {
+		if (begin(FILE_SEND_REQUEST)) {
+			try {
+				writeVarLong(friendnumber);
+				writeVarLong(filenumber);
+				writeVarLong(filesize);
+				writePayload(filename, 0, filename.length);
+			} catch (IOException e) {
+				fail(e);
+			}
+		}
+	}
+
+	synchronized void fileControl(int friendnumber, int receiveSend, int filenumber, ToxFileControl control,
+			byte[] data) {
+		if (begin(FILE_CONTROL)) {
+			try {
+				writeVarLong(friendnumber);
+				this.out.write(receiveSend);
+				writeVarLong(filenumber);
+				this.out.write(control.ordinal());
+				// Control data holds positions, not content, so it is always kept
+				writeVarLong(data == null ? 0 : data.length);
+
+				if (data != null) {
+					this.out.write(data);
+				}
+			} catch (IOException e) {
+				fail(e);
+			}
+		}
+	}
+
+	synchronized void fileData(int friendnumber, int filenumber, byte[] data) {
+		if (begin(FILE_DATA)) {
+			try {
+				writeVarLong(friendnumber);
+				writeVarLong(filenumber);
+				writePayload(data, 0, data.length);
+			} catch (IOException e) {
+				fail(e);
+			}
+		}
+	}
+
+	synchronized void avCallback(int callId, ToxAvCallbackID id) {
+		if (begin(AV_CALLBACK)) {
+			try {
+				writeVarLong(callId);
+				this.out.write(id.ordinal());
+			} catch (IOException e) {
+				fail(e);
+			}
+		}
+	}
+
+	synchronized void audioData(int callId, byte[] data) {
+		if (begin(AUDIO_DATA)) {
+			try {
+				writeVarLong(callId);
+				writePayload(data, 0, data.length);
+			} catch (IOException e) {
+				fail(e);
+			}
+		}
+	}
+
+	synchronized void videoData(int callId, byte[] data, int width, int height) {
+		if (begin(VIDEO_DATA)) {
+			try {
+				writeVarLong(callId);
+				writeVarLong(width);
+				writeVarLong(height);
+				writePayload(data, 0, data.length);
+			} catch (IOException e) {
+				fail(e);
+			}
+		}
+	}
+
+	synchronized void groupInvite(int friendnumber, byte[] groupPublicKey) {
+		if (begin(GROUP_INVITE)) {
+			try {
+				writeVarLong(friendnumber);
+				writeKey(groupPublicKey);
+			} catch (IOException e) {
+				fail(e);
+			}
+		}
+	}
+
+	synchronized void groupBuffered(int type, int groupnumber, int peernumber, ByteBuffer buffer, int length) {
+		if (begin(type)) {
+			try {
+				writeVarLong(groupnumber);
+				writeVarLong(peernumber);
+				writeVarLong(length);
+
+				if (this.payloads) {
+					for (int i = 0; i < length; i++) {
+						this.out.write(buffer.get(i));
+					}
+				}
+			} catch (IOException e) {
+				fail(e);
+			}
+		}
+	}
+
+	synchronized void groupNamelistChange(int groupnumber, int peernumber, int change) {
+		if (begin(GROUP_NAMELIST_CHANGE)) {
+			try {
+				writeVarLong(groupnumber);
+				writeVarLong(peernumber);
+				this.out.write(change);
+			} catch (IOException e) {
+				fail(e);
+			}
+		}
+	}
+
+	/**
+	 * Write the event type and the time since the previous event
+	 *
+	 * @return false if recording has stopped
+	 */
+	private boolean begin(int type) {
+		if (this.error != null) {
+			return false;
+		}
+
+		long now = System.nanoTime();
+
+		try {
+			this.out.write(type);
+			writeVarLong((now - this.last) / 1000);
+		} catch (IOException e) {
+			fail(e);
+			return false;
+		}
+
+		// Carry the sub-microsecond remainder, so rounding does not add up
+		this.last = now - (now - this.last) % 1000;
+		this.events++;
+		return true;
+	}
+
+	private void fail(IOException e) {
+		if (this.error == null) {
+			this.error = e;
+		}
+	}
+
+	private int pseudonym(byte[] publicKey) {
+		ByteBuffer key = ByteBuffer.wrap(publicKey.clone());
+		Integer id = this.pseudonyms.get(key);
+
+		if (id == null) {
+			id = this.pseudonyms.size();
+			this.pseudonyms.put(key, id);
+		}
+
+		return id;
+	}
+
+	private void writeKey(byte[] publicKey) throws IOException {
+		if (this.payloads) {
+			this.out.write(publicKey);
+		} else {
+			writeVarLong(pseudonym(publicKey));
+		}
+	}
+
+	private void writePayload(byte[] data, int offset, int length) throws IOException {
+		writeVarLong(length);
+
+		if (this.payloads) {
+			this.out.write(data, offset, length);
+		}
+	}
+
+	private void writeVarLong(long value) throws IOException {
+		while ((value & ~0x7FL) != 0) {
+			this.out.write((int) (value & 0x7F) | 0x80);
+			value >>>= 7;
+		}
+
+		this.out.write((int) value);
+	}
+
+	private void writeInt(int value) throws IOException {
+		this.out.write(value >>> 24);
+		this.out.write(value >>> 16);
+		this.out.write(value >>> 8);
+		this.out.write(value);
+	}
+
+	private void writeLong(long value) throws IOException {
+		writeInt((int) (value >>> 32));
+		writeInt((int) value);
+	}
+}
@@ -0,0 +1,127 @@
+/* CallbackRegistry.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+package im.tox.jtoxcore.callbacks;
+
+import java.util.Arrays;
+import java.util.Collection;
+
+/**
+ * Copy-on-write set of listeners for a single callback type. Dispatch reads
+ * the current snapshot with a single volatile load and never blocks;
+ * registration copies the array under the registry's own monitor, so it never
+ * waits for a listener that is currently running.
+ *
+ * @author sonOfRa
+ * @param <T>
+ *            listener type held by this registry
+ */
+final class CallbackRegistry<T> {
+
+	private volatile T[] callbacks;
+
+	/**
+	 * Create an empty registry
+	 *
+	 * @param empty
+	 *            an empty array of the listener type, used as the initial
+	 *            snapshot and to determine the component type of later ones
+	 */
+	CallbackRegistry(T[] empty) {
+		this.callbacks = empty;
+	}
+
+	/**
+	 * Get the current listeners. The returned array is shared and must not be
+	 * modified.
+	 *
+	 * @return the current snapshot
+	 */
+	T[] snapshot() {
+		return this.callbacks;
+	}
+
+	/**
+	 * @return true if no listeners are registered
+	 */
+	boolean isEmpty() {
+		return this.callbacks.length == 0;
+	}
+
+	/**
+	 * Append the given listener
+	 *
+	 * @param callback
+	 *            listener to add
+	 */
+	synchronized void add(T callback) {
+		T[] current = this.callbacks;
+		T[] updated = Arrays.copyOf(current, current.length + 1);
+		updated[current.length] = callback;
+		this.callbacks = updated;
+	}
+
+	/**
+	 * Append all given listeners in one copy
+	 *
+	 * @param callbacks
+	 *            listeners to add
+	 */
+	synchronized void addAll(Collection<? extends T> callbacks) {
+		T[] current = this.callbacks;
+		T[] updated = Arrays.copyOf(current, current.length + callbacks.size());
+		int i = current.length;
+
+		for (T callback : callbacks) {
+			updated[i++] = callback;
+		}
+
+		this.callbacks = updated;
+	}
+
+	/**
+	 * Remove the first occurrence of the given listener
+	 *
+	 * @param callback
+	 *            listener to remove
+	 * @return true if the listener was registered
+	 */
+	synchronized boolean remove(Object callback) {
+		T[] current = this.callbacks;
+
+		for (int i = 0; i < current.length; i++) {
+			if (current[i] == null ? callback == null : current[i].equals(callback)) {
+				T[] updated = Arrays.copyOf(current, current.length - 1);
+				System.arraycopy(current, i + 1, updated, i, current.length - i - 1);
+				this.callbacks = updated;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * Remove all listeners
+	 */
+	synchronized void clear() {
+		this.callbacks = Arrays.copyOf(this.callbacks, 0);
+	}
+}
@@ -0,0 +1,380 @@
+/* CallbackReplayer.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+package im.tox.jtoxcore.callbacks;
+
+import im.tox.jtoxcore.JTox;
+import im.tox.jtoxcore.ToxAvCallbackID;
+import im.tox.jtoxcore.ToxFileControl;
+import im.tox.jtoxcore.ToxFriend;
+import im.tox.jtoxcore.ToxUserStatus;
+
+import java.io.BufferedInputStream;
+import java.io.EOFException;
+import java.io.IOException;
+import java.io.InputStream;
+import java.util.Arrays;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Feeds a log written by {@link CallbackRecorder} back through a
+ * {@link CallbackHandler}, so handler code can be run against recorded
+ * traffic without a network. Events are dispatched on the calling thread, in
+ * the recorded order, to the same listeners core would reach.
+ * <p/>
+ * Friends that appear in the log are added to the handler's friend list if
+ * they do not exist. Payloads that were not recorded are replaced by 'x'
+ * bytes of the recorded length, and pseudonymous friend request keys by keys
+ * derived from the pseudonym.
+ *
+ * @author sonOfRa
+ * @param <F>
+ *            Friend type of the handler
+ */
+public final class CallbackReplayer<F extends ToxFriend> {
+
+	private final CallbackHandler<F> handler;
+	private final InputStream in;
+	private final boolean payloads;
+	private final long recordedAt;
+	private byte[] filler = new byte[0];
+
+	/**
+	 * Open a log for replay. The stream is read as events are replayed and
+	 * is not closed by the replayer.
+	 *
+	 * @param handler
+	 *            the handler to dispatch to
+	 * @param in
+	 *            the log
+	 * @throws IOException
+	 *             if the stream does not start with a callback log header
+	 */
+	public CallbackReplayer(CallbackHandler<F> handler, InputStream in) throws IOException {
+		this.handler = handler;
+		this.in = new BufferedInputStream(in, 65536);
+
+		if (readInt() != CallbackRecorder.MAGIC || readByte() != CallbackRecorder.VERSION) {
+			throw new IOException("Not a callback log");
+		}
+
+		this.payloads = (readByte() & CallbackRecorder.FLAG_PAYLOADS) != 0;
+		this.recordedAt = ((long) readInt() << 32) | (readInt() & 0xFFFFFFFFL);
+	}
+
+	/**
+	 * @return true if the log contains payloads, false if they were redacted
+	 */
+	public boolean hasPayloads() {
+		return this.payloads;
+	}
+
+	/**
+	 * @return when recording started, in milliseconds since the epoch
+	 */
+	public long getRecordingStart() {
+		return this.recordedAt;
+	}
+
+	/**
+	 * Replay the remaining events. A truncated last event, as left by a
+	 * process that died while recording, ends the replay.
+	 *
+	 * @param speed
+	 *            1 to keep the recorded timing, 2 to replay twice as fast and
+	 *            so on. 0 dispatches all events without waiting.
+	 * @return the number of events replayed
+	 * @throws IOException
+	 *             if reading failed or the log is corrupt
+	 * @throws InterruptedException
+	 *             if interrupted while waiting for the next event
+	 */
+	public long replay(double speed) throws IOException, InterruptedException {
+		long start = System.nanoTime();
+		double offset = 0;
+		long count = 0;
+
+		while (true) {
+			int type = this.in.read();
+
+			if (type == -1) {
+				return count;
+			}
+
+			try {
+				offset += readVarLong() * 1000.0;
+
+				if (speed > 0) {
+					long wait = start + (long) (offset / speed) - System.nanoTime();
+
+					if (wait > 0) {
+						TimeUnit.NANOSECONDS.sleep(wait);
+					}
+				}
+
+				dispatch(type);
+			} catch (EOFException e) {
+				return count;
+			}
+
+			count++;
+		}
+	}
+
+	private void dispatch(int type) throws IOException {
+		int friendnumber;
+
+		switch (type) {
+			case CallbackRecorder.FRIEND_REQUEST:
+				byte[] publicKey = readKey();
+				this.handler.onFriendRequest(publicKey, readPayload());
+				break;
+
+			case CallbackRecorder.MESSAGE:
+			case CallbackRecorder.ACTION:
+			case CallbackRecorder.NAME_CHANGE:
+			case CallbackRecorder.STATUS_MESSAGE:
+				friendnumber = readFriend();
+				int length = readLength();
+
+				length = this.handler.fillEventBuffer(this.payloads ? readFully(length) : filler(length), length);
+
+				if (type == CallbackRecorder.MESSAGE) {
+					this.handler.onMessage(friendnumber, length);
+				} else if (type == CallbackRecorder.ACTION) {
+					this.handler.onAction(friendnumber, length);
+				} else if (type == CallbackRecorder.NAME_CHANGE) {
+					this.handler.onNameChange(friendnumber, length);
+				} else {
+					this.handler.onStatusMessage(friendnumber, length);
+				}
+
+				break;
+
+			case CallbackRecorder.USER_STATUS:
+				friendnumber = readFriend();
+				this.handler.onUserStatus(friendnumber, readEnum(ToxUserStatus.values()));
+				break;
+
+			case CallbackRecorder.TYPING_CHANGE:
+				friendnumber = readFriend();
+				this.handler.onTypingChange(friendnumber, readVarLong() != 0);
+				break;
+
+			case CallbackRecorder.CONNECTION_STATUS:
+				friendnumber = readFriend();
+				this.handler.onConnectionStatus(friendnumber, readVarLong() != 0);
+				break;
+
+			case CallbackRecorder.READ_RECEIPT:
+				friendnumber = readFriend();
+				this.handler.onReadReceipt(friendnumber, (int) readVarLong());
+				break;
+
+			case CallbackRecorder.FILE_SEND_REQUEST:
+				friendnumber = readFriend();
+				int filenumber = (int) readVarLong();
+				long filesize = readVarLong();
+				this.handler.onFileSendRequest(friendnumber, filenumber, filesize, readPayload());
+				break;
+
+			case CallbackRecorder.FILE_CONTROL:
+				friendnumber = readFriend();
+				int receiveSend = readByte();
+				int controlFile = (int) readVarLong();
+				ToxFileControl control = readEnum(ToxFileControl.values());
+				byte[] data = readFully(readLength());
+				this.handler.onFileControl(friendnumber, receiveSend, controlFile, control, data);
+				break;
+
+			case CallbackRecorder.FILE_DATA:
+				friendnumber = readFriend();
+				int dataFile = (int) readVarLong();
+				this.handler.onFileData(friendnumber, dataFile, readPayload());
+				break;
+
+			case CallbackRecorder.AV_CALLBACK:
+				int callId = (int) readVarLong();
+				this.handler.onAvCallback(callId, readEnum(ToxAvCallbackID.values()));
+				break;
+
+			case CallbackRecorder.AUDIO_DATA:
+				int audioCall = (int) readVarLong();
+				this.handler.onAudioData(audioCall, readPayload());
+				break;
+
+			case CallbackRecorder.VIDEO_DATA:
+				int videoCall = (int) readVarLong();
+				int width = (int) readVarLong();
+				int height = (int) readVarLong();
+				this.handler.onVideoData(videoCall, readPayload(), width, height);
+				break;
+
+			case CallbackRecorder.GROUP_INVITE:
+				friendnumber = readFriend();
+				this.handler.onGroupInvite(friendnumber, readKey());
+				break;
+
+			case CallbackRecorder.GROUP_MESSAGE:
+			case CallbackRecorder.GROUP_ACTION:
+				int groupnumber = (int) readVarLong();
+				int peernumber = (int) readVarLong();
+				int groupLength = readLength();
+
+				groupLength = this.handler.fillEventBuffer(this.payloads ? readFully(groupLength) : filler(groupLength),
+						groupLength);
+
+				if (type == CallbackRecorder.GROUP_MESSAGE) {
+					this.handler.onGroupMessage(groupnumber, peernumber, groupLength);
+				} else {
+					this.handler.onGroupAction(groupnumber, peernumber, groupLength);
+				}
+
+				break;
+
+			case CallbackRecorder.GROUP_NAMELIST_CHANGE:
+				int changedGroup = (int) readVarLong();
+				int changedPeer = (int) readVarLong();
+				this.handler.onGroupNamelistChange(changedGroup, changedPeer, readByte());
+				break;
+
+			default:
+				throw new IOException("Corrupt callback log: unknown event type " + type);
+		}
+	}
+
+	/**
+	 * Read a public key, or turn a pseudonym back into a key that is the same
+	 * for the same pseudonym
+	 */
+	private byte[] readKey() throws IOException {
+		if (this.payloads) {
+			return readFully(JTox.TOX_CLIENT_ID_SIZE);
+		}
+
+		long pseudonym = readVarLong();
+		byte[] publicKey = new byte[JTox.TOX_CLIENT_ID_SIZE];
+
+		for (int i = 0; i < 8; i++) {
+			publicKey[i] = (byte) (pseudonym >>> (56 - 8 * i));
+		}
+
+		return publicKey;
+	}
+
+	private int readFriend() throws IOException {
+		int friendnumber = (int) readVarLong();
+		this.handler.ensureFriend(friendnumber);
+		return friendnumber;
+	}
+
+	private int readLength() throws IOException {
+		long length = readVarLong();
+
+		if (length > Integer.MAX_VALUE) {
+			throw new IOException("Corrupt callback log: length " + length);
+		}
+
+		return (int) length;
+	}
+
+	private <E extends Enum<E>> E readEnum(E[] values) throws IOException {
+		int ordinal = readByte();
+
+		if (ordinal >= values.length) {
+			throw new IOException("Corrupt callback log: unknown " + values[0].getClass().getSimpleName() + " "
+					+ ordinal);
+		}
+
+		return values[ordinal];
+	}
+
+	/**
+	 * Read a length prefixed payload, or produce filler if payloads were not
+	 * recorded. The result is a new array, listeners may keep it.
+	 */
+	private byte[] readPayload() throws IOException {
+		int length = readLength();
+
+		if (this.payloads) {
+			return readFully(length);
+		}
+
+		return Arrays.copyOf(filler(length), length);
+	}
+
+	/**
+	 * Shared filler of at least the given length
+	 */
+	private byte[] filler(int length) {
+		if (this.filler.length < length) {
+			this.filler = new byte[length];
+			Arrays.fill(this.filler, (byte) 'x');
+		}
+
+		return this.filler;
+	}
+
+	private byte[] readFully(int length) throws IOException {
+		byte[] data = new byte[length];
+		int read = 0;
+
+		while (read < length) {
+			int n = this.in.read(data, read, length - read);
+
+			if (n == -1) {
+				throw new EOFException();
+			}
+
+			read += n;
+		}
+
+		return data;
+	}
+
+	private int readByte() throws IOException {
+		int b = this.in.read();
+
+		if (b == -1) {
+			throw new EOFException();
+		}
+
+		return b;
+	}
+
+	private int readInt() throws IOException {
+		return (readByte() << 24) | (readByte() << 16) | (readByte() << 8) | readByte();
+	}
+
+	private long readVarLong() throws IOException {
+		long value = 0;
+
+		for (int shift = 0; shift < 64; shift += 7) {
+			int b = readByte();
+			value |= (long) (b & 0x7F) << shift;
+
+			if ((b & 0x80) == 0) {
+				return value;
+			}
+		}
+
+		throw new IOException("Corrupt callback log: varint too long");
+	}
+}
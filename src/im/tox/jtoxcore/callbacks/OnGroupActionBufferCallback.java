@@ -0,0 +1,50 @@
+/* OnGroupActionBufferCallback.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+package im.tox.jtoxcore.callbacks;
+
+import java.nio.ByteBuffer;
+
+/**
+ * Callback class for receiving group chat actions straight from the native
+ * event buffer, without allocating or decoding anything
+ *
+ * @author sonOfRa
+ */
+public interface OnGroupActionBufferCallback {
+
+	/**
+	 * Method to be executed each time an action is sent to a group chat. The
+	 * buffer is shared between events and only valid for the duration of this
+	 * call; copy the bytes out if they are needed afterwards.
+	 *
+	 * @param groupnumber
+	 *            the group the action was sent to
+	 * @param peernumber
+	 *            the peer who sent the action
+	 * @param data
+	 *            read-only buffer holding the UTF-8 encoded action
+	 * @param offset
+	 *            index of the first byte in data
+	 * @param length
+	 *            number of bytes
+	 */
+	void execute(int groupnumber, int peernumber, ByteBuffer data, int offset, int length);
+}
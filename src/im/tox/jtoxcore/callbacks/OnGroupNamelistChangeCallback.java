@@ -0,0 +1,44 @@
+/* OnGroupNamelistChangeCallback.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+package im.tox.jtoxcore.callbacks;
+
+import im.tox.jtoxcore.ToxChatChange;
+
+/**
+ * Callback class for changes to the peer list of a group chat
+ *
+ * @author sonOfRa
+ */
+public interface OnGroupNamelistChangeCallback {
+
+	/**
+	 * Method to be executed each time a peer joins or leaves a group chat, or
+	 * changes their name. Peer numbers above a peer that left move down by one.
+	 *
+	 * @param groupnumber
+	 *            the group whose peer list changed
+	 * @param peernumber
+	 *            the peer that changed
+	 * @param change
+	 *            what happened
+	 */
+	void execute(int groupnumber, int peernumber, ToxChatChange change);
+}
@@ -0,0 +1,40 @@
+/* OnQueuedMessageFailedCallback.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+package im.tox.jtoxcore.callbacks;
+
+/**
+ * Callback class for queued messages that can never be sent
+ *
+ * @author sonOfRa
+ */
+public interface OnQueuedMessageFailedCallback {
+
+	/**
+	 * Method to be executed each time a queued message is dropped because
+	 * its friend no longer exists
+	 *
+	 * @param friendnumber
+	 *            the friend the message was meant for
+	 * @param queueId
+	 *            the ID returned when the message was queued
+	 */
+	void execute(int friendnumber, int queueId);
+}
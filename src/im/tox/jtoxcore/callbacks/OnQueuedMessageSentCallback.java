@@ -0,0 +1,42 @@
+/* OnQueuedMessageSentCallback.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+package im.tox.jtoxcore.callbacks;
+
+/**
+ * Callback class for chunks of queued messages that core accepted
+ *
+ * @author sonOfRa
+ */
+public interface OnQueuedMessageSentCallback {
+
+	/**
+	 * Method to be executed each time core accepts a queued chunk
+	 *
+	 * @param friendnumber
+	 *            the friend the message was sent to
+	 * @param queueId
+	 *            the ID returned when the message was queued
+	 * @param messageId
+	 *            the message ID core assigned, as passed to the read receipt
+	 *            callback
+	 */
+	void execute(int friendnumber, int queueId, int messageId);
+}
@@ -0,0 +1,43 @@
+/* OnRawFriendRequestCallback.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+package im.tox.jtoxcore.callbacks;
+
+/**
+ * Callback class for receiving friend requests without hex encoding the
+ * public key or decoding the message
+ *
+ * @author sonOfRa
+ *
+ */
+public interface OnRawFriendRequestCallback {
+
+	/**
+	 * Method to be executed each time a friend request is received
+	 *
+	 * @param publicKey
+	 *            the friend's binary public key. Pass it to
+	 *            {@link im.tox.jtoxcore.JTox#confirmRequest(byte[])} to accept
+	 *            the request
+	 * @param message
+	 *            the UTF-8 encoded message sent with the friend request
+	 */
+	void execute(byte[] publicKey, byte[] message);
+}
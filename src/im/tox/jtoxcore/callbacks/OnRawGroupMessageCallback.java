@@ -0,0 +1,41 @@
+/* OnRawGroupMessageCallback.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+package im.tox.jtoxcore.callbacks;
+
+/**
+ * Callback class for receiving group chat messages without decoding them
+ *
+ * @author sonOfRa
+ */
+public interface OnRawGroupMessageCallback {
+
+	/**
+	 * Method to be executed each time a message is sent to a group chat
+	 *
+	 * @param groupnumber
+	 *            the group the message was sent to
+	 * @param peernumber
+	 *            the peer who sent the message
+	 * @param message
+	 *            the UTF-8 encoded message
+	 */
+	void execute(int groupnumber, int peernumber, byte[] message);
+}
@@ -0,0 +1,193 @@
+/* ToxMessageQueueTest.java
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+package im.tox.jtoxcore;
+
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.HashSet;
+import java.util.List;
+import java.util.Set;
+
+import im.tox.jtoxcore.callbacks.OnQueuedMessageFailedCallback;
+import im.tox.jtoxcore.callbacks.OnQueuedMessageSentCallback;
+
+/**
+ * Tests for {@link ToxMessageQueue}, drained into a fake instead of a native
+ * tox instance. Failures throw AssertionError.
+ *
+ * @author sonOfRa
+ */
+public class ToxMessageQueueTest {
+
+	/**
+	 * Accepts chunks while accepting is set, handing out message IDs from 1
+	 */
+	private static class FakeSender implements ToxMessageQueue.Sender {
+		boolean accepting = true;
+		final Set<Integer> friends = new HashSet<Integer>();
+		final List<byte[]> sent = new ArrayList<byte[]>();
+		int nextMessageId = 1;
+
+		@Override
+		public int send(int friendnumber, byte[] chunk) {
+			if (!this.accepting || !this.friends.contains(friendnumber)) {
+				return 0;
+			}
+
+			this.sent.add(chunk);
+			return this.nextMessageId++;
+		}
+
+		@Override
+		public boolean friendExists(int friendnumber) {
+			return this.friends.contains(friendnumber);
+		}
+	}
+
+	private final List<int[]> sentEvents = new ArrayList<int[]>();
+	private final List<int[]> failedEvents = new ArrayList<int[]>();
+
+	private ToxMessageQueue newQueue() {
+		ToxMessageQueue queue = new ToxMessageQueue();
+
+		this.sentEvents.clear();
+		this.failedEvents.clear();
+		queue.setSentCallback(new OnQueuedMessageSentCallback() {
+
+			@Override
+			public void execute(int friendnumber, int queueId, int messageId) {
+				ToxMessageQueueTest.this.sentEvents.add(new int[] { friendnumber, queueId, messageId });
+			}
+		});
+		queue.setFailedCallback(new OnQueuedMessageFailedCallback() {
+
+			@Override
+			public void execute(int friendnumber, int queueId) {
+				ToxMessageQueueTest.this.failedEvents.add(new int[] { friendnumber, queueId });
+			}
+		});
+		return queue;
+	}
+
+	private static void check(boolean condition, String what) {
+		if (!condition) {
+			throw new AssertionError(what);
+		}
+	}
+
+	private static byte[] message(int length) {
+		byte[] message = new byte[length];
+
+		Arrays.fill(message, (byte) 'x');
+		return message;
+	}
+
+	void sentMessagesReportTheirMessageId() throws InterruptedException {
+		ToxMessageQueue queue = newQueue();
+		FakeSender sender = new FakeSender();
+
+		sender.friends.add(3);
+		int first = queue.offer(3, message(10), false);
+		int second = queue.offer(3, message(10), false);
+
+		check(first != 0 && second != 0 && first != second, "queued messages get distinct IDs");
+		queue.drain(sender);
+		check(queue.getDepth() == 0, "everything was sent");
+		check(queue.getSentCount() == 2, "sent count");
+		check(this.sentEvents.size() == 2, "one sent event per chunk");
+		check(Arrays.equals(this.sentEvents.get(0), new int[] { 3, first, 1 }), "first message maps to receipt 1");
+		check(Arrays.equals(this.sentEvents.get(1), new int[] { 3, second, 2 }), "second message maps to receipt 2");
+	}
+
+	void splitMessagesShareOneId() throws InterruptedException {
+		ToxMessageQueue queue = newQueue();
+		FakeSender sender = new FakeSender();
+
+		sender.friends.add(0);
+		int id = queue.offer(0, message(JTox.TOX_MAX_MESSAGE_LENGTH * 2 + 1), false);
+
+		check(queue.getDepth(0) == 3, "message split in three chunks");
+		queue.drain(sender);
+		check(this.sentEvents.size() == 3, "one sent event per chunk");
+
+		for (int[] event : this.sentEvents) {
+			check(event[1] == id, "all chunks report the message's ID");
+		}
+	}
+
+	void refusedChunksAreRetried() throws InterruptedException {
+		ToxMessageQueue queue = newQueue();
+		FakeSender sender = new FakeSender();
+
+		sender.friends.add(1);
+		sender.accepting = false;
+		int id = queue.offer(1, message(10), false);
+
+		queue.drain(sender);
+		check(queue.getDepth(1) == 1, "refused chunk stays queued");
+		check(queue.getRetryCount() == 1, "retry counted");
+		check(this.sentEvents.isEmpty() && this.failedEvents.isEmpty(), "nothing reported yet");
+
+		sender.accepting = true;
+		queue.drain(sender);
+		check(queue.getDepth(1) == 0, "sent on the next drain");
+		check(this.sentEvents.size() == 1 && this.sentEvents.get(0)[1] == id, "sent event for the retried message");
+	}
+
+	void messagesForRemovedFriendsFail() throws InterruptedException {
+		ToxMessageQueue queue = newQueue();
+		FakeSender sender = new FakeSender();
+
+		sender.friends.add(2);
+		int first = queue.offer(5, message(JTox.TOX_MAX_MESSAGE_LENGTH + 1), false);
+		int second = queue.offer(5, message(10), false);
+		int other = queue.offer(2, message(10), false);
+
+		queue.drain(sender);
+		check(queue.getDepth() == 0, "queue of the removed friend was dropped");
+		check(queue.getFailedCount() == 3, "all three chunks counted as failed");
+		check(queue.getRetryCount() == 0, "removed friend is not retried");
+		check(this.failedEvents.size() == 2, "one failed event per message");
+		check(Arrays.equals(this.failedEvents.get(0), new int[] { 5, first }), "first message failed");
+		check(Arrays.equals(this.failedEvents.get(1), new int[] { 5, second }), "second message failed");
+		check(this.sentEvents.size() == 1 && this.sentEvents.get(0)[1] == other, "other friend unaffected");
+	}
+
+	void fullQueueDropsWithoutId() throws InterruptedException {
+		ToxMessageQueue queue = newQueue();
+
+		queue.setCapacity(1);
+		queue.setPolicy(ToxBackpressurePolicy.DROP);
+		check(queue.offer(4, message(10), false) != 0, "first message fits");
+		check(queue.offer(4, message(10), false) == 0, "second message is dropped");
+		check(queue.getDroppedCount() == 1, "drop counted");
+	}
+
+	public static void main(String[] args) throws InterruptedException {
+		ToxMessageQueueTest test = new ToxMessageQueueTest();
+
+		test.sentMessagesReportTheirMessageId();
+		test.splitMessagesShareOneId();
+		test.refusedChunksAreRetried();
+		test.messagesForRemovedFriendsFail();
+		test.fullQueueDropsWithoutId();
+	}
+}
@@ -0,0 +1,200 @@
+/* journal_test.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "journal.h"
+
+/* Must match journal.c */
+#define BLOCK_SIZE (256 * 1024)
+#define HEADER_SIZE 20
+
+#define OUT_PATH "journal_test.out"
+#define JOURNAL_PATH OUT_PATH ".journal"
+
+/* Stand-in for core: records the last control packet and fails on request */
+static int control_result;
+static uint8_t last_control;
+static uint64_t last_position;
+
+int tox_file_send_control(Tox *tox, int32_t friendnumber, uint8_t send_receive, uint8_t filenumber,
+						  uint8_t message_id, uint8_t *data, uint16_t length)
+{
+	(void) tox;
+	(void) friendnumber;
+	(void) send_receive;
+	(void) filenumber;
+	last_control = message_id;
+	last_position = 0;
+
+	if (data != NULL && length == sizeof(last_position)) {
+		memcpy(&last_position, data, sizeof(last_position));
+	}
+
+	return control_result;
+}
+
+static long file_size(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	long size;
+
+	if (f == NULL) {
+		return -1;
+	}
+
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fclose(f);
+	return size;
+}
+
+/* Feed length bytes of a fixed pattern in chunks the size core delivers */
+static void receive_bytes(journal_registry_t *reg, uint64_t length)
+{
+	uint8_t chunk[1000];
+	uint64_t offset = 0;
+
+	while (offset < length) {
+		uint16_t n = length - offset < sizeof(chunk) ? (uint16_t) (length - offset) : sizeof(chunk);
+		uint16_t i;
+
+		for (i = 0; i < n; i++) {
+			chunk[i] = (uint8_t) ((offset + i) * 31);
+		}
+
+		CHECK(journal_data(reg, NULL, 0, 1, chunk, n) == 1);
+		offset += n;
+	}
+}
+
+static void test_resume_from_last_block(void)
+{
+	journal_registry_t *reg = journal_new();
+
+	control_result = 0;
+	CHECK(journal_receive(reg, NULL, 0, 1, 3 * BLOCK_SIZE, OUT_PATH) == 0);
+	CHECK(last_control == TOX_FILECONTROL_ACCEPT);
+
+	receive_bytes(reg, 2 * BLOCK_SIZE + BLOCK_SIZE / 2);
+	CHECK(file_size(JOURNAL_PATH) == HEADER_SIZE + 2 * 4);
+
+	/* The partial third block is not journaled, so the resume starts after the second */
+	journal_reconnect(reg, NULL, 0);
+	CHECK(last_control == TOX_FILECONTROL_RESUME_BROKEN);
+	CHECK(last_position == 2 * BLOCK_SIZE);
+
+	/* The friend resends from there to the end */
+	receive_bytes(reg, BLOCK_SIZE);
+	CHECK(journal_control(reg, 0, 1, TOX_FILECONTROL_FINISHED) == 0);
+	CHECK(file_size(OUT_PATH) == 3 * BLOCK_SIZE);
+	CHECK(file_size(JOURNAL_PATH) == -1);
+	journal_free(reg);
+	remove(OUT_PATH);
+}
+
+static void test_damaged_block_is_given_up(void)
+{
+	journal_registry_t *reg = journal_new();
+	FILE *f;
+
+	control_result = 0;
+	CHECK(journal_receive(reg, NULL, 0, 1, 3 * BLOCK_SIZE, OUT_PATH) == 0);
+	receive_bytes(reg, 2 * BLOCK_SIZE);
+
+	/* Damage the second block behind the transfer's back */
+	f = fopen(OUT_PATH, "r+b");
+	CHECK(f != NULL);
+
+	if (f != NULL) {
+		fseek(f, BLOCK_SIZE + 10, SEEK_SET);
+		fputc(0xAA, f);
+		fclose(f);
+	}
+
+	journal_reconnect(reg, NULL, 0);
+	CHECK(last_control == TOX_FILECONTROL_RESUME_BROKEN);
+	CHECK(last_position == BLOCK_SIZE);
+	CHECK(file_size(JOURNAL_PATH) == HEADER_SIZE + 4);
+
+	/* A killed transfer keeps its journal for a later attempt */
+	CHECK(journal_control(reg, 0, 1, TOX_FILECONTROL_KILL) == 0);
+	CHECK(file_size(JOURNAL_PATH) == HEADER_SIZE + 4);
+	journal_free(reg);
+	remove(OUT_PATH);
+	remove(JOURNAL_PATH);
+}
+
+static void test_failed_receive_leaves_no_files(void)
+{
+	journal_registry_t *reg = journal_new();
+	uint8_t data[16] = {0};
+
+	control_result = -1;
+	CHECK(journal_receive(reg, NULL, 0, 1, BLOCK_SIZE, OUT_PATH) == -1);
+	CHECK(file_size(OUT_PATH) == -1);
+	CHECK(file_size(JOURNAL_PATH) == -1);
+	/* Nothing was registered, so the data is not taken */
+	CHECK(journal_data(reg, NULL, 0, 1, data, sizeof(data)) == 0);
+	journal_free(reg);
+}
+
+static void test_incomplete_finish_fails(void)
+{
+	journal_registry_t *reg = journal_new();
+
+	control_result = 0;
+	CHECK(journal_receive(reg, NULL, 0, 1, 2 * BLOCK_SIZE, OUT_PATH) == 0);
+	receive_bytes(reg, BLOCK_SIZE + 100);
+
+	/* Finished short of the size is a failure, the journal stays for a later attempt */
+	CHECK(journal_control(reg, 0, 1, TOX_FILECONTROL_FINISHED) == -1);
+	CHECK(file_size(JOURNAL_PATH) == HEADER_SIZE + 4);
+	journal_free(reg);
+	remove(OUT_PATH);
+	remove(JOURNAL_PATH);
+}
+
+static void test_forget_drops_transfers(void)
+{
+	journal_registry_t *reg = journal_new();
+	uint8_t data[16] = {0};
+
+	control_result = 0;
+	CHECK(journal_receive(reg, NULL, 0, 1, BLOCK_SIZE, OUT_PATH) == 0);
+	journal_forget(reg, 0);
+	/* A new friend with the same number does not write into the old transfer */
+	CHECK(journal_data(reg, NULL, 0, 1, data, sizeof(data)) == 0);
+	journal_free(reg);
+	remove(OUT_PATH);
+	remove(JOURNAL_PATH);
+}
+
+int main(void)
+{
+	test_resume_from_last_block();
+	test_damaged_block_is_given_up();
+	test_failed_receive_leaves_no_files();
+	test_incomplete_finish_fails();
+	test_forget_drops_transfers();
+	return check_failures != 0;
+}
@@ -0,0 +1,207 @@
+/* presence_test.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <string.h>
+
+#include "check.h"
+#include "presence.h"
+
+#define MAX_EVENTS 64
+
+typedef struct {
+	int32_t friendnumber;
+	int kind;
+	uint8_t value;
+	char data[16];
+} event_t;
+
+static presence_coalescer_t *p;
+static event_t events[MAX_EVENTS];
+static int event_count;
+/* What the listener does when it sees an event, for the reentrancy tests */
+static int32_t delete_on_connect = -1;
+static int32_t event_on_connect = -1;
+static int disable_on_connect;
+
+static void deliver(void *userdata, int32_t friendnumber, int kind, uint8_t value, const uint8_t *data,
+					uint16_t length)
+{
+	event_t *e = &events[event_count < MAX_EVENTS - 1 ? event_count++ : event_count];
+
+	(void) userdata;
+	memset(e, 0, sizeof(event_t));
+	e->friendnumber = friendnumber;
+	e->kind = kind;
+	e->value = value;
+
+	if (data != NULL) {
+		memcpy(e->data, data, length < sizeof(e->data) - 1 ? length : sizeof(e->data) - 1);
+	}
+
+	if (kind == PRESENCE_CONNECTION && friendnumber == delete_on_connect) {
+		presence_forget(p, friendnumber);
+	}
+
+	/* Deliver right away, as the JNI layer does when presence_value refuses; this grows the table */
+	if (kind == PRESENCE_CONNECTION && event_on_connect >= 0
+			&& presence_value(p, event_on_connect, PRESENCE_TYPING, 1) != 0) {
+		deliver(userdata, event_on_connect, PRESENCE_TYPING, 1, NULL, 0);
+	}
+
+	/* What setPresenceCoalescing(false) does */
+	if (kind == PRESENCE_CONNECTION && disable_on_connect) {
+		presence_flush(p, deliver, userdata);
+		presence_set_enabled(p, 0);
+	}
+}
+
+static void reset(void)
+{
+	presence_free(p);
+	p = presence_new();
+	presence_set_enabled(p, 1);
+	event_count = 0;
+	delete_on_connect = -1;
+	event_on_connect = -1;
+	disable_on_connect = 0;
+}
+
+static void test_coalescing(void)
+{
+	int64_t stats[PRESENCE_STAT_COUNT];
+
+	reset();
+	CHECK(presence_value(p, 1, PRESENCE_USER_STATUS, 1) == 0);
+	CHECK(presence_value(p, 0, PRESENCE_CONNECTION, 1) == 0);
+	CHECK(presence_value(p, 1, PRESENCE_USER_STATUS, 2) == 0);
+	CHECK(presence_data(p, 1, PRESENCE_NAME, (const uint8_t *) "old", 3) == 0);
+	CHECK(presence_data(p, 1, PRESENCE_NAME, (const uint8_t *) "new", 3) == 0);
+	presence_flush(p, deliver, NULL);
+
+	/* Friends in order of their first event, kinds in enum order, last value wins */
+	CHECK(event_count == 3);
+	CHECK(events[0].friendnumber == 1 && events[0].kind == PRESENCE_NAME && strcmp(events[0].data, "new") == 0);
+	CHECK(events[1].friendnumber == 1 && events[1].kind == PRESENCE_USER_STATUS && events[1].value == 2);
+	CHECK(events[2].friendnumber == 0 && events[2].kind == PRESENCE_CONNECTION && events[2].value == 1);
+
+	/* The same state again after a reconnect is dropped, names are always delivered */
+	event_count = 0;
+	presence_value(p, 1, PRESENCE_USER_STATUS, 2);
+	presence_data(p, 1, PRESENCE_NAME, (const uint8_t *) "new", 3);
+	presence_flush(p, deliver, NULL);
+	CHECK(event_count == 1 && events[0].kind == PRESENCE_NAME);
+
+	presence_stats(p, stats);
+	CHECK(stats[PRESENCE_STAT_RECEIVED] == 7);
+	CHECK(stats[PRESENCE_STAT_COALESCED] == 2);
+	CHECK(stats[PRESENCE_STAT_DELIVERED] == 4);
+	CHECK(stats[PRESENCE_STAT_UNCHANGED] == 1);
+}
+
+static void test_immediate_delivery_is_remembered(void)
+{
+	reset();
+	presence_value(p, 0, PRESENCE_USER_STATUS, 1);
+	presence_flush(p, deliver, NULL);
+
+	/* While disabled, the listener sees the change to 2 right away */
+	presence_set_enabled(p, 0);
+	CHECK(presence_value(p, 0, PRESENCE_USER_STATUS, 2) != 0);
+	presence_set_enabled(p, 1);
+
+	/* Back to 1 is a change from what the listener saw last */
+	event_count = 0;
+	presence_value(p, 0, PRESENCE_USER_STATUS, 1);
+	presence_flush(p, deliver, NULL);
+	CHECK(event_count == 1 && events[0].value == 1);
+
+	/* And 1 again is not */
+	event_count = 0;
+	presence_value(p, 0, PRESENCE_USER_STATUS, 1);
+	presence_flush(p, deliver, NULL);
+	CHECK(event_count == 0);
+}
+
+static void test_listener_deletes_friend(void)
+{
+	reset();
+	delete_on_connect = 2;
+	presence_value(p, 2, PRESENCE_CONNECTION, 1);
+	presence_data(p, 2, PRESENCE_NAME, (const uint8_t *) "gone", 4);
+	presence_value(p, 2, PRESENCE_TYPING, 1);
+	presence_value(p, 3, PRESENCE_TYPING, 1);
+	presence_flush(p, deliver, NULL);
+
+	/* The deleted friend's remaining events are dropped, the other friend is unaffected */
+	CHECK(event_count == 2);
+	CHECK(events[0].friendnumber == 2 && events[0].kind == PRESENCE_CONNECTION);
+	CHECK(events[1].friendnumber == 3 && events[1].kind == PRESENCE_TYPING);
+
+	/* A new friend with the same number starts over */
+	event_count = 0;
+	delete_on_connect = -1;
+	presence_value(p, 2, PRESENCE_CONNECTION, 1);
+	presence_flush(p, deliver, NULL);
+	CHECK(event_count == 1 && events[0].value == 1);
+}
+
+static void test_listener_grows_table(void)
+{
+	reset();
+	event_on_connect = 5000;
+	presence_value(p, 0, PRESENCE_CONNECTION, 1);
+	presence_value(p, 0, PRESENCE_USER_STATUS, 3);
+	presence_flush(p, deliver, NULL);
+
+	CHECK(event_count == 3);
+	CHECK(events[1].friendnumber == 5000 && events[1].kind == PRESENCE_TYPING);
+	CHECK(events[2].friendnumber == 0 && events[2].kind == PRESENCE_USER_STATUS && events[2].value == 3);
+}
+
+static void test_listener_disables_coalescing(void)
+{
+	reset();
+	disable_on_connect = 1;
+	presence_value(p, 0, PRESENCE_CONNECTION, 1);
+	presence_value(p, 0, PRESENCE_USER_STATUS, 2);
+	presence_value(p, 1, PRESENCE_TYPING, 1);
+	presence_flush(p, deliver, NULL);
+
+	/* Every pending event is delivered once, in order */
+	CHECK(event_count == 3);
+	CHECK(events[0].friendnumber == 0 && events[0].kind == PRESENCE_CONNECTION);
+	CHECK(events[1].friendnumber == 0 && events[1].kind == PRESENCE_USER_STATUS && events[1].value == 2);
+	CHECK(events[2].friendnumber == 1 && events[2].kind == PRESENCE_TYPING);
+
+	/* And from then on events are not held back */
+	CHECK(!presence_enabled(p));
+	CHECK(presence_value(p, 1, PRESENCE_TYPING, 0) != 0);
+}
+
+int main(void)
+{
+	test_coalescing();
+	test_immediate_delivery_is_remembered();
+	test_listener_deletes_friend();
+	test_listener_grows_table();
+	test_listener_disables_coalescing();
+	presence_free(p);
+	return check_failures != 0;
+}
@@ -0,0 +1,166 @@
+/* reqfilter_test.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <string.h>
+
+#include "check.h"
+#include "reqfilter.h"
+
+static void make_key(uint8_t *key, uint32_t n)
+{
+	memset(key, 0, TOX_CLIENT_ID_SIZE);
+	memcpy(key, &n, sizeof(n));
+}
+
+static void test_lists(void)
+{
+	request_filter_t *f = reqfilter_new(1);
+	int64_t stats[REQFILTER_STAT_COUNT];
+	uint8_t blocked[TOX_CLIENT_ID_SIZE];
+	uint8_t allowed[TOX_CLIENT_ID_SIZE];
+	uint8_t other[TOX_CLIENT_ID_SIZE];
+
+	make_key(blocked, 1);
+	make_key(allowed, 2);
+	make_key(other, 3);
+	CHECK(reqfilter_list(f, blocked, REQFILTER_BLOCK) == 0);
+	CHECK(reqfilter_list(f, allowed, REQFILTER_ALLOW) == 0);
+
+	CHECK(reqfilter_check(f, blocked, 10, 1) == 0);
+	CHECK(reqfilter_check(f, allowed, 10, 1) == 1);
+	CHECK(reqfilter_check(f, other, 10, 1) == 1);
+
+	/* Allow-only drops everything not on the allow list */
+	reqfilter_allow_only(f, 1);
+	CHECK(reqfilter_check(f, other, 10, 1) == 0);
+	CHECK(reqfilter_check(f, allowed, 10, 1) == 1);
+	reqfilter_allow_only(f, 0);
+
+	/* Listing again moves the key, unlisting removes it */
+	CHECK(reqfilter_list(f, blocked, REQFILTER_ALLOW) == 0);
+	CHECK(reqfilter_check(f, blocked, 10, 1) == 1);
+	CHECK(reqfilter_list(f, allowed, REQFILTER_UNLISTED) == 0);
+	reqfilter_allow_only(f, 1);
+	CHECK(reqfilter_check(f, allowed, 10, 1) == 0);
+
+	reqfilter_stats(f, stats);
+	CHECK(stats[REQFILTER_STAT_BLOCKED] == 1);
+	CHECK(stats[REQFILTER_STAT_NOT_ALLOWED] == 2);
+	CHECK(stats[REQFILTER_STAT_ACCEPTED] == 4);
+	reqfilter_free(f);
+}
+
+static void test_list_growth(void)
+{
+	request_filter_t *f = reqfilter_new(2);
+	uint8_t key[TOX_CLIENT_ID_SIZE];
+	uint32_t i;
+
+	for (i = 0; i < 1000; i++) {
+		make_key(key, i);
+		CHECK(reqfilter_list(f, key, i % 2 ? REQFILTER_BLOCK : REQFILTER_ALLOW) == 0);
+	}
+
+	/* Unlisting half leaves deleted slots behind, which must not hide the other keys */
+	for (i = 0; i < 1000; i += 4) {
+		make_key(key, i);
+		CHECK(reqfilter_list(f, key, REQFILTER_UNLISTED) == 0);
+	}
+
+	reqfilter_allow_only(f, 1);
+
+	for (i = 0; i < 1000; i++) {
+		make_key(key, i);
+		CHECK(reqfilter_check(f, key, 10, 1) == (i % 2 == 0 && i % 4 != 0));
+	}
+
+	reqfilter_clear(f);
+	make_key(key, 2);
+	CHECK(reqfilter_check(f, key, 10, 1) == 0);
+	reqfilter_free(f);
+}
+
+static void test_max_length(void)
+{
+	request_filter_t *f = reqfilter_new(3);
+	int64_t stats[REQFILTER_STAT_COUNT];
+	uint8_t key[TOX_CLIENT_ID_SIZE];
+
+	make_key(key, 1);
+	reqfilter_max_length(f, 100);
+	CHECK(reqfilter_check(f, key, 100, 1) == 1);
+	CHECK(reqfilter_check(f, key, 101, 1) == 0);
+	reqfilter_max_length(f, 0);
+	CHECK(reqfilter_check(f, key, 1000, 1) == 1);
+
+	reqfilter_stats(f, stats);
+	CHECK(stats[REQFILTER_STAT_TOO_LONG] == 1);
+	reqfilter_free(f);
+}
+
+static void test_rate_limits(void)
+{
+	request_filter_t *f = reqfilter_new(4);
+	int64_t stats[REQFILTER_STAT_COUNT];
+	uint8_t noisy[TOX_CLIENT_ID_SIZE];
+	uint8_t key[TOX_CLIENT_ID_SIZE];
+	uint64_t now = 1000000;
+	uint32_t i;
+
+	/* One request per second and key, bursts of 2; ten per second in total, bursts of 5 */
+	reqfilter_limits(f, 1.0, 2, 10.0, 5);
+	make_key(noisy, 1);
+	CHECK(reqfilter_check(f, noisy, 10, now) == 1);
+	CHECK(reqfilter_check(f, noisy, 10, now) == 1);
+	CHECK(reqfilter_check(f, noisy, 10, now) == 0);
+
+	/* A second later the key has one token again */
+	now += 1000000;
+	CHECK(reqfilter_check(f, noisy, 10, now) == 1);
+	CHECK(reqfilter_check(f, noisy, 10, now) == 0);
+
+	/* The global bucket refilled to its burst of 5 and the noisy key took one of them */
+	for (i = 0; i < 5; i++) {
+		make_key(key, 100 + i);
+		CHECK(reqfilter_check(f, key, 10, now) == (i < 4));
+	}
+
+	reqfilter_stats(f, stats);
+	CHECK(stats[REQFILTER_STAT_KEY_RATE] == 2);
+	CHECK(stats[REQFILTER_STAT_GLOBAL_RATE] == 1);
+
+	/* Zero turns the limits off */
+	reqfilter_limits(f, 0, 0, 0, 0);
+
+	for (i = 0; i < 100; i++) {
+		CHECK(reqfilter_check(f, noisy, 10, now) == 1);
+	}
+
+	reqfilter_free(f);
+}
+
+int main(void)
+{
+	test_lists();
+	test_list_growth();
+	test_max_length();
+	test_rate_limits();
+	return check_failures != 0;
+}
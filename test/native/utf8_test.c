@@ -0,0 +1,89 @@
+/* utf8_test.c
+ *
+ *  Copyright (C) 2014 Tox project All Rights Reserved.
+ *
+ *  This file is part of jToxcore
+ *
+ *  jToxcore is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  jToxcore is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with jToxcore.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <string.h>
+
+#include "check.h"
+#include "utf8.h"
+
+#define FFFD 0xFFFD
+
+/* Convert and compare with the expected UTF-16, given as a zero terminated list */
+static int converts_to(const char *utf8, const jchar *expected)
+{
+	size_t length = strlen(utf8);
+	jchar out[64];
+	size_t count = utf8_to_utf16((const uint8_t *) utf8, length, out);
+	size_t i;
+
+	for (i = 0; expected[i] != 0; i++) {
+		if (i == count || out[i] != expected[i]) {
+			return 0;
+		}
+	}
+
+	return i == count;
+}
+
+static void test_valid(void)
+{
+	static const jchar mixed[] = {'a', 0xE9, 0x20AC, 0xD83D, 0xDE00, 'z', 0};
+
+	CHECK(converts_to("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80z", mixed));
+	CHECK(utf8_validate((const uint8_t *) "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80z", 12));
+}
+
+static void test_truncated_sequence(void)
+{
+	static const jchar truncated_three[] = {'a', FFFD, 'b', 0};
+	static const jchar truncated_four[] = {'a', FFFD, 0};
+	static const jchar truncated_twice[] = {FFFD, FFFD, 'x', 0};
+
+	/* Both bytes of a cut off three byte sequence are one maximal subpart */
+	CHECK(converts_to("a\xE2\x82" "b", truncated_three));
+	/* So are three bytes of a four byte sequence at the end of the input */
+	CHECK(converts_to("a\xF0\x9F\x98", truncated_four));
+	/* A new lead byte ends the subpart */
+	CHECK(converts_to("\xE2\x82\xF0\x9F" "x", truncated_twice));
+	CHECK(!utf8_validate((const uint8_t *) "a\xE2\x82" "b", 4));
+}
+
+static void test_invalid_bytes(void)
+{
+	static const jchar continuations[] = {FFFD, FFFD, 'a', 0};
+	static const jchar overlong[] = {FFFD, FFFD, 0};
+	static const jchar surrogate[] = {FFFD, FFFD, FFFD, 0};
+	static const jchar too_large[] = {FFFD, FFFD, FFFD, FFFD, 0};
+
+	/* Stray continuation bytes are replaced one by one */
+	CHECK(converts_to("\x80\xBF" "a", continuations));
+	/* Overlong forms, surrogates and code points above U+10FFFF never start a valid sequence */
+	CHECK(converts_to("\xC0\xAF", overlong));
+	CHECK(converts_to("\xED\xA0\x80", surrogate));
+	CHECK(converts_to("\xF4\x90\x80\x80", too_large));
+}
+
+int main(void)
+{
+	test_valid();
+	test_truncated_sequence();
+	test_invalid_bytes();
+	return check_failures != 0;
+}